@@ -16,8 +16,8 @@
 //free memory for a boundary plane
 #define FREEPLANE(e) if((e) != NULL) {FreeMemory(e);e=NULL;}
 
-//allocate memory for a boundary plane
-#define ALLOCATEPLANE(e) if(ret == ERR_OK){ e = (double *)AllocateMemory(sizeof(double) * size); if(e == NULL) ret = ERR_OUTOFMEMORY;}
+//allocate memory for a boundary plane and set it to 0
+#define ALLOCATEPLANE(e, size) if(ret == ERR_OK){ e = (double *)AllocateMemory(sizeof(double) * (size)); if(e == NULL) ret = ERR_OUTOFMEMORY; else {for(size_t i=0;i<(size);i++) e[i]=0.0;}}
 
 AbcFirstOrder::AbcFirstOrder(void)
 {
@@ -53,32 +53,27 @@ int AbcFirstOrder::initialize(double Courant, int maximumRadius, TaskFile *taskP
 	int ret = BoundaryCondition::initialize(Courant, maximumRadius, taskParameters);
 	if(ret == ERR_OK)
 	{
-		size_t size = gridSize * gridSize; //number of points on a boundary plane
+		//number of points on boundary planes perpendicular to x, y and z axis
+		size_t sizeX = (size_t)gridSizeY * (size_t)gridSizeZ;
+		size_t sizeY = (size_t)gridSizeX * (size_t)gridSizeZ;
+		size_t sizeZ = (size_t)gridSizeX * (size_t)gridSizeY;
 		abccoef = (Cdtds - 1.0) / (Cdtds + 1.0);
 		//allocate memory for remembering boundary planes
 		cleanup();
-		ALLOCATEPLANE(exy0)
-		ALLOCATEPLANE(exz0)
-		ALLOCATEPLANE(exy1)
-		ALLOCATEPLANE(exz1)
-
-		ALLOCATEPLANE(eyx0)
-		ALLOCATEPLANE(eyz0)
-		ALLOCATEPLANE(eyx1)
-		ALLOCATEPLANE(eyz1)
-
-		ALLOCATEPLANE(ezy0)
-		ALLOCATEPLANE(ezx0)
-		ALLOCATEPLANE(ezy1)
-		ALLOCATEPLANE(ezx1)
-
-		if(ret == ERR_OK)
-		{
-			for(size_t i=0;i<size;i++)
-			{
-				exy0[i] = exz0[i] = exy1[i] = exz1[i] = eyx0[i] = eyz0[i] = eyx1[i] = eyz1[i] = ezx0[i] = ezy0[i] = ezx1[i] = ezy1[i] = 0.0;
-			}
-		}
+		ALLOCATEPLANE(exy0, sizeY)
+		ALLOCATEPLANE(exz0, sizeZ)
+		ALLOCATEPLANE(exy1, sizeY)
+		ALLOCATEPLANE(exz1, sizeZ)
+
+		ALLOCATEPLANE(eyx0, sizeX)
+		ALLOCATEPLANE(eyz0, sizeZ)
+		ALLOCATEPLANE(eyx1, sizeX)
+		ALLOCATEPLANE(eyz1, sizeZ)
+
+		ALLOCATEPLANE(ezy0, sizeY)
+		ALLOCATEPLANE(ezx0, sizeX)
+		ALLOCATEPLANE(ezy1, sizeY)
+		ALLOCATEPLANE(ezx1, sizeX)
 	}
 	return ret;
 }
@@ -88,7 +83,8 @@ int AbcFirstOrder::initialize(double Courant, int maximumRadius, TaskFile *taskP
 
 	m,n,p=0,+-1,+-2,...,+-maxRadius
 	because thickness = 1 this function is called when
-	at least one of |m|, |n|, or |p| is maxRadius
+	at least one of |m|, |n|, or |p| is maxRadius.
+	for a rectangular box, it is called when |m| is maxRadiusX, or |n| is maxRadiusY, or |p| is maxRadiusZ
 
 	the code/algorithm is taken from book "understanding FDTD method" by John B. Schneider
 	see https://github.com/john-b-schneider/uFDTD/blob/master/Code/Fdtd-3d/abc3dfirst.c
@@ -100,7 +96,7 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 	size_t idx2;
 	bool atx=true,aty=true,atz=true;
 	//
-	if(m == -maxRadius)
+	if(m == -maxRadiusX)
 	{
 		//at back-plane (-maxRadius, y, z)
 		//it is equivalent to plane "x0"
@@ -108,7 +104,7 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		Ey(mm, nn, pp) = Eyx0(nn, pp) + abccoef * (Ey(mm + 1, nn, pp) - Ey(mm, nn, pp));
 		Eyx0(nn, pp) = Ey(mm + 1, nn, pp);
 		*/
-		idxPlane = PLANEINDEX(n, p);
+		idxPlane = PLANEINDEXX(n, p);
 		idx2 = SINDEX(m + 1, n, p);
 		//
 		_fields[idx].E.y = eyx0[idxPlane] + abccoef * (_fields[idx2].E.y - _fields[idx].E.y);
@@ -121,11 +117,11 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		_fields[idx].E.z = ezx0[idxPlane] + abccoef * (_fields[idx2].E.z - _fields[idx].E.z);
 		ezx0[idxPlane] = _fields[idx2].E.z;
 	}
-	else if(m == maxRadius)
+	else if(m == maxRadiusX)
 	{
 		//at front-plane (maRadius, y, z)
 		//it is equivalent to plane "x1"
-		idxPlane = PLANEINDEX(n, p);
+		idxPlane = PLANEINDEXX(n, p);
 		idx2 = SINDEX(m - 1, n, p);
 		/* corresponding to following code in the book "understanding FDTD method":
 		Ey(mm, nn, pp) = Eyx1(nn, pp) + abccoef * (Ey(mm - 1, nn, pp) - Ey(mm, nn, pp));
@@ -145,11 +141,11 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		atx = false;
 	}
 	//
-	if(n == -maxRadius)
+	if(n == -maxRadiusY)
 	{
 		//at left plane (x, -maxRadius, z)
 		//it is equivalent to plane "y0"
-		idxPlane = PLANEINDEX(m, p);
+		idxPlane = PLANEINDEXY(m, p);
 		idx2 = SINDEX(m, n + 1, p);
 		/* corresponding to following code in the book "understanding FDTD method":
 		Ex(mm, nn, pp) = Exy0(mm, pp) + abccoef * (Ex(mm, nn + 1, pp) - Ex(mm, nn, pp));
@@ -164,11 +160,11 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		_fields[idx].E.z = ezy0[idxPlane] + abccoef * (_fields[idx2].E.z - _fields[idx].E.z);
 		ezy0[idxPlane] = _fields[idx2].E.z;
 	}
-	else if(n == maxRadius)
+	else if(n == maxRadiusY)
 	{
 		//at right plane (x, maxRadius, z)
 		//it is equivalent to plane "y1"
-		idxPlane = PLANEINDEX(m, p);
+		idxPlane = PLANEINDEXY(m, p);
 		idx2 = SINDEX(m, n - 1, p);
 		/* corresponding to following code in the book "understanding FDTD method":
 		Ex(mm, nn, pp) = Exy1(mm, pp) + abccoef * (Ex(mm, nn - 1, pp) - Ex(mm, nn, pp));
@@ -188,11 +184,11 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		aty = false;
 	}
 	//
-	if(p == -maxRadius)
+	if(p == -maxRadiusZ)
 	{
 		//at bottom plane (x, y, -maxRadius)
 		//it is equivalent to plane "z0"
-		idxPlane = PLANEINDEX(m, n);
+		idxPlane = PLANEINDEXZ(m, n);
 		idx2 = SINDEX(m, n, p + 1);
 		/* corresponding to following code in the book "understanding FDTD method":
 		Ex(mm, nn, pp) = Exz0(mm, nn) + abccoef * (Ex(mm, nn, pp + 1) - Ex(mm, nn, pp));
@@ -207,11 +203,11 @@ void AbcFirstOrder::handleData(int m, int n, int p)
 		_fields[idx].E.y = eyz0[idxPlane] + abccoef * (_fields[idx2].E.y - _fields[idx].E.y);
 		eyz0[idxPlane] = _fields[idx2].E.y;
 	}
-	else if(p == maxRadius)
+	else if(p == maxRadiusZ)
 	{
 		//at top plane (x, y, maxRadius)
 		//it is equivalent to plane "z1"
-		idxPlane = PLANEINDEX(m, n);
+		idxPlane = PLANEINDEXZ(m, n);
 		idx2 = SINDEX(m, n, p - 1);
 		/* corresponding to following code in the book "understanding FDTD method":
 		Ex(mm, nn, pp) = Exz1(mm, nn) + abccoef * (Ex(mm, nn, pp - 1) - Ex(mm, nn, pp));
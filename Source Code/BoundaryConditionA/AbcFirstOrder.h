@@ -36,7 +36,11 @@ public:
 	virtual void handleData(int m, int n, int p);
 };
 
-//get memory index from plane index
-#define PLANEINDEX(idx1, idx2) (CUBICINDEX(idx2) + gridSize * CUBICINDEX(idx1))
+//get memory index from plane index.
+//a plane perpendicular to x axis is indexed by (n,p), to y axis by (m,p), to z axis by (m,n);
+//for a cube all 3 macros give the same index
+#define PLANEINDEXX(n, p) (((p)+maxRadiusZ) + gridSizeZ * ((n)+maxRadiusY))
+#define PLANEINDEXY(m, p) (((p)+maxRadiusZ) + gridSizeZ * ((m)+maxRadiusX))
+#define PLANEINDEXZ(m, n) (((n)+maxRadiusY) + gridSizeY * ((m)+maxRadiusX))
 
 #endif
\ No newline at end of file
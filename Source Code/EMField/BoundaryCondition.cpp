@@ -12,16 +12,32 @@ BoundaryCondition::BoundaryCondition(void)
 {
 	thickness = 1;
 	_fields = NULL;
+	_boxSet = false;
 }
 
 int BoundaryCondition::initialize(double Courant, int maximumRadius, TaskFile *taskParameters)
 {
 	Cdtds = Courant;
+	if(!_boxSet)
+	{
+		//not a box; a box of an earlier initialize is not kept
+		GoThroughSphereByIndexes::setBoxRadius(maximumRadius, maximumRadius, maximumRadius);
+	}
+	_boxSet = false;
 	maxRadius = maximumRadius;
 	gridSize = 2 * maxRadius + 1;
+	gridSizeX = 2 * maxRadiusX + 1;
+	gridSizeY = 2 * maxRadiusY + 1;
+	gridSizeZ = 2 * maxRadiusZ + 1;
 	return ERR_OK;
 }
 
+void BoundaryCondition::setBoxRadius(int maxRx, int maxRy, int maxRz)
+{
+	GoThroughSphereByIndexes::setBoxRadius(maxRx, maxRy, maxRz);
+	_boxSet = true;
+}
+
 int BoundaryCondition::getThickNess()
 {
 	return thickness;
@@ -25,6 +25,8 @@ protected:
 	FieldPoint3D *_fields; //fields to work on
 	int thickness; //boundary thickness
 	int gridSize;  //number of space points on one axis, it is 2*maxRadius + 1
+	int gridSizeX, gridSizeY, gridSizeZ; //number of space points on each axis of a rectangular box; all equal gridSize for a cube
+	bool _boxSet; //setBoxRadius is called for the next initialize
 public:
 	BoundaryCondition(void);
 	//int SetMemoryMappingFolder(const wchar_t *folder);
@@ -36,11 +38,16 @@ public:
 		if a derived class overrides this function then it should the base function first.
 		a derived class may define runtime parameters. each parameter appears in a task file as a line of name=value
 		in the derived function the parameter values are read back via taskParameters
+
+		for a rectangular box, call setBoxRadius(...) before calling initialize(...); without it initialize makes a cube
 	*/
 	virtual int initialize(double Courant, int maximumRadius, TaskFile *taskParameters);
+	void setBoxRadius(int maxRx, int maxRy, int maxRz);
 	/*
 		the following overridable functions will be called when applying boundary conditions.
 		a simulation system calls gothroughSphere() to go through space points radius by radius.
+		for a rectangular box, a simulation system calls gothroughBoxFaces() to go through space points 
+		within "thickness" of the box faces; setRadius is not called.
 	*/
 	/*
 		the function setRadius(...) is called when a new radius is to be processed.
@@ -43,6 +43,7 @@
 #define ERR_RADIUS_INDEX_CACHE      26
 #define ERR_RADIUS_HANDLE_DATA      27
 #define ERR_INVALID_DATA_FOLDER     28
+#define ERR_TFSF_INCIDENT           29
 
 
 //it is used for specifying a location or a 3D vector
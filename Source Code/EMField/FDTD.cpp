@@ -23,12 +23,17 @@ FDTD::FDTD(void)
 	courant = 1.0 / sqrt(3.0);
 	seriesIndex = NULL;
 	_tfsf = NULL;
+	_maskInitializer = NULL;
+	_mask = NULL;
 	_basefilename = NULL;
 	N = 0;
 	dt = 0;
 	ds = 0.0;
 	maxRadius = 0;
 	maxN = 0;
+	Nx = Ny = Nz = 0;
+	maxRadiusX = maxRadiusY = maxRadiusZ = 0;
+	_boxDomain = false;
 	_maximumTimeIndex = 0;
 	_maxOrderTimeAdvance = 1;
 	_maxOrderSpaceDerivative = 1;
@@ -40,7 +45,42 @@ FDTD::FDTD(void)
 }
 FDTD::~FDTD(void)
 {
+	freeMask();
+}
 
+/*
+	form the material mask from the task file and the mask initializer.
+	the mask is removed if all the points are active
+*/
+int FDTD::createMask(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	freeMask();
+	//a curl estimation reaches at most 2 times of the half order at each side of a point
+	_mask = new MaterialMask(fieldItems, maxRadiusX, maxRadiusY, maxRadiusZ, _boxDomain, ds);
+	_mask->SetMemoryManager(_mem);
+	_mask->setIndexCache(seriesIndex);
+	ret = _mask->initialize(taskParameters, _maskInitializer);
+	if(ret == ERR_OK)
+	{
+		if(!_mask->IsUsed())
+		{
+			freeMask();
+		}
+		else if(!SupportMaterialMask())
+		{
+			ret = ERR_EMF_MASK;
+		}
+	}
+	return ret;
+}
+void FDTD::freeMask()
+{
+	if(_mask != NULL)
+	{
+		delete _mask;
+		_mask = NULL;
+	}
 }
 
 /*
@@ -59,7 +99,14 @@ int FDTD::formBaseFilePath(const char *dataFolder, char *baseName)
 	{
 		int r1,r2;
 		doubleToIntegers(range, &r1,&r2);
-		err = sprintf_s(fieldFile, FILENAME_MAX, "%s\\%s_N%d_R%dR%d_T%dS%d_", dataFolder,getClassName(), N,r1,r2,2*_maxOrderTimeAdvance,2*_maxOrderSpaceDerivative);
+		if(_boxDomain)
+		{
+			err = sprintf_s(fieldFile, FILENAME_MAX, "%s\\%s_N%dx%dx%d_R%dR%d_T%dS%d_", dataFolder,getClassName(), Nx,Ny,Nz,r1,r2,2*_maxOrderTimeAdvance,2*_maxOrderSpaceDerivative);
+		}
+		else
+		{
+			err = sprintf_s(fieldFile, FILENAME_MAX, "%s\\%s_N%d_R%dR%d_T%dS%d_", dataFolder,getClassName(), N,r1,r2,2*_maxOrderTimeAdvance,2*_maxOrderSpaceDerivative);
+		}
 		if(err == -1)
 		{
 			ret = ERR_EMF_EINVAL;
@@ -88,6 +135,32 @@ int FDTD::formBaseFilePath(const char *dataFolder, char *baseName)
 	return ret;
 }
 
+/*
+	read N of the domain. FDTD.N is required; FDTD.NX, FDTD.NY and FDTD.NZ are optional.
+	if they are not all the same then the domain is a rectangular box
+*/
+int FDTD::ReadGridSize(TaskFile *taskParameters, unsigned *n, unsigned *nx, unsigned *ny, unsigned *nz, bool *isBox)
+{
+	int ret;
+	*n = taskParameters->getUInt(TP_FDTDN, false);
+	*nx = taskParameters->getUInt(TP_FDTDNX, true);
+	*ny = taskParameters->getUInt(TP_FDTDNY, true);
+	*nz = taskParameters->getUInt(TP_FDTDNZ, true);
+	ret = taskParameters->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		if(*nx == 0) *nx = *n;
+		if(*ny == 0) *ny = *n;
+		if(*nz == 0) *nz = *n;
+		*isBox = !(*nx == *ny && *ny == *nz);
+		if(*n == 0)
+		{
+			ret = ERR_INVALID_SIZE;
+		}
+	}
+	return ret;
+}
+
 /*
 	prepare for starting simulations
 
@@ -101,9 +174,11 @@ int FDTD::formBaseFilePath(const char *dataFolder, char *baseName)
 	common configutation values in a task file:
 	FDTD.N - integer, half number of space grid on an axis. total number is 2N+1
 	FDTD.R - double, half space size on an axis. total size is 2R
+	FDTD.NX, FDTD.NY, FDTD.NZ - integer, optional, N for each axis of a rectangular domain
 	FDTD.maxTimeIndex - long integer, maximum simulation time steps
 	FDTD.HalfOrderTimeAdvance - integer, half estimation order for time advancement, optional, default to 1
 	FDTD.HalfOrderSpaceDerivate - integer, half estimation order for space derivative, optional, default to 1
+	FDTD.MASK_FILE, FDTD.MASK_BOXES - optional, a material mask, see MaterialMask
 */
 int FDTD::initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *tfsf, TaskFile *taskParameters)
 {
@@ -114,7 +189,7 @@ int FDTD::initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *t
 	}
 	else
 	{
-		N = taskParameters->getUInt(TP_FDTDN, false);
+		ret = ReadGridSize(taskParameters, &N, &Nx, &Ny, &Nz, &_boxDomain);
 		range = taskParameters->getDouble(TP_FDTDR, false);
 		_maximumTimeIndex = (size_t)taskParameters->getLong(TP_MAX_TIMESTEP, false);
 		_recordFDTDStepTimes = taskParameters->getBoolean(TP_REC_TIMESTEP, true);
@@ -138,6 +213,10 @@ int FDTD::initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *t
 		{
 			ret = ERR_INVALID_SIZE;
 		}
+		else if(_boxDomain && !SupportBoxDomain())
+		{
+			ret = ERR_EMF_BOX;
+		}
 	}
 	if(ret == ERR_OK)
 	{
@@ -166,11 +245,25 @@ int FDTD::initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *t
 	if(ret == ERR_OK)
 	{
 		//
-		maxRadius = GRIDRADIUS(N);
-		maxN = GRIDPOINTS(N);
+		maxRadiusX = GRIDRADIUS(Nx);
+		maxRadiusY = GRIDRADIUS(Ny);
+		maxRadiusZ = GRIDRADIUS(Nz);
 		ds = SPACESTEP(range, N);
 		//
-		fieldItems = totalPointsInSphere(maxRadius);
+		if(_boxDomain)
+		{
+			//memory is decided by the box, not by the largest axis
+			maxRadius = maxRadiusX;
+			if(maxRadiusY > maxRadius) maxRadius = maxRadiusY;
+			if(maxRadiusZ > maxRadius) maxRadius = maxRadiusZ;
+			fieldItems = BOXPOINTS(maxRadiusX, maxRadiusY, maxRadiusZ);
+		}
+		else
+		{
+			maxRadius = maxRadiusX;
+			fieldItems = totalPointsInSphere(maxRadius);
+		}
+		maxN = 2 * maxRadius + 1;
 		fieldMemorySize = sizeof(FieldPoint3D) * fieldItems;
 		//
 		dt = (ds / c0) * courant;
@@ -181,6 +274,10 @@ int FDTD::initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *t
 		ret = allocateFieldMemory();
 	}
 	if(ret == ERR_OK)
+	{
+		ret = createMask(taskParameters);
+	}
+	if(ret == ERR_OK)
 	{
 		ret = onInitialized(taskParameters);
 		if(_recordFDTDStepTimes)
@@ -229,6 +326,7 @@ int FDTD::moveForward()
 void FDTD::FinishSimulation()
 {
 	OnFinishSimulation();
+	freeMask();
 	if(filehandleStepTime != 0)
 	{
 		closefile(filehandleStepTime);
@@ -241,8 +339,44 @@ void FDTD::FinishSimulation()
 */
 int FDTD::PopulateFields(FieldsInitializer *fieldValues)
 {
+	int ret;
 	FieldsFiller p(fieldValues, GetFieldMemory());
-	int ret = p.gothroughSphere(maxRadius, ds);
+	if(_boxDomain)
+	{
+		ret = p.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ, ds);
+	}
+	else
+	{
+		ret = p.gothroughSphere(maxRadius, ds);
+	}
+	if(ret == ERR_OK)
+	{
+		applyMaskToFields();
+	}
+	return ret;
+}
+/*
+	replace the fields and move to a time index.
+	it is called by a time-parallel simulator to start a propagation from the fields at the start of a time slice.
+*/
+int FDTD::SetFieldsAtTime(FieldPoint3D *fields, size_t timeIndex)
+{
+	int ret = ERR_OK;
+	if(HE == NULL)
+	{
+		ret = ERR_NOTINITIALIZED;
+	}
+	else
+	{
+		for(size_t i=0;i<fieldItems;i++)
+		{
+			HE[i] = fields[i];
+		}
+		applyMaskToFields();
+		_timeIndex = timeIndex;
+		_time = dt * (double)timeIndex;
+		ret = onFieldsReplaced();
+	}
 	return ret;
 }
 
@@ -13,10 +13,14 @@
 #include "FdtdMemory.h"
 #include "Plugin.h"
 #include "TotalFieldScatteredFieldBoundary.h"
+#include "MaterialMask.h"
 #include "..\FileUtil\taskFile.h"
 #include "..\OutputUtil\OutputUtility.h"
 
 #define ERR_EMF_EINVAL 2001
+#define ERR_EMF_BOX    2002
+#define ERR_EMF_MASK   2003
+#define ERR_EMF_TIME_BLOCK 2004
 
 /*
 	abstract class for FDTD algorithm. An FDTD class should be implemented in a dynamic link library 
@@ -35,6 +39,12 @@ protected:
 	unsigned maxN;          //4N+3, memory row size
 	unsigned maxRadius;     //2N+1, maximum radius
 	//
+	//rectangular domain. Nx, Ny and Nz are N for each axis; they all equal N for a cubic domain.
+	//if they are not all equal then the fields are stored in a row-major box instead of by radius indexing
+	unsigned Nx, Ny, Nz;
+	unsigned maxRadiusX, maxRadiusY, maxRadiusZ; //2Nx+1, 2Ny+1, 2Nz+1
+	bool _boxDomain;
+	//
 	size_t _maximumTimeIndex;     //maximum time index for simulation
 	int _maxOrderTimeAdvance;     //max half order for time advancement
 	int _maxOrderSpaceDerivative; //max half order for space derivative estimations
@@ -43,6 +53,13 @@ protected:
 	//
 	TotalFieldScatteredFieldBoundary *_tfsf; //total field/scattered field boundary
 	//
+	MaterialMaskInitializer *_maskInitializer; //optional, gives a material mask by space locations
+	MaterialMask *_mask;                       //NULL if all the points are active
+	int createMask(TaskFile *taskParameters);
+	void freeMask();
+	//hold the fields of masked points at 0; it is called after the fields are populated
+	void applyMaskToFields(){if(_mask != NULL) _mask->ApplyToFields(HE);}
+	//
 	virtual int formBaseFilePath(const char *dataFolder, char *baseName);    //form full path of base file name and assigned it to _basefilename
 	virtual void cleanup()=0;      //free memory
 	virtual int onInitialized(TaskFile *taskParameters)=0; //called after initialize(...) returns ERR_OK
@@ -55,6 +72,11 @@ protected:
 		it is called when the maximum time step is reached
 	*/
 	virtual void OnFinishSimulation()=0;
+	/*
+		it is called by SetFieldsAtTime after the fields are replaced.
+		a derived class keeping time stepping states overrides it to reset the states
+	*/
+	virtual int onFieldsReplaced(){return ERR_OK;}
 	//
 //enable speed recording---------------
 	bool _recordFDTDStepTimes;
@@ -75,11 +97,53 @@ public:
 	unsigned getHalfGridNumber(){return N;}
 	unsigned getMaxRadius(){return maxRadius;}
 	unsigned getOneDsize(){return maxN;}
+	bool IsBoxDomain(){return _boxDomain;}
+	unsigned getMaxRadiusX(){return maxRadiusX;}
+	unsigned getMaxRadiusY(){return maxRadiusY;}
+	unsigned getMaxRadiusZ(){return maxRadiusZ;}
 	double GetSpaceStepSize(){return ds;}
 	double GetTimeStepSize(){return dt;}
 	double getTime(){return _time;}
 	size_t getMaximumTimeIndex(){return _maximumTimeIndex;}
 	//--------------------------------------------------
+	/*
+		read FDTD.N and the optional FDTD.NX, FDTD.NY and FDTD.NZ.
+		an axis not given uses FDTD.N. 
+		returns true in *isBox if the 3 axes are not the same
+	*/
+	static int ReadGridSize(TaskFile *taskParameters, unsigned *n, unsigned *nx, unsigned *ny, unsigned *nz, bool *isBox);
+	/*
+		an FDTD class which can work on a row-major box returns true.
+		it is called by initialize when the task file defines a rectangular domain
+	*/
+	virtual bool SupportBoxDomain(){return false;}
+	/*
+		true if the field components are at Yee's positions: each component is half a space step away from its grid point,
+		and H is half a time step behind E. false if all components are at the grid points and at the same time
+	*/
+	virtual bool IsStaggered(){return false;}
+	/*
+		an FDTD class which skips inactive points and holds the fields of PEC/PMC points of a MaterialMask returns true.
+		it is called by initialize when the task file or the mask initializer gives a mask
+	*/
+	virtual bool SupportMaterialMask(){return false;}
+	//call it before initialize(...); the initializer must have been initialized by the task file
+	void SetMaskInitializer(MaterialMaskInitializer *initializer){_maskInitializer = initializer;}
+	//NULL if there is not a mask or all the points are active
+	MaterialMask *GetMaterialMask(){return _mask;}
+	/*
+		an FDTD class which makes divergence statistics while it advances time returns true, and gives the average
+		absolute divergences of E and H over the points within radius. the statistics are of the fields at the start of
+		the latest time step, so a simulator does not need another pass over the fields to get them
+	*/
+	virtual bool GetStepDivergence(int radius, double *averageE, double *averageH){return false;}
+	/*
+		number of time steps one moveForward may advance. an FDTD class returning more than 1 applies a first order ABC
+		at the domain faces by itself after each of the steps, so a simulator must not apply field sources, TF/SF boundaries
+		or its own boundary condition between the steps; it sees the fields only at every GetStepsPerMove() time index,
+		and at the maximum time index
+	*/
+	virtual unsigned GetStepsPerMove(){return 1;}
 	/*
 		prepare for starting simulations
 
@@ -93,9 +157,11 @@ public:
 		basic configutation values in a task file:
 		FDTD.N - integer, half number of space grid on an axis. total number is 2N+1
 		FDTD.R - double, half space size on an axis. total size is 2R
+		FDTD.NX, FDTD.NY, FDTD.NZ - integer, optional, N for each axis of a rectangular domain. space step is still decided by FDTD.N and FDTD.R
 		FDTD.maxTimeIndex - long integer, maximum simulation time steps
 		FDTD.HalfOrderTimeAdvance - integer, half estimation order for time advancement, optional, default to 1
 		FDTD.HalfOrderSpaceDerivate - integer, half estimation order for space derivative, optional, default to 1
+		FDTD.MASK_FILE, FDTD.MASK_BOXES - optional, a material mask, see MaterialMask
 
 	*/
 	int initialize(const char *dataFolder, TotalFieldScatteredFieldBoundary *tfsf, TaskFile *taskParameters);
@@ -111,6 +177,12 @@ public:
 		if special initialization is needed then override this function
 	*/
 	virtual int PopulateFields(FieldsInitializer *fieldValues);
+	/*
+		replace the fields and move to a time index.
+		it is called by a time-parallel simulator to start a propagation from the fields at the start of a time slice.
+		fields must hold GetMemoryItemCount() items
+	*/
+	int SetFieldsAtTime(FieldPoint3D *fields, size_t timeIndex);
 	//
 	virtual bool ReachedMaximumTime(){return _timeIndex >= _maximumTimeIndex;}
 	//
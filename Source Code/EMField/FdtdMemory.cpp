@@ -70,7 +70,7 @@ int FdtdMemory::allocateFieldMemory()
 			if(HE == NULL)
 			{
 				//allocate memory by mapping to a temporary file
-				HE = (FieldPoint3D *)AllocateMemory(fieldMemorySize);
+				HE = (FieldPoint3D *)AllocateTaggedMemory(fieldMemorySize, MEM_TAG_FIELDS);
 				if(HE == NULL)
 				{
 					ret = ERR_OUTOFMEMORY;
@@ -94,7 +94,7 @@ int FdtdMemory::allocateFieldMemory()
 			if(ret == ERR_OK)
 			{
 				//allocate memory and map the memory to a file using the newly formed file name
-				p = (FieldPoint3D *)CreateFileIntoMemory(filename, fieldMemorySize, &ret);
+				p = (FieldPoint3D *)CreateFileIntoTaggedMemory(filename, fieldMemorySize, &ret, MEM_TAG_FIELDS);
 				if(ret == ERR_OK)
 				{
 					if(p == NULL)
@@ -43,7 +43,8 @@ public:
 	size_t GetMemorySize();
 	size_t GetMemoryItemCount();
 	size_t GetTimeStepIndex();
-	FieldPoint3D *GetFieldMemory();
+	//a derived class keeping the fields in its own memory between time steps overrides it to bring HE up to date
+	virtual FieldPoint3D *GetFieldMemory();
 	//---------------------------------------
 };
 
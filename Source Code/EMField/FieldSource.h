@@ -18,7 +18,7 @@
 	abstract class for field source. a source should be implemented in a dynamic link library 
 	to be plugged into a simulation system at runtime.
 */
-class FieldSource: public GoThroughSphereByIndexes, public virtual MemoryManUser, public Plugin
+class FieldSource: public GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser, public virtual MemoryManUser, public Plugin
 {
 protected:
 	double Cdtds;          //Courant number = 1.0 / sqrt(3.0)
@@ -34,7 +34,9 @@ public:
 	virtual int initialize(double Courant, int maximumRadius, TaskFile *taskParameters);
 
 	/*
-		prepare variables for the source to work
+		prepare variables for the source to work.
+		a simulation system calls gothroughSphere() for a cube and gothroughSphereInBox() for a rectangular box,
+		in both cases use SINDEX(m,n,p) to get the memory index of a space point
 	*/
 	virtual void reset(FieldPoint3D *fields, size_t timeIndex, double time){_fields=fields; _timeIndex=timeIndex; _time = time;}
 	
@@ -0,0 +1,410 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "MaterialMask.h"
+#include "..\MemoryMan\memman.h"
+#include "..\FileUtil\fileutil.h"
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PASS_INITIALIZER 0
+
+//largest size of one reading of a mask file
+#define MASK_READ_BLOCK 0x40000000
+
+static bool isValidKind(unsigned char k)
+{
+	return k == MASK_ACTIVE || k == MASK_PEC || k == MASK_PMC || k == MASK_INACTIVE;
+}
+
+MaterialMask::MaterialMask(size_t items, int maxRx, int maxRy, int maxRz, bool box, double ds)
+{
+	_pass = PASS_INITIALIZER;
+	_items = items;
+	_rx = maxRx;
+	_ry = maxRy;
+	_rz = maxRz;
+	_box = box;
+	_ds = ds;
+	_kinds = NULL;
+	_maskedCount = 0;
+	_initializer = NULL;
+	_runs = NULL;
+	_runCount = 0;
+	_constrained = NULL;
+	_constrainedCount = 0;
+}
+
+MaterialMask::~MaterialMask()
+{
+	cleanup();
+}
+
+void MaterialMask::cleanup()
+{
+	if(_kinds != NULL)
+	{
+		FreeMemory(_kinds);
+		_kinds = NULL;
+	}
+	if(_runs != NULL)
+	{
+		free(_runs);
+		_runs = NULL;
+	}
+	if(_constrained != NULL)
+	{
+		free(_constrained);
+		_constrained = NULL;
+	}
+	_runCount = 0;
+	_constrainedCount = 0;
+	_maskedCount = 0;
+}
+
+int MaterialMask::gothrough()
+{
+	if(_box)
+	{
+		return gothroughBox(_rx, _ry, _rz);
+	}
+	return gothroughSphere(_rx);
+}
+
+/*
+	read one byte per space point, in memory order
+*/
+int MaterialMask::readMaskFile(const char *file)
+{
+	int handle = 0;
+	int ret = openfileRead(file, &handle);
+	if(ret == ERR_OK)
+	{
+		size_t done = 0;
+		unsigned size;
+		while(done < _items && ret == ERR_OK)
+		{
+			size = (_items - done > MASK_READ_BLOCK) ? MASK_READ_BLOCK : (unsigned)(_items - done);
+			ret = readfile(handle, _kinds + done, size);
+			done += size;
+		}
+		closefile(handle);
+	}
+	if(ret == ERR_OK)
+	{
+		for(size_t i=0;i<_items;i++)
+		{
+			if(!isValidKind(_kinds[i]))
+			{
+				ret = ERR_TASK_INVALID_VALUE;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	boxes - "kind:m0,n0,p0,m1,n1,p1;...", kind is PEC, PMC or OFF.
+	the points of (m,n,p) with m0<=m<=m1, n0<=n<=n1 and p0<=p<=p1 are set to the kind; a box is clipped by the domain
+*/
+int MaterialMask::applyBoxes(TaskFile *taskParameters, const char *boxes)
+{
+	int ret = ERR_OK;
+	const char *s = boxes;
+	char *e;
+	long v[6];
+	unsigned char kind;
+	while(*s != 0 && ret == ERR_OK)
+	{
+		while(*s == ' ') s++;
+		if(strncmp(s, "PEC", 3) == 0)
+		{
+			kind = MASK_PEC;
+		}
+		else if(strncmp(s, "PMC", 3) == 0)
+		{
+			kind = MASK_PMC;
+		}
+		else if(strncmp(s, "OFF", 3) == 0)
+		{
+			kind = MASK_INACTIVE;
+		}
+		else
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s += 3;
+		while(*s == ' ') s++;
+		if(*s != ':')
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s++;
+		for(int i=0;i<6;i++)
+		{
+			v[i] = strtol(s, &e, 10);
+			if(e == s)
+			{
+				ret = ERR_TASK_INVALID_VALUE;
+				break;
+			}
+			s = e;
+			while(*s == ' ') s++;
+			if(i < 5)
+			{
+				if(*s != ',')
+				{
+					ret = ERR_TASK_INVALID_VALUE;
+					break;
+				}
+				s++;
+			}
+		}
+		if(ret != ERR_OK)
+		{
+			break;
+		}
+		if(*s == ';')
+		{
+			s++;
+		}
+		else if(*s != 0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		//clip by the domain
+		if(v[0] < -_rx) v[0] = -_rx;
+		if(v[1] < -_ry) v[1] = -_ry;
+		if(v[2] < -_rz) v[2] = -_rz;
+		if(v[3] > _rx) v[3] = _rx;
+		if(v[4] > _ry) v[4] = _ry;
+		if(v[5] > _rz) v[5] = _rz;
+		for(long m=v[0];m<=v[3];m++)
+		{
+			for(long n=v[1];n<=v[4];n++)
+			{
+				for(long p=v[2];p<=v[5];p++)
+				{
+					_kinds[SINDEX(m,n,p)] = kind;
+				}
+			}
+		}
+	}
+	if(ret != ERR_OK)
+	{
+		taskParameters->setNameOfInvalidValue(TP_MASK_BOXES);
+	}
+	return ret;
+}
+
+void MaterialMask::handleData(int m, int n, int p)
+{
+	unsigned char k;
+	switch(_pass)
+	{
+	case PASS_INITIALIZER:
+		k = _initializer->funcMask((double)m * _ds, (double)n * _ds, (double)p * _ds);
+		if(isValidKind(k))
+		{
+			_kinds[index] = k;
+		}
+		else
+		{
+			ret = ERR_INVALID_INIT;
+		}
+		break;
+	}
+	index++;
+}
+
+/*
+	constrained is false: runs of the points to be advanced, the kind of a run is MASK_ACTIVE.
+	constrained is true: runs of PEC/PMC points to be advanced, the kind of a run is MASK_PEC or MASK_PMC.
+	*count is 0 and NULL is returned if there is not such a point
+*/
+MaskRun *MaterialMask::formRuns(bool constrained, size_t *count)
+{
+	MaskRun *runs = NULL;
+	size_t c = 0;
+	unsigned char k, last = 0;
+	bool inRun = false, take;
+	//count the runs first, then fill them
+	for(int step=0;step<2;step++)
+	{
+		c = 0;
+		inRun = false;
+		for(size_t i=0;i<_items;i++)
+		{
+			k = _kinds[i];
+			if(constrained)
+			{
+				take = (k == MASK_PEC || k == MASK_PMC);
+			}
+			else
+			{
+				take = (k & MASK_INACTIVE) == 0;
+				k = MASK_ACTIVE;
+			}
+			if(take)
+			{
+				if(!inRun || k != last)
+				{
+					if(runs != NULL)
+					{
+						runs[c].start = i;
+						runs[c].kind = k;
+					}
+					c++;
+					inRun = true;
+					last = k;
+				}
+				if(runs != NULL)
+				{
+					runs[c-1].end = i + 1;
+				}
+			}
+			else
+			{
+				inRun = false;
+			}
+		}
+		if(step == 0)
+		{
+			if(c == 0)
+			{
+				break;
+			}
+			runs = (MaskRun *)malloc(c * sizeof(MaskRun));
+			if(runs == NULL)
+			{
+				break;
+			}
+		}
+	}
+	*count = c;
+	return runs;
+}
+
+int MaterialMask::initialize(TaskFile *taskParameters, MaterialMaskInitializer *initializer)
+{
+	int ret = ERR_OK;
+	char *file = taskParameters->getString(TP_MASK_FILE, true);
+	char *boxes = taskParameters->getString(TP_MASK_BOXES, true);
+	ret = taskParameters->getErrorCode();
+	cleanup();
+	if(ret == ERR_OK)
+	{
+		ret = MEMMANEXIST;
+	}
+	if(ret == ERR_OK)
+	{
+		_kinds = (unsigned char *)AllocateTaggedMemory(_items, MEM_TAG_MATERIALS);
+		if(_kinds == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			memset(_kinds, MASK_ACTIVE, _items);
+		}
+	}
+	if(ret == ERR_OK && file != NULL && strlen(file) > 0)
+	{
+		ret = readMaskFile(file);
+		if(ret == ERR_TASK_INVALID_VALUE)
+		{
+			taskParameters->setNameOfInvalidValue(TP_MASK_FILE);
+		}
+	}
+	if(ret == ERR_OK && initializer != NULL)
+	{
+		_initializer = initializer;
+		_pass = PASS_INITIALIZER;
+		ret = gothrough();
+		_initializer = NULL;
+	}
+	if(ret == ERR_OK && boxes != NULL && strlen(boxes) > 0)
+	{
+		ret = applyBoxes(taskParameters, boxes);
+	}
+	if(ret == ERR_OK)
+	{
+		for(size_t i=0;i<_items;i++)
+		{
+			if(_kinds[i] != MASK_ACTIVE)
+			{
+				_maskedCount++;
+			}
+		}
+	}
+	if(ret == ERR_OK && _maskedCount > 0)
+	{
+		_runs = formRuns(false, &_runCount);
+		_constrained = formRuns(true, &_constrainedCount);
+		if((_runs == NULL && _runCount > 0) || (_constrained == NULL && _constrainedCount > 0))
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	return ret;
+}
+
+void MaterialMask::ApplyToFields(FieldPoint3D *fields)
+{
+	unsigned char k;
+	for(size_t i=0;i<_items;i++)
+	{
+		k = _kinds[i];
+		if(k & (MASK_PEC | MASK_INACTIVE))
+		{
+			fields[i].E.x = fields[i].E.y = fields[i].E.z = 0.0;
+		}
+		if(k & (MASK_PMC | MASK_INACTIVE))
+		{
+			fields[i].H.x = fields[i].H.y = fields[i].H.z = 0.0;
+		}
+	}
+}
+
+void MaterialMask::ConstrainCurls(FieldPoint3D *curls, int order)
+{
+	bool even = (order % 2) == 0;
+	for(size_t r=0;r<_constrainedCount;r++)
+	{
+		//the components applied to E are held at a PEC point, the components applied to H are held at a PMC point
+		if((_constrained[r].kind == MASK_PEC) == even)
+		{
+			for(size_t i=_constrained[r].start;i<_constrained[r].end;i++)
+			{
+				curls[i].E.x = curls[i].E.y = curls[i].E.z = 0.0;
+			}
+		}
+		else
+		{
+			for(size_t i=_constrained[r].start;i<_constrained[r].end;i++)
+			{
+				curls[i].H.x = curls[i].H.y = curls[i].H.z = 0.0;
+			}
+		}
+	}
+}
+
+void MaterialMask::ClearInactive(FieldPoint3D *curls)
+{
+	for(size_t i=0;i<_items;i++)
+	{
+		if(_kinds[i] & MASK_INACTIVE)
+		{
+			curls[i].E.x = curls[i].E.y = curls[i].E.z = 0.0;
+			curls[i].H.x = curls[i].H.y = curls[i].H.z = 0.0;
+		}
+	}
+}
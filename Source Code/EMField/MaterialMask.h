@@ -0,0 +1,113 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "EMField.h"
+#include "RadiusIndex.h"
+#include "Plugin.h"
+#include "..\MemoryMan\MemoryManager.h"
+#include "..\FileUtil\taskFile.h"
+
+/*
+	kinds of space points of a material mask.
+	at a PEC point E is held at 0 and H is advanced; at a PMC point H is held at 0 and E is advanced.
+	nothing is advanced at an inactive point; it is a point inside a PEC/PMC body or a "don't care" region.
+	points are only made inactive by the mask sources; a PEC or PMC point is not made inactive automatically because
+	curls of order 2 and higher reach off-axis points, so the curls deep inside a PEC/PMC body are not exactly 0
+*/
+#define MASK_ACTIVE   0
+#define MASK_PEC      1
+#define MASK_PMC      2
+#define MASK_INACTIVE 4
+#define MASK_MATERIAL (MASK_PEC | MASK_PMC)
+
+/*
+	a run of consecutive memory indexes [start, end) of the same kind
+*/
+typedef struct MaskRun{
+	size_t start;
+	size_t end;
+	unsigned char kind;
+}MaskRun;
+
+/*
+	abstract class for giving a material mask by space locations.
+	it should be implemented in a dynamic link library to be plugged into a simulation system at runtime,
+	the same way a FieldsInitializer is
+*/
+class MaterialMaskInitializer: public virtual MemoryManUser, public Plugin
+{
+public:
+	virtual int initialize(TaskFile *taskParameters) = 0;           //read back configurations from a task file
+	virtual unsigned char funcMask(double x, double y, double z) = 0; //MASK_ACTIVE, MASK_PEC, MASK_PMC or MASK_INACTIVE at the point
+};
+
+/*
+	a mask giving the kind of each space point, in the memory order of the fields.
+
+	it is formed from, in order, each later one overriding the earlier ones:
+	FDTD.MASK_FILE  - optional, a file of one byte per space point in the memory order of the fields, holding the values of MASK_ACTIVE, etc.
+	an initializer  - optional, a MaterialMaskInitializer plugin given by SIM.MASK_DLL and SIM.MASK_NAME
+	FDTD.MASK_BOXES - optional, boxes of grid indexes, "kind:m0,n0,p0,m1,n1,p1;...", kind is PEC, PMC or OFF (inactive).
+
+	the mask is compiled into runs of the points to be advanced and runs of the PEC/PMC points among them,
+	so that a sweep over the runs does not visit inactive points at all.
+*/
+class MaterialMask: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser, public virtual MemoryManUser
+{
+private:
+	int _pass;
+	bool _box;                  //true for a row-major box domain
+	int _rx, _ry, _rz;          //radius of each axis of the domain
+	double _ds;                 //space step, for forming locations given to the initializer
+	size_t _items;              //number of space points
+	unsigned char *_kinds;      //kind of each space point
+	size_t _maskedCount;        //number of points which are not MASK_ACTIVE
+	MaterialMaskInitializer *_initializer;
+	//
+	MaskRun *_runs;             //runs of points to be advanced, in memory order
+	size_t _runCount;
+	MaskRun *_constrained;      //runs of PEC/PMC points to be advanced, in memory order
+	size_t _constrainedCount;
+	//
+	int gothrough();
+	int readMaskFile(const char *file);
+	int applyBoxes(TaskFile *taskParameters, const char *boxes);
+	MaskRun *formRuns(bool constrained, size_t *count);
+	void cleanup();
+protected:
+	virtual void handleData(int m, int n, int p);
+public:
+	/*
+		items - number of space points; maxRx, maxRy, maxRz - radius of each axis; box - true for a row-major box domain
+	*/
+	MaterialMask(size_t items, int maxRx, int maxRy, int maxRz, bool box, double ds);
+	~MaterialMask();
+	/*
+		read the mask from the task file and the initializer, which can be NULL, and compile it
+	*/
+	int initialize(TaskFile *taskParameters, MaterialMaskInitializer *initializer);
+	//false if all the points are active; such a mask is not needed
+	bool IsUsed(){return _maskedCount > 0;}
+	const unsigned char *Kinds(){return _kinds;}
+	const MaskRun *Runs(){return _runs;}
+	size_t RunCount(){return _runCount;}
+	/*
+		set the held fields to 0: E at PEC points, H at PMC points and both at inactive points.
+		it is called after the fields are populated
+	*/
+	void ApplyToFields(FieldPoint3D *fields);
+	/*
+		set the held components of a curl estimation of an order to 0 at PEC/PMC points.
+		an even order applies curls.E to E and curls.H to H, an odd order applies curls.H to E and curls.E to H
+	*/
+	void ConstrainCurls(FieldPoint3D *curls, int order);
+	/*
+		set curls at inactive points to 0. a curl estimator skipping inactive points calls it once for its curl memory
+	*/
+	void ClearInactive(FieldPoint3D *curls);
+};
+
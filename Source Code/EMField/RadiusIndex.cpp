@@ -31,14 +31,32 @@ size_t ***Allocate3DIntegerArray(int n)
 	return a;
 }
 
+size_t ***Allocate3DIntegerArray(int nx, int ny, int nz)
+{
+	size_t ***a = new size_t **[nx]();
+	for(int i=0;i<nx;i++)
+	{
+		a[i] = new size_t *[ny]();
+		for(int j=0;j<ny;j++)
+		{
+			a[i][j] = new size_t[nz]();
+		}
+	}
+	return a;
+}
+
 /*
 	free a 3D integer array which was allocated by Allocate3DIntegerArray
 */
 void Free3DIntegerArray(size_t ***a, int n)
 {
-	for(int i=0;i<n;i++)
+	Free3DIntegerArray(a, n, n);
+}
+void Free3DIntegerArray(size_t ***a, int nx, int ny)
+{
+	for(int i=0;i<nx;i++)
 	{
-		for(int j=0;j<n;j++)
+		for(int j=0;j<ny;j++)
 		{
 			delete[] a[i][j];
 		}
@@ -1106,6 +1124,7 @@ int GoThroughSphereByIndexes::gothroughSphere(int maxR)
 	ret = ERR_OK;
 	index = 0;
 	maxRadius = maxR;
+	maxRadiusX = maxRadiusY = maxRadiusZ = maxR;
 	int j,k;
 		int r;
 		RadiusHandleType rht;
@@ -1784,6 +1803,220 @@ int GoThroughSphereBySpaces::gothroughSphere(int maxR, double ds)
 	return ret;
 }
 
+/////////rectangular box/////////////////////////////////////////////////////////////////////////////////////
+/*
+	remember the max radius of each axis of a rectangular box
+*/
+void GoThroughSphereByIndexes::setBoxRadius(int maxRx, int maxRy, int maxRz)
+{
+	maxRadiusX = maxRx;
+	maxRadiusY = maxRy;
+	maxRadiusZ = maxRz;
+	maxRadius = maxRx;
+	if(maxRy > maxRadius) maxRadius = maxRy;
+	if(maxRz > maxRadius) maxRadius = maxRz;
+}
+
+/*
+	m = -maxRx, ..., maxRx
+	  n = -maxRy, ..., maxRy
+	    p = -maxRz, ..., maxRz
+	the visiting order is the memory order of a row-major box field,
+	so, handleData can use its index counting as memory index
+*/
+int GoThroughSphereByIndexes::gothroughBox(int maxRx, int maxRy, int maxRz)
+{
+	int m,n,p;
+	int rm, rmn;
+	ret = ERR_OK;
+	index = 0;
+	setBoxRadius(maxRx, maxRy, maxRz);
+	for(m=-maxRx;m<=maxRx;m++)
+	{
+		rm = (m < 0)?-m:m;
+		for(n=-maxRy;n<=maxRy;n++)
+		{
+			rmn = (n < 0)?-n:n;
+			if(rm > rmn) rmn = rm;
+			for(p=-maxRz;p<=maxRz;p++)
+			{
+				r = (p < 0)?-p:p;
+				if(rmn > r) r = rmn;
+				handleData(m, n, p);
+			}
+			if(ret != ERR_OK)
+			{
+				return ret;
+			}
+		}
+	}
+	onFinish();
+	return ret;
+}
+
+/*
+	go through the points at the 6 faces of a box, each face is thickness deep.
+	a point shared by more than one face is visited once.
+	the number of visited points is proportional to face areas, not to box volume
+*/
+int GoThroughSphereByIndexes::gothroughBoxFaces(int maxRx, int maxRy, int maxRz, int thickness)
+{
+	int m,n,p;
+	int rm, rmn;
+	bool onX, onXY;
+	int innerX = maxRx - thickness; //|m| > innerX: at x faces
+	int innerY = maxRy - thickness;
+	int innerZ = maxRz - thickness;
+	ret = ERR_OK;
+	index = 0;
+	setBoxRadius(maxRx, maxRy, maxRz);
+	for(m=-maxRx;m<=maxRx;m++)
+	{
+		rm = (m < 0)?-m:m;
+		onX = (rm > innerX);
+		for(n=-maxRy;n<=maxRy;n++)
+		{
+			rmn = (n < 0)?-n:n;
+			onXY = onX || (rmn > innerY);
+			if(rm > rmn) rmn = rm;
+			if(onXY)
+			{
+				//the whole p line is at an x face or a y face
+				for(p=-maxRz;p<=maxRz;p++)
+				{
+					r = (p < 0)?-p:p;
+					if(rmn > r) r = rmn;
+					handleData(m, n, p);
+				}
+			}
+			else
+			{
+				//only the two ends of the p line are at z faces
+				for(p=-maxRz;p<=maxRz;p++)
+				{
+					if(innerZ >= 0 && p == -innerZ)
+					{
+						//skip the inner part
+						p = innerZ;
+						continue;
+					}
+					r = (p < 0)?-p:p;
+					if(rmn > r) r = rmn;
+					handleData(m, n, p);
+				}
+			}
+			if(ret != ERR_OK)
+			{
+				return ret;
+			}
+		}
+	}
+	onFinish();
+	return ret;
+}
+
+/*
+	radius = 0, 1, 2, ..., max(maxRx,maxRy,maxRz)
+	for each radius, go through the points of the radius which are inside the box.
+	it is for a handler which only works on a few radius, i.e. a field source, 
+	so that a box is visited in the same radius order as a sphere
+*/
+int GoThroughSphereByIndexes::gothroughSphereInBox(int maxRx, int maxRy, int maxRz)
+{
+	int m,n,p;
+	int mm, nn, pm;
+	int rm, rmn;
+	RadiusHandleType rht;
+	ret = ERR_OK;
+	index = 0;
+	setBoxRadius(maxRx, maxRy, maxRz);
+	for(int radius=0;radius<=maxRadius;radius++)
+	{
+		rht = setRadius(radius);
+		if(rht == DoNotProcess)
+		{
+			continue;
+		}
+		else if(rht == Finish)
+		{
+			break;
+		}
+		r = radius;
+		//clip the radius by the box
+		mm = (radius < maxRx)?radius:maxRx;
+		nn = (radius < maxRy)?radius:maxRy;
+		pm = (radius < maxRz)?radius:maxRz;
+		for(m=-mm;m<=mm;m++)
+		{
+			rm = (m < 0)?-m:m;
+			for(n=-nn;n<=nn;n++)
+			{
+				rmn = (n < 0)?-n:n;
+				if(rm > rmn) rmn = rm;
+				if(rmn == radius)
+				{
+					//(m,n) is on the radius, the whole p line belongs to the radius
+					for(p=-pm;p<=pm;p++)
+					{
+						handleData(m, n, p);
+					}
+				}
+				else if(radius <= maxRz)
+				{
+					//only p=-radius and p=radius belong to the radius
+					handleData(m, n, -radius);
+					handleData(m, n, radius);
+				}
+			}
+		}
+		if(ret != ERR_OK || rht == ProcessAndFinish)
+		{
+			break;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		onFinish();
+	}
+	return ret;
+}
+
+/*
+	x = m*ds, y = n*ds, z = p*ds
+	the visiting order is the memory order of a row-major box field
+*/
+int GoThroughSphereBySpaces::gothroughBox(int maxRx, int maxRy, int maxRz, double ds)
+{
+	int m,n,p;
+	int rm, rmn;
+	double x, y;
+	ret = ERR_OK;
+	index = 0;
+	for(m=-maxRx;m<=maxRx;m++)
+	{
+		rm = (m < 0)?-m:m;
+		x = (double)m * ds;
+		for(n=-maxRy;n<=maxRy;n++)
+		{
+			rmn = (n < 0)?-n:n;
+			if(rm > rmn) rmn = rm;
+			y = (double)n * ds;
+			for(p=-maxRz;p<=maxRz;p++)
+			{
+				r = (p < 0)?-p:p;
+				if(rmn > r) r = rmn;
+				handleData(x, y, (double)p * ds);
+			}
+			if(ret != ERR_OK)
+			{
+				return ret;
+			}
+		}
+	}
+	onFinish();
+	return ret;
+}
+
 /////////RadiusIndexToSeriesIndex////////////////////////////////////////////////////////////////////////////
 /*
 	when the maximum radius is known, (m,n,p)->series index can be put into a 3D array for quick access
@@ -1805,7 +2038,7 @@ void RadiusIndexToSeriesIndex::cleanup()
 {
 	if(seriesIndex != NULL)
 	{
-		Free3DIntegerArray(seriesIndex, 2*maxRadius + 1);
+		Free3DIntegerArray(seriesIndex, 2*maxRadiusX + 1, 2*maxRadiusY + 1);
 		seriesIndex = NULL;
 	}
 }
@@ -1815,17 +2048,14 @@ void RadiusIndexToSeriesIndex::cleanup()
 */
 int RadiusIndexToSeriesIndex::initialize(int maxR)
 {
-	if(maxRadius != maxR)
+	if(maxRadiusX != maxR || maxRadiusY != maxR || maxRadiusZ != maxR)
 	{
-		if(seriesIndex != NULL)
-		{
-			Free3DIntegerArray(seriesIndex, 2*maxRadius + 1);
-			seriesIndex = NULL;
-		}
+		cleanup();
 	}
 	if(seriesIndex == NULL)
 	{
 		maxRadius = maxR;
+		maxRadiusX = maxRadiusY = maxRadiusZ = maxR;
 		seriesIndex = Allocate3DIntegerArray(2*maxR+1);
 		if(seriesIndex == NULL)
 		{
@@ -1841,12 +2071,39 @@ int RadiusIndexToSeriesIndex::initialize(int maxR)
 	return ret;
 }
 
+/*
+	allocate memory and hold (m,n,p) to row-major memory index mapping of a box
+*/
+int RadiusIndexToSeriesIndex::initializeBox(int maxRx, int maxRy, int maxRz)
+{
+	if(maxRadiusX != maxRx || maxRadiusY != maxRy || maxRadiusZ != maxRz)
+	{
+		cleanup();
+	}
+	if(seriesIndex == NULL)
+	{
+		setBoxRadius(maxRx, maxRy, maxRz);
+		seriesIndex = Allocate3DIntegerArray(2*maxRx+1, 2*maxRy+1, 2*maxRz+1);
+		if(seriesIndex == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			//handleData(m,n,p) will be called for each point in row-major order
+			index = 0;
+			ret = gothroughBox(maxRx, maxRy, maxRz);
+		}
+	}
+	return ret;
+}
+
 /*
 	remember series index for each combination of (mn,n,p)
 */
 void RadiusIndexToSeriesIndex::handleData(int m, int n, int p)
 {
-	seriesIndex[CUBICINDEX(m)][CUBICINDEX(n)][CUBICINDEX(p)] = index;
+	seriesIndex[m+maxRadiusX][n+maxRadiusY][p+maxRadiusZ] = index;
 	index ++;
 }
 
@@ -1855,7 +2112,7 @@ void RadiusIndexToSeriesIndex::handleData(int m, int n, int p)
 */
 size_t RadiusIndexToSeriesIndex::Index(int m, int n, int p)
 {
-	return seriesIndex[CUBICINDEX(m)][CUBICINDEX(n)][CUBICINDEX(p)];
+	return seriesIndex[m+maxRadiusX][n+maxRadiusY][p+maxRadiusZ];
 }
 
 /*
@@ -34,17 +34,24 @@
 //one side of axis, therefore, the size of space interval is the range divided by 2*i_N+1
 #define SPACESTEP(range, i_N) ((range) / (2.0 * (double)(i_N)+1.0))
 
+//total space points in a rectangular box of per-axis max radius rx, ry and rz.
+//a box is used when the task file gives different numbers of space intervals for the 3 axes;
+//its fields are stored in row-major order, not by radius indexing
+#define BOXPOINTS(rx, ry, rz) ((size_t)(2*(rx)+1) * (size_t)(2*(ry)+1) * (size_t)(2*(rz)+1))
+
 /*
 	Allocate memory for a 3D integer array.
 	it can be used for storing series indexes for a 3D radius index.
 	After using the array, it should be freed by Free3DIntegerArray()
 */
 size_t ***Allocate3DIntegerArray(int n);
+size_t ***Allocate3DIntegerArray(int nx, int ny, int nz);
 
 /*
 	free a 3D integer array which was allocated by Allocate3DIntegerArray
 */
 void Free3DIntegerArray(size_t ***a, int n);
+void Free3DIntegerArray(size_t ***a, int nx, int ny);
 
 /*
 	*p is a cubic root of p3, return value is ERR_OK.
@@ -110,15 +117,33 @@ protected:
 	int r;
 	size_t index;
 	int maxRadius;
+	int maxRadiusX, maxRadiusY, maxRadiusZ; //max radius of each axis; all equal to maxRadius when going through a sphere
 	virtual RadiusHandleType setRadius(int radius){r = radius; return NeedProcess;}
 	virtual void handleData(int m, int n, int p)=0;
 	virtual void onFinish(){}
 	
 public:
-	GoThroughSphereByIndexes(void){ret = ERR_OK; index = 0;}
+	GoThroughSphereByIndexes(void){ret = ERR_OK; index = 0; maxRadius = maxRadiusX = maxRadiusY = maxRadiusZ = 0;}
 	int GetLastHandlerError(){return ret;}
 	size_t getCurrentIndex(){return index;}
+	void setBoxRadius(int maxRx, int maxRy, int maxRz);
 	int gothroughSphere(int maxR);
+	/*
+		go through a rectangular box, m=0,+-1,...,+-maxRx; n=0,+-1,...,+-maxRy; p=0,+-1,...,+-maxRz.
+		points are visited in row-major order (p changes fastest) so that a handler counting index
+		gets the memory index of a box field. setRadius is not called; r is max(|m|,|n|,|p|) of each point.
+	*/
+	int gothroughBox(int maxRx, int maxRy, int maxRz);
+	/*
+		go through only those points of a box which are within thickness of a box face.
+		index is not counted; a handler uses SINDEX to get memory index.
+	*/
+	int gothroughBoxFaces(int maxRx, int maxRy, int maxRz, int thickness);
+	/*
+		go through a box radius by radius, the same way gothroughSphere does, but a radius
+		is clipped by the box; setRadius is called for each radius. a handler uses SINDEX to get memory index.
+	*/
+	int gothroughSphereInBox(int maxRx, int maxRy, int maxRz);
 };
 /*
 	go through space points by point location x,y,z
@@ -139,6 +164,10 @@ public:
 	int GetLastHandlerError(){return ret;}
 	size_t getCurrentIndex(){return index;}
 	int gothroughSphere(int maxR, double ds);
+	/*
+		go through a rectangular box in row-major order, see GoThroughSphereByIndexes::gothroughBox
+	*/
+	int gothroughBox(int maxRx, int maxRy, int maxRz, double ds);
 };
 
 /*
@@ -171,6 +200,14 @@ public:
 	RadiusIndexToSeriesIndex(void);
 	~RadiusIndexToSeriesIndex();
 	int initialize(int maxR);
+	/*
+		map (m,n,p) to the memory index of a row-major box field
+	*/
+	int initializeBox(int maxRx, int maxRy, int maxRz);
+	bool IsBox(){return !(maxRadiusX == maxRadiusY && maxRadiusY == maxRadiusZ);}
+	int getMaxRadiusX(){return maxRadiusX;}
+	int getMaxRadiusY(){return maxRadiusY;}
+	int getMaxRadiusZ(){return maxRadiusZ;}
 	size_t Index(int m, int n, int p);
 	size_t CubicIndex(int i, int j, int k);
 	void cleanup();
@@ -6,13 +6,36 @@
 ********************************************************************/
 
 #include "TotalFieldScatteredFieldBoundary.h"
+#include <malloc.h>
 
 TotalFieldScatteredFieldBoundary::TotalFieldScatteredFieldBoundary(void)
 {
 	gridSize = 0;
 	maxRadius = 0;
+	maxRadiusX = maxRadiusY = maxRadiusZ = 0;
+	gridSizeX = gridSizeY = gridSizeZ = 0;
+	_boxSet = false;
 	firstX = firstY = firstZ = lastX = lastY = lastZ = 0;
 	_fields = NULL;
+	for(int a=0;a<3;a++)
+	{
+		_faceFirst[a] = 0;
+		_faceLast[a] = -1;
+	}
+	for(int f=0;f<6;f++)
+	{
+		for(int l=0;l<4;l++)
+		{
+			_faceLines[f][l] = NULL;
+		}
+		_faceExists[f] = false;
+	}
+	_faceWork = NULL;
+}
+
+TotalFieldScatteredFieldBoundary::~TotalFieldScatteredFieldBoundary(void)
+{
+	freeFaceFields();
 }
 
 int TotalFieldScatteredFieldBoundary::initialize(double Courant, int maximumRadius, TaskFile *taskParameters)
@@ -21,6 +44,15 @@ int TotalFieldScatteredFieldBoundary::initialize(double Courant, int maximumRadi
 	Cdtds = Courant;
 	maxRadius = maximumRadius;
 	gridSize = 2 * maxRadius + 1;
+	if(!_boxSet)
+	{
+		//not a box; a box of an earlier initialize is not kept
+		maxRadiusX = maxRadiusY = maxRadiusZ = maxRadius;
+	}
+	_boxSet = false;
+	gridSizeX = 2 * maxRadiusX + 1;
+	gridSizeY = 2 * maxRadiusY + 1;
+	gridSizeZ = 2 * maxRadiusZ + 1;
 	firstX = taskParameters->getInt("TFSF.firstX", false);
 	firstY = taskParameters->getInt("TFSF.firstY", false);
 	firstZ = taskParameters->getInt("TFSF.firstZ", false);
@@ -28,9 +60,255 @@ int TotalFieldScatteredFieldBoundary::initialize(double Courant, int maximumRadi
 	lastY = taskParameters->getInt("TFSF.lastY", false);
 	lastZ = taskParameters->getInt("TFSF.lastZ", false);
 	ret = taskParameters->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		ret = allocateFaceFields();
+	}
+	return ret;
+}
+
+/*
+	remember the maximum radius of each axis of a rectangular box
+*/
+void TotalFieldScatteredFieldBoundary::setBoxRadius(int maxRx, int maxRy, int maxRz)
+{
+	maxRadiusX = maxRx;
+	maxRadiusY = maxRy;
+	maxRadiusZ = maxRz;
+	_boxSet = true;
+}
+
+void TotalFieldScatteredFieldBoundary::freeFaceFields()
+{
+	for(int f=0;f<6;f++)
+	{
+		for(int l=0;l<4;l++)
+		{
+			if(_faceLines[f][l] != NULL)
+			{
+				free(_faceLines[f][l]);
+				_faceLines[f][l] = NULL;
+			}
+		}
+		_faceExists[f] = false;
+	}
+	if(_faceWork != NULL)
+	{
+		free(_faceWork);
+		_faceWork = NULL;
+	}
+}
+
+/*
+	a face exists if the TF region does not reach the domain boundary at its side, and the clipped TF region is not empty
+*/
+int TotalFieldScatteredFieldBoundary::allocateFaceFields()
+{
+	int ret = ERR_OK;
+	int first[3], last[3], size[3];
+	bool empty = false;
+	size_t points;
+	freeFaceFields();
+	first[0] = firstX; first[1] = firstY; first[2] = firstZ;
+	last[0] = lastX; last[1] = lastY; last[2] = lastZ;
+	size[0] = gridSizeX; size[1] = gridSizeY; size[2] = gridSizeZ;
+	for(int a=0;a<3;a++)
+	{
+		_faceFirst[a] = (first[a] < 0)?0:first[a];
+		_faceLast[a] = (last[a] > size[a] - 1)?size[a] - 1:last[a];
+		if(_faceFirst[a] > _faceLast[a])
+		{
+			empty = true;
+		}
+	}
+	if(!empty)
+	{
+		//lines are along y or z
+		points = (size_t)(_faceLast[2] - _faceFirst[2] + 1);
+		if((size_t)(_faceLast[1] - _faceFirst[1] + 1) > points)
+		{
+			points = (size_t)(_faceLast[1] - _faceFirst[1] + 1);
+		}
+		_faceWork = (FieldPoint3D *)malloc(points * sizeof(FieldPoint3D));
+		if(_faceWork == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		for(int f=0;f<6 && ret == ERR_OK;f++)
+		{
+			int a = f / 2;
+			if(f % 2 == 0)
+			{
+				_faceExists[f] = (first[a] >= 1 && first[a] <= size[a] - 1);
+			}
+			else
+			{
+				_faceExists[f] = (last[a] >= 0 && last[a] + 1 <= size[a] - 1);
+			}
+			if(_faceExists[f])
+			{
+				points = 1;
+				for(int b=0;b<3;b++)
+				{
+					if(b != a)
+					{
+						points *= (size_t)(_faceLast[b] - _faceFirst[b] + 1);
+					}
+				}
+				for(int l=0;l<4;l++)
+				{
+					_faceLines[f][l] = (double *)malloc(points * sizeof(double));
+					if(_faceLines[f][l] == NULL)
+					{
+						ret = ERR_OUTOFMEMORY;
+						break;
+					}
+				}
+			}
+		}
+	}
 	return ret;
 }
 
+/*
+	first - 1 at faces x0, y0 and z0; last at faces x1, y1 and z1
+*/
+int TotalFieldScatteredFieldBoundary::GetFaceLow(int face)
+{
+	int a = face / 2;
+	if(face % 2 == 0)
+	{
+		return ((a == 0)?firstX:((a == 1)?firstY:firstZ)) - 1;
+	}
+	return (a == 0)?lastX:((a == 1)?lastY:lastZ);
+}
+
+int TotalFieldScatteredFieldBoundary::getIncidentLine(double x, double y, double z, int axis, int count, double t, FieldPoint3D *f)
+{
+	int ret = ERR_OK;
+	for(int s=0;s<count && ret == ERR_OK;s++)
+	{
+		ret = getIncidentFieldAt(x + ((axis == 0)?s:0), y + ((axis == 1)?s:0), z + ((axis == 2)?s:0), t, f + s);
+	}
+	return ret;
+}
+
+int TotalFieldScatteredFieldBoundary::formFaceFields(double tE, double tH)
+{
+	int ret = ERR_OK;
+	int h, e;
+	double sign;
+	double c[3];
+	for(int f=0;f<6 && ret == ERR_OK;f++)
+	{
+		if(!_faceExists[f])
+		{
+			continue;
+		}
+		int a = f / 2;
+		int u = (a == 0)?1:0; //axis of the lines
+		int v = (a == 2)?1:2; //axis along a line
+		int count = _faceLast[v] - _faceFirst[v] + 1;
+		int lo = GetFaceLow(f);
+		for(int term=0;term<2 && ret == ERR_OK;term++)
+		{
+			FaceTerm(a, term, &h, &e, &sign);
+			for(int l=_faceFirst[u];l<=_faceLast[u] && ret == ERR_OK;l++)
+			{
+				double *line;
+				size_t offset = (size_t)(l - _faceFirst[u]) * (size_t)count;
+				//E[e], read by H at the point with the smaller index, at the other point
+				c[a] = (double)(lo + 1);
+				c[u] = (double)l;
+				c[v] = (double)_faceFirst[v];
+				c[e] += 0.5;
+				ret = getIncidentLine(c[0] - maxRadiusX, c[1] - maxRadiusY, c[2] - maxRadiusZ, v, count, tE, _faceWork);
+				if(ret == ERR_OK)
+				{
+					line = _faceLines[f][term] + offset;
+					for(int s=0;s<count;s++)
+					{
+						line[s] = ((const double *)&(_faceWork[s]))[e];
+					}
+					//H[h], read by E at the point with the larger index, at the other point
+					c[a] = (double)lo;
+					c[u] = (double)l;
+					c[v] = (double)_faceFirst[v];
+					for(int b=0;b<3;b++)
+					{
+						if(b != h)
+						{
+							c[b] += 0.5;
+						}
+					}
+					ret = getIncidentLine(c[0] - maxRadiusX, c[1] - maxRadiusY, c[2] - maxRadiusZ, v, count, tH, _faceWork);
+				}
+				if(ret == ERR_OK)
+				{
+					line = _faceLines[f][2 + term] + offset;
+					for(int s=0;s<count;s++)
+					{
+						line[s] = ((const double *)&(_faceWork[s]))[3 + h];
+					}
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	the faces are done in the order x0, x1, y0, y1, z0, z1; a point at an edge of the TF region is corrected by 2 faces in this order
+*/
+void TotalFieldScatteredFieldBoundary::applyFaceFieldsH(FieldPoint3D *fields, double coef)
+{
+	applyFaceFields(fields, coef, true);
+}
+void TotalFieldScatteredFieldBoundary::applyFaceFieldsE(FieldPoint3D *fields, double coef)
+{
+	applyFaceFields(fields, coef, false);
+}
+void TotalFieldScatteredFieldBoundary::applyFaceFields(FieldPoint3D *fields, double coef, bool forH)
+{
+	int c[3];
+	int h, e;
+	double sign, s;
+	const double *line;
+	for(int f=0;f<6;f++)
+	{
+		if(!_faceExists[f])
+		{
+			continue;
+		}
+		int a = f / 2;
+		int u = (a == 0)?1:0;
+		int v = (a == 2)?1:2;
+		int count = _faceLast[v] - _faceFirst[v] + 1;
+		//H is corrected at the point with the smaller index, E at the other
+		c[a] = forH?GetFaceLow(f):GetFaceLow(f) + 1;
+		for(int term=0;term<2;term++)
+		{
+			FaceTerm(a, term, &h, &e, &sign);
+			s = (f % 2 == 0)?sign * coef:-sign * coef;
+			for(c[u]=_faceFirst[u];c[u]<=_faceLast[u];c[u]++)
+			{
+				line = GetFaceLine(f, forH, term) + (size_t)(c[u] - _faceFirst[u]) * (size_t)count;
+				for(c[v]=_faceFirst[v];c[v]<=_faceLast[v];c[v]++)
+				{
+					if(forH)
+					{
+						((double *)&(fields[CINDEX(c[0], c[1], c[2])]))[3 + h] += s * line[c[v] - _faceFirst[v]];
+					}
+					else
+					{
+						((double *)&(fields[CINDEX(c[0], c[1], c[2])]))[e] += s * line[c[v] - _faceFirst[v]];
+					}
+				}
+			}
+		}
+	}
+}
+
 /*
 	go through each TFSF boundary plane and call applyOnPlane?? for each space point
 	access EM fields by _fields[CINDEX(i,j,k)]
@@ -41,54 +319,54 @@ int TotalFieldScatteredFieldBoundary::applyTFSF(FieldPoint3D *fields)
 	_fields = fields;
 	//plane x0
 	//i = firstX;
-	for(j=0;j<gridSize;j++)
+	for(j=0;j<gridSizeY;j++)
 	{
-		for(k=0;k<gridSize;k++)
+		for(k=0;k<gridSizeZ;k++)
 		{
 			applyOnPlaneX0(j,k);
 		}
 	}
 	//plane x1
 	//i = lastX;
-	for(j=0;j<gridSize;j++)
+	for(j=0;j<gridSizeY;j++)
 	{
-		for(k=0;k<gridSize;k++)
+		for(k=0;k<gridSizeZ;k++)
 		{
 			applyOnPlaneX1(j,k);
 		}
 	}
 	//plane y0
 	//j = firstY;
-	for(i=0;i<gridSize;i++)
+	for(i=0;i<gridSizeX;i++)
 	{
-		for(k=0;k<gridSize;k++)
+		for(k=0;k<gridSizeZ;k++)
 		{
 			applyOnPlaneY0(i,k);
 		}
 	}
 	//plane y1
 	//j = lastY;
-	for(i=0;i<gridSize;i++)
+	for(i=0;i<gridSizeX;i++)
 	{
-		for(k=0;k<gridSize;k++)
+		for(k=0;k<gridSizeZ;k++)
 		{
 			applyOnPlaneY1(i,k);
 		}
 	}
 	//plane z0
 	//k = firstZ;
-	for(i=0;i<gridSize;i++)
+	for(i=0;i<gridSizeX;i++)
 	{
-		for(j=0;j<gridSize;j++)
+		for(j=0;j<gridSizeY;j++)
 		{
 			applyOnPlaneZ0(i,j);
 		}
 	}
 	//plane z1
 	//k = lastZ;
-	for(i=0;i<gridSize;i++)
+	for(i=0;i<gridSizeX;i++)
 	{
-		for(j=0;j<gridSize;j++)
+		for(j=0;j<gridSizeY;j++)
 		{
 			applyOnPlaneZ1(i,j);
 		}
@@ -96,3 +374,14 @@ int TotalFieldScatteredFieldBoundary::applyTFSF(FieldPoint3D *fields)
 	return ERR_OK;
 }
 
+/*
+	the total field region is firstX<=i<=lastX, firstY<=j<=lastY, firstZ<=k<=lastZ
+*/
+bool TotalFieldScatteredFieldBoundary::IsTotalField(int m, int n, int p)
+{
+	int i = m + maxRadiusX;
+	int j = n + maxRadiusY;
+	int k = p + maxRadiusZ;
+	return i >= firstX && i <= lastX && j >= firstY && j <= lastY && k >= firstZ && k <= lastZ;
+}
+
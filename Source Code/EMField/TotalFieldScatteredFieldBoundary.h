@@ -13,6 +13,14 @@
 #include "..\FileUtil\taskFile.h"
 #include "..\MemoryMan\MemoryManager.h"
 
+//faces of the TF region, see formFaceFields
+#define TFSF_FACE_X0 0
+#define TFSF_FACE_X1 1
+#define TFSF_FACE_Y0 2
+#define TFSF_FACE_Y1 3
+#define TFSF_FACE_Z0 4
+#define TFSF_FACE_Z1 5
+
 /*
 	abstract class for implementing Total Field/Scattered Field Boundary
 	A TF/SF boundary should be implemented in a dynamic link library 
@@ -25,31 +33,109 @@ protected:
 	FieldPoint3D *_fields; //fields to work on
 	int maxRadius; //maximum radius
 	int gridSize;  //number of space points on one axis, it is 2*maxRadius + 1
+	int maxRadiusX, maxRadiusY, maxRadiusZ; //maximum radius of each axis of a rectangular box, all equal maxRadius for a cube
+	int gridSizeX, gridSizeY, gridSizeZ;    //number of space points on each axis
+	bool _boxSet;                           //setBoxRadius is called for the next initialize
 	//TFSF boundary
 	int firstX, firstY, firstZ, // indices for first point in TF region
 		lastX, lastY, lastZ;    // indices for last point in TF region
 	//
+	//incident fields at the faces of the TF region, see formFaceFields
+	int _faceFirst[3], _faceLast[3]; //the TF region clipped by the domain, on each axis
+	double *_faceLines[6][4];        //for each face: E of term 0 and 1 of FaceTerm, used by H updates; H of term 0 and 1, used by E updates
+	bool _faceExists[6];
+	FieldPoint3D *_faceWork;         //incident fields of one line
+	int allocateFaceFields();
+	void freeFaceFields();
+	void applyFaceFields(FieldPoint3D *fields, double coef, bool forH);
+	//
 public:
 	TotalFieldScatteredFieldBoundary(void);
+	~TotalFieldScatteredFieldBoundary(void);
 	//
 	/*
 		initialize TF/SF boundary object
 		if a derived class overrides this function then it should call the base function first.
 		a derived class may define runtime parameters. each parameter appears in a task file as a line of name=value
 		in the derived function the parameter values are read back via taskParameters
+
+		for a rectangular box, call setBoxRadius(...) before calling initialize(...); without it initialize makes a cube
 	*/
 	virtual int initialize(double Courant, int maximumRadius, TaskFile *taskParameters);
+	void setBoxRadius(int maxRx, int maxRy, int maxRz);
 	virtual int applyTFSF(FieldPoint3D *fields);
 	//relationship of radius indexing m,n,p and cubic indexing i,j,k:
-	//i = m + gridSize; j = n + gridSize; k = p + gridSize
+	//i = m + maxRadiusX; j = n + maxRadiusY; k = p + maxRadiusZ
 	//m,n,p=0,+-1,+-2,...,+-maxRadius
 	//i,j,k=0,1,2,...,2*maxRadius, use _fields[CINDEX(i,j,k)] to access fields
+	//for a rectangular box, i<gridSizeX, j<gridSizeY, k<gridSizeZ
 	virtual void applyOnPlaneX0(int j, int k)=0;
 	virtual void applyOnPlaneX1(int j, int k)=0;
 	virtual void applyOnPlaneY0(int i, int k)=0;
 	virtual void applyOnPlaneY1(int i, int k)=0;
 	virtual void applyOnPlaneZ0(int i, int j)=0;
 	virtual void applyOnPlaneZ1(int i, int j)=0;
+	//
+	//whether (m,n,p) is inside the total field region
+	bool IsTotalField(int m, int n, int p);
+	/*
+		incident fields at radius index (m,n,p) and time t. t is in time steps, fields are in SI units.
+		a TSS FDTD module does not call applyTFSF; it uses incident fields to correct curl estimations across the TF/SF boundary.
+		a derived class overrides it to support TSS; the default returns ERR_TFSF_INCIDENT
+	*/
+	virtual int getIncidentField(int m, int n, int p, double t, FieldPoint3D *f){return ERR_TFSF_INCIDENT;}
+	/*
+		incident fields at location (x*ds, y*ds, z*ds) and time t; x, y and z are radius indexes which may be between grid points.
+		a Yee FDTD module uses it to get each field component at its own location. the default returns ERR_TFSF_INCIDENT
+	*/
+	virtual int getIncidentFieldAt(double x, double y, double z, double t, FieldPoint3D *f){return ERR_TFSF_INCIDENT;}
+	/*
+		incident fields of count locations starting at (x,y,z), one space step apart along axis (0: x, 1: y, 2: z), at time t.
+		the default calls getIncidentFieldAt for each location; a derived class overrides it to make a line at once
+	*/
+	virtual int getIncidentLine(double x, double y, double z, int axis, int count, double t, FieldPoint3D *f);
+	//
+	/*
+		incident fields for a Yee FDTD module, which corrects H and E at the faces of the TF region while it updates them,
+		instead of calling applyTFSF.
+		a face is formed by pairs of neighbouring points, one in the TF region and one in the SF region; e.g. face x0 is
+		the pairs (firstX-1,j,k) and (firstX,j,k), face x1 is (lastX,j,k) and (lastX+1,j,k), for the j and k of the TF region.
+		H at the point of a pair with the smaller index reads E at the other point, and E at the point with the larger index
+		reads H at the other point; each is corrected by the incident component it reads (see FaceTerm), taken at the Yee
+		location of the component: Ex at (i+1/2,j,k), Ey at (i,j+1/2,k), Ez at (i,j,k+1/2), Hx at (i,j+1/2,k+1/2),
+		Hy at (i+1/2,j,k+1/2), Hz at (i+1/2,j+1/2,k). E is taken at time tE and H at time tH.
+		a face is made of lines along z for x and y faces and along y for z faces; e.g. the value for (j,k) at face x0 is at
+		(j-getFaceFirst(1))*(getFaceLast(2)-getFaceFirst(2)+1)+(k-getFaceFirst(2)). a face at the domain boundary does not exist.
+		returns ERR_TFSF_INCIDENT if the derived class does not give incident fields
+	*/
+	int formFaceFields(double tE, double tH);
+	bool FaceExists(int face){return _faceExists[face];}
+	//incident values of a face for correcting H (forH is true) or E by term 0 or 1 of FaceTerm
+	const double *GetFaceLine(int face, bool forH, int term){return _faceLines[face][(forH?0:2) + term];}
+	//index of the point of a face pair with the smaller index, along the axis perpendicular to the face
+	int GetFaceLow(int face);
+	//first and last point index of the faces on an axis
+	int getFaceFirst(int axis){return _faceFirst[axis];}
+	int getFaceLast(int axis){return _faceLast[axis];}
+	/*
+		the 2 corrections of a face perpendicular to axis: H[h] += sign*coef*E[e] and E[e] += sign*coef*H[h],
+		h and e being components 0, 1, 2 for x, y, z, and E and H being incident fields of the face.
+		sign is for faces x0, y0 and z0; it is negated for faces x1, y1 and z1
+	*/
+	static void FaceTerm(int axis, int term, int *h, int *e, double *sign)
+	{
+		static const int terms[3][2][3] = {{{1,2,-1},{2,1,1}}, {{0,2,1},{2,0,-1}}, {{0,1,-1},{1,0,1}}};
+		*h = terms[axis][term][0];
+		*e = terms[axis][term][1];
+		*sign = (double)terms[axis][term][2];
+	}
+	/*
+		correct H, or E, at the faces by the fields of formFaceFields. fields are in the memory order of the index cache.
+		coef is (dt/ds)/mu0 for H and (dt/ds)/eps0 for E. call applyFaceFieldsH after H is updated and
+		applyFaceFieldsE after E is updated
+	*/
+	void applyFaceFieldsH(FieldPoint3D *fields, double coef);
+	void applyFaceFieldsE(FieldPoint3D *fields, double coef);
 };
 
 
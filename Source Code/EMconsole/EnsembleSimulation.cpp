@@ -0,0 +1,378 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\FileUtil\fileutil.h"
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\memman.h"
+#include "..\ProcessMonitor\ProcessMonitor.h"
+#include "EnsembleSimulation.h"
+#include "simConsole.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+
+//Ctrl-C handling is shared with FieldSimulation
+extern bool cancel_simulation_flag;
+extern "C" void signals_handler(int);
+
+EnsembleSimulation::EnsembleSimulation()
+{
+	seriesIndex = NULL;
+	maxRadius = 0;
+	fieldItems = 0;
+	maxTimeIndex = 0;
+	memberCount = 0;
+	reporter = NULL;
+	engine = NULL;
+	field0 = NULL;
+	source = NULL;
+	boundaryCondition = NULL;
+	for(unsigned b=0;b<MAX_ENSEMBLE_LANES;b++)
+	{
+		memberTasks[b] = NULL;
+		sources[b] = NULL;
+		boundaryConditions[b] = NULL;
+		baseNames[b] = NULL;
+	}
+}
+
+EnsembleSimulation::~EnsembleSimulation()
+{
+	cleanup();
+	if(seriesIndex != NULL)
+	{
+		delete seriesIndex;
+		seriesIndex = NULL;
+	}
+}
+
+void EnsembleSimulation::cleanup()
+{
+	if(engine != NULL)
+	{
+		engine->FinishSimulation();
+		delete engine;
+		engine = NULL;
+	}
+	for(unsigned b=0;b<MAX_ENSEMBLE_LANES;b++)
+	{
+		if(memberTasks[b] != NULL)
+		{
+			delete memberTasks[b];
+			memberTasks[b] = NULL;
+		}
+		if(baseNames[b] != NULL)
+		{
+			free(baseNames[b]);
+			baseNames[b] = NULL;
+		}
+		//plug-in objects are owned by their libraries
+		sources[b] = NULL;
+		boundaryConditions[b] = NULL;
+	}
+}
+
+/*
+	open the member task files listed by ENSEMBLE.TASKS, and form the data file names of the members having SIM.BASENAME
+*/
+int EnsembleSimulation::readMembers(TaskFile *taskConfig, const char *dataFolder)
+{
+	int ret = ERR_OK;
+	char name[FILENAME_MAX];
+	char path[FILENAME_MAX];
+	char *s = taskConfig->getString(TP_ENSEMBLE_TASKS, false);
+	ret = taskConfig->getErrorCode();
+	while(ret == ERR_OK && s != NULL && *s != 0)
+	{
+		size_t len = 0;
+		while(*s == ' ') s++;
+		while(*s != 0 && *s != ';' && len < FILENAME_MAX - 1)
+		{
+			name[len++] = *s++;
+		}
+		while(len > 0 && name[len-1] == ' ') len--;
+		name[len] = 0;
+		if(*s == ';') s++;
+		if(len == 0)
+		{
+			continue;
+		}
+		if(memberCount == MAX_ENSEMBLE_LANES)
+		{
+			taskConfig->setNameOfInvalidValue(TP_ENSEMBLE_TASKS);
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		memberTasks[memberCount] = new TaskFile(name);
+		ret = memberTasks[memberCount]->getErrorCode();
+		if(ret == ERR_OK)
+		{
+			char *basefile = memberTasks[memberCount]->getString(TP_SIMBASENAME, true);
+			if(basefile != NULL && strlen(basefile) > 0)
+			{
+				if(strcmp(basefile, "DEF") == 0)
+				{
+					ret = ERR_TP_BASENAME_DEF;
+				}
+				else
+				{
+					ret = formFilePath(path, FILENAME_MAX, dataFolder, basefile);
+					if(ret == ERR_OK)
+					{
+						baseNames[memberCount] = (wchar_t *)malloc(FILENAME_MAX * sizeof(wchar_t));
+						if(baseNames[memberCount] == NULL)
+						{
+							ret = ERR_OUTOFMEMORY;
+						}
+						else
+						{
+							ret = copyC2W(baseNames[memberCount], FILENAME_MAX, path);
+						}
+					}
+				}
+			}
+		}
+		if(ret != ERR_OK)
+		{
+			printf("\r\nInvalid ensemble member task file: %s\r\n", name);
+		}
+		memberCount++;
+	}
+	if(ret == ERR_OK && memberCount == 0)
+	{
+		taskConfig->setNameOfInvalidValue(TP_ENSEMBLE_TASKS);
+		ret = ERR_TASK_INVALID_VALUE;
+	}
+	return ret;
+}
+
+/*
+	the first member uses the plug-in objects given by the console; other members load their own
+*/
+int EnsembleSimulation::loadModules(TaskFile *taskConfig, char *libFolder)
+{
+	int ret = ERR_OK;
+	sources[0] = source;
+	boundaryConditions[0] = boundaryCondition;
+	for(unsigned b=1;b<memberCount && ret == ERR_OK;b++)
+	{
+		boundaryConditions[b] = (BoundaryCondition *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMBC_DLL, true), taskConfig->getString(TP_SIMBC_NAME, true), &ret);
+		if(source != NULL)
+		{
+			sources[b] = (FieldSource *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMFS_DLL, true), taskConfig->getString(TP_SIMFS_NAME, true), &ret);
+		}
+		if(ret == ERR_OK)
+		{
+			if(boundaryConditions[b] == NULL)
+			{
+				ret = ERR_SIM_BOUNDARY;
+			}
+			else if(source != NULL && sources[b] == NULL)
+			{
+				ret = ERR_SIM_FDTD;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	initialize the modules of member b by its task file, and put its initial fields into its lane
+*/
+int EnsembleSimulation::initMember(unsigned b, FieldPoint3D *work)
+{
+	int ret = ERR_OK;
+	TaskFile *task = memberTasks[b];
+	boundaryConditions[b]->SetMemoryManager(_mem);
+	boundaryConditions[b]->setIndexCache(seriesIndex);
+	ret = boundaryConditions[b]->initialize(engine->getCourantNumber(), maxRadius, task);
+	if(ret == ERR_OK && sources[b] != NULL)
+	{
+		sources[b]->SetMemoryManager(_mem);
+		sources[b]->setIndexCache(seriesIndex);
+		ret = sources[b]->initialize(engine->getCourantNumber(), maxRadius, task);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = field0->initialize(task);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = engine->PopulateFields(field0);
+	}
+	if(ret == ERR_OK)
+	{
+		engine->SetMemberFields(b, work);
+		if(baseNames[b] != NULL)
+		{
+			ret = saveFields(b, work, 0);
+		}
+	}
+	return ret;
+}
+
+int EnsembleSimulation::saveFields(unsigned b, FieldPoint3D *fields, size_t timeIndex)
+{
+	int ret = ERR_OK;
+	wchar_t fieldFile[FILENAME_MAX];
+	FieldPoint3D *p;
+	ret = formDataFileNameW(fieldFile, FILENAME_MAX, baseNames[b], timeIndex);
+	if(ret == ERR_OK)
+	{
+		p = (FieldPoint3D *)CreateFileIntoTaggedMemory(fieldFile, fieldItems * sizeof(FieldPoint3D), &ret, MEM_TAG_FIELDS);
+		if(ret == ERR_OK)
+		{
+			if(p == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+			else
+			{
+				for(size_t i=0;i<fieldItems;i++)
+				{
+					p[i] = fields[i];
+				}
+				FreeMemory(p);
+			}
+		}
+		else
+		{
+			RememberOSerror();
+		}
+	}
+	return ret;
+}
+
+int EnsembleSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFolder, char *libFolder)
+{
+	int ret = ERR_OK;
+	unsigned b;
+	FieldPoint3D *work = NULL;
+	unsigned long startTime, timeUsed;
+	if(field0 == NULL)
+	{
+		ret = ERR_SIM_FIELD0;
+	}
+	else if(boundaryCondition == NULL)
+	{
+		ret = ERR_SIM_BOUNDARY;
+	}
+	if(ret == ERR_OK)
+	{
+		unsigned nn, nx, ny, nz;
+		bool isBox;
+		ret = FDTD::ReadGridSize(taskConfig, &nn, &nx, &ny, &nz, &isBox);
+		if(ret == ERR_INVALID_SIZE)
+		{
+			ret = ERR_TP_INVALID_N;
+		}
+		if(ret == ERR_OK)
+		{
+			char *s = taskConfig->getString(TP_SIMTFSF_DLL, true);
+			if(isBox || (s != NULL && strlen(s) > 0))
+			{
+				ret = ERR_TSS_ENSEMBLE;
+			}
+			maxRadius = GRIDRADIUS(nn);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		maxTimeIndex = (size_t)taskConfig->getLong(TP_MAX_TIMESTEP, false);
+		ret = taskConfig->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		ret = readMembers(taskConfig, dataFolder);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = loadModules(taskConfig, libFolder);
+	}
+	if(ret == ERR_OK)
+	{
+		printf("\r\nStarting ensemble TSS simulation of %u members. Press Ctrl-C to stop. \r\n Initialize ...\r\n", memberCount);
+		cancel_simulation_flag = false;
+		signal(SIGINT, &signals_handler);
+		seriesIndex = new RadiusIndexToSeriesIndex();
+		ret = seriesIndex->initialize(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		engine = new TssEnsemble();
+		engine->SetMemoryManager(_mem);
+		engine->setIndexCache(seriesIndex);
+		ret = engine->SetLaneCount(memberCount);
+		if(ret == ERR_OK)
+		{
+			//fields are saved to files by members
+			ret = engine->initialize(NULL, NULL, taskConfig);
+		}
+		if(ret == ERR_OK && engine->GetStepsPerMove() != 1)
+		{
+			//the members apply their sources and boundary conditions at every time step
+			ret = ERR_EMF_TIME_BLOCK;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//the fields of one member are worked on in the field memory of the engine
+		fieldItems = engine->GetMemoryItemCount();
+		work = engine->GetFieldMemory();
+		for(b=0;b<memberCount && ret == ERR_OK;b++)
+		{
+			ret = initMember(b, work);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		startTime = GetTimeTick();
+		for(size_t n=1;n<=maxTimeIndex && ret == ERR_OK;n++)
+		{
+			ret = engine->moveForward();
+			for(b=0;b<memberCount && ret == ERR_OK;b++)
+			{
+				engine->GetMemberFields(b, work);
+				if(sources[b] != NULL)
+				{
+					sources[b]->reset(work, engine->GetTimeStepIndex(), engine->getTime());
+					ret = sources[b]->gothroughSphere(maxRadius);
+				}
+				if(ret == ERR_OK)
+				{
+					boundaryConditions[b]->setFields(work);
+					ret = boundaryConditions[b]->gothroughSphere(maxRadius);
+				}
+				if(ret == ERR_OK)
+				{
+					engine->SetMemberFields(b, work);
+					if(baseNames[b] != NULL)
+					{
+						ret = saveFields(b, work, n);
+					}
+				}
+			}
+			if(ret == ERR_OK)
+			{
+				reportProcess(reporter, true, "Reached time index: %d", n);
+				if(cancel_simulation_flag) //user terminates simulation
+				{
+					ret = ERR_SIMULATION_CANCEL;
+				}
+			}
+		}
+		timeUsed = GetTimeTick() - startTime;
+		if(ret == ERR_OK)
+		{
+			printf("\r\n%u members finished in %d ms, %g ms per member\r\n", memberCount, timeUsed, (double)timeUsed / (double)memberCount);
+		}
+	}
+	cleanup();
+	return ret;
+}
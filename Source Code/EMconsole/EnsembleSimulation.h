@@ -0,0 +1,66 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FieldSource.h"
+#include "..\EMField\BoundaryCondition.h"
+#include "..\ProcessMonitor\workProcess.h"
+#include "..\FileUtil\taskFile.h"
+#include "..\TssInSphere\TssEnsemble.h"
+#include "FieldSimulation.h"
+
+/*
+	an ensemble of TSS simulations on the same grid, advanced together by TssEnsemble.
+
+	the task file gives the grid, estimation orders and time steps as for task 100; the FDTD module is always TssEnsemble.
+	task parameter ENSEMBLE.TASKS lists the task files of the members, "file1;file2;...", up to MAX_ENSEMBLE_LANES.
+	a member task file provides the task parameters of the member's initial fields, field source and boundary condition,
+	i.e. IV.MAGNITUDE or FS.PPW; the modules themselves are given by SIM.IV_DLL, SIM.BC_DLL, SIM.FS_DLL, etc. of the task file.
+	if a member task file has SIM.BASENAME then the fields of the member are saved to {SIM.BASENAME}{n}.em in the data folder
+	at each time step, as task 100 does; "DEF" cannot be used.
+
+	each member has its own boundary condition and field source objects, so modules keeping states (i.e. AbcFirstOrder) work.
+	after each time step the fields of a member are copied out of the ensemble for its field source, boundary condition
+	and data file, and copied back.
+*/
+class EnsembleSimulation:public virtual RadiusIndexCacheUser
+{
+private:
+	int maxRadius;
+	size_t fieldItems;
+	size_t maxTimeIndex;
+	unsigned memberCount;
+	fnProgressReport reporter;
+	//
+	TssEnsemble *engine;
+	FieldsInitializer *field0;
+	FieldSource *source;                  //source of the first member; NULL if not used
+	BoundaryCondition *boundaryCondition; //boundary condition of the first member
+	//
+	TaskFile *memberTasks[MAX_ENSEMBLE_LANES];
+	FieldSource *sources[MAX_ENSEMBLE_LANES];
+	BoundaryCondition *boundaryConditions[MAX_ENSEMBLE_LANES];
+	wchar_t *baseNames[MAX_ENSEMBLE_LANES]; //NULL if the member does not save data files
+	//
+	int readMembers(TaskFile *taskConfig, const char *dataFolder);
+	int loadModules(TaskFile *taskConfig, char *libFolder);
+	int initMember(unsigned b, FieldPoint3D *work);
+	int saveFields(unsigned b, FieldPoint3D *fields, size_t timeIndex);
+	void cleanup();
+public:
+	EnsembleSimulation();
+	~EnsembleSimulation();
+	void setReporter(fnProgressReport rep){reporter = rep;}
+	void setFieldInitializer(FieldsInitializer *obj){field0 = obj;}
+	void setFieldSource(FieldSource *obj){source = obj;}
+	void setBoundaryCondition(BoundaryCondition *obj){boundaryCondition = obj;}
+	/*
+		run all the members and save fields of the members having SIM.BASENAME to data files
+	*/
+	int simulationToFiles(TaskFile *taskConfig, const char *dataFolder, char *libFolder);
+};
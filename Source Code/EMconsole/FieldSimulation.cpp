@@ -11,6 +11,7 @@
 #include "..\MemoryMan\memman.h"
 #include "..\ProcessMonitor\ProcessMonitor.h"
 #include "FieldSimulation.h"
+#include "SubgridPatch.h"
 #include "simConsole.h"
 #include "..\TssInSphere\FieldAnalysor.h"
 
@@ -41,7 +42,10 @@ FieldSimulation::FieldSimulation()
 	source = NULL;
 	boundaryCondition = NULL;
 	tfsf = NULL;
+	patch = NULL;
 	seriesIndex = NULL;
+	isBox = false;
+	maxRadiusX = maxRadiusY = maxRadiusZ = 0;
 }
 
 FieldSimulation::~FieldSimulation()
@@ -106,27 +110,44 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 	}
 	if(ret == ERR_OK)
 	{
-		N = taskConfig->getInt(TP_FDTDN, false);
+		unsigned n, nx, ny, nz;
+		ret = FDTD::ReadGridSize(taskConfig, &n, &nx, &ny, &nz, &isBox);
 		range = taskConfig->getDouble(TP_FDTDR, false);
-		ret = taskConfig->getErrorCode();
 		if(ret == ERR_OK)
 		{
-			if(N <= 0)
-			{
-				ret = ERR_TP_INVALID_N;
-			}
-			else if(range <= 0.0)
+			ret = taskConfig->getErrorCode();
+		}
+		else if(ret == ERR_INVALID_SIZE)
+		{
+			ret = ERR_TP_INVALID_N;
+		}
+		if(ret == ERR_OK)
+		{
+			N = (int)n;
+			if(range <= 0.0)
 			{
 				ret = ERR_TP_INVALID_R;
 			}
 		}
 		if(ret == ERR_OK)
 		{
-			maxRadius = GRIDRADIUS(N);
+			maxRadiusX = GRIDRADIUS(nx);
+			maxRadiusY = GRIDRADIUS(ny);
+			maxRadiusZ = GRIDRADIUS(nz);
+			maxRadius = maxRadiusX;
+			if(maxRadiusY > maxRadius) maxRadius = maxRadiusY;
+			if(maxRadiusZ > maxRadius) maxRadius = maxRadiusZ;
 			minimumStepTime = UINT_MAX;
 			averageStepTime = 0.0;
 			timeStepCount = 0;
-			datapoints = totalPointsInSphere(maxRadius);
+			if(isBox)
+			{
+				datapoints = BOXPOINTS(maxRadiusX, maxRadiusY, maxRadiusZ);
+			}
+			else
+			{
+				datapoints = totalPointsInSphere(maxRadius);
+			}
 			//
 			puts("\r\nStarting FDTD simulation. Press Ctrl-C to stop. \r\n Initialize and prepare fields at time 0 ...\r\n");
 			startTime = GetTimeTick();
@@ -136,7 +157,14 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 			//
 			//create a index converter for quick accessing fields
 			seriesIndex = new RadiusIndexToSeriesIndex();
-			ret = seriesIndex->initialize(maxRadius);
+			if(isBox)
+			{
+				ret = seriesIndex->initializeBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+			}
+			else
+			{
+				ret = seriesIndex->initialize(maxRadius);
+			}
 			//
 			if(ret == ERR_OK)
 			{
@@ -146,6 +174,22 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 				{
 					tfsf->setIndexCache(seriesIndex);
 				}
+				if(source != NULL)
+				{
+					source->setIndexCache(seriesIndex);
+				}
+				if(patch != NULL)
+				{
+					patch->setIndexCache(seriesIndex);
+				}
+				if(isBox)
+				{
+					boundaryCondition->setBoxRadius(maxRadiusX, maxRadiusY, maxRadiusZ);
+					if(tfsf != NULL)
+					{
+						tfsf->setBoxRadius(maxRadiusX, maxRadiusY, maxRadiusZ);
+					}
+				}
 				//initialize plug-in objects
 				ret = field0->initialize(taskConfig);
 			}
@@ -154,6 +198,14 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 				if(ret == ERR_OK)
 				{
 					ret = fdtd->initialize(dataFolder, tfsf, taskConfig);
+					if(ret == ERR_OK && fdtd->GetStepsPerMove() > 1)
+					{
+						//the FDTD module applies a first order ABC itself; nothing can be applied between its steps
+						if(source != NULL || tfsf != NULL || patch != NULL || strcmp(boundaryCondition->getClassName(), "AbcFirstOrder") != 0)
+						{
+							ret = ERR_EMF_TIME_BLOCK;
+						}
+					}
 					if(ret == ERR_OK)
 					{
 						if(source != NULL)
@@ -182,6 +234,11 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 							ret = tfsf->initialize(fdtd->getCourantNumber(), maxRadius, taskConfig);
 						}
 					}
+					if(ret == ERR_OK && patch != NULL)
+					{
+						//fill the refined patch from the fields at time 0
+						ret = patch->initialize(fdtd, taskConfig, dataFolder);
+					}
 				}
 				else
 				{
@@ -212,20 +269,47 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 			reportProcess(reporter, false, "Current time index %d. Moving forward, please wait ...", fdtd->GetTimeStepIndex());
 			startTime = GetTimeTick();
 			//move forward
-			ret = fdtd->moveForward();
+			if(patch != NULL)
+			{
+				ret = patch->beforeCoarseStep();
+			}
+			if(ret == ERR_OK)
+			{
+				ret = fdtd->moveForward();
+			}
+			if(ret == ERR_OK && patch != NULL)
+			{
+				//sub-cycle the refined patch and put its fields into the simulation fields
+				ret = patch->afterCoarseStep();
+			}
 			if(ret == ERR_OK)
 			{
 				if(source != NULL)
 				{
 					//apply field source
 					source->reset(fdtd->GetFieldMemory(), fdtd->GetTimeStepIndex(), fdtd->getTime());
-					ret = source->gothroughSphere(maxRadius);
+					if(isBox)
+					{
+						ret = source->gothroughSphereInBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+					}
+					else
+					{
+						ret = source->gothroughSphere(maxRadius);
+					}
 				}
-				if(ret == ERR_OK)
+				if(ret == ERR_OK && fdtd->GetStepsPerMove() == 1)
 				{
 					//apply boundary condition
 					boundaryCondition->setFields(fdtd->GetFieldMemory());
-					ret = boundaryCondition->gothroughSphere(maxRadius);
+					if(isBox)
+					{
+						//only the points near the box faces are visited
+						ret = boundaryCondition->gothroughBoxFaces(maxRadiusX, maxRadiusY, maxRadiusZ, boundaryCondition->getThickNess());
+					}
+					else
+					{
+						ret = boundaryCondition->gothroughSphere(maxRadius);
+					}
 				}
 			}
 			if(ret == ERR_OK)
@@ -238,14 +322,32 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 				reportProcess(reporter, true, "Reached time index: %d, time for this step: %d ms. average time:%g", fdtd->GetTimeStepIndex(), timeUsed, averageStepTime);
 				if(fa != NULL)
 				{
-					ret = fa->setFields(fdtd->GetFieldMemory(), maxRadius-(int)fdtd->GetTimeStepIndex()-2,fdtd->GetSpaceStepSize(), fdtd->getHalfOrderSpaceDerivate());
-					if(ret == ERR_OK)
+					double stepE, stepH;
+					if(!isBox && fdtd->GetStepDivergence(maxRadius-(int)fdtd->GetTimeStepIndex()-1, &stepE, &stepH))
+					{
+						//made by the time step from the fields of the previous time index; no need of another pass over the fields
+						avgE += stepE;
+						avgH += stepH;
+					}
+					else
 					{
-						ret = fa->execute();
+						if(isBox)
+						{
+							//a box is analyzed as a whole because a sub-box is not contiguous in row-major memory
+							ret = fa->setFields(fdtd->GetFieldMemory(), maxRadiusX, maxRadiusY, maxRadiusZ, fdtd->GetSpaceStepSize(), fdtd->getHalfOrderSpaceDerivate());
+						}
+						else
+						{
+							ret = fa->setFields(fdtd->GetFieldMemory(), maxRadius-(int)fdtd->GetTimeStepIndex()-2,fdtd->GetSpaceStepSize(), fdtd->getHalfOrderSpaceDerivate());
+						}
 						if(ret == ERR_OK)
 						{
-							avgE += fa->getAverageDivergenceE();
-							avgH += fa->getAverageDivergenceH();
+							ret = fa->execute();
+							if(ret == ERR_OK)
+							{
+								avgE += fa->getAverageDivergenceE();
+								avgH += fa->getAverageDivergenceH();
+							}
 						}
 					}
 				}
@@ -260,6 +362,10 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 						if(fdtd->ReachedMaximumTime())
 						{
 							fdtd->FinishSimulation();
+							if(patch != NULL)
+							{
+								patch->FinishSimulation();
+							}
 							ret = ERR_REACHED_TIME_LIMIT;
 						}
 					}
@@ -313,6 +419,10 @@ int FieldSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFol
 		{
 			free(fa);
 		}
+		if(patch != NULL)
+		{
+			patch->ShowSummary();
+		}
 		printf("\r\nTotal time used:%d\r\n", totalTime);
 	}
 	return ret;
@@ -344,6 +454,25 @@ int FieldSimulation::createStatisticsFiles(TaskFile *taskConfig, const char *dat
 	halfOrder = taskConfig->getInt(TP_HALF_ORDER_SPACE, true);
 	ret = taskConfig->getErrorCode();
 	if(ret == ERR_OK)
+	{
+		//a rectangular box cannot be derived from a file size, it must be given by the task file
+		unsigned n, nx, ny, nz;
+		nx = taskConfig->getUInt(TP_FDTDNX, true);
+		ny = taskConfig->getUInt(TP_FDTDNY, true);
+		nz = taskConfig->getUInt(TP_FDTDNZ, true);
+		if(nx != 0 || ny != 0 || nz != 0)
+		{
+			ret = FDTD::ReadGridSize(taskConfig, &n, &nx, &ny, &nz, &isBox);
+			if(ret == ERR_OK && isBox)
+			{
+				N = (int)n;
+				maxRadiusX = GRIDRADIUS(nx);
+				maxRadiusY = GRIDRADIUS(ny);
+				maxRadiusZ = GRIDRADIUS(nz);
+			}
+		}
+	}
+	if(ret == ERR_OK)
 	{
 		if(range <= 0.0)
 		{
@@ -428,8 +557,37 @@ int FieldSimulation::createStatisticsFiles(TaskFile *taskConfig, const char *dat
 				}
 				else
 				{
-					ret = MemorySizeToRadius(fsize, &simulationRadius);
-					if(ret == ERR_OK)
+					if(isBox)
+					{
+						if(fsize != sizeof(FieldPoint3D) * BOXPOINTS(maxRadiusX, maxRadiusY, maxRadiusZ))
+						{
+							ret = ERR_FILESIZE_MISMATCH;
+						}
+						else if(k == 0) //the first file, create indexing cache
+						{
+							maxRadius = maxRadiusX;
+							if(maxRadiusY > maxRadius) maxRadius = maxRadiusY;
+							if(maxRadiusZ > maxRadius) maxRadius = maxRadiusZ;
+							simulationRadius = (unsigned int)maxRadius;
+							ret = writefile(divergReportFileHandle, &simulationRadius, sizeof(simulationRadius));
+							if(ret == ERR_OK)
+							{
+								ds = SPACESTEP(range, N);
+								seriesIndex = new RadiusIndexToSeriesIndex();
+								seriesIndex->initializeBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+								fa.setIndexCache(seriesIndex);
+							}
+						}
+						if(ret == ERR_OK)
+						{
+							ret = fa.setFields(fields, maxRadiusX, maxRadiusY, maxRadiusZ, ds, halfOrder);
+						}
+					}
+					else
+					{
+						ret = MemorySizeToRadius(fsize, &simulationRadius);
+					}
+					if(ret == ERR_OK && !isBox)
 					{
 						if(k == 0) //the first file, create indexing cache
 						{
@@ -460,20 +618,20 @@ int FieldSimulation::createStatisticsFiles(TaskFile *taskConfig, const char *dat
 						{
 							ret = fa.setFields(fields, simulationRadius, ds, halfOrder);
 						}
+					}
+					if(ret == ERR_OK)
+					{
+						ret = fa.execute();
 						if(ret == ERR_OK)
 						{
-							ret = fa.execute();
+							ret = fa.WriteDivegenceToFile(divergReportFileHandle);
 							if(ret == ERR_OK)
 							{
-								ret = fa.WriteDivegenceToFile(divergReportFileHandle);
-								if(ret == ERR_OK)
-								{
-									fa.ShowReport(writeReport); //write to report file
-								}
+								fa.ShowReport(writeReport); //write to report file
 							}
 						}
-						fa.cleanup();
 					}
+					fa.cleanup();
 					FreeMemory(fields);
 				}
 			}
@@ -20,6 +20,22 @@
 #define ERR_SIM_FIELD0    301
 #define ERR_SIM_BOUNDARY  302
 #define ERR_SIM_MONOTONIC 303
+//parareal: coarse propagator not loaded
+#define ERR_SIM_COARSE    304
+//parareal: coarse and fine propagators do not use the same time step and memory size
+#define ERR_SIM_PROPAGATORS 305
+//parareal: a thread cannot be created
+#define ERR_SIM_THREAD    306
+//parareal: rectangular domains and TF/SF boundaries are not supported
+#define ERR_SIM_PARAREAL  307
+//subgrid: the fine grid is not an integer refinement of the simulation grid, or it does not fit in the simulation domain
+#define ERR_SIM_SUBGRID   308
+//impulse response: rectangular domains, TF/SF boundaries and refined patches are not supported
+#define ERR_SIM_IMPULSE   309
+//impulse response: the field source changes more than one field component at one point
+#define ERR_SIM_IMPULSE_SOURCE 310
+
+class SubgridPatch;
 
 /*
 	EM Fields Simulation Class
@@ -44,6 +60,8 @@ private:
 	double range;            //space range at one side of the axis
 	//calculated space values ----------------------------------
 	int maxRadius;           //maximum radius, it is 2N+1
+	int maxRadiusX, maxRadiusY, maxRadiusZ; //maximum radius of each axis, they are not all equal for a rectangular box
+	bool isBox;              //fields are in a row-major rectangular box
 	size_t datapoints;       //number of space points in the simulation cubic
 	size_t memorySize;       //field memory size
 	double spaceStepSize;    //space step size
@@ -73,6 +91,7 @@ private:
 	BoundaryCondition *boundaryCondition;   //boundary condition
 	TotalFieldScatteredFieldBoundary *tfsf; //total field/scattered field boundary
 	//---------------------------------------------------------------------------------
+	SubgridPatch *patch;                    //optional locally refined patch
 	//
 public:
 	FieldSimulation();
@@ -87,6 +106,7 @@ public:
 	void setFieldSource(FieldSource *obj){source = obj;}
 	void setBoundaryCondition(BoundaryCondition *obj){boundaryCondition = obj;}
 	void setTFST(TotalFieldScatteredFieldBoundary *obj){tfsf = obj;}
+	void setSubgridPatch(SubgridPatch *obj){patch = obj;}
 	//-------------------------------------------------------------------------------
 	bool EnabledFDTDtimeRecording();
 	double GetAverageFDTDOneStepTime();
@@ -0,0 +1,710 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\FileUtil\fileutil.h"
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\memman.h"
+#include "..\ProcessMonitor\ProcessMonitor.h"
+#include "ImpulseResponse.h"
+#include "simConsole.h"
+
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+
+//Ctrl-C handling is shared with FieldSimulation
+extern bool cancel_simulation_flag;
+extern "C" void signals_handler(int);
+
+//field component c (0-5 for Ex,Ey,Ez,Hx,Hy,Hz) of a field point
+#define COMPONENT(f, c) (((double *)(f))[(c)])
+
+static void copyName(char *dest, const char *src)
+{
+	int i = 0;
+	if(src != NULL)
+	{
+		for(;i<IMPULSE_NAME_SIZE-1 && src[i] != 0;i++)
+		{
+			dest[i] = src[i];
+		}
+	}
+	dest[i] = 0;
+}
+
+ImpulseResponseSimulation::ImpulseResponseSimulation()
+{
+	seriesIndex = NULL;
+	maxRadius = 0;
+	fieldItems = 0;
+	maxTimeIndex = 0;
+	probeCount = 0;
+	probes = NULL;
+	probeIndexes = NULL;
+	sourceIndex = 0;
+	sourceValues = NULL;
+	reporter = NULL;
+	memset(&header, 0, sizeof(ImpulseResponseHeader));
+	fdtd = NULL;
+	field0 = NULL;
+	source = NULL;
+	boundaryCondition = NULL;
+	free0 = NULL;
+	impulse = NULL;
+	result = NULL;
+	work = NULL;
+}
+
+ImpulseResponseSimulation::~ImpulseResponseSimulation()
+{
+	cleanup();
+	if(seriesIndex != NULL)
+	{
+		delete seriesIndex;
+		seriesIndex = NULL;
+	}
+}
+
+void ImpulseResponseSimulation::cleanup()
+{
+	if(probes != NULL) { free(probes); probes = NULL; }
+	if(probeIndexes != NULL) { free(probeIndexes); probeIndexes = NULL; }
+	if(sourceValues != NULL) { free(sourceValues); sourceValues = NULL; }
+	if(free0 != NULL) { free(free0); free0 = NULL; }
+	if(impulse != NULL) { free(impulse); impulse = NULL; }
+	if(result != NULL) { free(result); result = NULL; }
+	if(work != NULL)
+	{
+		FreeMemory(work);
+		work = NULL;
+	}
+}
+
+/*
+	parse count points "m,n,p;m,n,p;..." into points[3*count]; each index must be within maxRadius
+*/
+int ImpulseResponseSimulation::parsePoints(const char *s, int *points, unsigned count)
+{
+	char *e;
+	long v;
+	for(unsigned i=0;i<3*count;i++)
+	{
+		while(*s == ' ') s++;
+		v = strtol(s, &e, 10);
+		if(e == s || v > maxRadius || v < -maxRadius)
+		{
+			return ERR_TASK_INVALID_VALUE;
+		}
+		points[i] = (int)v;
+		s = e;
+		while(*s == ' ') s++;
+		if(i == 3 * count - 1)
+		{
+			if(*s == ';') s++;
+			while(*s == ' ') s++;
+			if(*s != 0)
+			{
+				return ERR_TASK_INVALID_VALUE;
+			}
+		}
+		else if((i % 3 == 2 && *s != ';') || (i % 3 != 2 && *s != ','))
+		{
+			return ERR_TASK_INVALID_VALUE;
+		}
+		else
+		{
+			s++;
+		}
+	}
+	return ERR_OK;
+}
+
+int ImpulseResponseSimulation::readParameters(TaskFile *taskConfig)
+{
+	int ret = ERR_OK;
+	unsigned nn, nx, ny, nz;
+	bool isBox;
+	char *s;
+	ret = FDTD::ReadGridSize(taskConfig, &nn, &nx, &ny, &nz, &isBox);
+	if(ret == ERR_INVALID_SIZE)
+	{
+		ret = ERR_TP_INVALID_N;
+	}
+	if(ret == ERR_OK)
+	{
+		char *tfsf = taskConfig->getString(TP_SIMTFSF_DLL, true);
+		char *patch = taskConfig->getString(TP_SUBGRID_TASK, true);
+		if(isBox || (tfsf != NULL && strlen(tfsf) > 0) || (patch != NULL && strlen(patch) > 0))
+		{
+			ret = ERR_SIM_IMPULSE;
+		}
+		maxRadius = GRIDRADIUS(nn);
+		header.N = nn;
+	}
+	if(ret == ERR_OK)
+	{
+		maxTimeIndex = (size_t)taskConfig->getLong(TP_MAX_TIMESTEP, false);
+		ret = taskConfig->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		s = taskConfig->getString(TP_IR_PROBES, false);
+		ret = taskConfig->getErrorCode();
+		if(ret == ERR_OK)
+		{
+			probeCount = 1;
+			for(const char *c=s;*c != 0;c++)
+			{
+				//a ';' at the end does not start a probe
+				if(*c == ';' && c[1] != 0) probeCount++;
+			}
+			probes = (int *)malloc(3 * probeCount * sizeof(int));
+			if(probes == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+			else
+			{
+				ret = parsePoints(s, probes, probeCount);
+				if(ret != ERR_OK)
+				{
+					taskConfig->setNameOfInvalidValue(TP_IR_PROBES);
+				}
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		s = taskConfig->getString(TP_IR_SOURCE, true);
+		ret = taskConfig->getErrorCode();
+		if(ret == ERR_OK && s != NULL && strlen(s) > 0)
+		{
+			ret = parsePoints(s, header.source, 1);
+			if(ret != ERR_OK)
+			{
+				taskConfig->setNameOfInvalidValue(TP_IR_SOURCE);
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		s = taskConfig->getString(TP_IR_SOURCE_COMPONENT, true);
+		ret = taskConfig->getErrorCode();
+		header.source[3] = 2;
+		if(ret == ERR_OK && s != NULL && strlen(s) > 0)
+		{
+			const char *names[6] = {"EX", "EY", "EZ", "HX", "HY", "HZ"};
+			header.source[3] = -1;
+			for(int c=0;c<6;c++)
+			{
+				if(strcmp(s, names[c]) == 0)
+				{
+					header.source[3] = c;
+					break;
+				}
+			}
+			if(header.source[3] < 0)
+			{
+				ret = ERR_TASK_INVALID_VALUE;
+				taskConfig->setNameOfInvalidValue(TP_IR_SOURCE_COMPONENT);
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	load responses from a cache file. *loaded is false if the file does not exist or it does not match the task
+*/
+int ImpulseResponseSimulation::loadCache(const char *file, bool *loaded)
+{
+	int ret = ERR_OK;
+	int handle = 0;
+	ImpulseResponseHeader h;
+	int *p = NULL;
+	*loaded = false;
+	ret = openfileRead(file, &handle);
+	if(ret == ERR_FILE_OPEN_READ_ENOENT)
+	{
+		return ERR_OK;
+	}
+	if(ret == ERR_OK)
+	{
+		ret = readfile(handle, &h, sizeof(ImpulseResponseHeader));
+		if(ret == ERR_OK)
+		{
+			size_t steps = h.steps;
+			h.steps = header.steps;
+			if(steps >= maxTimeIndex && memcmp(&h, &header, sizeof(ImpulseResponseHeader)) == 0)
+			{
+				p = (int *)malloc(3 * probeCount * sizeof(int));
+				free0 = (FieldPoint3D *)malloc((steps + 1) * probeCount * sizeof(FieldPoint3D));
+				impulse = (FieldPoint3D *)malloc((steps + 1) * probeCount * sizeof(FieldPoint3D));
+				if(p == NULL || free0 == NULL || impulse == NULL)
+				{
+					ret = ERR_OUTOFMEMORY;
+				}
+				else
+				{
+					ret = readfile(handle, p, 3 * probeCount * sizeof(int));
+					if(ret == ERR_OK && memcmp(p, probes, 3 * probeCount * sizeof(int)) == 0)
+					{
+						ret = readfile(handle, free0, (unsigned int)((steps + 1) * probeCount * sizeof(FieldPoint3D)));
+						if(ret == ERR_OK)
+						{
+							ret = readfile(handle, impulse, (unsigned int)((steps + 1) * probeCount * sizeof(FieldPoint3D)));
+						}
+						if(ret == ERR_OK)
+						{
+							*loaded = true;
+						}
+					}
+				}
+				if(p != NULL)
+				{
+					free(p);
+				}
+			}
+		}
+		closefile(handle);
+	}
+	if(ret == ERR_OK && !(*loaded))
+	{
+		if(free0 != NULL) { free(free0); free0 = NULL; }
+		if(impulse != NULL) { free(impulse); impulse = NULL; }
+	}
+	return ret;
+}
+
+int ImpulseResponseSimulation::saveCache(const char *file)
+{
+	int ret = ERR_OK;
+	int handle = 0;
+	ret = openfileWrite(file, &handle);
+	if(ret == ERR_OK)
+	{
+		ret = writefile(handle, &header, sizeof(ImpulseResponseHeader));
+		if(ret == ERR_OK)
+		{
+			ret = writefile(handle, probes, 3 * probeCount * sizeof(int));
+		}
+		if(ret == ERR_OK)
+		{
+			ret = writefile(handle, free0, (unsigned int)((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D)));
+		}
+		if(ret == ERR_OK)
+		{
+			ret = writefile(handle, impulse, (unsigned int)((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D)));
+		}
+		closefile(handle);
+	}
+	return ret;
+}
+
+void ImpulseResponseSimulation::recordProbes(FieldPoint3D *dest)
+{
+	FieldPoint3D *fields = fdtd->GetFieldMemory();
+	for(unsigned k=0;k<probeCount;k++)
+	{
+		dest[k] = fields[probeIndexes[k]];
+	}
+}
+
+/*
+	simulate maxTimeIndex time steps and record the probes into dest[(maxTimeIndex+1)*probeCount].
+	withImpulse: start from zero fields and add a unit impulse to the source component after the first time step;
+	otherwise start from the fields at time 0. withSource: apply the field source after each time step.
+	field source and boundary condition are applied the same way FieldSimulation does.
+	the boundary condition is initialized again so that it does not keep memory of the previous run, e.g. AbcFirstOrder planes
+*/
+int ImpulseResponseSimulation::run(TaskFile *taskConfig, bool withImpulse, bool withSource, FieldPoint3D *dest)
+{
+	int ret = boundaryCondition->initialize(fdtd->getCourantNumber(), maxRadius, taskConfig);
+	size_t i;
+	if(ret == ERR_OK)
+	{
+		if(withImpulse)
+		{
+			for(i=0;i<fieldItems;i++)
+			{
+				work[i].E.x = work[i].E.y = work[i].E.z = 0.0;
+				work[i].H.x = work[i].H.y = work[i].H.z = 0.0;
+			}
+		}
+		else
+		{
+			ret = fdtd->PopulateFields(field0);
+			if(ret == ERR_OK)
+			{
+				FieldPoint3D *f = fdtd->GetFieldMemory();
+				for(i=0;i<fieldItems;i++)
+				{
+					work[i] = f[i];
+				}
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		ret = fdtd->SetFieldsAtTime(work, 0);
+	}
+	if(ret == ERR_OK)
+	{
+		recordProbes(dest);
+	}
+	for(size_t n=1;n<=maxTimeIndex && ret == ERR_OK;n++)
+	{
+		ret = fdtd->moveForward();
+		if(ret == ERR_OK)
+		{
+			if(withImpulse && n == 1)
+			{
+				COMPONENT(&(fdtd->GetFieldMemory()[sourceIndex]), header.source[3]) += 1.0;
+			}
+			if(withSource && source != NULL)
+			{
+				source->reset(fdtd->GetFieldMemory(), fdtd->GetTimeStepIndex(), fdtd->getTime());
+				ret = source->gothroughSphere(maxRadius);
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			boundaryCondition->setFields(fdtd->GetFieldMemory());
+			ret = boundaryCondition->gothroughSphere(maxRadius);
+		}
+		if(ret == ERR_OK)
+		{
+			recordProbes(dest + n * probeCount);
+			reportProcess(reporter, true, "Reached time index: %d", n);
+			if(cancel_simulation_flag) //user terminates simulation
+			{
+				ret = ERR_SIMULATION_CANCEL;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	s(n) is what the field source adds to the source component of zero fields at time index n
+*/
+int ImpulseResponseSimulation::findSourceValues()
+{
+	int ret = ERR_OK;
+	size_t i;
+	sourceValues = (double *)malloc((maxTimeIndex + 1) * sizeof(double));
+	if(sourceValues == NULL)
+	{
+		return ERR_OUTOFMEMORY;
+	}
+	for(i=0;i<fieldItems;i++)
+	{
+		work[i].E.x = work[i].E.y = work[i].E.z = 0.0;
+		work[i].H.x = work[i].H.y = work[i].H.z = 0.0;
+	}
+	sourceValues[0] = 0.0;
+	for(size_t n=1;n<=maxTimeIndex && ret == ERR_OK;n++)
+	{
+		sourceValues[n] = 0.0;
+		if(source != NULL)
+		{
+			source->reset(work, n, fdtd->GetTimeStepSize() * (double)n);
+			ret = source->gothroughSphere(maxRadius);
+			if(ret == ERR_OK)
+			{
+				sourceValues[n] = COMPONENT(&(work[sourceIndex]), header.source[3]);
+				COMPONENT(&(work[sourceIndex]), header.source[3]) = 0.0;
+			}
+		}
+	}
+	//anything left is not a superposition of the impulse
+	for(i=0;i<fieldItems && ret == ERR_OK;i++)
+	{
+		for(int c=0;c<6;c++)
+		{
+			if(COMPONENT(&(work[i]), c) != 0.0)
+			{
+				ret = ERR_SIM_IMPULSE_SOURCE;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	F(n) = F0(n) + sum of s(j) * h(n-j+1), j = 1,2,...,n
+*/
+void ImpulseResponseSimulation::convolve()
+{
+	for(size_t n=0;n<=maxTimeIndex;n++)
+	{
+		FieldPoint3D *f = result + n * probeCount;
+		for(unsigned k=0;k<probeCount;k++)
+		{
+			f[k] = free0[n * probeCount + k];
+		}
+		for(size_t j=1;j<=n;j++)
+		{
+			double s = sourceValues[j];
+			if(s != 0.0)
+			{
+				FieldPoint3D *h = impulse + (n - j + 1) * probeCount;
+				for(unsigned k=0;k<probeCount;k++)
+				{
+					for(int c=0;c<6;c++)
+					{
+						COMPONENT(&(f[k]), c) += s * COMPONENT(&(h[k]), c);
+					}
+				}
+			}
+		}
+	}
+}
+
+int ImpulseResponseSimulation::saveResult(const char *file)
+{
+	int ret = ERR_OK;
+	int handle = 0;
+	char line[200];
+	ret = openTextfileWrite(file, &handle);
+	if(ret == ERR_OK)
+	{
+		for(size_t n=0;n<=maxTimeIndex && ret == ERR_OK;n++)
+		{
+			int err = sprintf_s(line, 200, "%u", (unsigned int)n);
+			if(err > 0)
+			{
+				ret = writefile(handle, line, (unsigned int)strlen(line));
+			}
+			for(unsigned k=0;k<probeCount && ret == ERR_OK;k++)
+			{
+				FieldPoint3D *f = &(result[n * probeCount + k]);
+				err = sprintf_s(line, 200, ",%g,%g,%g,%g,%g,%g", f->E.x, f->E.y, f->E.z, f->H.x, f->H.y, f->H.z);
+				if(err <= 0)
+				{
+					ret = ERR_MEM_EINVAL;
+				}
+				else
+				{
+					ret = writefile(handle, line, (unsigned int)strlen(line));
+				}
+			}
+			if(ret == ERR_OK)
+			{
+				ret = writefile(handle, "\r\n", 2);
+			}
+		}
+		closefile(handle);
+	}
+	return ret;
+}
+
+int ImpulseResponseSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFolder)
+{
+	int ret = ERR_OK;
+	char cacheFile[FILENAME_MAX];
+	char outputFile[FILENAME_MAX];
+	bool loaded = false;
+	bool verify = false;
+	unsigned long startTime, timeUsed;
+	if(fdtd == NULL)
+	{
+		ret = ERR_SIM_FDTD;
+	}
+	else if(field0 == NULL)
+	{
+		ret = ERR_SIM_FIELD0;
+	}
+	else if(boundaryCondition == NULL)
+	{
+		ret = ERR_SIM_BOUNDARY;
+	}
+	if(ret == ERR_OK)
+	{
+		ret = readParameters(taskConfig);
+	}
+	if(ret == ERR_OK)
+	{
+		char *s = taskConfig->getString(TP_IR_CACHE, false);
+		char *o = taskConfig->getString(TP_IR_OUTPUT, false);
+		verify = taskConfig->getBoolean(TP_IR_VERIFY, true);
+		ret = taskConfig->getErrorCode();
+		if(ret == ERR_OK)
+		{
+			ret = formFilePath(cacheFile, FILENAME_MAX, dataFolder, s);
+		}
+		if(ret == ERR_OK)
+		{
+			ret = formFilePath(outputFile, FILENAME_MAX, dataFolder, o);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		puts("\r\nStarting impulse response simulation. Press Ctrl-C to stop. \r\n Initialize ...\r\n");
+		cancel_simulation_flag = false;
+		signal(SIGINT, &signals_handler);
+		seriesIndex = new RadiusIndexToSeriesIndex();
+		ret = seriesIndex->initialize(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		//fields are not saved to files
+		fdtd->SetMemoryManager(_mem);
+		fdtd->setIndexCache(seriesIndex);
+		boundaryCondition->SetMemoryManager(_mem);
+		boundaryCondition->setIndexCache(seriesIndex);
+		if(source != NULL)
+		{
+			source->SetMemoryManager(_mem);
+			source->setIndexCache(seriesIndex);
+		}
+		ret = field0->initialize(taskConfig);
+		if(ret == ERR_OK)
+		{
+			ret = fdtd->initialize(NULL, NULL, taskConfig);
+		}
+		if(ret == ERR_OK && fdtd->GetStepsPerMove() != 1)
+		{
+			//the impulse is applied and the probes are read at every time step
+			ret = ERR_EMF_TIME_BLOCK;
+		}
+		if(ret == ERR_OK && source != NULL)
+		{
+			ret = source->initialize(fdtd->getCourantNumber(), maxRadius, taskConfig);
+		}
+		if(ret == ERR_OK)
+		{
+			ret = boundaryCondition->initialize(fdtd->getCourantNumber(), maxRadius, taskConfig);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		fieldItems = fdtd->GetMemoryItemCount();
+		work = (FieldPoint3D *)AllocateTaggedMemory(fieldItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+		probeIndexes = (size_t *)malloc(probeCount * sizeof(size_t));
+		result = (FieldPoint3D *)malloc((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D));
+		if(work == NULL || probeIndexes == NULL || result == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			for(unsigned k=0;k<probeCount;k++)
+			{
+				probeIndexes[k] = seriesIndex->Index(probes[3*k], probes[3*k+1], probes[3*k+2]);
+			}
+			sourceIndex = seriesIndex->Index(header.source[0], header.source[1], header.source[2]);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//the initial fields are identified by their sum of squares
+		ret = fdtd->PopulateFields(field0);
+		if(ret == ERR_OK)
+		{
+			FieldPoint3D *f = fdtd->GetFieldMemory();
+			double sum = 0.0;
+			for(size_t i=0;i<fieldItems;i++)
+			{
+				sum += f[i].E.x * f[i].E.x + f[i].E.y * f[i].E.y + f[i].E.z * f[i].E.z
+					+ f[i].H.x * f[i].H.x + f[i].H.y * f[i].H.y + f[i].H.z * f[i].H.z;
+			}
+			header.version = IMPULSE_CACHE_VERSION;
+			header.halfOrderTime = (unsigned int)fdtd->getHalfOrderTimeAdvance();
+			header.halfOrderSpace = (unsigned int)fdtd->getHalfOrderSpaceDerivate();
+			header.steps = (unsigned int)maxTimeIndex;
+			header.probeCount = probeCount;
+			header.ds = fdtd->GetSpaceStepSize();
+			header.dt = fdtd->GetTimeStepSize();
+			header.fields0 = sum;
+			copyName(header.fdtdName, fdtd->getClassName());
+			copyName(header.bcName, boundaryCondition->getClassName());
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		ret = loadCache(cacheFile, &loaded);
+	}
+	if(ret == ERR_OK && !loaded)
+	{
+		free0 = (FieldPoint3D *)malloc((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D));
+		impulse = (FieldPoint3D *)malloc((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D));
+		if(free0 == NULL || impulse == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		if(ret == ERR_OK)
+		{
+			reportProcess(reporter, false, "Computing the responses to the fields at time 0 and to an impulse, please wait ...");
+			startTime = GetTimeTick();
+			ret = run(taskConfig, false, false, free0);
+			if(ret == ERR_OK)
+			{
+				ret = run(taskConfig, true, false, impulse);
+			}
+			if(ret == ERR_OK)
+			{
+				ret = saveCache(cacheFile);
+			}
+			timeUsed = GetTimeTick() - startTime;
+			printf("\r\nResponses computed and saved to %s in %d ms\r\n", cacheFile, timeUsed);
+		}
+	}
+	else if(ret == ERR_OK)
+	{
+		printf("\r\nResponses loaded from %s\r\n", cacheFile);
+	}
+	if(ret == ERR_OK)
+	{
+		startTime = GetTimeTick();
+		ret = findSourceValues();
+		if(ret == ERR_OK)
+		{
+			convolve();
+			ret = saveResult(outputFile);
+		}
+		timeUsed = GetTimeTick() - startTime;
+		printf("\r\nProbe fields by superposition written to %s in %d ms\r\n", outputFile, timeUsed);
+	}
+	if(ret == ERR_OK && verify)
+	{
+		FieldPoint3D *direct = (FieldPoint3D *)malloc((maxTimeIndex + 1) * probeCount * sizeof(FieldPoint3D));
+		if(direct == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			reportProcess(reporter, false, "Verifying by a direct simulation, please wait ...");
+			startTime = GetTimeTick();
+			ret = run(taskConfig, false, true, direct);
+			timeUsed = GetTimeTick() - startTime;
+			if(ret == ERR_OK)
+			{
+				double diff = 0.0, maxValue = 0.0, d;
+				for(size_t i=0;i<(maxTimeIndex + 1) * probeCount;i++)
+				{
+					for(int c=0;c<6;c++)
+					{
+						d = fabs(COMPONENT(&(direct[i]), c) - COMPONENT(&(result[i]), c));
+						if(d > diff) diff = d;
+						d = fabs(COMPONENT(&(direct[i]), c));
+						if(d > maxValue) maxValue = d;
+					}
+				}
+				printf("\r\nDirect simulation finished in %d ms. Largest difference at the probes: %g; largest field at the probes: %g\r\n", timeUsed, diff, maxValue);
+			}
+			free(direct);
+		}
+	}
+	fdtd->FinishSimulation();
+	cleanup();
+	return ret;
+}
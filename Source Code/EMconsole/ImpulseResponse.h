@@ -0,0 +1,110 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "..\EMField\FieldSource.h"
+#include "..\EMField\BoundaryCondition.h"
+#include "..\ProcessMonitor\workProcess.h"
+#include "..\FileUtil\taskFile.h"
+#include "FieldSimulation.h"
+
+//version of the cache file layout
+#define IMPULSE_CACHE_VERSION 1
+#define IMPULSE_NAME_SIZE     64
+
+/*
+	the first part of a cache file. a cache can be used by a task if all items are the same,
+	except that a cache may have more time steps than the task needs
+*/
+typedef struct ImpulseResponseHeader
+{
+	unsigned int version;
+	unsigned int N;
+	unsigned int halfOrderTime;
+	unsigned int halfOrderSpace;
+	unsigned int steps;                //time steps of the responses
+	unsigned int probeCount;
+	int source[4];                     //m, n, p and the component (0-5 for Ex,Ey,Ez,Hx,Hy,Hz) of the impulse
+	double ds;
+	double dt;
+	double fields0;                    //sum of squares of the fields at time 0; it tells whether the initial fields are the same
+	char fdtdName[IMPULSE_NAME_SIZE];  //FDTD class
+	char bcName[IMPULSE_NAME_SIZE];    //boundary condition class
+}ImpulseResponseHeader;
+
+/*
+	probe fields of a linear simulation by superposition of cached responses.
+
+	with a time-invariant FDTD module and boundary condition, and a soft field source adding s(n) to one field component
+	at one point after time step n (as FieldSourceEz does), the fields at a probe point are
+		F(n) = F0(n) + sum of s(j) * h(n-j+1), j = 1,2,...,n
+	F0 is the response to the fields at time 0 without the source; h(k) is the response at time index k to a unit impulse
+	added at time index 1. F0 and h at the probe points are computed by 2 simulations and saved to a cache file;
+	a later task with the same grid, FDTD module, boundary condition, initial fields, source point and probes only
+	evaluates s(n) and the convolution.
+
+	task parameters:
+		IR.CACHE - cache file name in the data folder. it is created if it does not exist or does not match the task
+		IR.PROBES - probe points by grid indexes, "m,n,p;m,n,p;..."
+		IR.SOURCE - optional, "m,n,p" of the source point, default to "0,0,0"
+		IR.SOURCE_COMPONENT - optional, EX, EY, EZ, HX, HY or HZ, default to EZ
+		IR.OUTPUT - text file in the data folder for the probe fields: a line for each time index,
+		            "n,Ex,Ey,Ez,Hx,Hy,Hz" with 6 values for each probe
+		IR.VERIFY - optional, true to run the simulation directly and report the largest difference at the probes
+
+	s(n) is found by applying the field source to zero fields. it is an error if the source changes other components or points.
+	a rectangular domain, a TF/SF boundary and a locally refined patch are not supported.
+*/
+class ImpulseResponseSimulation:public virtual RadiusIndexCacheUser
+{
+private:
+	int maxRadius;
+	size_t fieldItems;
+	size_t maxTimeIndex;
+	unsigned probeCount;
+	int *probes;                     //[3*probeCount]
+	size_t *probeIndexes;            //[probeCount]
+	size_t sourceIndex;
+	double *sourceValues;            //[maxTimeIndex+1], s(n)
+	fnProgressReport reporter;
+	ImpulseResponseHeader header;
+	//
+	FDTD *fdtd;
+	FieldsInitializer *field0;
+	FieldSource *source;
+	BoundaryCondition *boundaryCondition;
+	//
+	FieldPoint3D *free0;             //[(steps+1)*probeCount], F0
+	FieldPoint3D *impulse;           //[(steps+1)*probeCount], h
+	FieldPoint3D *result;            //[(maxTimeIndex+1)*probeCount], F
+	FieldPoint3D *work;              //[fieldItems]
+	//
+	int parsePoints(const char *s, int *points, unsigned count);
+	int readParameters(TaskFile *taskConfig);
+	int loadCache(const char *file, bool *loaded);
+	int saveCache(const char *file);
+	void recordProbes(FieldPoint3D *dest);
+	int run(TaskFile *taskConfig, bool withImpulse, bool withSource, FieldPoint3D *dest);
+	int findSourceValues();
+	void convolve();
+	int saveResult(const char *file);
+	void cleanup();
+public:
+	ImpulseResponseSimulation();
+	~ImpulseResponseSimulation();
+	void setReporter(fnProgressReport rep){reporter = rep;}
+	void setFDTD(FDTD* obj){fdtd = obj;}
+	void setFieldInitializer(FieldsInitializer *obj){field0 = obj;}
+	void setFieldSource(FieldSource *obj){source = obj;}
+	void setBoundaryCondition(BoundaryCondition *obj){boundaryCondition = obj;}
+	/*
+		create or load the cache and write the probe fields to IR.OUTPUT
+	*/
+	int simulationToFiles(TaskFile *taskConfig, const char *dataFolder);
+};
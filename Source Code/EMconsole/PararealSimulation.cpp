@@ -0,0 +1,657 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\FileUtil\fileutil.h"
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\memman.h"
+#include "..\ProcessMonitor\ProcessMonitor.h"
+#include "PararealSimulation.h"
+#include "simConsole.h"
+
+#include <Windows.h>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+
+//Ctrl-C handling is shared with FieldSimulation
+extern bool cancel_simulation_flag;
+extern "C" void signals_handler(int);
+
+static void clearPropagator(PararealPropagator *p)
+{
+	p->fdtd = NULL;
+	p->boundaryCondition = NULL;
+	p->source = NULL;
+	p->start = NULL;
+	p->result = NULL;
+	p->startIndex = 0;
+	p->steps = 0;
+	p->maxRadius = 0;
+	p->ret = ERR_OK;
+}
+
+/*
+	thread function for running the fine propagator of one time slice
+*/
+static DWORD WINAPI fineThread(LPVOID param)
+{
+	PararealPropagator *p = (PararealPropagator *)param;
+	p->ret = PararealSimulation::Propagate(p);
+	return 0;
+}
+
+PararealSimulation::PararealSimulation()
+{
+	seriesIndex = NULL;
+	maxRadius = 0;
+	fieldItems = 0;
+	maxTimeIndex = 0;
+	sliceCount = 0;
+	maxIterations = 0;
+	tolerance = 0.0;
+	reporter = NULL;
+	field0 = NULL;
+	clearPropagator(&coarse);
+	clearPropagator(&fine0);
+	fine = NULL;
+	coarseTask = NULL;
+	U = NULL;
+	G = NULL;
+	F = NULL;
+	work = NULL;
+	comparer = NULL;
+}
+
+PararealSimulation::~PararealSimulation()
+{
+	cleanup();
+	if(seriesIndex != NULL)
+	{
+		delete seriesIndex;
+		seriesIndex = NULL;
+	}
+}
+
+void PararealSimulation::cleanup()
+{
+	unsigned n;
+	if(U != NULL || G != NULL || F != NULL)
+	{
+		for(n=0;n<=sliceCount;n++)
+		{
+			if(U != NULL && U[n] != NULL) FreeMemory(U[n]);
+			if(G != NULL && G[n] != NULL) FreeMemory(G[n]);
+			if(F != NULL && F[n] != NULL) FreeMemory(F[n]);
+		}
+	}
+	if(U != NULL) { free(U); U = NULL; }
+	if(G != NULL) { free(G); G = NULL; }
+	if(F != NULL) { free(F); F = NULL; }
+	if(work != NULL)
+	{
+		FreeMemory(work);
+		work = NULL;
+	}
+	if(comparer != NULL)
+	{
+		delete comparer;
+		comparer = NULL;
+	}
+	if(fine != NULL)
+	{
+		free(fine);
+		fine = NULL;
+	}
+	if(coarseTask != NULL)
+	{
+		delete coarseTask;
+		coarseTask = NULL;
+	}
+}
+
+/*
+	time index at the start of time slice n; slice sliceCount is the end of the simulation.
+	the first (maxTimeIndex % sliceCount) slices are one time step longer than the others
+*/
+size_t PararealSimulation::sliceStart(unsigned n)
+{
+	size_t steps = maxTimeIndex / sliceCount;
+	size_t extra = maxTimeIndex % sliceCount;
+	return (size_t)n * steps + ((size_t)n < extra ? (size_t)n : extra);
+}
+
+/*
+	advance p->start by p->steps time steps into p->result.
+	field source and boundary condition are applied after each time step, the same way FieldSimulation does
+*/
+int PararealSimulation::Propagate(PararealPropagator *p)
+{
+	int ret = p->fdtd->SetFieldsAtTime(p->start, p->startIndex);
+	for(size_t s=0;s<p->steps && ret == ERR_OK;s++)
+	{
+		ret = p->fdtd->moveForward();
+		if(ret == ERR_OK)
+		{
+			if(p->source != NULL)
+			{
+				p->source->reset(p->fdtd->GetFieldMemory(), p->fdtd->GetTimeStepIndex(), p->fdtd->getTime());
+				ret = p->source->gothroughSphere(p->maxRadius);
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			p->boundaryCondition->setFields(p->fdtd->GetFieldMemory());
+			ret = p->boundaryCondition->gothroughSphere(p->maxRadius);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		FieldPoint3D *fields = p->fdtd->GetFieldMemory();
+		size_t items = p->fdtd->GetMemoryItemCount();
+		for(size_t i=0;i<items;i++)
+		{
+			p->result[i] = fields[i];
+		}
+	}
+	return ret;
+}
+
+/*
+	load the coarse propagator and the plug-in objects of the time slices other than the first one.
+	each time slice runs in its own thread, so it needs its own FDTD, boundary condition and field source objects
+*/
+int PararealSimulation::loadPropagators(TaskFile *taskConfig, char *libFolder)
+{
+	int ret = ERR_OK;
+	unsigned n;
+	coarse.fdtd = (FDTD *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMCOARSE_DLL, true), taskConfig->getString(TP_SIMCOARSE_NAME, true), &ret);
+	coarse.boundaryCondition = (BoundaryCondition *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMBC_DLL, true), taskConfig->getString(TP_SIMBC_NAME, true), &ret);
+	if(fine0.source != NULL)
+	{
+		coarse.source = (FieldSource *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMFS_DLL, true), taskConfig->getString(TP_SIMFS_NAME, true), &ret);
+	}
+	if(ret == ERR_OK)
+	{
+		if(coarse.fdtd == NULL)
+		{
+			ret = ERR_SIM_COARSE;
+		}
+		else if(coarse.boundaryCondition == NULL)
+		{
+			ret = ERR_SIM_BOUNDARY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		fine = (PararealPropagator *)malloc(sliceCount * sizeof(PararealPropagator));
+		if(fine == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			fine[0] = fine0;
+			for(n=1;n<sliceCount;n++)
+			{
+				clearPropagator(&(fine[n]));
+			}
+			for(n=1;n<sliceCount && ret == ERR_OK;n++)
+			{
+				fine[n].fdtd = (FDTD *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMFDTD_DLL, true), taskConfig->getString(TP_SIMFDTD_NAME, true), &ret);
+				fine[n].boundaryCondition = (BoundaryCondition *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMBC_DLL, true), taskConfig->getString(TP_SIMBC_NAME, true), &ret);
+				if(fine0.source != NULL)
+				{
+					fine[n].source = (FieldSource *)loadPluginInstance(libFolder, taskConfig->getString(TP_SIMFS_DLL, true), taskConfig->getString(TP_SIMFS_NAME, true), &ret);
+				}
+				if(ret == ERR_OK)
+				{
+					if(fine[n].fdtd == NULL || fine[n].boundaryCondition == NULL || (fine0.source != NULL && fine[n].source == NULL))
+					{
+						ret = ERR_SIM_FDTD;
+					}
+				}
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	initialize the plug-in objects of a propagator. fields are not saved to files by a propagator
+*/
+int PararealSimulation::initPropagator(PararealPropagator *p, TaskFile *taskConfig)
+{
+	int ret = ERR_OK;
+	p->maxRadius = maxRadius;
+	p->fdtd->SetMemoryManager(_mem);
+	p->fdtd->setIndexCache(seriesIndex);
+	p->boundaryCondition->SetMemoryManager(_mem);
+	p->boundaryCondition->setIndexCache(seriesIndex);
+	if(p->source != NULL)
+	{
+		p->source->SetMemoryManager(_mem);
+		p->source->setIndexCache(seriesIndex);
+	}
+	ret = p->fdtd->initialize(NULL, NULL, taskConfig);
+	if(ret == ERR_OK && p->fdtd->GetStepsPerMove() != 1)
+	{
+		//a propagator applies its source and boundary condition at every time step
+		ret = ERR_EMF_TIME_BLOCK;
+	}
+	if(ret == ERR_OK)
+	{
+		if(p->source != NULL)
+		{
+			ret = p->source->initialize(p->fdtd->getCourantNumber(), maxRadius, taskConfig);
+		}
+		if(ret == ERR_OK)
+		{
+			ret = p->boundaryCondition->initialize(p->fdtd->getCourantNumber(), maxRadius, taskConfig);
+		}
+	}
+	return ret;
+}
+
+/*
+	run the fine propagators of time slices firstSlice, firstSlice+1, ..., sliceCount-1 in parallel.
+	the time slices before firstSlice are already the same as a sequential fine simulation
+*/
+int PararealSimulation::runFineInParallel(unsigned firstSlice)
+{
+	int ret = ERR_OK;
+	HANDLE threads[MAX_PARAREAL_SLICES];
+	DWORD count = 0;
+	unsigned n;
+	for(n=firstSlice;n<sliceCount;n++)
+	{
+		fine[n].start = U[n];
+		fine[n].result = F[n+1];
+		fine[n].startIndex = sliceStart(n);
+		fine[n].steps = sliceStart(n+1) - fine[n].startIndex;
+		fine[n].ret = ERR_OK;
+		threads[count] = CreateThread(NULL, 0, fineThread, &(fine[n]), 0, NULL);
+		if(threads[count] == NULL)
+		{
+			RememberOSerror();
+			ret = ERR_SIM_THREAD;
+			break;
+		}
+		count++;
+	}
+	if(count > 0)
+	{
+		WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+		for(DWORD i=0;i<count;i++)
+		{
+			CloseHandle(threads[i]);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		for(n=firstSlice;n<sliceCount;n++)
+		{
+			if(fine[n].ret != ERR_OK)
+			{
+				ret = fine[n].ret;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	sum of differences over sum of field strengths, by FieldDataComparer
+*/
+double PararealSimulation::relativeChange(FieldPoint3D *newFields, FieldPoint3D *oldFields)
+{
+	double sumDiff = 0.0;
+	double sumField = 0.0;
+	FieldCompareResult *r;
+	comparer->setFields(newFields, oldFields);
+	if(comparer->compareDataByRadius() == ERR_OK)
+	{
+		r = comparer->GetResults();
+		for(int i=0;i<=maxRadius;i++)
+		{
+			sumDiff += r[i].sumDiff.E.x + r[i].sumDiff.E.y + r[i].sumDiff.E.z + r[i].sumDiff.H.x + r[i].sumDiff.H.y + r[i].sumDiff.H.z;
+			sumField += r[i].sumField.E.x + r[i].sumField.E.y + r[i].sumField.E.z + r[i].sumField.H.x + r[i].sumField.H.y + r[i].sumField.H.z;
+		}
+	}
+	if(sumField > 0.0)
+	{
+		return sumDiff / sumField;
+	}
+	return sumDiff;
+}
+
+/*
+	save fields at the start of each time slice and at the end of the simulation to {SIM.BASENAME}{n}.em
+*/
+int PararealSimulation::saveFields(TaskFile *taskConfig, const char *dataFolder)
+{
+	int ret = ERR_OK;
+	char filenamebase[FILENAME_MAX];
+	wchar_t fieldFileBase[FILENAME_MAX];
+	wchar_t fieldFile[FILENAME_MAX];
+	FieldPoint3D *p;
+	char *basefile = taskConfig->getString(TP_SIMBASENAME, false);
+	ret = taskConfig->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		if(strlen(basefile) == 0)
+		{
+			ret = ERR_TP_BASENAME;
+		}
+		else if(strcmp(basefile, "DEF") == 0)
+		{
+			ret = ERR_TP_BASENAME_DEF;
+		}
+		else
+		{
+			ret = formFilePath(filenamebase, FILENAME_MAX, dataFolder, basefile);
+			if(ret == ERR_OK)
+			{
+				ret = copyC2W(fieldFileBase, FILENAME_MAX, filenamebase);
+			}
+		}
+	}
+	for(unsigned n=0;n<=sliceCount && ret == ERR_OK;n++)
+	{
+		ret = formDataFileNameW(fieldFile, FILENAME_MAX, fieldFileBase, sliceStart(n));
+		if(ret == ERR_OK)
+		{
+			p = (FieldPoint3D *)CreateFileIntoTaggedMemory(fieldFile, fieldItems * sizeof(FieldPoint3D), &ret, MEM_TAG_FIELDS);
+			if(ret == ERR_OK)
+			{
+				if(p == NULL)
+				{
+					ret = ERR_OUTOFMEMORY;
+				}
+				else
+				{
+					for(size_t i=0;i<fieldItems;i++)
+					{
+						p[i] = U[n][i];
+					}
+					FreeMemory(p);
+				}
+			}
+			else
+			{
+				RememberOSerror();
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	run a parareal simulation and save fields at the end of each time slice to data files
+*/
+int PararealSimulation::simulationToFiles(TaskFile *taskConfig, const char *dataFolder, char *libFolder)
+{
+	int ret = ERR_OK;
+	unsigned n, k;
+	size_t i;
+	double change, c;
+	char *s;
+	if(fine0.fdtd == NULL)
+	{
+		ret = ERR_SIM_FDTD;
+	}
+	else if(field0 == NULL)
+	{
+		ret = ERR_SIM_FIELD0;
+	}
+	else if(fine0.boundaryCondition == NULL)
+	{
+		ret = ERR_SIM_BOUNDARY;
+	}
+	if(ret == ERR_OK)
+	{
+		unsigned nn, nx, ny, nz;
+		bool isBox;
+		ret = FDTD::ReadGridSize(taskConfig, &nn, &nx, &ny, &nz, &isBox);
+		if(ret == ERR_INVALID_SIZE)
+		{
+			ret = ERR_TP_INVALID_N;
+		}
+		if(ret == ERR_OK)
+		{
+			s = taskConfig->getString(TP_SIMTFSF_DLL, true);
+			if(isBox || (s != NULL && strlen(s) > 0))
+			{
+				ret = ERR_SIM_PARAREAL;
+			}
+			maxRadius = GRIDRADIUS(nn);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		maxTimeIndex = (size_t)taskConfig->getLong(TP_MAX_TIMESTEP, false);
+		sliceCount = taskConfig->getUInt(TP_PARAREAL_SLICES, false);
+		maxIterations = taskConfig->getUInt(TP_PARAREAL_ITERATIONS, true);
+		tolerance = taskConfig->getDouble(TP_PARAREAL_TOL, true);
+		ret = taskConfig->getErrorCode();
+		if(ret == ERR_OK)
+		{
+			if(sliceCount == 0 || sliceCount > MAX_PARAREAL_SLICES || sliceCount > maxTimeIndex)
+			{
+				taskConfig->setNameOfInvalidValue(TP_PARAREAL_SLICES);
+				ret = ERR_TASK_INVALID_VALUE;
+			}
+			else if(tolerance < 0.0)
+			{
+				taskConfig->setNameOfInvalidValue(TP_PARAREAL_TOL);
+				ret = ERR_TASK_INVALID_VALUE;
+			}
+			else
+			{
+				if(maxIterations == 0 || maxIterations > sliceCount) maxIterations = sliceCount;
+				if(tolerance == 0.0) tolerance = 1.0e-6;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		s = taskConfig->getString(TP_SIMCOARSE_TASK, true);
+		if(s != NULL && strlen(s) > 0)
+		{
+			coarseTask = new TaskFile(s);
+			ret = coarseTask->getErrorCode();
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		puts("\r\nStarting parareal FDTD simulation. Press Ctrl-C to stop. \r\n Initialize propagators ...\r\n");
+		cancel_simulation_flag = false;
+		signal(SIGINT, &signals_handler);
+		seriesIndex = new RadiusIndexToSeriesIndex();
+		ret = seriesIndex->initialize(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = loadPropagators(taskConfig, libFolder);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = initPropagator(&coarse, coarseTask != NULL?coarseTask:taskConfig);
+		for(n=0;n<sliceCount && ret == ERR_OK;n++)
+		{
+			ret = initPropagator(&(fine[n]), taskConfig);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//a coarse correction is only meaningful if both propagators advance the same fields by the same time step
+		double dt = fine[0].fdtd->GetTimeStepSize();
+		fieldItems = fine[0].fdtd->GetMemoryItemCount();
+		if(coarse.fdtd->GetMemoryItemCount() != fieldItems || fabs(coarse.fdtd->GetTimeStepSize() - dt) > 1.0e-9 * dt)
+		{
+			ret = ERR_SIM_PROPAGATORS;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		U = (FieldPoint3D **)malloc((sliceCount+1) * sizeof(FieldPoint3D *));
+		G = (FieldPoint3D **)malloc((sliceCount+1) * sizeof(FieldPoint3D *));
+		F = (FieldPoint3D **)malloc((sliceCount+1) * sizeof(FieldPoint3D *));
+		if(U == NULL || G == NULL || F == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			for(n=0;n<=sliceCount;n++)
+			{
+				U[n] = G[n] = F[n] = NULL;
+			}
+			for(n=0;n<=sliceCount;n++)
+			{
+				U[n] = (FieldPoint3D *)AllocateTaggedMemory(fieldItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+				if(n > 0)
+				{
+					G[n] = (FieldPoint3D *)AllocateTaggedMemory(fieldItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+					F[n] = (FieldPoint3D *)AllocateTaggedMemory(fieldItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+				}
+				if(U[n] == NULL || (n > 0 && (G[n] == NULL || F[n] == NULL)))
+				{
+					ret = ERR_OUTOFMEMORY;
+					break;
+				}
+			}
+			if(ret == ERR_OK)
+			{
+				work = (FieldPoint3D *)AllocateTaggedMemory(fieldItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+				if(work == NULL)
+				{
+					ret = ERR_OUTOFMEMORY;
+				}
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		comparer = new FieldDataComparer(seriesIndex, maxRadius);
+		ret = comparer->GetLastHandlerError();
+	}
+	if(ret == ERR_OK)
+	{
+		//fields at time 0, populated by the fine propagator which parareal converges to
+		ret = fine[0].fdtd->PopulateFields(field0);
+		if(ret == ERR_OK)
+		{
+			FieldPoint3D *f0 = fine[0].fdtd->GetFieldMemory();
+			for(i=0;i<fieldItems;i++)
+			{
+				U[0][i] = f0[i];
+			}
+		}
+	}
+	//first guess by the coarse propagator
+	for(n=0;n<sliceCount && ret == ERR_OK;n++)
+	{
+		coarse.start = U[n];
+		coarse.result = G[n+1];
+		coarse.startIndex = sliceStart(n);
+		coarse.steps = sliceStart(n+1) - coarse.startIndex;
+		ret = Propagate(&coarse);
+		if(ret == ERR_OK)
+		{
+			for(i=0;i<fieldItems;i++)
+			{
+				U[n+1][i] = G[n+1][i];
+			}
+		}
+	}
+	//parareal iterations. after iteration k, slices 0,1,...,k are exact
+	for(k=0;k<maxIterations && ret == ERR_OK;k++)
+	{
+		reportProcess(reporter, false, "Parareal iteration %d. Running %d time slices in parallel, please wait ...", k, sliceCount - k);
+		ret = runFineInParallel(k);
+		change = 0.0;
+		for(n=k;n<sliceCount && ret == ERR_OK;n++)
+		{
+			if(n == k)
+			{
+				//U[k] did not change, so the coarse correction is 0
+				for(i=0;i<fieldItems;i++)
+				{
+					work[i] = F[n+1][i];
+				}
+			}
+			else
+			{
+				coarse.start = U[n];
+				coarse.result = work;
+				coarse.startIndex = sliceStart(n);
+				coarse.steps = sliceStart(n+1) - coarse.startIndex;
+				ret = Propagate(&coarse);
+				if(ret == ERR_OK)
+				{
+					//work = G(new) + F - G(old); G[n+1] = G(new)
+					FieldPoint3D g;
+					for(i=0;i<fieldItems;i++)
+					{
+						g = work[i];
+						work[i].E.x = g.E.x + F[n+1][i].E.x - G[n+1][i].E.x;
+						work[i].E.y = g.E.y + F[n+1][i].E.y - G[n+1][i].E.y;
+						work[i].E.z = g.E.z + F[n+1][i].E.z - G[n+1][i].E.z;
+						work[i].H.x = g.H.x + F[n+1][i].H.x - G[n+1][i].H.x;
+						work[i].H.y = g.H.y + F[n+1][i].H.y - G[n+1][i].H.y;
+						work[i].H.z = g.H.z + F[n+1][i].H.z - G[n+1][i].H.z;
+						G[n+1][i] = g;
+					}
+				}
+			}
+			if(ret == ERR_OK)
+			{
+				c = relativeChange(work, U[n+1]);
+				if(c > change) change = c;
+				for(i=0;i<fieldItems;i++)
+				{
+					U[n+1][i] = work[i];
+				}
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			reportProcess(reporter, false, "Parareal iteration %d finished. Largest relative change of fields: %g", k, change);
+			if(change <= tolerance)
+			{
+				break;
+			}
+			if(cancel_simulation_flag) //user terminates simulation
+			{
+				ret = ERR_SIMULATION_CANCEL;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		ret = saveFields(taskConfig, dataFolder);
+	}
+	if(fine != NULL)
+	{
+		for(n=0;n<sliceCount;n++)
+		{
+			if(fine[n].fdtd != NULL)
+			{
+				fine[n].fdtd->FinishSimulation();
+			}
+		}
+	}
+	if(coarse.fdtd != NULL)
+	{
+		coarse.fdtd->FinishSimulation();
+	}
+	cleanup();
+	return ret;
+}
@@ -0,0 +1,109 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "..\EMField\FieldSource.h"
+#include "..\EMField\BoundaryCondition.h"
+#include "..\ProcessMonitor\workProcess.h"
+#include "..\FileUtil\taskFile.h"
+#include "..\FieldDataComparer\FieldDataComparer.h"
+#include "FieldSimulation.h"
+
+//largest number of time slices; each slice is run by one thread
+#define MAX_PARAREAL_SLICES 64
+
+/*
+	a propagator: an FDTD object with its own boundary condition and field source.
+	it advances fields from the start of a time slice to the end of the time slice
+*/
+typedef struct PararealPropagator
+{
+	FDTD *fdtd;
+	BoundaryCondition *boundaryCondition;
+	FieldSource *source;   //optional
+	//work of one time slice
+	FieldPoint3D *start;   //fields at the start of the time slice
+	FieldPoint3D *result;  //fields at the end of the time slice
+	size_t startIndex;     //time index at the start of the time slice
+	size_t steps;          //time steps of the time slice
+	int maxRadius;
+	int ret;               //error code of the last propagation
+}PararealPropagator;
+
+/*
+	time-parallel EM fields simulation by the parareal algorithm.
+
+	the simulation time is divided into time slices. a cheap coarse propagator G (i.e. YeeFDTD, or a low order TSS)
+	goes through the slices sequentially; an accurate fine propagator F (i.e. a high order TSS) goes through
+	all slices in parallel threads. for iteration k, at the end of slice n:
+		U(n+1, k+1) = G(U(n, k+1)) + F(U(n, k)) - G(U(n, k))
+	after iteration k the first k+1 slices are the same as a sequential fine simulation. iterations stop when
+	the largest relative change of the fields at the ends of the slices, measured by FieldDataComparer, is within PARAREAL.TOL.
+
+	task parameters, in addition to those used by FieldSimulation:
+		SIM.COARSE_DLL, SIM.COARSE_NAME - the coarse FDTD module; SIM.FDTD_DLL and SIM.FDTD_NAME give the fine FDTD module
+		SIM.COARSE_TASK - optional, a task file for initializing the coarse module, i.e. using lower estimation orders.
+		                  it must use the same FDTD.N and FDTD.R. if it is missing then the simulation task file is used
+		PARAREAL.SLICES - number of time slices, 1 to MAX_PARAREAL_SLICES
+		PARAREAL.MAX_ITERATIONS - optional, default to PARAREAL.SLICES
+		PARAREAL.TOL - optional, default to 1.0e-6
+
+	the fields at the end of each time slice are saved to {SIM.BASENAME}{n}.em in the data folder, n is the time index.
+	a rectangular domain and a TF/SF boundary are not supported; a field source must only depend on the time given by FieldSource::reset
+*/
+class PararealSimulation:public virtual RadiusIndexCacheUser
+{
+private:
+	int maxRadius;
+	size_t fieldItems;
+	size_t maxTimeIndex;
+	unsigned sliceCount;
+	unsigned maxIterations;
+	double tolerance;
+	fnProgressReport reporter;
+	//
+	FieldsInitializer *field0;           //initial values
+	PararealPropagator coarse;           //coarse propagator
+	PararealPropagator fine0;            //plug-in objects loaded by the console, used by the first time slice
+	PararealPropagator *fine;            //[sliceCount], fine propagator of each time slice
+	TaskFile *coarseTask;                //task file for the coarse propagator, NULL if the simulation task file is used
+	//
+	FieldPoint3D **U;                    //[sliceCount+1], fields at the start of each time slice, U[sliceCount] at the end of the simulation
+	FieldPoint3D **G;                    //[sliceCount+1], coarse propagation of the previous iteration, G[n] ends at U[n]
+	FieldPoint3D **F;                    //[sliceCount+1], fine propagation of the current iteration, F[n] ends at U[n]
+	FieldPoint3D *work;
+	FieldDataComparer *comparer;
+	//
+	size_t sliceStart(unsigned n);
+	int loadPropagators(TaskFile *taskConfig, char *libFolder);
+	int initPropagator(PararealPropagator *p, TaskFile *taskConfig);
+	int runFineInParallel(unsigned firstSlice);
+	double relativeChange(FieldPoint3D *newFields, FieldPoint3D *oldFields);
+	int saveFields(TaskFile *taskConfig, const char *dataFolder);
+	void cleanup();
+public:
+	PararealSimulation();
+	~PararealSimulation();
+	void setReporter(fnProgressReport rep){reporter = rep;}
+	//plug-in objects loaded by the console are used by the first time slice
+	void setFDTD(FDTD* obj){fine0.fdtd = obj;}
+	void setFieldInitializer(FieldsInitializer *obj){field0 = obj;}
+	void setFieldSource(FieldSource *obj){fine0.source = obj;}
+	void setBoundaryCondition(BoundaryCondition *obj){fine0.boundaryCondition = obj;}
+	/*
+		run a parareal simulation and save fields at the end of each time slice to data files.
+		libFolder is for loading more plug-in objects for the coarse propagator and the other time slices
+	*/
+	int simulationToFiles(TaskFile *taskConfig, const char *dataFolder, char *libFolder);
+	//
+	/*
+		advance p->start by p->steps time steps into p->result
+	*/
+	static int Propagate(PararealPropagator *p);
+};
@@ -0,0 +1,497 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\FileUtil\fileutil.h"
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\memman.h"
+#include "SubgridPatch.h"
+#include "simConsole.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+//handleData passes
+#define PASS_FILL  0 //all fine points from the coarse fields
+#define PASS_GHOST 1 //fine points within ghost of the patch faces from the coarse fields
+
+/*
+	shift of each component from its grid point, in space steps, for Yee's layout.
+	components are numbered 0-5 for Ex, Ey, Ez, Hx, Hy, Hz
+*/
+static const double yeeShift[6][3] = {
+	{0.5, 0.0, 0.0}, {0.0, 0.5, 0.0}, {0.0, 0.0, 0.5},
+	{0.0, 0.5, 0.5}, {0.5, 0.0, 0.5}, {0.5, 0.5, 0.0}
+};
+static const double noShift[3] = {0.0, 0.0, 0.0};
+
+static double *fieldComponent(FieldPoint3D *f, int c)
+{
+	switch(c)
+	{
+	case 0: return &(f->E.x);
+	case 1: return &(f->E.y);
+	case 2: return &(f->E.z);
+	case 3: return &(f->H.x);
+	case 4: return &(f->H.y);
+	default: return &(f->H.z);
+	}
+}
+
+SubgridPatch::SubgridPatch(void)
+{
+	coarse = NULL;
+	fine = NULL;
+	fineTask = NULL;
+	fineIndex = NULL;
+	seriesIndex = NULL;
+	ratio = 0;
+	centerX = centerY = centerZ = 0;
+	fineRadius = 0;
+	ghost = 0;
+	boxRadius = 0;
+	boxSize = 0;
+	boxItems = 0;
+	coarseStaggered = fineStaggered = false;
+	coarseOld = NULL;
+	coarseNew = NULL;
+	for(int k=0;k<=MAX_SUBGRID_RATIO;k++)
+	{
+		restricted[k] = NULL;
+	}
+	_pass = PASS_FILL;
+	_fields = NULL;
+	_wE = _wH = 0.0;
+}
+SubgridPatch::~SubgridPatch(void)
+{
+	cleanup();
+	if(fineTask != NULL)
+	{
+		delete fineTask;
+		fineTask = NULL;
+	}
+}
+void SubgridPatch::cleanup()
+{
+	if(coarseOld != NULL)
+	{
+		FreeMemory(coarseOld);
+		coarseOld = NULL;
+	}
+	if(coarseNew != NULL)
+	{
+		FreeMemory(coarseNew);
+		coarseNew = NULL;
+	}
+	for(int k=0;k<=MAX_SUBGRID_RATIO;k++)
+	{
+		if(restricted[k] != NULL)
+		{
+			FreeMemory(restricted[k]);
+			restricted[k] = NULL;
+		}
+	}
+	if(fineIndex != NULL)
+	{
+		delete fineIndex;
+		fineIndex = NULL;
+	}
+}
+/*
+	the fine FDTD module defaults to the module of the simulation
+*/
+int SubgridPatch::load(TaskFile *taskConfig, char *libFolder)
+{
+	int ret = ERR_OK;
+	char *dll;
+	char *name;
+	char *s = taskConfig->getString(TP_SUBGRID_TASK, false);
+	ret = taskConfig->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		fineTask = new TaskFile(s);
+		ret = fineTask->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		dll = taskConfig->getString(TP_SUBGRID_DLL, true);
+		name = taskConfig->getString(TP_SUBGRID_NAME, true);
+		if(dll == NULL || strlen(dll) == 0)
+		{
+			dll = taskConfig->getString(TP_SIMFDTD_DLL, true);
+			name = taskConfig->getString(TP_SIMFDTD_NAME, true);
+		}
+		fine = (FDTD *)loadPluginInstance(libFolder, dll, name, &ret);
+		if(ret == ERR_OK)
+		{
+			if(fine == NULL)
+			{
+				ret = ERR_SIM_FDTD;
+			}
+			else
+			{
+				fine->SetMemoryManager(_mem);
+			}
+		}
+	}
+	return ret;
+}
+/*
+	coarse fields around the patch
+*/
+void SubgridPatch::copyCoarse(FieldPoint3D *dest)
+{
+	FieldPoint3D *fields = coarse->GetFieldMemory();
+	for(int m=-boxRadius;m<=boxRadius;m++)
+	{
+		for(int n=-boxRadius;n<=boxRadius;n++)
+		{
+			for(int p=-boxRadius;p<=boxRadius;p++)
+			{
+				dest[boxIndex(m, n, p)] = fields[SINDEX(centerX + m, centerY + n, centerZ + p)];
+			}
+		}
+	}
+}
+/*
+	component c at (x,y,z), in coarse space steps from the patch center, interpolated trilinearly in space.
+	w is the weight of the coarse fields after the coarse time step
+*/
+double SubgridPatch::coarseComponent(int c, double x, double y, double z, double w)
+{
+	const double *s = coarseStaggered?yeeShift[c]:noShift;
+	double u = x - s[0], v = y - s[1], t = z - s[2];
+	int m0 = (int)floor(u), n0 = (int)floor(v), p0 = (int)floor(t);
+	double a = u - (double)m0, b = v - (double)n0, g = t - (double)p0;
+	double weight, value = 0.0;
+	size_t i;
+	for(int dm=0;dm<2;dm++)
+	{
+		for(int dn=0;dn<2;dn++)
+		{
+			for(int dp=0;dp<2;dp++)
+			{
+				weight = (dm?a:1.0-a) * (dn?b:1.0-b) * (dp?g:1.0-g);
+				if(weight != 0.0)
+				{
+					i = boxIndex(m0 + dm, n0 + dn, p0 + dp);
+					value += weight * ((1.0 - w) * (*fieldComponent(&(coarseOld[i]), c)) + w * (*fieldComponent(&(coarseNew[i]), c)));
+				}
+			}
+		}
+	}
+	return value;
+}
+/*
+	position of component c of coarse point (m,n,p), relative to the patch center, in fine space steps.
+	returns false if its interpolation uses fine points within 2*ghost of the patch faces
+*/
+bool SubgridPatch::fineStencil(int c, int m, int n, int p, double *fx, double *fy, double *fz)
+{
+	const double *sc = coarseStaggered?yeeShift[c]:noShift;
+	const double *sf = fineStaggered?yeeShift[c]:noShift;
+	int limit = fineRadius - 2 * ghost;
+	*fx = ((double)m + sc[0]) * (double)ratio - sf[0];
+	*fy = ((double)n + sc[1]) * (double)ratio - sf[1];
+	*fz = ((double)p + sc[2]) * (double)ratio - sf[2];
+	return floor(*fx) >= -limit && floor(*fx) + 1 <= limit
+		&& floor(*fy) >= -limit && floor(*fy) + 1 <= limit
+		&& floor(*fz) >= -limit && floor(*fz) + 1 <= limit;
+}
+double SubgridPatch::fineComponent(int c, double fx, double fy, double fz)
+{
+	FieldPoint3D *fields = fine->GetFieldMemory();
+	int i0 = (int)floor(fx), j0 = (int)floor(fy), k0 = (int)floor(fz);
+	double a = fx - (double)i0, b = fy - (double)j0, g = fz - (double)k0;
+	double weight, value = 0.0;
+	for(int di=0;di<2;di++)
+	{
+		for(int dj=0;dj<2;dj++)
+		{
+			for(int dk=0;dk<2;dk++)
+			{
+				weight = (di?a:1.0-a) * (dj?b:1.0-b) * (dk?g:1.0-g);
+				if(weight != 0.0)
+				{
+					value += weight * (*fieldComponent(&(fields[fineIndex->Index(i0 + di, j0 + dj, k0 + dk)]), c));
+				}
+			}
+		}
+	}
+	return value;
+}
+/*
+	fine fields at the coarse points inside the patch
+*/
+void SubgridPatch::restrictFine(FieldPoint3D *dest)
+{
+	double fx, fy, fz;
+	for(int m=-boxRadius;m<=boxRadius;m++)
+	{
+		for(int n=-boxRadius;n<=boxRadius;n++)
+		{
+			for(int p=-boxRadius;p<=boxRadius;p++)
+			{
+				FieldPoint3D *f = &(dest[boxIndex(m, n, p)]);
+				for(int c=0;c<6;c++)
+				{
+					if(fineStencil(c, m, n, p, &fx, &fy, &fz))
+					{
+						*fieldComponent(f, c) = fineComponent(c, fx, fy, fz);
+					}
+				}
+			}
+		}
+	}
+}
+/*
+	for PASS_GHOST, radiuses not within ghost of the patch faces are skipped; index is moved to the next radius
+*/
+RadiusHandleType SubgridPatch::setRadius(int radius)
+{
+	r = radius;
+	if(_pass == PASS_GHOST && radius <= fineRadius - ghost)
+	{
+		index = totalPointsInSphere(radius);
+		return DoNotProcess;
+	}
+	return NeedProcess;
+}
+void SubgridPatch::handleData(int m, int n, int p)
+{
+	const double *s;
+	FieldPoint3D *f = &(_fields[index]);
+	for(int c=0;c<6;c++)
+	{
+		s = fineStaggered?yeeShift[c]:noShift;
+		*fieldComponent(f, c) = coarseComponent(c, ((double)m + s[0]) / (double)ratio, ((double)n + s[1]) / (double)ratio, ((double)p + s[2]) / (double)ratio, c < 3?_wE:_wH);
+	}
+	index++;
+}
+int SubgridPatch::initialize(FDTD *coarseFDTD, TaskFile *taskConfig, const char *dataFolder)
+{
+	int ret = ERR_OK;
+	unsigned n, nx, ny, nz;
+	bool isBox;
+	cleanup();
+	coarse = coarseFDTD;
+	if(fine == NULL || fineTask == NULL)
+	{
+		ret = ERR_SIM_FDTD;
+	}
+	else
+	{
+		centerX = taskConfig->getInt(TP_SUBGRID_CENTERX, true);
+		centerY = taskConfig->getInt(TP_SUBGRID_CENTERY, true);
+		centerZ = taskConfig->getInt(TP_SUBGRID_CENTERZ, true);
+		ghost = (int)taskConfig->getUInt(TP_SUBGRID_GHOST, true);
+		ret = taskConfig->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		//the fine grid is a cube
+		ret = FDTD::ReadGridSize(fineTask, &n, &nx, &ny, &nz, &isBox);
+		if(ret == ERR_OK && isBox)
+		{
+			ret = ERR_SIM_SUBGRID;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		fineIndex = new RadiusIndexToSeriesIndex();
+		ret = fineIndex->initialize(GRIDRADIUS(n));
+		if(ret == ERR_OK)
+		{
+			fine->setIndexCache(fineIndex);
+			ret = fine->initialize(dataFolder, NULL, fineTask);
+		}
+		if(ret == ERR_OK && fine->GetStepsPerMove() != 1)
+		{
+			//the faces of the patch are driven at every fine time step
+			ret = ERR_EMF_TIME_BLOCK;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//the space step and the time step must be 1/ratio of the coarse ones
+		double q = coarse->GetSpaceStepSize() / fine->GetSpaceStepSize();
+		ratio = (int)(q + 0.5);
+		if(ratio < 2 || ratio > MAX_SUBGRID_RATIO || fabs(q - (double)ratio) > 1.0e-6 * q)
+		{
+			ret = ERR_SIM_SUBGRID;
+		}
+		else if(fabs(fine->GetTimeStepSize() * (double)ratio - coarse->GetTimeStepSize()) > 1.0e-6 * coarse->GetTimeStepSize())
+		{
+			ret = ERR_SIM_SUBGRID;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		coarseStaggered = coarse->IsStaggered();
+		fineStaggered = fine->IsStaggered();
+		fineRadius = (int)fine->getMaxRadius();
+		if(ghost == 0)
+		{
+			ghost = (2 * fine->getHalfOrderTimeAdvance() - 1) * fine->getHalfOrderSpaceDerivate();
+		}
+		//at least one coarse point is inside the patch
+		if(fineRadius - 2 * ghost < ratio)
+		{
+			taskConfig->setNameOfInvalidValue(TP_SUBGRID_GHOST);
+			ret = ERR_TASK_INVALID_VALUE;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//coarse points used by interpolating the fine points
+		boxRadius = (fineRadius + ratio - 1) / ratio + 1;
+		boxSize = 2 * boxRadius + 1;
+		boxItems = (size_t)boxSize * boxSize * boxSize;
+		if(abs(centerX) + boxRadius > (int)coarse->getMaxRadiusX() || abs(centerY) + boxRadius > (int)coarse->getMaxRadiusY() || abs(centerZ) + boxRadius > (int)coarse->getMaxRadiusZ())
+		{
+			ret = ERR_SIM_SUBGRID;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		coarseOld = (FieldPoint3D *)AllocateTaggedMemory(boxItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+		coarseNew = (FieldPoint3D *)AllocateTaggedMemory(boxItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+		if(coarseOld == NULL || coarseNew == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		for(int k=0;k<=ratio && ret == ERR_OK;k++)
+		{
+			restricted[k] = (FieldPoint3D *)AllocateTaggedMemory(boxItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+			if(restricted[k] == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//fill the patch from the coarse fields at time 0
+		copyCoarse(coarseOld);
+		copyCoarse(coarseNew);
+		_fields = fine->GetFieldMemory();
+		_wE = _wH = 0.0;
+		_pass = PASS_FILL;
+		ret = gothroughSphere(fineRadius);
+		if(ret == ERR_OK)
+		{
+			restrictFine(restricted[0]);
+		}
+	}
+	return ret;
+}
+int SubgridPatch::beforeCoarseStep()
+{
+	copyCoarse(coarseOld);
+	return ERR_OK;
+}
+/*
+	time is measured in coarse time steps from the start of the coarse time step.
+	E of both grids is at the time of the step; H of a staggered grid is half a time step behind
+*/
+int SubgridPatch::afterCoarseStep()
+{
+	int ret = ERR_OK;
+	int k, kH;
+	double tH, tHfine0, alphaH;
+	FieldPoint3D *f;
+	double dtFine = 1.0 / (double)ratio;
+	double hCoarseOld = coarseStaggered?-0.5:0.0; //time of coarse H before the coarse time step
+	double hFine = fineStaggered?-0.5*dtFine:0.0;  //time of fine H relative to fine E
+	copyCoarse(coarseNew);
+	//sub-cycling
+	for(k=1;k<=ratio && ret == ERR_OK;k++)
+	{
+		ret = fine->moveForward();
+		if(ret == ERR_OK)
+		{
+			_fields = fine->GetFieldMemory();
+			_wE = (double)k * dtFine;
+			_wH = (double)k * dtFine + hFine - hCoarseOld;
+			_pass = PASS_GHOST;
+			ret = gothroughSphere(fineRadius);
+		}
+		if(ret == ERR_OK)
+		{
+			restrictFine(restricted[k]);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//coarse E is at time 1, taken from the last fine time step.
+		//coarse H is at time 1+hCoarseOld, interpolated between the 2 fine time steps around it
+		tH = 1.0 + hCoarseOld;
+		for(kH=1;kH<ratio;kH++)
+		{
+			if((double)kH * dtFine + hFine >= tH)
+			{
+				break;
+			}
+		}
+		tHfine0 = (double)(kH - 1) * dtFine + hFine;
+		alphaH = (tH - tHfine0) / dtFine;
+		FieldPoint3D *fields = coarse->GetFieldMemory();
+		double fx, fy, fz;
+		for(int m=-boxRadius;m<=boxRadius;m++)
+		{
+			for(int n=-boxRadius;n<=boxRadius;n++)
+			{
+				for(int p=-boxRadius;p<=boxRadius;p++)
+				{
+					size_t i = boxIndex(m, n, p);
+					f = &(fields[SINDEX(centerX + m, centerY + n, centerZ + p)]);
+					for(int c=0;c<6;c++)
+					{
+						if(fineStencil(c, m, n, p, &fx, &fy, &fz))
+						{
+							if(c < 3)
+							{
+								*fieldComponent(f, c) = *fieldComponent(&(restricted[ratio][i]), c);
+							}
+							else
+							{
+								double h0 = *fieldComponent(&(restricted[kH-1][i]), c);
+								double h1 = *fieldComponent(&(restricted[kH][i]), c);
+								*fieldComponent(f, c) = h0 + alphaH * (h1 - h0);
+							}
+						}
+					}
+				}
+			}
+		}
+		//the last fine time step starts the next coarse time step
+		f = restricted[0];
+		restricted[0] = restricted[ratio];
+		restricted[ratio] = f;
+	}
+	return ret;
+}
+void SubgridPatch::FinishSimulation()
+{
+	if(fine != NULL)
+	{
+		fine->FinishSimulation();
+	}
+}
+void SubgridPatch::ShowSummary()
+{
+	if(fine != NULL)
+	{
+		printf("\r\nRefined patch: ratio %d, center (%d,%d,%d), %d fine space points at each side of an axis, time index %d.\r\n",
+			ratio, centerX, centerY, centerZ, fineRadius, fine->GetTimeStepIndex());
+		if(fine->EnabledFDTDtimeRecording())
+		{
+			printf("Average patch FDTD step time:%g, total patch FDTD time:%g\r\n", fine->GetAverageFDTDOneStepTime(), fine->GetSumFDTDOneStepTime());
+		}
+	}
+}
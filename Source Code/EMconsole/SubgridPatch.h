@@ -0,0 +1,91 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "..\FileUtil\taskFile.h"
+#include "FieldSimulation.h"
+
+//largest refinement ratio of a patch
+#define MAX_SUBGRID_RATIO 4
+
+/*
+	a locally refined patch embedded in the grid of a simulation.
+
+	the patch is a cubic grid simulated by its own FDTD object (the fine FDTD), with a space step and a time step
+	1/ratio of the simulation's (the coarse FDTD), ratio = 2, 3 or 4. for each coarse time step the fine FDTD makes
+	ratio time steps (sub-cycling). after each fine time step the points within SUBGRID.GHOST of the patch faces are
+	overwritten by the coarse fields, interpolated trilinearly in space and linearly in time between the coarse fields
+	before and after the coarse time step. after the sub-cycling the coarse fields inside the patch are replaced by the fine fields
+	interpolated to the coarse points, so the coarse data files hold the refined solution.
+
+	the positions and times of field components come from FDTD::IsStaggered of each FDTD object, so a TSS patch
+	can be used in a Yee grid and the other way round.
+
+	task parameters of the simulation task file:
+		SUBGRID.TASK - task file for the fine FDTD: FDTD.N, FDTD.R, estimation orders, SIM.BASENAME for its own data files
+		               and FDTD.RECTIMESTEP for its own time statistics. FDTD.R/(2*FDTD.N+1) gives the fine space step
+		SUBGRID.FDTD_DLL, SUBGRID.FDTD_NAME - optional, the fine FDTD module; default to SIM.FDTD_DLL and SIM.FDTD_NAME
+		SUBGRID.CENTER_X, SUBGRID.CENTER_Y, SUBGRID.CENTER_Z - optional, coarse grid point at the patch center, default to 0
+		SUBGRID.GHOST - optional, width of the overwritten layer in fine space steps; default to the reach of
+		                the fine time step, (2*FDTD.HALF_ORDER_TIME-1)*FDTD.HALF_ORDER_SPACE of the fine task file
+	a field source is only applied to the coarse grid; a TF/SF boundary must be outside the patch
+*/
+class SubgridPatch: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	FDTD *coarse;
+	FDTD *fine;
+	TaskFile *fineTask;
+	RadiusIndexToSeriesIndex *fineIndex; //seriesIndex is for the coarse grid
+	int ratio;                           //coarse space step / fine space step
+	int centerX, centerY, centerZ;       //coarse grid point at the patch center
+	int fineRadius;                      //maximum radius of the fine grid
+	int ghost;                           //width of the fine points overwritten by the coarse fields
+	int boxRadius;                       //coarse points within boxRadius of the patch center along each axis are used by the patch
+	int boxSize;                         //2*boxRadius+1
+	size_t boxItems;
+	bool coarseStaggered, fineStaggered;
+	//
+	FieldPoint3D *coarseOld;             //[boxItems], coarse fields around the patch before a coarse time step
+	FieldPoint3D *coarseNew;             //[boxItems], coarse fields around the patch after a coarse time step
+	FieldPoint3D *restricted[MAX_SUBGRID_RATIO+1]; //[ratio+1][boxItems], fine fields at coarse points after each fine time step
+	//
+	int _pass;                           //what handleData does, see SubgridPatch.cpp
+	FieldPoint3D *_fields;               //fine fields being filled
+	double _wE, _wH;                     //time weights of coarseNew for E and H
+	//
+	size_t boxIndex(int m, int n, int p){return ((size_t)(m + boxRadius) * boxSize + (n + boxRadius)) * boxSize + (p + boxRadius);}
+	double coarseComponent(int c, double x, double y, double z, double w);
+	bool fineStencil(int c, int m, int n, int p, double *fx, double *fy, double *fz);
+	double fineComponent(int c, double fx, double fy, double fz);
+	void copyCoarse(FieldPoint3D *dest);
+	void restrictFine(FieldPoint3D *dest);
+	void cleanup();
+protected:
+	virtual RadiusHandleType setRadius(int radius);
+	virtual void handleData(int m, int n, int p);
+public:
+	SubgridPatch(void);
+	~SubgridPatch(void);
+	/*
+		load the fine FDTD object and the fine task file given by the simulation task file
+	*/
+	int load(TaskFile *taskConfig, char *libFolder);
+	/*
+		initialize the fine FDTD object and fill the patch from the coarse fields.
+		call it after the coarse fields are populated
+	*/
+	int initialize(FDTD *coarseFDTD, TaskFile *taskConfig, const char *dataFolder);
+	//call it before the coarse FDTD moves forward
+	int beforeCoarseStep();
+	//call it after the coarse FDTD moves forward; the fine FDTD makes ratio time steps and the coarse fields inside the patch are replaced
+	int afterCoarseStep();
+	void FinishSimulation();
+	void ShowSummary();
+};
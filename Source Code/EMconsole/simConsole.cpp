@@ -21,13 +21,21 @@
 #include "..\MemoryMan\MemoryManager.h"
 #include "..\MathTools\MathTools.h"
 #include "..\TssInSphere\TssInSphere.h"
+#include "..\PstdFDTD\PstdFDTD.h"
+#include "..\YeeFDTD\YeeFDTDRowMajor.h"
 #include "..\FileUtil\taskFile.h"
 #include "taskdef.h"
 #include "FieldSimulation.h"
+#include "PararealSimulation.h"
+#include "SubgridPatch.h"
+#include "ImpulseResponse.h"
+#include "EnsembleSimulation.h"
 
 /*
 	memory manager is used to allocate large size memories.
 	it uses file mapping to allocate memories; the memory limit is drive capacity, not RAM.
+	temporary memories are taken from a pool of RAM blocks until the RAM budget (MEMORY.RAM_BUDGET) is used up,
+	then they are mapped to files as well.
 	the drive speed affects the program speed. for large domain simulations, it is a good idea to use high speed drives.
 	if memory contents are not needed after executing the program then the memory is allocate in work folder specified
 	by command line parameter /W
@@ -62,6 +70,7 @@ int main(int argc, char* argv[])
 	BoundaryCondition                  *BCplugin = NULL;
 	FieldSource                        *FSplugin = NULL;
 	TotalFieldScatteredFieldBoundary *TFSFplugin = NULL;
+	MaterialMaskInitializer          *MASKplugin = NULL;
 	////////////////////////////////////////////////////////////////////////////////
 	TaskFile *taskfile = NULL; //task file object for reading task parameters
 	int taskIndex = -1; //index into tasks array identifying the task to run
@@ -165,6 +174,7 @@ int main(int argc, char* argv[])
 				if(DirectoryExists(workfolderW))
 				{
 					_mem = new MemoryManager(workfolderW);
+					ret = setMemoryOptions(taskfile);
 				}
 				else
 				{
@@ -196,6 +206,7 @@ int main(int argc, char* argv[])
 				BCplugin   = (BoundaryCondition *)loadPluginInstance(libFolder, taskfile->getString(TP_SIMBC_DLL, true), taskfile->getString(TP_SIMBC_NAME, true), &ret);
 				FSplugin   = (FieldSource *)loadPluginInstance(libFolder, taskfile->getString(TP_SIMFS_DLL, true), taskfile->getString(TP_SIMFS_NAME, true), &ret);
 				TFSFplugin = (TotalFieldScatteredFieldBoundary *)loadPluginInstance(libFolder, taskfile->getString(TP_SIMTFSF_DLL, true), taskfile->getString(TP_SIMTFSF_NAME, true), &ret);
+				MASKplugin = (MaterialMaskInitializer *)loadPluginInstance(libFolder, taskfile->getString(TP_SIMMASK_DLL, true), taskfile->getString(TP_SIMMASK_NAME, true), &ret);
 				if(ret == ERR_OK)
 				{
 					if(FDTDplugin != NULL) FDTDplugin->SetMemoryManager(_mem);
@@ -203,6 +214,16 @@ int main(int argc, char* argv[])
 					if(BCplugin   != NULL) BCplugin->SetMemoryManager(_mem);
 					if(FSplugin   != NULL) FSplugin->SetMemoryManager(_mem);
 					if(TFSFplugin != NULL) TFSFplugin->SetMemoryManager(_mem);
+					if(MASKplugin != NULL) MASKplugin->SetMemoryManager(_mem);
+				}
+				if(ret == ERR_OK && MASKplugin != NULL)
+				{
+					//the FDTD module forms its material mask by the initializer when it is initialized
+					ret = MASKplugin->initialize(taskfile);
+					if(ret == ERR_OK && FDTDplugin != NULL)
+					{
+						FDTDplugin->SetMaskInitializer(MASKplugin);
+					}
 				}
 			}
 		}
@@ -261,6 +282,9 @@ int main(int argc, char* argv[])
 				ret = task3_sphereIndexSpeedTest(N);
 			}
 			break;
+		case TASK_TEST_NUMA_BANDWIDTH:
+			ret = task6_numaBandwidthTest(taskfile);
+			break;
 		case TASK_TEST_FDTD_INIT_FLD:
 			if(IVplugin == NULL)
 			{
@@ -340,7 +364,93 @@ int main(int argc, char* argv[])
 				sim->setBoundaryCondition(BCplugin);
 				sim->setFieldSource(FSplugin);
 				sim->setTFST(TFSFplugin);
-				ret = sim->simulationToFiles(taskfile, dataFolder);
+				//optional locally refined patch
+				SubgridPatch *patch = NULL;
+				char *subgridTask = taskfile->getString(TP_SUBGRID_TASK, true);
+				if(subgridTask != NULL && strlen(subgridTask) > 0)
+				{
+					patch = new SubgridPatch();
+					ret = patch->load(taskfile, libFolder);
+					sim->setSubgridPatch(patch);
+				}
+				if(ret == ERR_OK)
+				{
+					ret = sim->simulationToFiles(taskfile, dataFolder);
+				}
+				if(patch != NULL)
+				{
+					delete patch;
+				}
+			}
+			break;
+		case TASK_PARAREAL_SIMULATION:
+			if(IVplugin == NULL)
+			{
+				ret = ERR_TP_IV;
+			}
+			else if(BCplugin == NULL)
+			{
+				ret = ERR_TP_BC;
+			}
+			else if(FDTDplugin == NULL)
+			{
+				ret = ERR_TP_FDTD;
+			}
+			if(ret == ERR_OK)
+			{
+				PararealSimulation *psim = new PararealSimulation();
+				psim->setReporter(showProgressReport);
+				psim->setFDTD(FDTDplugin);
+				psim->setFieldInitializer(IVplugin);
+				psim->setBoundaryCondition(BCplugin);
+				psim->setFieldSource(FSplugin);
+				ret = psim->simulationToFiles(taskfile, dataFolder, libFolder);
+				delete psim;
+			}
+			break;
+		case TASK_IMPULSE_RESPONSE:
+			if(IVplugin == NULL)
+			{
+				ret = ERR_TP_IV;
+			}
+			else if(BCplugin == NULL)
+			{
+				ret = ERR_TP_BC;
+			}
+			else if(FDTDplugin == NULL)
+			{
+				ret = ERR_TP_FDTD;
+			}
+			if(ret == ERR_OK)
+			{
+				ImpulseResponseSimulation *isim = new ImpulseResponseSimulation();
+				isim->setReporter(showProgressReport);
+				isim->setFDTD(FDTDplugin);
+				isim->setFieldInitializer(IVplugin);
+				isim->setBoundaryCondition(BCplugin);
+				isim->setFieldSource(FSplugin);
+				ret = isim->simulationToFiles(taskfile, dataFolder);
+				delete isim;
+			}
+			break;
+		case TASK_ENSEMBLE_SIMULATION:
+			if(IVplugin == NULL)
+			{
+				ret = ERR_TP_IV;
+			}
+			else if(BCplugin == NULL)
+			{
+				ret = ERR_TP_BC;
+			}
+			if(ret == ERR_OK)
+			{
+				EnsembleSimulation *esim = new EnsembleSimulation();
+				esim->setReporter(showProgressReport);
+				esim->setFieldInitializer(IVplugin);
+				esim->setBoundaryCondition(BCplugin);
+				esim->setFieldSource(FSplugin);
+				ret = esim->simulationToFiles(taskfile, dataFolder, libFolder);
+				delete esim;
 			}
 			break;
 		case TASK_COMPARE_DATA_FILES:
@@ -379,6 +489,7 @@ int main(int argc, char* argv[])
 				puts("\r\n\r\nTask finished");
 			}
 		}
+		showMemoryUsage();
 	}
 	else
 	{
@@ -552,6 +663,9 @@ void showError(const char *msg, int err)
 	case ERR_INVALID_DATA_FOLDER:     //28
 		printf("data folder does not exist. (signal=%d)",err);
 		break;
+	case ERR_TFSF_INCIDENT:           //29
+		printf("The TFSF module does not provide incident fields; it cannot be used with this FDTD module. (signal=%d)",err);
+		break;
 	//
 	case ERR_CMD_COMMANDLINE:       //100
 		printf("Invalid command line. Cannot interpret the command line syntax (error=%d)",err);
@@ -610,6 +724,27 @@ void showError(const char *msg, int err)
 	case ERR_TSS_DERIVATIVE://    202
 		printf("missing space derivative estimator (error=%d)", err);
 		break;
+	case ERR_TSS_HYBRID_TFSF://   203
+		printf("A TF/SF boundary is not supported by the hybrid TSS/Yee FDTD module (error=%d)", err);
+		break;
+	case ERR_TSS_WAVE_TFSF://     204
+		printf("A TF/SF boundary is not supported by the wave equation FDTD module (error=%d)", err);
+		break;
+	case ERR_TSS_WAVE_UNSTABLE:// 205
+		printf("The wave equation FDTD module is unstable with the space estimation order; use a larger FDTD.HALF_ORDER_TIME (error=%d)", err);
+		break;
+	case ERR_TSS_ENSEMBLE://      206
+		printf("An ensemble has 1 to 64 members, and does not support rectangular domains and TF/SF boundaries (error=%d)", err);
+		break;
+	case ERR_TSS_MATERIALS://     207
+		printf("Too many materials in the inhomogeneous environment; at most 65536 pairs of Permeability and Permittivity are supported (error=%d)", err);
+		break;
+	case ERR_TSS_VOXEL://         208
+		printf("The voxel model file does not match its header, or task parameters VOXEL.DIMS and VOXEL.BYTES (error=%d)", err);
+		break;
+	case ERR_TSS_THREAD://        209
+		printf("Error creating a thread for the TSS module. (error=%d)", err);
+		break;
 
 	case ERR_SIM_FDTD://     300
 		printf("FDTD module not loaded (error=%d)", err);
@@ -623,6 +758,27 @@ void showError(const char *msg, int err)
 	case ERR_SIM_MONOTONIC:// 303
 		printf("Sorting algoritm error: result list is not monotonic (error=%d)", err);
 		break;
+	case ERR_SIM_COARSE://    304
+		printf("Coarse FDTD module not loaded. Check task parameters SIM.COARSE_DLL and SIM.COARSE_NAME (error=%d)", err);
+		break;
+	case ERR_SIM_PROPAGATORS:// 305
+		printf("The coarse and the fine FDTD modules do not use the same time step and space points (error=%d)", err);
+		break;
+	case ERR_SIM_THREAD://    306
+		printf("Cannot create a thread for a time slice (error=%d)", err);
+		break;
+	case ERR_SIM_PARAREAL://  307
+		printf("Parareal simulation does not support rectangular domains and TF/SF boundaries (error=%d)", err);
+		break;
+	case ERR_SIM_SUBGRID://   308
+		printf("The refined patch must use 1/2, 1/3 or 1/4 of the simulation space step and time step, be a cube, and fit in the simulation domain (error=%d)", err);
+		break;
+	case ERR_SIM_IMPULSE://    309
+		printf("Impulse response simulation does not support rectangular domains, TF/SF boundaries and refined patches (error=%d)", err);
+		break;
+	case ERR_SIM_IMPULSE_SOURCE:// 310
+		printf("The field source must only add values to the field component at the point given by IR.SOURCE and IR.SOURCE_COMPONENT (error=%d)", err);
+		break;
 
 	case ERR_TASKFIILE_INVALID://       380
 		printf("Invalid task parameter formatting. Each parameter value should be expressed as 'name=value' in one line in a task file. (error=%d)", err);
@@ -710,6 +866,24 @@ void showError(const char *msg, int err)
 	case ERR_EMF_EINVAL: //         2001
 		printf("Error formatning file name. (error=%d)",err);
 		break;
+	case ERR_EMF_BOX: //            2002
+		printf("The FDTD module does not support a rectangular domain. Check task parameters FDTD.NX, FDTD.NY and FDTD.NZ (error=%d)",err);
+		break;
+	case ERR_EMF_MASK: //           2003
+		printf("The FDTD module does not support a material mask. Check task parameters FDTD.MASK_FILE, FDTD.MASK_BOXES and SIM.MASK_DLL (error=%d)",err);
+		break;
+	case ERR_EMF_TIME_BLOCK: //     2004
+		printf("FDTD.TIME_BLOCK is only supported by a field simulation on a box domain without field sources, TF/SF boundaries and sub-grid patches, using boundary condition AbcFirstOrder (error=%d)",err);
+		break;
+	case ERR_PSTD_TFSF: //          2101
+		printf("A TF/SF boundary is not supported by the PSTD module (error=%d)",err);
+		break;
+	case ERR_PSTD_THREAD: //        2102
+		printf("Error creating a thread for the PSTD module. (error=%d)",err);
+		break;
+	case ERR_YEE_THREAD: //         2201
+		printf("Error creating a thread for the row-major Yee module. (error=%d)",err);
+		break;
 
 
 	case ERR_MEM_CREATE_FILE: //    6001
@@ -769,6 +943,18 @@ void showError(const char *msg, int err)
 	case ERR_MEM_DIR_NOTEXIST://   6019
 		printf("Folder does not exist. (error=%d)",err);
 		break;
+	case ERR_MEM_MAP_OPTION://     6020
+		printf("Invalid memory mapping option. Check task parameters MEMORY.SCRATCH, MEMORY.SNAPSHOT and MEMORY.INPUT (error=%d)",err);
+		break;
+	case ERR_MEM_BUDGET://         6021
+		printf("Memory limit reached. Check task parameter MEMORY.HARD_LIMIT (error=%d)",err);
+		break;
+	case ERR_MEM_PIN_THREAD://     6022
+		printf("Error pinning a thread to a processor. Check task parameter FDTD.PIN_THREADS (error=%d)",err);
+		break;
+	case ERR_MEM_HUGE_PAGE_SIZE:// 6023
+		printf("Invalid huge page size. Task parameter MEMORY.HUGE_PAGES can be 0, 2 or 1024 (error=%d)",err);
+		break;
 	case ERR_MEM_UNKNOWN: //       6030
 		printf("Unknown memory management error. (error=%d)",err);
 		break;
@@ -785,6 +971,9 @@ void showError(const char *msg, int err)
 	case ERR_MATH_NOT_INVERSE: //8004
 		printf("It is not an inverse matrix of a given matrix. (error=%d)",err);
 		break;
+	case ERR_MATH_FFT_SIZE:    //8005
+		printf("Invalid FFT length. (error=%d)",err);
+		break;
 	case ERR_MATH_MEM_SMALL:  //8100
 		printf("Memory allocated is too small. (error=%d)",err);
 		break;
@@ -924,6 +1113,106 @@ void *loadPluginInstance(char *libFolder, char *libName, char *className, int *r
 	return NULL;
 }
 
+/*
+	set the memory mapping options of each allocation purpose of the memory manager from the optional
+	task parameters MEMORY.SCRATCH, MEMORY.SNAPSHOT and MEMORY.INPUT, for example MEMORY.INPUT=SEQUENTIAL;WILLNEED.
+	a purpose without a task parameter keeps the default options of the memory manager.
+	the optional MEMORY.RAM_BUDGET gives the RAM budget in MB of the scratch memory pool
+*/
+int setMemoryOptions(TaskFile *taskfile)
+{
+	int ret = ERR_OK;
+	const char *names[MEM_PURPOSE_COUNT] = {TP_MEM_SCRATCH, TP_MEM_SNAPSHOT, TP_MEM_INPUT};
+	if(taskfile != NULL)
+	{
+		for(int i=0;i<MEM_PURPOSE_COUNT && ret == ERR_OK;i++)
+		{
+			char *value = taskfile->getString(names[i], true);
+			if(value != NULL)
+			{
+				unsigned options;
+				ret = ParseMappingOptions(value, &options);
+				if(ret == ERR_OK)
+				{
+					ret = _mem->SetMappingOptions(i, options);
+				}
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			if(taskfile->getString(TP_MEM_RAM_BUDGET, true) != NULL)
+			{
+				unsigned mb = taskfile->getUInt(TP_MEM_RAM_BUDGET, false);
+				ret = taskfile->getErrorCode();
+				if(ret == ERR_OK)
+				{
+					_mem->SetRamBudget((size_t)mb * 1024 * 1024);
+				}
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			if(taskfile->getString(TP_MEM_HARD_LIMIT, true) != NULL)
+			{
+				unsigned mb = taskfile->getUInt(TP_MEM_HARD_LIMIT, false);
+				ret = taskfile->getErrorCode();
+				if(ret == ERR_OK)
+				{
+					_mem->SetHardLimit((size_t)mb * 1024 * 1024);
+				}
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			if(taskfile->getString(TP_MEM_HUGE_PAGES, true) != NULL)
+			{
+				unsigned mb = taskfile->getUInt(TP_MEM_HUGE_PAGES, false);
+				ret = taskfile->getErrorCode();
+				if(ret == ERR_OK)
+				{
+					ret = _mem->SetHugePageSize((size_t)mb * 1024 * 1024);
+				}
+			}
+		}
+	}
+	return ret;
+}
+/*
+	show peak and current memory usage of each memory category, huge pages obtained, and the allocation refused by the hard limit, if any
+*/
+void showMemoryUsage()
+{
+	size_t used, peak;
+	size_t deniedSize;
+	int deniedTag;
+	const double MB = 1024.0 * 1024.0;
+	if(_mem == NULL)
+	{
+		return;
+	}
+	puts("\r\nMemory usage (MB)       peak    in use");
+	for(int tag=0;tag<MEM_TAG_COUNT;tag++)
+	{
+		_mem->GetUsage(tag, &used, &peak);
+		if(peak > 0)
+		{
+			printf(" %-16s %12.1f %9.1f\r\n", MemoryTagName(tag), (double)peak / MB, (double)used / MB);
+		}
+	}
+	_mem->GetUsage(MEM_TAG_COUNT, &used, &peak);
+	printf(" %-16s %12.1f %9.1f\r\n", "total", (double)peak / MB, (double)used / MB);
+	if(_mem->GetHugePageSize() > 0)
+	{
+		size_t obtained, fallbacks;
+		_mem->GetHugePageReport(&obtained, &fallbacks);
+		printf(" huge pages of %.0f MB obtained: %lu; blocks on small pages: %lu\r\n", (double)_mem->GetHugePageSize() / MB, (unsigned long)obtained, (unsigned long)fallbacks);
+	}
+	if(_mem->GetDeniedAllocation(&deniedSize, &deniedTag, &used))
+	{
+		printf("\r\n An allocation of %.1f MB for %s was refused: %.1f MB were in use and the limit %s is %.1f MB.\r\n", (double)deniedSize / MB, MemoryTagName(deniedTag), (double)used / MB, TP_MEM_HARD_LIMIT, (double)_mem->GetHardLimit() / MB);
+	}
+}
+
 
 
 
@@ -7,6 +7,7 @@
 ********************************************************************/
 #include "..\EMField\EMField.h"
 #include "..\TssInSphere\TssInSphere.h"
+#include "..\FileUtil\taskFile.h"
 
 #define NULL 0
 
@@ -61,5 +62,7 @@ void writeReport(char *message, bool sameline);
 int CreateReportFile(const char *filename);
 void CloseReportFile();
 void *loadPluginInstance(char *libFolder, char *libName, char *className, int *ret);
+int setMemoryOptions(TaskFile *taskfile);
+void showMemoryUsage();
 
 
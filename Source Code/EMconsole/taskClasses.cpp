@@ -65,7 +65,7 @@ int PickFieldPoints::initialize(size_t picks, FieldPoint3D *fields, FieldItem3D
 	ret = MEMMANEXIST;
 	if(ret == ERR_OK)
 	{
-		_magnitudes = (double *)AllocateMemory(sizeof(double)*picks);
+		_magnitudes = (double *)AllocateTaggedMemory(sizeof(double)*picks, MEM_TAG_STATISTICS);
 		if(_magnitudes == NULL)
 		{
 			ret = ERR_OUTOFMEMORY;
@@ -73,7 +73,7 @@ int PickFieldPoints::initialize(size_t picks, FieldPoint3D *fields, FieldItem3D
 	}
 	if(ret == ERR_OK)
 	{
-		_collectedIndexes = (size_t *)AllocateMemory(sizeof(size_t)*picks);
+		_collectedIndexes = (size_t *)AllocateTaggedMemory(sizeof(size_t)*picks, MEM_TAG_STATISTICS);
 		if(_collectedIndexes == NULL)
 		{
 			ret = ERR_OUTOFMEMORY;
@@ -24,6 +24,25 @@ public:
 	void setTotalIndex(size_t total, int interval);
 };
 
+//largest number of threads of task 6; it is the limit of WaitForMultipleObjects
+#define MAX_BANDWIDTH_THREADS 64
+
+/*
+	work of one thread of task 6: a block of x-planes of a row-major grid laid out as YeeFDTDRowMajor does
+*/
+typedef struct BandwidthWork
+{
+	double *c[6];        //Ex, Ey, Ez, Hx, Hy, Hz
+	size_t first;        //grid index of the first point of the block
+	size_t last;         //grid index after the last point of the block
+	unsigned sweeps;
+	int index;           //thread index
+	int threadCount;
+	bool pin;            //pin the thread by PinThreadToNode before it touches its block
+	unsigned long ticks; //time of the sweeps
+	int ret;
+}BandwidthWork;
+
 /*
 	
 */
@@ -16,12 +16,16 @@
 #define TASK_TEST_INDEX_SPEED     3
 #define TASK_TEST_FDTD_INIT_FLD   4
 #define TASK_TEST_FIELD_DIVER     5
+#define TASK_TEST_NUMA_BANDWIDTH  6
 #define TASK_FDTD_SIMULATION      100
 #define TASK_COMPARE_DATA_FILES   110
 #define TASK_MAKE_REPORT_FILES    120
 #define TASK_PICK_POINTS_FILES    130
 #define TASK_TWO_SUMFILES_TO_ONE  140
 #define TASK_2DS_SUMFILES_TO_ONE  160
+#define TASK_PARAREAL_SIMULATION  200
+#define TASK_IMPULSE_RESPONSE     210
+#define TASK_ENSEMBLE_SIMULATION  220
 
 /*
 	task definitions.
@@ -35,12 +39,16 @@ TaskInfo tasks[] = {
 	 ,{TASK_TEST_INDEX_SPEED,   false, false, "speed comparison between using function RadiusIndexToSeriesIndex and using a row-major 3D array looping; it requires a command line parameter \"/W\"; it requires a task parameter \"FDTD.N\""}
 	 ,{TASK_TEST_FDTD_INIT_FLD, false, false, "verify that the abstract class FDTD uses a field Initial Value module correctly. It requires command line parameters \"/W\" and \"/L\". It requires following task parameters: \"FDTD.N\", \"FDTD.R\", \"SIM.IV_DLL\" and \"SIM.IV_NAME\""}
 	 ,{TASK_TEST_FIELD_DIVER,   false, false, "verify an Initial Value module by divergences. It requires command line parameter \"/W\"; and \"/L\" is optional. It requires following task parameters: \"FDTD.N\", \"FDTD.R\", \"SIM.IV_DLL\", \"SIM.IV_NAME\" and \"FDTD.HALF_ORDER_SPACE\""}
+	 ,{TASK_TEST_NUMA_BANDWIDTH,false, false, "measure the memory bandwidth of each NUMA node by STREAM-style sweeps over the row-major grid of YeeFDTDRowMajor, once without and once with the threads pinned as FDTD.PIN_THREADS pins them. Each thread first touches its own block of x-planes before sweeping it. It requires a command line parameter \"/W\"; it requires a task parameter \"FDTD.N\". Optional task parameters: \"FDTD.NX\", \"FDTD.NY\" and \"FDTD.NZ\" for a rectangular grid; \"FDTD.THREADS\", default to all processors; \"SIM.SWEEPS\", default to 10"}
 	 ,{TASK_FDTD_SIMULATION,    true,  false, "execute an EM field simulation. It requires command line parameters \"/W\" and \"/D\", and \"/L\" is optional. It requires following task parameters: \"FDTD.N\", \"FDTD.R\" , \"SIM.FDTD_DLL\", \"SIM.FDTD_NAME\", \"SIM.BC_DLL\", \"SIM.BC_NAME\", \"SIM.IV_DLL\" and \"SIM.IV_NAME\". Following task parameters are optional: \"SIM.TFSF_DLL\", \"SIM.TFSF_NAME\", \"SIM.FS_DLL\", and \"SIM.FS_NAME\". It also requires a task parameter \"SIM.BASENAME\" for specifying base file name, which does not include file name extension. Suppose \"SIM.BASENAME\" is specified as\r\nSIM.BASENAME=simA\r\nand command line uses \"/Dc:\\simulation\\data\" then for each simulation time step, the electromagnetic field is saved in a file \"c:\\simulation\\data\\simA{n}.em\", where {n} is time step index which can be 0, 1, 2, .... Use \"FDTD.HALF_ORDER_SPACE\" and \"FDTD.HALF_ORDER_TIME\" to specify estimation orders for space curls and time advancement, respectively."}
 	 ,{TASK_COMPARE_DATA_FILES, true,  true,  "compare two simulations and generate a report file for each time step. It requires command line parameters \"/W\", \"/D\" and \"/E\". Use task parameters \"FDTD.N\" and \"FDTD.R\" to specify space geometry.  Use task parameters \"SIM.FILE1\" and \"SIM.FILE2\" to specify the base file names used by the two simulations; \"/D\" specifies folder for \"SIM.FILE1\" and \"/E\" specifies folder for \"SIM.FILE2\". Use task parameter \"SIM.THICKNESS\" to specify boundary thickness to be excluded from the comparison."}
 	 ,{TASK_MAKE_REPORT_FILES,  true,  false, "create a report file for each data file, It requires command line parameters \"/W\" and \"/D\". It also requires a task parameter \"SIM.BASENAME\" for specifying base file name, which does not include file name extension. It searches data files by {path by /D}\\{base file name}{n}.em, where {n}=0,1,2,...; it uses an optional task parameter, \"FDTD.HALF_ORDER_SPACE\", to specify half estimation order for divergence estimations; default value is 1. "}
 	 ,{TASK_PICK_POINTS_FILES,  true,  false, "pick field points with the largest strengths from each data file and generate a new data file. the new file contains items of 9 doubles: 3 for space location, 6 for EM field. It requires command line parameters \"/W\" and \"/D\". It requires following task parameters: \"FDTD.R\", \"SIM.BASENAME\", \"SIM.POINTS\" for the number of field points to pick, and \"SIM.MAXTIMES\" for maximum number of data files to process, use 0 to process all data files."}
 	 ,{TASK_TWO_SUMFILES_TO_ONE,true,  true,  "merge two summary files into one file. a summary is generated by task 120. It requires command line parameters \"/W\", \"/D\" and \"/E\". Use task parameters \"SIM.FILE1\" and \"SIM.FILE2\" to specify the names of the summary files; \"/D\" specifies folder for \"SIM.FILE1\" and \"/E\" specifies folder for \"SIM.FILE2\". Use an optional task parameter \"SIM.THICKNESS\" to specify boundary thickness to be excluded from the merge; if it is missing then 0 is assumed."}
 	 ,{TASK_2DS_SUMFILES_TO_ONE,true,  true,  "merge two summary files into one file. a summary is generated by task 120. It requires command line parameters \"/W\", \"/D\" and \"/E\". Use task parameters \"SIM.FILE1\" and \"SIM.FILE2\" to specify the names of the summary files; \"/D\" specifies folder for \"SIM.FILE1\" and \"/E\" specifies folder for \"SIM.FILE2\". the space steps of the two simulations are ds1 and ds2, and ds1 = ds2/2, and maxRadius1 + 1 = 2 * maxRadius2 "}
+	 ,{TASK_PARAREAL_SIMULATION,true,  false, "execute an EM field simulation by the parareal time-parallel algorithm. It uses the same command line parameters and task parameters as task 100, except that TF/SF boundaries and rectangular domains are not supported. The FDTD module given by \"SIM.FDTD_DLL\" and \"SIM.FDTD_NAME\" is the fine propagator. It also requires task parameters \"SIM.COARSE_DLL\" and \"SIM.COARSE_NAME\" for the coarse propagator, i.e. YeeFDTD, and \"PARAREAL.SLICES\" for the number of time slices running in parallel, up to 64. Optional task parameters: \"SIM.COARSE_TASK\" for a task file initializing the coarse propagator, i.e. with lower estimation orders; \"PARAREAL.MAX_ITERATIONS\", default to \"PARAREAL.SLICES\"; \"PARAREAL.TOL\" for the largest relative change of fields between iterations, default to 1.0e-6. Fields at the start of each time slice and at the end of the simulation are saved to data files."}
+ ,{TASK_IMPULSE_RESPONSE,   true,  false, "compute the fields at probe points of a linear simulation by superposition of cached responses. It uses the same command line parameters and task parameters as task 100, except that TF/SF boundaries, rectangular domains and refined patches are not supported and no data files are written. The field source, if used, must add a value to one field component at one point after each time step. It requires task parameters \"IR.CACHE\" for a cache file in the data folder holding the responses to the initial fields and to a unit impulse, \"IR.PROBES\" for probe points as \"m,n,p;m,n,p;...\", and \"IR.OUTPUT\" for a text file in the data folder receiving the probe fields of each time step. The cache is created if it does not exist or does not match the task. Optional task parameters: \"IR.SOURCE\" for the source point, default to \"0,0,0\"; \"IR.SOURCE_COMPONENT\", one of EX, EY, EZ, HX, HY and HZ, default to EZ; \"IR.VERIFY\", true to run the simulation directly and report the largest difference at the probes."}
+ ,{TASK_ENSEMBLE_SIMULATION,true, false, "execute an ensemble of TSS simulations which differ only in initial fields, field sources and boundary conditions, advancing all members together by one engine. It uses the same command line parameters and task parameters as task 100 for the grid, estimation orders and time steps, except that TF/SF boundaries and rectangular domains are not supported and \"SIM.FDTD_DLL\" is not used. It requires task parameter \"ENSEMBLE.TASKS\" for the task files of the members, \"file1;file2;...\", up to 64 members. A member task file gives the task parameters of the member's initial fields, field source and boundary condition. If a member task file has \"SIM.BASENAME\" then the fields of the member are saved to data files at each time step."}
 };
 
 //
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 ********************************************************************/
 
+#include <Windows.h>
 #include "simConsole.h"
 #include "tasks.h"
 #include "..\FileUtil\fileutil.h"
@@ -62,7 +63,7 @@ int task1_verifyRadiusIndexConversions(int N)
 	maxN = GRIDPOINTS(N); //4N+3
 	maxN2 = maxN * maxN;
 	indexCount = totalPointsInSphere(maxRadius);
-	used = (bool *)AllocateMemory(indexCount * sizeof(bool));
+	used = (bool *)AllocateTaggedMemory(indexCount * sizeof(bool), MEM_TAG_STATISTICS);
 	if(used == NULL)
 	{
 		return ERR_OUTOFMEMORY;
@@ -183,7 +184,7 @@ int task2_verifySphereIndexCache(int N)
 		size_t idx;
 		size_t monitorCount = 0;
 		size_t points = totalPointsInSphere(maxR);
-		bool *used = (bool *)AllocateMemory(points * sizeof(bool));
+		bool *used = (bool *)AllocateTaggedMemory(points * sizeof(bool), MEM_TAG_STATISTICS);
 		if(used == NULL)
 		{
 			ret = ERR_OUTOFMEMORY;
@@ -384,6 +385,202 @@ int task3_sphereIndexSpeedTest(int N)
 	return ret;
 }
 
+/*
+	thread function of task 6: first touch the block, then sweep it.
+	a sweep does E += H/2 and H -= E/2 component by component, the streams of the H and E passes of YeeFDTDRowMajor:
+	each element of a sweep reads 2 doubles and writes 1, the 3 doubles STREAM counts for its add and triad kernels
+*/
+static DWORD WINAPI bandwidthThread(LPVOID param)
+{
+	BandwidthWork *w = (BandwidthWork *)param;
+	size_t count = w->last - w->first;
+	unsigned long startTick;
+	w->ret = ERR_OK;
+	w->ticks = 0;
+	if(w->pin)
+	{
+		w->ret = PinThreadToNode(w->index, w->threadCount);
+	}
+	if(w->ret == ERR_OK)
+	{
+		//the pages of the block are placed on the node of this thread
+		for(int c=0;c<6;c++)
+		{
+			double * __restrict f = w->c[c] + w->first;
+			for(size_t k=0;k<count;k++)
+			{
+				f[k] = 1.0;
+			}
+		}
+		startTick = GetTimeTick();
+		for(unsigned s=0;s<w->sweeps;s++)
+		{
+			for(int c=0;c<3;c++)
+			{
+				double * __restrict e = w->c[c] + w->first;
+				const double * __restrict h = w->c[c+3] + w->first;
+				for(size_t k=0;k<count;k++)
+				{
+					e[k] += 0.5 * h[k];
+				}
+			}
+			for(int c=0;c<3;c++)
+			{
+				const double * __restrict e = w->c[c] + w->first;
+				double * __restrict h = w->c[c+3] + w->first;
+				for(size_t k=0;k<count;k++)
+				{
+					h[k] -= 0.5 * e[k];
+				}
+			}
+		}
+		w->ticks = GetTimeTick() - startTick;
+	}
+	return 0;
+}
+
+/*
+	measure the memory bandwidth of each NUMA node by sweeping the row-major grid of YeeFDTDRowMajor.
+	the x-planes are shared by FDTD.THREADS threads in contiguous blocks, and thread i belongs to node i*nodes/threads,
+	the same as YeeFDTDRowMajor and PinThreadToNode do. it runs twice: the threads are not pinned in the first run,
+	so the OS may move them away from the pages they touched; they are pinned in the second run, as FDTD.PIN_THREADS does.
+	the bandwidth of a node is the bytes swept by its threads over the time of its slowest thread
+*/
+int task6_numaBandwidthTest(TaskFile *taskConfig)
+{
+	int ret = ERR_OK;
+	unsigned n, nx, ny, nz;
+	bool isBox;
+	int gx, gy, gz;        //grid points along each axis
+	size_t sx, items;      //stride of x and points of a component array with the face layers
+	int threadCount = (int)taskConfig->getUInt(TP_FDTD_THREADS, true);
+	unsigned sweeps = taskConfig->getUInt(TP_SIM_SWEEPS, true);
+	int nodes = NumaNodeCount();
+	BandwidthWork works[MAX_BANDWIDTH_THREADS];
+	double *grid = NULL;
+	ret = taskConfig->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		ret = FDTD::ReadGridSize(taskConfig, &n, &nx, &ny, &nz, &isBox);
+	}
+	if(ret == ERR_OK)
+	{
+		if(n == 0)
+		{
+			ret = ERR_TP_INVALID_N;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		gx = 2 * GRIDRADIUS(nx) + 1;
+		gy = 2 * GRIDRADIUS(ny) + 1;
+		gz = 2 * GRIDRADIUS(nz) + 1;
+		sx = (size_t)(gy + 2) * (size_t)(gz + 2);
+		items = (size_t)(gx + 2) * sx;
+		if(sweeps == 0)
+		{
+			sweeps = 10;
+		}
+		if(threadCount == 0)
+		{
+			SYSTEM_INFO si;
+			GetSystemInfo(&si);
+			threadCount = (int)si.dwNumberOfProcessors;
+		}
+		if(threadCount > MAX_BANDWIDTH_THREADS) threadCount = MAX_BANDWIDTH_THREADS;
+		if(threadCount > gx) threadCount = gx;
+		printf("\r\ngrid %d x %d x %d, %g MB, %d threads, %d NUMA nodes, %u sweeps\r\n", gx, gy, gz,
+			(double)(6 * items * sizeof(double)) / 1.0e6, threadCount, nodes, sweeps);
+	}
+	for(int run=0;run<2 && ret == ERR_OK;run++)
+	{
+		HANDLE threads[MAX_BANDWIDTH_THREADS];
+		DWORD count = 0;
+		//new pages for each run, so that each run places them by its own first touch
+		grid = (double *)malloc(6 * items * sizeof(double));
+		if(grid == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+			break;
+		}
+		for(int i=0;i<threadCount;i++)
+		{
+			for(int c=0;c<6;c++)
+			{
+				works[i].c[c] = grid + c * items;
+			}
+			//contiguous blocks of planes, the same as YeeFDTDRowMajor
+			works[i].first = (size_t)(1 + ((size_t)gx * i) / threadCount) * sx;
+			works[i].last = (size_t)(1 + ((size_t)gx * (i + 1)) / threadCount) * sx;
+			works[i].sweeps = sweeps;
+			works[i].index = i;
+			works[i].threadCount = threadCount;
+			works[i].pin = (run == 1);
+			works[i].ticks = 0;
+			works[i].ret = ERR_OK;
+			threads[count] = CreateThread(NULL, 0, bandwidthThread, &(works[i]), 0, NULL);
+			if(threads[count] == NULL)
+			{
+				RememberOSerror();
+				ret = ERR_SIM_THREAD;
+				break;
+			}
+			count++;
+		}
+		if(count > 0)
+		{
+			WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+			for(DWORD i=0;i<count;i++)
+			{
+				CloseHandle(threads[i]);
+			}
+		}
+		for(DWORD i=0;i<count && ret == ERR_OK;i++)
+		{
+			ret = works[i].ret;
+		}
+		if(ret == ERR_OK)
+		{
+			unsigned long slowest = 0;
+			double total = 0.0;
+			printf("\r\n%s\r\n", run == 0?"threads not pinned:":"threads pinned (FDTD.PIN_THREADS=true):");
+			for(int node=0;node<nodes;node++)
+			{
+				double bytes = 0.0;
+				unsigned long ticks = 0;
+				int first = -1, last = -1;
+				for(int i=0;i<threadCount;i++)
+				{
+					if((int)(((__int64)i * nodes) / threadCount) == node)
+					{
+						if(first < 0) first = i;
+						last = i;
+						//3 doubles per element of the 6 components
+						bytes += 18.0 * sizeof(double) * (double)(works[i].last - works[i].first) * (double)sweeps;
+						if(works[i].ticks > ticks) ticks = works[i].ticks;
+					}
+				}
+				if(first < 0)
+				{
+					printf("  node %d: no threads\r\n", node);
+				}
+				else
+				{
+					if(ticks == 0) ticks = 1;
+					printf("  node %d: threads %d-%d, %g GB/s\r\n", node, first, last, bytes / ((double)ticks * 1.0e6));
+					total += bytes;
+					if(ticks > slowest) slowest = ticks;
+				}
+			}
+			if(slowest == 0) slowest = 1;
+			printf("  all nodes: %g GB/s in %lu ms\r\n", total / ((double)slowest * 1.0e6), slowest);
+		}
+		free(grid);
+		grid = NULL;
+	}
+	return ret;
+}
+
 /*
 	Verify that fields initialized in a FDTD class are the same as that provided by the same FieldsInitializer instance.
 	it goes through all space points, radius by radius, getting fields from FieldsInitializer for each space point,
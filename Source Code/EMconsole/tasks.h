@@ -10,10 +10,12 @@
 
 #define TP_SIM_PICKS   "SIM.POINTS"
 #define TP_SIM_MAXTIME "SIM.MAXTIMES"
+#define TP_SIM_SWEEPS  "SIM.SWEEPS"
 
 int task1_verifyRadiusIndexConversions(int N);
 int task2_verifySphereIndexCache(int N);
 int task3_sphereIndexSpeedTest(int N);
+int task6_numaBandwidthTest(TaskFile *taskConfig);
 int task4_verifyFieldInitializer(FieldsInitializer *fields0, TaskFile *taskConfig);
 int task5_verifyFields(FieldsInitializer *fields0, TaskFile *taskConfig);
 int task110_compareSimData(TaskFile *taskConfig, const char *dataFolder1, const char *dataFolder2);
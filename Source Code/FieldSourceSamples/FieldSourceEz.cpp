@@ -73,6 +73,6 @@ void FieldSourceEz::handleData(int m, int n, int p)
 	double arg;
 	arg = M_PI * ((Cdtds * _time - 0.0) / ppw - 1.0);
 	arg = arg * arg;
-	//m=n=p=0 is the first element of array _fields
-	_fields[0].E.z += (1.0 - 2.0 * arg) * exp(-arg);
+	//m=n=p=0 is the first element of array _fields for a cube; it is in the middle of a rectangular box
+	_fields[SINDEX(0,0,0)].E.z += (1.0 - 2.0 * arg) * exp(-arg);
 }
@@ -115,16 +115,89 @@ public:
 #define TP_SIMTFSF_DLL  "SIM.TFSF_DLL"
 #define TP_SIMTFSF_NAME "SIM.TFSF_NAME"
 #define TP_SIMBASENAME  "SIM.BASENAME"
+#define TP_SIMMASK_DLL  "SIM.MASK_DLL"
+#define TP_SIMMASK_NAME "SIM.MASK_NAME"
+//task parameters used by a time-parallel (parareal) simulation, see PararealSimulation
+#define TP_SIMCOARSE_DLL        "SIM.COARSE_DLL"
+#define TP_SIMCOARSE_NAME       "SIM.COARSE_NAME"
+#define TP_SIMCOARSE_TASK       "SIM.COARSE_TASK"
+#define TP_PARAREAL_SLICES      "PARAREAL.SLICES"
+#define TP_PARAREAL_ITERATIONS  "PARAREAL.MAX_ITERATIONS"
+#define TP_PARAREAL_TOL         "PARAREAL.TOL"
+
+//task parameters used by an impulse response simulation, see ImpulseResponseSimulation
+#define TP_IR_CACHE             "IR.CACHE"
+#define TP_IR_PROBES            "IR.PROBES"
+#define TP_IR_SOURCE            "IR.SOURCE"
+#define TP_IR_SOURCE_COMPONENT  "IR.SOURCE_COMPONENT"
+#define TP_IR_OUTPUT            "IR.OUTPUT"
+#define TP_IR_VERIFY            "IR.VERIFY"
+
+//task parameter used by an ensemble simulation, see EnsembleSimulation
+#define TP_ENSEMBLE_TASKS       "ENSEMBLE.TASKS"
+
+//optional task parameters for a locally refined patch in a simulation, see SubgridPatch
+#define TP_SUBGRID_TASK         "SUBGRID.TASK"
+#define TP_SUBGRID_DLL          "SUBGRID.FDTD_DLL"
+#define TP_SUBGRID_NAME         "SUBGRID.FDTD_NAME"
+#define TP_SUBGRID_CENTERX      "SUBGRID.CENTER_X"
+#define TP_SUBGRID_CENTERY      "SUBGRID.CENTER_Y"
+#define TP_SUBGRID_CENTERZ      "SUBGRID.CENTER_Z"
+#define TP_SUBGRID_GHOST        "SUBGRID.GHOST"
 
 //task parameters used by a FDTD module
 #define TP_FDTDN            "FDTD.N"
 #define TP_FDTDR            "FDTD.R"
+//optional per-axis N for a rectangular (non-cubic) domain; an axis not given uses FDTD.N
+#define TP_FDTDNX           "FDTD.NX"
+#define TP_FDTDNY           "FDTD.NY"
+#define TP_FDTDNZ           "FDTD.NZ"
 #define TP_MAX_TIMESTEP     "FDTD.MAXTIMESTEP"
 //enable recording speeds
 #define TP_REC_TIMESTEP     "FDTD.RECTIMESTEP"
 //task parameters used by a FDTD module which may use different estimation orders
 #define TP_HALF_ORDER_SPACE "FDTD.HALF_ORDER_SPACE"
 #define TP_HALF_ORDER_TIME  "FDTD.HALF_ORDER_TIME"
+//optional task parameters for using different space estimation orders at different radiuses, see EstimationOrderMap
+#define TP_HALF_ORDER_SPACE_MAP      "FDTD.HALF_ORDER_SPACE_MAP"
+#define TP_HALF_ORDER_SPACE_TOL      "FDTD.HALF_ORDER_SPACE_TOL"
+#define TP_HALF_ORDER_SPACE_INTERVAL "FDTD.HALF_ORDER_SPACE_INTERVAL"
+//optional largest multiple of dt for advancing slow regions of an inhomogeneous environment, see MultiRateStepper
+#define TP_MAX_RATE         "FDTD.MAX_RATE"
+//radius of the TSS region of the hybrid TSS/Yee engine, see TssYeeHybrid
+#define TP_TSS_RADIUS       "FDTD.TSS_RADIUS"
+//optional task parameters of the pseudo-spectral engine, see PstdFDTD
+#define TP_PSTD_SUBSTEPS    "FDTD.PSTD_SUBSTEPS"
+#define TP_FDTD_THREADS     "FDTD.THREADS"
+//optional: true to pin the threads of the row-major Yee engine to processors spread over the NUMA nodes, see YeeFDTDRowMajor
+#define TP_FDTD_PIN_THREADS "FDTD.PIN_THREADS"
+//optional number of time steps the row-major Yee engine advances in one sweep over the memory, see YeeFDTDRowMajor
+#define TP_FDTD_TIME_BLOCK  "FDTD.TIME_BLOCK"
+//optional task parameter of the E-only wave equation engine, see TssWaveEquation
+#define TP_WAVE_H           "FDTD.WAVE_H"
+//optional task parameter: true to make divergence statistics within the first curl estimation of each time step, see JacobianEstimatorAsymmetric
+#define TP_STEP_STATISTICS  "FDTD.STEP_STATISTICS"
+//optional task parameters giving a material mask of PEC, PMC and inactive points, see MaterialMask
+#define TP_MASK_FILE        "FDTD.MASK_FILE"
+#define TP_MASK_BOXES       "FDTD.MASK_BOXES"
+//optional task parameters importing an inhomogeneous environment from a voxel model, see VoxelMaterialImport
+#define TP_VOXEL_FILE       "VOXEL.FILE"
+#define TP_VOXEL_DIMS       "VOXEL.DIMS"
+#define TP_VOXEL_BYTES      "VOXEL.BYTES"
+#define TP_VOXEL_SIZE       "VOXEL.SIZE"
+#define TP_VOXEL_MATERIALS  "VOXEL.MATERIALS"
+#define TP_VOXEL_BACKGROUND "VOXEL.BACKGROUND"
+
+//optional memory mapping options of the memory manager, names separated by ';', see ParseMappingOptions
+#define TP_MEM_SCRATCH      "MEMORY.SCRATCH"
+#define TP_MEM_SNAPSHOT     "MEMORY.SNAPSHOT"
+#define TP_MEM_INPUT        "MEMORY.INPUT"
+//optional RAM budget in MB of the scratch memory pool; 0 to allocate scratch memory by temporary files only, see MemoryManager
+#define TP_MEM_RAM_BUDGET   "MEMORY.RAM_BUDGET"
+//optional hard limit in MB of all the memory given out by the memory manager; an allocation going over it fails
+#define TP_MEM_HARD_LIMIT   "MEMORY.HARD_LIMIT"
+//optional huge page size in MB of the field and curl memory from the pool: 0, 2 or 1024, see MemoryManager::SetHugePageSize
+#define TP_MEM_HUGE_PAGES   "MEMORY.HUGE_PAGES"
 
 //task parameters needed by some tasks
 #define TP_SIMFILE1     "SIM.FILE1"
@@ -0,0 +1,232 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "MathTools.h"
+#include "Fft.h"
+#include <malloc.h>
+
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+
+FftPlan::FftPlan(void)
+{
+	n = 0;
+	m = 0;
+	twiddle = NULL;
+	bitReverse = NULL;
+	chirp = NULL;
+	chirpFft = NULL;
+}
+
+FftPlan::~FftPlan(void)
+{
+	cleanup();
+}
+
+void FftPlan::cleanup()
+{
+	if(twiddle != NULL)
+	{
+		free(twiddle);
+		twiddle = NULL;
+	}
+	if(bitReverse != NULL)
+	{
+		free(bitReverse);
+		bitReverse = NULL;
+	}
+	if(chirp != NULL)
+	{
+		free(chirp);
+		chirp = NULL;
+	}
+	if(chirpFft != NULL)
+	{
+		free(chirpFft);
+		chirpFft = NULL;
+	}
+	n = 0;
+	m = 0;
+}
+
+int FftPlan::initialize(int length)
+{
+	int ret = ERR_OK;
+	int bits = 0;
+	cleanup();
+	if(length < 1)
+	{
+		ret = ERR_MATH_FFT_SIZE;
+	}
+	else
+	{
+		n = length;
+		if((n & (n - 1)) == 0)
+		{
+			m = n;
+		}
+		else
+		{
+			//circular convolution of 2n-1 items
+			m = 1;
+			while(m < 2 * n - 1)
+			{
+				m = m << 1;
+			}
+		}
+		while((1 << bits) < m)
+		{
+			bits++;
+		}
+		twiddle = (FftComplex *)malloc((m / 2 + 1) * sizeof(FftComplex));
+		bitReverse = (int *)malloc(m * sizeof(int));
+		if(twiddle == NULL || bitReverse == NULL)
+		{
+			ret = ERR_MATH_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		for(int k=0;k<m/2;k++)
+		{
+			twiddle[k].re = cos(2.0 * M_PI * (double)k / (double)m);
+			twiddle[k].im = -sin(2.0 * M_PI * (double)k / (double)m);
+		}
+		for(int k=0;k<m;k++)
+		{
+			int r = 0;
+			for(int b=0;b<bits;b++)
+			{
+				if(k & (1 << b))
+				{
+					r |= 1 << (bits - 1 - b);
+				}
+			}
+			bitReverse[k] = r;
+		}
+		if(m != n)
+		{
+			chirp = (FftComplex *)malloc(n * sizeof(FftComplex));
+			chirpFft = (FftComplex *)malloc(m * sizeof(FftComplex));
+			if(chirp == NULL || chirpFft == NULL)
+			{
+				ret = ERR_MATH_OUTOFMEMORY;
+			}
+		}
+	}
+	if(ret == ERR_OK && chirp != NULL)
+	{
+		//k*k is taken modulo 2n so that the angle stays small for a long transform
+		for(int k=0;k<n;k++)
+		{
+			long long k2 = ((long long)k * (long long)k) % (2 * (long long)n);
+			double a = M_PI * (double)k2 / (double)n;
+			chirp[k].re = cos(a);
+			chirp[k].im = -sin(a);
+		}
+		for(int k=0;k<m;k++)
+		{
+			chirpFft[k].re = 0.0;
+			chirpFft[k].im = 0.0;
+		}
+		chirpFft[0].re = chirp[0].re;
+		chirpFft[0].im = -chirp[0].im;
+		for(int k=1;k<n;k++)
+		{
+			chirpFft[k].re = chirpFft[m - k].re = chirp[k].re;
+			chirpFft[k].im = chirpFft[m - k].im = -chirp[k].im;
+		}
+		radix2(chirpFft);
+		//the inverse transform of the convolution needs a division by m
+		for(int k=0;k<m;k++)
+		{
+			chirpFft[k].re /= (double)m;
+			chirpFft[k].im /= (double)m;
+		}
+	}
+	if(ret != ERR_OK)
+	{
+		cleanup();
+	}
+	return ret;
+}
+
+/*
+	in-place iterative radix-2 transform of data[m]
+*/
+void FftPlan::radix2(FftComplex *data)
+{
+	FftComplex t;
+	for(int k=0;k<m;k++)
+	{
+		int r = bitReverse[k];
+		if(r > k)
+		{
+			t = data[k]; data[k] = data[r]; data[r] = t;
+		}
+	}
+	for(int len=2;len<=m;len=len<<1)
+	{
+		int half = len >> 1;
+		int step = m / len;
+		for(int start=0;start<m;start+=len)
+		{
+			FftComplex *a = data + start;
+			FftComplex *b = a + half;
+			for(int j=0;j<half;j++)
+			{
+				FftComplex w = twiddle[j * step];
+				t.re = b[j].re * w.re - b[j].im * w.im;
+				t.im = b[j].re * w.im + b[j].im * w.re;
+				b[j].re = a[j].re - t.re;
+				b[j].im = a[j].im - t.im;
+				a[j].re += t.re;
+				a[j].im += t.im;
+			}
+		}
+	}
+}
+
+void FftPlan::transform(FftComplex *data, FftComplex *work)
+{
+	if(chirp == NULL)
+	{
+		radix2(data);
+	}
+	else
+	{
+		double re, im;
+		//Bluestein: X[k] = chirp[k] * sum of (x[j]*chirp[j]) * conj(chirp[k-j])
+		for(int k=0;k<n;k++)
+		{
+			work[k].re = data[k].re * chirp[k].re - data[k].im * chirp[k].im;
+			work[k].im = data[k].re * chirp[k].im + data[k].im * chirp[k].re;
+		}
+		for(int k=n;k<m;k++)
+		{
+			work[k].re = 0.0;
+			work[k].im = 0.0;
+		}
+		radix2(work);
+		//multiply by the transform of the conjugate chirp and take the inverse transform by conj(forward(conj(.)))
+		for(int k=0;k<m;k++)
+		{
+			re = work[k].re * chirpFft[k].re - work[k].im * chirpFft[k].im;
+			im = work[k].re * chirpFft[k].im + work[k].im * chirpFft[k].re;
+			work[k].re = re;
+			work[k].im = -im;
+		}
+		radix2(work);
+		for(int k=0;k<n;k++)
+		{
+			re = work[k].re;
+			im = -work[k].im;
+			data[k].re = re * chirp[k].re - im * chirp[k].im;
+			data[k].im = re * chirp[k].im + im * chirp[k].re;
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef __FFT_H__
+#define __FFT_H__
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "MathTools.h"
+
+typedef struct FftComplex{double re; double im;} FftComplex;
+
+/*
+	forward discrete Fourier transform of any length n:
+		X[k] = sum of x[j]*exp(-2*pi*i*j*k/n), j = 0,1,...,n-1
+
+	a power of 2 length uses a radix-2 FFT. any other length uses Bluestein's algorithm,
+	which turns the transform into a circular convolution done by radix-2 FFTs of length m >= 2n-1.
+	an inverse transform is conj(forward(conj(X)))/n.
+
+	a plan only holds read-only tables, so one plan can be used by several threads,
+	each thread providing its own work buffer of getWorkSize() items.
+*/
+class FftPlan
+{
+private:
+	int n;                 //transform length
+	int m;                 //radix-2 length, n for a power of 2
+	FftComplex *twiddle;   //[m/2], exp(-2*pi*i*k/m)
+	int *bitReverse;       //[m]
+	FftComplex *chirp;     //[n], exp(-pi*i*k*k/n), NULL for a power of 2
+	FftComplex *chirpFft;  //[m], transform of the conjugate chirp, divided by m
+	//
+	void radix2(FftComplex *data);
+public:
+	FftPlan(void);
+	~FftPlan(void);
+	int initialize(int length);
+	void cleanup();
+	int getLength(){return n;}
+	//number of work items needed by transform
+	int getWorkSize(){return (chirp == NULL)?0:m;}
+	//in-place forward transform of data[n]
+	void transform(FftComplex *data, FftComplex *work);
+};
+
+#endif
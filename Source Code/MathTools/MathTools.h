@@ -11,5 +11,6 @@
 #define ERR_MATH_INV_DIM     8002
 #define ERR_MATH_OUTOFMEMORY 8003
 #define ERR_MATH_NOT_INVERSE 8004
+#define ERR_MATH_FFT_SIZE    8005
 
 #define ERR_MATH_MEM_SMALL   8100
\ No newline at end of file
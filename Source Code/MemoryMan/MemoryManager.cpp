@@ -7,27 +7,77 @@
 	It also provides an interface to other functions specific to operating systems
 */
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <FileAPI.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <wchar.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+//the POSIX backend formats narrow strings the same way
+#define sprintf_s snprintf
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0
+#endif
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_SHIFT 26
+#endif
+#endif
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-#include "..\ProcessMonitor\workProcess.h"
+#include "../ProcessMonitor/workProcess.h"
 #include "memman.h"
 #include "MemoryManager.h"
+#ifdef _WIN32
 #include "Shlwapi.h"
+#endif
 
 unsigned long osErrorCode = 0;
 
+#ifdef _WIN32
+#define OSLASTERROR() GetLastError()
+#else
+#define OSLASTERROR() ((unsigned long)errno)
+/*
+	a wide path of the interface to a narrow path for the POSIX calls
+*/
+static int pathW2C(char *dest, const wchar_t *src)
+{
+	size_t n = wcstombs(dest, src, FILENAME_MAX);
+	if(n == (size_t)-1 || n >= FILENAME_MAX)
+	{
+		return ERR_STR_SIZE_TOO_SMALL;
+	}
+	return ERR_OK;
+}
+#endif
+
 unsigned long GetTimeTick()
 {
+#ifdef _WIN32
 	return GetTickCount();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#endif
 }
 void RememberOSerror()
 {
 	if(osErrorCode == 0)
 	{
-		osErrorCode = GetLastError();
+		osErrorCode = OSLASTERROR();
 	}
 }
 void ClearOSerror()
@@ -38,16 +88,26 @@ unsigned long GetLastWinError()
 {
 	if(osErrorCode == 0)
 	{
-		osErrorCode = GetLastError();
+		osErrorCode = OSLASTERROR();
 	}
 	return osErrorCode;
 }
 bool DirectoryExists(const wchar_t* szPath)
 {
+#ifdef _WIN32
   DWORD dwAttrib = GetFileAttributes(szPath);
 
   return (dwAttrib != INVALID_FILE_ATTRIBUTES && 
          (dwAttrib & FILE_ATTRIBUTE_DIRECTORY));
+#else
+	char path[FILENAME_MAX];
+	struct stat st;
+	if(pathW2C(path, szPath) != ERR_OK || stat(path, &st) != 0)
+	{
+		return false;
+	}
+	return S_ISDIR(st.st_mode);
+#endif
 }
 bool DirectoryExists_c(const char *szPath, int *ret)
 {
@@ -59,6 +119,7 @@ bool DirectoryExists_c(const char *szPath, int *ret)
 	}
 	return false;
 }
+#ifdef _WIN32
 __int64 WinFileSize(const wchar_t* name)
 {
     HANDLE hFile = CreateFile(name, GENERIC_READ, 
@@ -108,6 +169,69 @@ __int64 FileSizeW(wchar_t* wname)
     size.LowPart = fad.nFileSizeLow;
     return size.QuadPart;
 }
+#else
+__int64 FileSize(const char* name)
+{
+	struct stat st;
+	if(stat(name, &st) != 0)
+		return -1;
+	return (__int64)st.st_size;
+}
+__int64 FileSizeW(wchar_t* wname)
+{
+	char name[FILENAME_MAX];
+	if(pathW2C(name, wname) != ERR_OK)
+		return -1;
+	return FileSize(name);
+}
+__int64 WinFileSize(const wchar_t* name)
+{
+	return FileSizeW((wchar_t *)name);
+}
+#endif
+int ParseMappingOptions(const char *names, unsigned *options)
+{
+	int ret = ERR_OK;
+	char name[NAMESIZE];
+	int i = 0, j = 0;
+	*options = 0;
+	while(ret == ERR_OK)
+	{
+		if(names[i] == ',' || names[i] == ';' || names[i] == 0)
+		{
+			name[j] = 0;
+			if(j == 0 || strcmp(name, "NONE") == 0)
+				;
+			else if(strcmp(name, "POPULATE") == 0)
+				*options |= MEM_MAP_POPULATE;
+			else if(strcmp(name, "SEQUENTIAL") == 0)
+				*options |= MEM_MAP_SEQUENTIAL;
+			else if(strcmp(name, "WILLNEED") == 0)
+				*options |= MEM_MAP_WILLNEED;
+			else if(strcmp(name, "HUGEPAGE") == 0)
+				*options |= MEM_MAP_HUGEPAGE;
+			else if(strcmp(name, "FALLOCATE") == 0)
+				*options |= MEM_MAP_FALLOCATE;
+			else
+				ret = ERR_MEM_MAP_OPTION;
+			j = 0;
+			if(names[i] == 0) break;
+		}
+		else if(names[i] != ' ')
+		{
+			if(j >= NAMESIZE - 1)
+			{
+				ret = ERR_MEM_MAP_OPTION;
+			}
+			else
+			{
+				name[j++] = names[i];
+			}
+		}
+		i++;
+	}
+	return ret;
+}
 double *parseDecimals(char *name_argv, int *argc, int *ret)
 {
 	int i,j,k,f;
@@ -169,6 +293,23 @@ double *parseDecimals(char *name_argv, int *argc, int *ret)
 	}
 	return params;
 }
+#ifdef _WIN32
+#define loadLibrary(libname) LoadLibrary(libname)
+#define getLibraryProc(lib, name) GetProcAddress((lib), (name))
+#define freeLibrary(lib) FreeLibrary(lib)
+#else
+static HINSTANCE loadLibrary(wchar_t *libname)
+{
+	char path[FILENAME_MAX];
+	if(pathW2C(path, libname) != ERR_OK)
+	{
+		return NULL;
+	}
+	return dlopen(path, RTLD_NOW);
+}
+#define getLibraryProc(lib, name) dlsym((lib), (name))
+#define freeLibrary(lib) dlclose(lib)
+#endif
 HINSTANCE *libs = NULL;
 int libCount = 0;
 void *LoadPlugin(wchar_t *libname, char *name_argv, int *ret)
@@ -247,7 +388,7 @@ void *LoadPlugin(wchar_t *libname, char *name_argv, int *ret)
 		*ret = ERR_INVALID_DLLPARAM;
 		return NULL;
 	}
-	hinstLib = LoadLibrary(libname);
+	hinstLib = loadLibrary(libname);
 	if (hinstLib == NULL)
 	{
 		*ret = ERR_INVALID_DLLPATH;
@@ -255,7 +396,7 @@ void *LoadPlugin(wchar_t *libname, char *name_argv, int *ret)
 	else
 	{
 		fnCreatePluginInstance proc;
-		proc = (fnCreatePluginInstance) GetProcAddress(hinstLib, (LPCSTR)"CreatePluginInstance");
+		proc = (fnCreatePluginInstance) getLibraryProc(hinstLib, (LPCSTR)"CreatePluginInstance");
 		if(proc == NULL)
 		{
 			*ret = ERR_DLL_FUNC_NOTFOUND;
@@ -265,7 +406,7 @@ void *LoadPlugin(wchar_t *libname, char *name_argv, int *ret)
 			func = proc(name, params);
 			if(func == NULL)
 			{
-				FreeLibrary(hinstLib); 
+				freeLibrary(hinstLib); 
 				*ret = ERR_DLL_FUNC_ERROR;
 			}
 			else
@@ -308,7 +449,7 @@ void ClearPluginInstances(int *ret)
 			{
 				fnRemovePluginInstances proc;
 				{
-					proc = (fnRemovePluginInstances) GetProcAddress(libs[i], (LPCSTR)"RemovePluginInstances");
+					proc = (fnRemovePluginInstances) getLibraryProc(libs[i], (LPCSTR)"RemovePluginInstances");
 					if(proc == NULL)
 					{
 						*ret = ERR_DLL_FUNC_NOTFOUND;
@@ -318,7 +459,7 @@ void ClearPluginInstances(int *ret)
 						proc();
 					}
 				}
-				FreeLibrary(libs[i]);
+				freeLibrary(libs[i]);
 				libs[i] = NULL;
 			}
 		}
@@ -406,6 +547,7 @@ int copyW2C(char *dest, int size, const wchar_t *src)
 	}
 }
 
+#ifdef _WIN32
 int WriteToBinaryFile(wchar_t *filename, void *data, size_t itemSize, size_t itemCount, unsigned long *err, fnProgressReport progressReport)
 {
 	int ret = ERR_OK;
@@ -495,16 +637,84 @@ int WriteToBinaryFile(wchar_t *filename, void *data, size_t itemSize, size_t ite
 	}
 	return ret;
 }
+#else
+int WriteToBinaryFile(wchar_t *filename, void *data, size_t itemSize, size_t itemCount, unsigned long *err, fnProgressReport progressReport)
+{
+	int ret = ERR_OK;
+	char path[FILENAME_MAX];
+	FILE *fh = NULL;
+	*err = 0;
+	ret = pathW2C(path, filename);
+	if(ret == ERR_OK)
+	{
+		fh = fopen(path, "wb");
+		if(fh == NULL)
+		{
+			*err = OSLASTERROR();
+			ret = ERR_MEM_CREATE_FILE;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		char msg[SHORTMESSAGESIZE];
+		size_t pp = 0;
+		double pr;
+		size_t skip = itemCount / 1000;
+		size_t i;
+		unsigned char *pdata = (unsigned char *)data;
+		for(i=0;i<itemCount;i++)
+		{
+			if(fwrite(&(pdata[i*itemSize]), itemSize, 1, fh) != 1)
+			{
+				*err = OSLASTERROR();
+				ret = ERR_MEM_WRITE_FILE;
+				break;
+			}
+			if(progressReport != NULL)
+			{
+				pp++;
+				if(pp > skip)
+				{
+					pr = ((double)i/(double)itemCount) * 100.0;
+					sprintf_s(msg, SHORTMESSAGESIZE, "written %#.2f %%",pr);
+					progressReport(msg, true);
+					pp = 0;
+				}
+			}
+		}
+		if(fclose(fh) != 0 && ret == ERR_OK)
+		{
+			*err = OSLASTERROR();
+			ret = ERR_MEM_WRITE_FILE;
+		}
+		if(progressReport != NULL)
+		{
+			sprintf_s(msg, SHORTMESSAGESIZE, "written 100 %%");
+			progressReport(msg, true);
+		}
+	}
+	return ret;
+}
+#endif
 
 bool FileExists(const wchar_t *fileName)
 {
+#ifdef _WIN32
 	DWORD fileAttr;
 	fileAttr = GetFileAttributes(fileName);
 	if (0xFFFFFFFF == fileAttr)
 		return false;
 	return true;
+#else
+	char path[FILENAME_MAX];
+	struct stat st;
+	if(pathW2C(path, fileName) != ERR_OK)
+		return false;
+	return stat(path, &st) == 0;
+#endif
 }
 
+#ifdef _WIN32
 int GetAppFolder(char *appfolder, unsigned long size)
 {
 	int ret = ERR_OK;
@@ -541,11 +751,40 @@ int GetAppFolder(char *appfolder, unsigned long size)
 	}
 	return ret;
 }
+#else
+int GetAppFolder(char *appfolder, unsigned long size)
+{
+	int ret = ERR_OK;
+	ssize_t n = readlink("/proc/self/exe", appfolder, size);
+	if(n <= 0)
+	{
+		osErrorCode = OSLASTERROR();
+		ret = ERR_MEM_MAN_APP_PATH;
+	}
+	else if((unsigned long)n >= size)
+	{
+		ret = ERR_STR_SIZE_TOO_SMALL;
+	}
+	else
+	{
+		appfolder[n] = 0;
+		for(ssize_t i=n-1;i>0;i--)
+		{
+			if(appfolder[i] == '/')
+			{
+				appfolder[i] = 0;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+#endif
 
 int formDataFileName(char *filename, size_t size, const char *basename, size_t timeIndex)
 {
 	int ret = ERR_OK;
-	int err = sprintf_s(filename, size, "%s%d.em", basename, timeIndex);
+	int err = sprintf_s(filename, size, "%s%d.em", basename, (int)timeIndex);
 	if(err <= 0)
 	{
 		ret = ERR_MEM_EINVAL;
@@ -556,7 +795,11 @@ int formDataFileName(char *filename, size_t size, const char *basename, size_t t
 int formDataFileNameW(wchar_t *filename, size_t size, const wchar_t *basename, size_t timeIndex)
 {
 	int ret = ERR_OK;
+#ifdef _WIN32
 	int err = swprintf_s(filename, size, L"%s%d.em", basename, timeIndex);
+#else
+	int err = swprintf(filename, size, L"%ls%d.em", basename, (int)timeIndex);
+#endif
 	if(err == -1)
 	{
 		ret = ERR_MEM_EINVAL;
@@ -566,13 +809,153 @@ int formDataFileNameW(wchar_t *filename, size_t size, const wchar_t *basename, s
 int formFieldFileNameW(wchar_t *filename, size_t size, const wchar_t *basename, size_t timeIndex)
 {
 	int ret = ERR_OK;
+#ifdef _WIN32
 	int err = swprintf_s(filename, size, L"%s%d.field", basename, timeIndex);
+#else
+	int err = swprintf(filename, size, L"%ls%d.field", basename, (int)timeIndex);
+#endif
 	if(err == -1)
 	{
 		ret = ERR_MEM_EINVAL;
 	}
 	return ret;
 }
+
+//largest number of processors of a NUMA node used by PinThreadToNode
+#define MAX_NODE_PROCESSORS 1024
+
+/*
+	processors of a NUMA node; returns the number of processors written to list
+*/
+static int nodeProcessors(int node, int *list, int size)
+{
+	int n = 0;
+#ifdef _WIN32
+	ULONGLONG mask = 0;
+	if(GetNumaNodeProcessorMask((UCHAR)node, &mask))
+	{
+		for(int b=0;b<64 && n<size;b++)
+		{
+			if(mask & ((ULONGLONG)1 << b))
+			{
+				list[n++] = b;
+			}
+		}
+	}
+#else
+	char path[FILENAME_MAX];
+	FILE *f;
+	snprintf(path, FILENAME_MAX, "/sys/devices/system/node/node%d/cpulist", node);
+	f = fopen(path, "r");
+	if(f != NULL)
+	{
+		//ranges such as 0-15,32-47
+		int a, b;
+		char c;
+		while(fscanf(f, "%d", &a) == 1)
+		{
+			b = a;
+			c = (char)fgetc(f);
+			if(c == '-')
+			{
+				if(fscanf(f, "%d", &b) != 1)
+				{
+					break;
+				}
+				c = (char)fgetc(f);
+			}
+			for(int k=a;k<=b && n<size;k++)
+			{
+				list[n++] = k;
+			}
+			if(c != ',')
+			{
+				break;
+			}
+		}
+		fclose(f);
+	}
+	else if(node == 0)
+	{
+		//not a NUMA computer
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		for(int k=0;k<count && n<size;k++)
+		{
+			list[n++] = k;
+		}
+	}
+#endif
+	return n;
+}
+int NumaNodeCount()
+{
+#ifdef _WIN32
+	ULONG highest = 0;
+	if(GetNumaHighestNodeNumber(&highest))
+	{
+		return (int)highest + 1;
+	}
+	return 1;
+#else
+	int count = 0;
+	char path[FILENAME_MAX];
+	struct stat st;
+	while(count < 1024)
+	{
+		snprintf(path, FILENAME_MAX, "/sys/devices/system/node/node%d", count);
+		if(stat(path, &st) != 0)
+		{
+			break;
+		}
+		count++;
+	}
+	return count > 0 ? count : 1;
+#endif
+}
+int PinThreadToNode(int i, int threadCount)
+{
+	int ret = ERR_OK;
+	int nodes = NumaNodeCount();
+	int node, first, n;
+	int *list;
+	if(threadCount < 1 || i < 0 || i >= threadCount)
+	{
+		return ERR_INVALID_PARAMS;
+	}
+	//thread i is on node i*nodes/threadCount; first is the first thread of the node
+	node = (int)(((__int64)i * nodes) / threadCount);
+	first = (int)(((__int64)node * threadCount + nodes - 1) / nodes);
+	list = (int *)malloc(MAX_NODE_PROCESSORS * sizeof(int));
+	if(list == NULL)
+	{
+		return ERR_MEM_OUTOFMEMORY;
+	}
+	n = nodeProcessors(node, list, MAX_NODE_PROCESSORS);
+	if(n > 0)
+	{
+		//more threads than processors of the node share the processors
+		int processor = list[(i - first) % n];
+#ifdef _WIN32
+		if(SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor) == 0)
+		{
+			RememberOSerror();
+			ret = ERR_MEM_PIN_THREAD;
+		}
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(processor, &set);
+		if(sched_setaffinity(0, sizeof(set), &set) != 0)
+		{
+			RememberOSerror();
+			ret = ERR_MEM_PIN_THREAD;
+		}
+#endif
+	}
+	//a node without processors leaves the thread where it is
+	free(list);
+	return ret;
+}
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 FileWriter::FileWriter()
 {
@@ -582,22 +965,49 @@ int FileWriter::OpenBinaryFileWrite(wchar_t *filename, unsigned long *err)
 {
 	int ret = ERR_OK;
 	*err = 0;
+#ifdef _WIN32
 	filehandle = CreateFile(filename,GENERIC_WRITE,0,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_NORMAL,NULL);
 	if(filehandle == INVALID_HANDLE_VALUE)
 	{
 		*err = GetLastError();
 		ret = ERR_MEM_CREATE_FILE;
 	}
+#else
+	char path[FILENAME_MAX];
+	ret = pathW2C(path, filename);
+	if(ret == ERR_OK)
+	{
+		filehandle = fopen(path, "wb");
+		if(filehandle == NULL)
+		{
+			*err = OSLASTERROR();
+			ret = ERR_MEM_CREATE_FILE;
+		}
+	}
+#endif
 	return ret;
 }
 void FileWriter::CloseBineryFile()
 {
 	if(filehandle != NULL)
-	CloseHandle(filehandle);
+	{
+#ifdef _WIN32
+		CloseHandle(filehandle);
+#else
+		fclose((FILE *)filehandle);
+#endif
+		filehandle = NULL;
+	}
 }
 int FileWriter::WriteDataToBineryFile(void *data, size_t itemSize, size_t itemCount)
 {
 	int ret = ERR_OK;
+#ifndef _WIN32
+	if(fwrite(data, itemSize, itemCount, (FILE *)filehandle) != itemCount)
+	{
+		ret = ERR_MEM_WRITE_FILE;
+	}
+#else
 	DWORD hw;
 	size_t p;
 	size_t i;
@@ -610,6 +1020,7 @@ int FileWriter::WriteDataToBineryFile(void *data, size_t itemSize, size_t itemCo
 			break;
 		}
 	}
+#endif
 	return ret;
 }
 
@@ -625,18 +1036,40 @@ MemoryItem::MemoryItem(LPCWSTR diskfile)
 		}
 		filename[i] = diskfile[i];
 	}
+#ifdef _WIN32
 	filehandle = NULL;
 	maphandle = NULL;
+#else
+	filehandle = -1;
+	mappedSize = 0;
+#endif
+	options = 0;
 	address = NULL;
 	lastError = 0;
 	keepFileOnFree = true;
+	anonymous = false;
+	blockSize = 0;
+	hugePages = 0;
+	next = NULL;
+	tag = MEM_TAG_OTHER;
+	usedSize = 0;
 }
 void MemoryItem::KeepFile()
 {
 	keepFileOnFree = true;
 }
+#ifdef _WIN32
 void MemoryItem::Free()
 {
+	if(anonymous)
+	{
+		if(address != NULL)
+		{
+			VirtualFree(address, 0, MEM_RELEASE);
+			address = NULL;
+		}
+		return;
+	}
 	if(address != NULL)
 	{
 		UnmapViewOfFile(address);
@@ -783,126 +1216,763 @@ int MemoryItem::AllocateMemoryItem(size_t size)
 	return ret;
 }
 
-MemoryManager::MemoryManager(LPCWSTR folder)
+int MemoryItem::AllocateAnonymousItem(size_t size, size_t hugePageSize)
 {
-	count = 0;
-	items = NULL;
-	if(folder == NULL)
-		fileDir[0] = 0;
+	int ret = ERR_OK;
+	anonymous = true;
+	keepFileOnFree = false;
+	readOnly = false;
+	hugePages = 0;
+	address = NULL;
+	if(hugePageSize > 0 && size >= hugePageSize && size % hugePageSize == 0)
+	{
+		//large pages are locked in memory and need the "Lock pages in memory" right
+		address = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if(address != NULL)
+		{
+			hugePages = size / hugePageSize;
+		}
+	}
+	if(address == NULL)
+	{
+		address = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+	if(address == NULL)
+	{
+		lastError = GetLastError();
+		ret = ERR_MEM_OUTOFMEMORY;
+	}
 	else
 	{
-		SetFolder(folder);
-		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+		blockSize = size;
 	}
+	return ret;
 }
-MemoryManager::~MemoryManager()
-{
-	Clear();
-}
-void MemoryManager::Clear()
+#else
+void MemoryItem::Free()
 {
-	int i;
-	for(i=0;i<count;i++)
+	if(anonymous)
 	{
-		if(items[i] != NULL)
+		if(address != NULL)
 		{
-			items[i]->Free();
-			items[i] = NULL;
+			munmap(address, blockSize);
+			address = NULL;
 		}
+		return;
 	}
-	free(items);
-	items = NULL;
-	count = 0;
-}
-void MemoryManager::SetFolder(LPCWSTR folder)
-{
-	int i;
-	for(i=0;i<FILENAME_MAX;i++)
+	if(address != NULL)
 	{
-		if(folder[i] == 0)
+		munmap(address, mappedSize);
+		address = NULL;
+	}
+	if(filehandle != -1)
+	{
+		close(filehandle);
+		filehandle = -1;
+	}
+	if(!keepFileOnFree)
+	{
+		char path[FILENAME_MAX];
+		if(pathW2C(path, filename) == ERR_OK)
 		{
-			fileDir[i] = 0;
-			break;
+			unlink(path);
 		}
-		fileDir[i] = folder[i];
 	}
 }
-DWORD MemoryManager::LastError()
+MemoryItem::~MemoryItem(void)
+{
+	Free();
+}
+DWORD MemoryItem::LastError()
 {
 	return lastError;
 }
-void *MemoryManager::mapFileIntoMemory(wchar_t *filepath, size_t *size, int *nRet, bool createFile)
+bool MemoryItem::IsReadOnly()
 {
-	int i;
-	int ret;
-	bool full = true;
-	MemoryItem *p = NULL;
-	p = new MemoryItem(filepath);
-	if(createFile)
+	return readOnly;
+}
+/*
+	give the kernel the access pattern of the mapping. the advices are hints; a failure is not an error
+*/
+void MemoryItem::adviseMemory()
+{
+	if(options & MEM_MAP_SEQUENTIAL)
 	{
-		ret = p->AllocateMemoryItem(*size);
-		p->KeepFile();
+		madvise(address, mappedSize, MADV_SEQUENTIAL);
 	}
-	else
+	if(options & MEM_MAP_WILLNEED)
 	{
-		ret = p->ReadFileIntoMemoryItem(size);
+		madvise(address, mappedSize, MADV_WILLNEED);
 	}
-	if(ret != ERR_OK)
+#ifdef MADV_HUGEPAGE
+	if(options & MEM_MAP_HUGEPAGE)
 	{
-		lastError = p->LastError();
-		*nRet = ret;
+		madvise(address, mappedSize, MADV_HUGEPAGE);
 	}
-	else
+#endif
+}
+int MemoryItem::ReadFileIntoMemoryItem(size_t *size)
+{
+	int ret = ERR_OK;
+	char path[FILENAME_MAX];
+	struct stat st;
+	keepFileOnFree = true;
+	readOnly = true;
+	ret = pathW2C(path, filename);
+	if(ret == ERR_OK)
 	{
-		for(i=0;i<count;i++)
+		filehandle = open(path, O_RDONLY);
+		if(filehandle == -1)
 		{
-			if(items[i] == NULL)
-			{
-				items[i] = p;
-				full = false;
-				break;
-			}
+			lastError = errno;
+			ret = ERR_MEM_OPEN_FILE;
 		}
-		if(full)
+	}
+	if(ret == ERR_OK)
+	{
+		if(fstat(filehandle, &st) != 0)
+		{
+			lastError = errno;
+			ret = ERR_MEM_GET_FILE_SIZE;
+		}
+		else
 		{
-			MemoryItem **pp = (MemoryItem **) malloc((count+1)*sizeof(MemoryItem *));
-			for(i=0;i<count;i++)
+			*size = (size_t)st.st_size;
+			mappedSize = *size;
+			address = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED | ((options & MEM_MAP_POPULATE)?MAP_POPULATE:0), filehandle, 0);
+			if(address == MAP_FAILED)
 			{
-				pp[i] = items[i];
+				lastError = errno;
+				address = NULL;
+				ret = ERR_MEM_CREATE_VIEW;
 			}
-			pp[count] = p;
-			if(items != NULL)
+			else
 			{
-				free(items);
+				adviseMemory();
 			}
-			items = pp;
-			count ++;
 		}
-		return p->address;
+		if(ret != ERR_OK)
+		{
+			close(filehandle);
+			filehandle = -1;
+		}
 	}
-	return NULL;
-}
-void *MemoryManager::ReadFileIntoMemoryItem(wchar_t *filepath, size_t *size, int *nRet)
-{
-	return mapFileIntoMemory(filepath, size, nRet, false);
+	return ret;
 }
-void *MemoryManager::CreateFileIntoMemoryItem(wchar_t *filepath, size_t size, int *nRet)
+int MemoryItem::AllocateMemoryItem(size_t size)
 {
-	return mapFileIntoMemory(filepath, &size, nRet, true);
+	int ret = ERR_OK;
+	char path[FILENAME_MAX];
+	keepFileOnFree = false;
+	readOnly = false;
+	ret = pathW2C(path, filename);
+	if(ret == ERR_OK)
+	{
+		filehandle = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if(filehandle == -1)
+		{
+			lastError = errno;
+			ret = ERR_MEM_CREATE_FILE;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		int err = -1;
+#ifdef __linux__
+		if(options & MEM_MAP_FALLOCATE)
+		{
+			//reserve the blocks; a file system without fallocate falls back to a sparse file
+			err = fallocate(filehandle, 0, 0, (off_t)size);
+		}
+#endif
+		if(err != 0)
+		{
+			err = ftruncate(filehandle, (off_t)size);
+		}
+		if(err != 0)
+		{
+			lastError = errno;
+			ret = ERR_MEM_CREATE_FILE;
+		}
+		else
+		{
+			mappedSize = size;
+			address = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED | ((options & MEM_MAP_POPULATE)?MAP_POPULATE:0), filehandle, 0);
+			if(address == MAP_FAILED)
+			{
+				lastError = errno;
+				address = NULL;
+				ret = ERR_MEM_CREATE_VIEW;
+			}
+			else
+			{
+				adviseMemory();
+			}
+		}
+		if(ret != ERR_OK)
+		{
+			close(filehandle);
+			filehandle = -1;
+			unlink(path);
+		}
+	}
+	return ret;
 }
-LPVOID MemoryManager::Allocate(size_t size)
+int MemoryItem::AllocateAnonymousItem(size_t size, size_t hugePageSize)
+{
+	int ret = ERR_OK;
+	anonymous = true;
+	keepFileOnFree = false;
+	readOnly = false;
+	hugePages = 0;
+	address = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if(hugePageSize > 0 && size >= hugePageSize && size % hugePageSize == 0)
+	{
+		//pages reserved in /proc/sys/vm/nr_hugepages, or in hugepages-<size>kB for a size other than the default
+		int shift = 0;
+		while(((size_t)1 << shift) < hugePageSize)
+		{
+			shift++;
+		}
+		address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+		if(address != MAP_FAILED)
+		{
+			hugePages = size / hugePageSize;
+		}
+	}
+#endif
+	if(address == MAP_FAILED)
+	{
+		address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+		if(address != MAP_FAILED && hugePageSize > 0)
+		{
+			//transparent huge pages may still back the block
+			madvise(address, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	if(address == MAP_FAILED)
+	{
+		lastError = errno;
+		address = NULL;
+		ret = ERR_MEM_OUTOFMEMORY;
+	}
+	else
+	{
+		blockSize = size;
+	}
+	return ret;
+}
+#endif
+
+/*
+	size of the pool block for an allocation. above MEM_POOL_MIN_BLOCK there are 4 size classes per power of 2,
+	so a block wastes at most a quarter of its size
+*/
+static size_t poolSizeClass(size_t size)
+{
+	size_t p = MEM_POOL_MIN_BLOCK;
+	size_t step;
+	if(size <= p)
+	{
+		return p;
+	}
+	while(p <= size / 2)
+	{
+		p *= 2;
+	}
+	step = p / 4;
+	return ((size + step - 1) / step) * step;
+}
+static size_t physicalMemorySize()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX ms;
+	ms.dwLength = sizeof(ms);
+	if(GlobalMemoryStatusEx(&ms))
+	{
+		return (size_t)ms.ullTotalPhys;
+	}
+	return 0;
+#else
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long pageSize = sysconf(_SC_PAGESIZE);
+	if(pages > 0 && pageSize > 0)
+	{
+		return (size_t)pages * (size_t)pageSize;
+	}
+	return 0;
+#endif
+}
+
+const char *MemoryTagName(int tag)
+{
+	switch(tag)
+	{
+	case MEM_TAG_FIELDS:     return "fields";
+	case MEM_TAG_CURLS:      return "curls";
+	case MEM_TAG_MATERIALS:  return "materials";
+	case MEM_TAG_STATISTICS: return "statistics";
+	case MEM_TAG_IO:         return "I/O";
+	case MEM_TAG_OTHER:      return "other";
+	}
+	return "total";
+}
+/*
+	bucket of an address in a handle table of a power of 2 size.
+	allocations are page aligned, so the low bits are dropped before mixing
+*/
+static size_t handleBucket(LPVOID address, size_t bucketCount)
+{
+	unsigned long long h = (unsigned long long)(size_t)address >> 12;
+	h *= 0x9E3779B97F4A7C15ULL;
+	return (size_t)(h >> 32) & (bucketCount - 1);
+}
+
+MemoryManager::MemoryManager(LPCWSTR folder)
+{
+	int i;
+	buckets = NULL;
+	bucketCount = 0;
+	itemCount = 0;
+	for(i=0;i<MEM_TAG_COUNT;i++)
+	{
+		tagUsed[i] = tagPeak[i] = 0;
+	}
+	totalUsed = totalPeak = 0;
+	hardLimit = 0;
+	deniedSize = 0;
+	deniedTag = MEM_TAG_OTHER;
+	deniedUsed = 0;
+	pool = NULL;
+	poolCount = 0;
+	ramUsed = 0;
+	ramBudget = physicalMemorySize() / 2;
+	hugePageSize = 0;
+	hugePagesObtained = 0;
+	hugePageFallbacks = 0;
+	mapOptions[MEM_PURPOSE_SCRATCH] = MEM_MAP_FALLOCATE;
+	mapOptions[MEM_PURPOSE_SNAPSHOT] = MEM_MAP_FALLOCATE | MEM_MAP_SEQUENTIAL;
+	mapOptions[MEM_PURPOSE_INPUT] = MEM_MAP_SEQUENTIAL | MEM_MAP_WILLNEED;
+	if(folder == NULL)
+		fileDir[0] = 0;
+	else
+	{
+		SetFolder(folder);
+#ifdef _WIN32
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#endif
+	}
+}
+MemoryManager::~MemoryManager()
+{
+	Clear();
+}
+void MemoryManager::Clear()
+{
+	size_t i;
+	for(i=0;i<bucketCount;i++)
+	{
+		while(buckets[i] != NULL)
+		{
+			MemoryItem *p = buckets[i];
+			buckets[i] = p->next;
+			if(p->IsAnonymous())
+			{
+				ramUsed -= p->BlockSize();
+			}
+			p->Free();
+			delete p;
+		}
+	}
+	free(buckets);
+	buckets = NULL;
+	bucketCount = 0;
+	itemCount = 0;
+	for(i=0;i<MEM_TAG_COUNT;i++)
+	{
+		tagUsed[i] = 0;
+	}
+	totalUsed = 0;
+	ReleasePool();
+}
+void MemoryManager::SetRamBudget(size_t bytes)
+{
+	ramBudget = bytes;
+	if(ramUsed > ramBudget)
+	{
+		trimPool(ramUsed - ramBudget);
+	}
+}
+#ifdef _WIN32
+/*
+	enable the privilege of locking pages in memory, which large pages need; returns the large page size, 0 if unavailable
+*/
+static size_t enableLargePages()
+{
+	HANDLE token;
+	TOKEN_PRIVILEGES tp;
+	size_t size = 0;
+	if(OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+	{
+		if(LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &(tp.Privileges[0].Luid)))
+		{
+			tp.PrivilegeCount = 1;
+			tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+			//AdjustTokenPrivileges succeeds with ERROR_NOT_ALL_ASSIGNED when the account does not have the right
+			if(AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL) && GetLastError() == ERROR_SUCCESS)
+			{
+				size = GetLargePageMinimum();
+			}
+		}
+		CloseHandle(token);
+	}
+	return size;
+}
+#endif
+int MemoryManager::SetHugePageSize(size_t bytes)
+{
+	if(bytes != 0 && bytes != ((size_t)2 << 20) && bytes != ((size_t)1 << 30))
+	{
+		return ERR_MEM_HUGE_PAGE_SIZE;
+	}
+	//blocks kept in the pool have the old page size
+	ReleasePool();
+	hugePageSize = bytes;
+#ifdef _WIN32
+	if(bytes > 0)
+	{
+		size_t large = enableLargePages();
+		if(large > 0)
+		{
+			hugePageSize = large;
+		}
+		//without the right every block falls back to small pages and is counted by hugePageFallbacks
+	}
+#endif
+	return ERR_OK;
+}
+void MemoryManager::GetHugePageReport(size_t *obtained, size_t *fallbacks)
+{
+	*obtained = hugePagesObtained;
+	*fallbacks = hugePageFallbacks;
+}
+void MemoryManager::ReleasePool()
+{
+	trimPool(ramUsed);
+	free(pool);
+	pool = NULL;
+	poolCount = 0;
+}
+/*
+	release blocks kept in the pool until the given number of bytes are released or the pool is empty
+*/
+void MemoryManager::trimPool(size_t bytes)
+{
+	int i;
+	size_t released = 0;
+	for(i=0;i<poolCount && released < bytes;i++)
+	{
+		if(pool[i] != NULL)
+		{
+			released += pool[i]->BlockSize();
+			ramUsed -= pool[i]->BlockSize();
+			pool[i]->Free();
+			delete pool[i];
+			pool[i] = NULL;
+		}
+	}
+}
+/*
+	take a block of the size class of the allocation from the pool, or a new anonymous block if it fits in the budget.
+	a reused block is cleared so that the memory is zero-filled as a new mapping.
+	returns NULL if the allocation should spill to a temporary file
+*/
+MemoryItem *MemoryManager::allocateFromPool(size_t size, int tag)
+{
+	int i;
+	size_t blockSize = poolSizeClass(size);
+	size_t huge = 0;
+	MemoryItem *p = NULL;
+	if(hugePageSize > 0 && (tag == MEM_TAG_FIELDS || tag == MEM_TAG_CURLS) && blockSize >= hugePageSize)
+	{
+		//a whole number of huge pages
+		huge = hugePageSize;
+		blockSize = ((blockSize + huge - 1) / huge) * huge;
+	}
+	for(i=0;i<poolCount;i++)
+	{
+		if(pool[i] != NULL && pool[i]->BlockSize() == blockSize)
+		{
+			p = pool[i];
+			pool[i] = NULL;
+			memset(p->address, 0, size);
+			return p;
+		}
+	}
+	if(ramUsed + blockSize > ramBudget)
+	{
+		//blocks of other size classes give way to the new one
+		trimPool(ramUsed + blockSize - ramBudget);
+	}
+	if(ramUsed + blockSize <= ramBudget)
+	{
+		p = new MemoryItem(L"");
+		if(p->AllocateAnonymousItem(blockSize, huge) == ERR_OK)
+		{
+			ramUsed += blockSize;
+			if(huge > 0)
+			{
+				if(p->HugePages() > 0)
+				{
+					hugePagesObtained += p->HugePages();
+				}
+				else
+				{
+					hugePageFallbacks++;
+				}
+			}
+		}
+		else
+		{
+			//out of RAM; use a file
+			delete p;
+			p = NULL;
+		}
+	}
+	return p;
+}
+/*
+	check the hard limit before giving memory of the size. a denied allocation is remembered for reporting
+*/
+bool MemoryManager::withinLimit(size_t size, int tag)
+{
+	if(hardLimit > 0 && totalUsed + size > hardLimit)
+	{
+		deniedSize = size;
+		deniedTag = tag;
+		deniedUsed = totalUsed;
+		lastError = ERR_MEM_BUDGET;
+		return false;
+	}
+	return true;
+}
+/*
+	record an allocated item in the handle table so that Free can find it by its address, and count its size
+*/
+void MemoryManager::addItem(MemoryItem *p, size_t size, int tag)
+{
+	size_t b;
+	if(tag < 0 || tag >= MEM_TAG_COUNT)
+	{
+		tag = MEM_TAG_OTHER;
+	}
+	if(itemCount >= bucketCount)
+	{
+		//grow the table to keep the chains short
+		size_t i;
+		size_t n = (bucketCount == 0)? 64 : 2 * bucketCount;
+		MemoryItem **bb = (MemoryItem **)calloc(n, sizeof(MemoryItem *));
+		if(bb != NULL)
+		{
+			for(i=0;i<bucketCount;i++)
+			{
+				while(buckets[i] != NULL)
+				{
+					MemoryItem *q = buckets[i];
+					buckets[i] = q->next;
+					b = handleBucket(q->address, n);
+					q->next = bb[b];
+					bb[b] = q;
+				}
+			}
+			free(buckets);
+			buckets = bb;
+			bucketCount = n;
+		}
+	}
+	b = handleBucket(p->address, bucketCount);
+	p->next = buckets[b];
+	buckets[b] = p;
+	itemCount++;
+	//
+	p->tag = tag;
+	p->usedSize = size;
+	tagUsed[tag] += size;
+	if(tagUsed[tag] > tagPeak[tag])
+	{
+		tagPeak[tag] = tagUsed[tag];
+	}
+	totalUsed += size;
+	if(totalUsed > totalPeak)
+	{
+		totalPeak = totalUsed;
+	}
+}
+/*
+	take the item of an address out of the handle table and uncount its size. returns NULL if the address is not found
+*/
+MemoryItem *MemoryManager::removeItem(LPVOID address)
+{
+	MemoryItem **pp;
+	if(bucketCount == 0)
+	{
+		return NULL;
+	}
+	pp = &(buckets[handleBucket(address, bucketCount)]);
+	while(*pp != NULL)
+	{
+		MemoryItem *p = *pp;
+		if(p->address == address)
+		{
+			*pp = p->next;
+			p->next = NULL;
+			itemCount--;
+			tagUsed[p->tag] -= p->usedSize;
+			totalUsed -= p->usedSize;
+			return p;
+		}
+		pp = &(p->next);
+	}
+	return NULL;
+}
+bool MemoryManager::GetDeniedAllocation(size_t *size, int *tag, size_t *used)
+{
+	*used = deniedUsed;
+	*size = deniedSize;
+	*tag = deniedTag;
+	return deniedSize > 0;
+}
+void MemoryManager::GetUsage(int tag, size_t *used, size_t *peak)
+{
+	if(tag >= 0 && tag < MEM_TAG_COUNT)
+	{
+		*used = tagUsed[tag];
+		*peak = tagPeak[tag];
+	}
+	else
+	{
+		*used = totalUsed;
+		*peak = totalPeak;
+	}
+}
+void MemoryManager::SetFolder(LPCWSTR folder)
+{
+	int i;
+	for(i=0;i<FILENAME_MAX;i++)
+	{
+		if(folder[i] == 0)
+		{
+			fileDir[i] = 0;
+			break;
+		}
+		fileDir[i] = folder[i];
+	}
+}
+DWORD MemoryManager::LastError()
+{
+	return lastError;
+}
+int MemoryManager::SetMappingOptions(int purpose, unsigned options)
+{
+	if(purpose < 0 || purpose >= MEM_PURPOSE_COUNT)
+	{
+		return ERR_MEM_MAP_OPTION;
+	}
+	mapOptions[purpose] = options;
+	return ERR_OK;
+}
+unsigned MemoryManager::GetMappingOptions(int purpose)
+{
+	if(purpose < 0 || purpose >= MEM_PURPOSE_COUNT)
+	{
+		return 0;
+	}
+	return mapOptions[purpose];
+}
+void *MemoryManager::mapFileIntoMemory(wchar_t *filepath, size_t *size, int *nRet, bool createFile, int tag)
+{
+	int ret;
+	MemoryItem *p = NULL;
+	if(createFile && !withinLimit(*size, tag))
+	{
+		*nRet = ERR_MEM_BUDGET;
+		return NULL;
+	}
+	p = new MemoryItem(filepath);
+	if(createFile)
+	{
+		p->SetOptions(mapOptions[MEM_PURPOSE_SNAPSHOT]);
+		ret = p->AllocateMemoryItem(*size);
+		p->KeepFile();
+	}
+	else
+	{
+		p->SetOptions(mapOptions[MEM_PURPOSE_INPUT]);
+		ret = p->ReadFileIntoMemoryItem(size);
+		if(ret == ERR_OK && !withinLimit(*size, tag))
+		{
+			//the size of a file is known after it is opened
+			p->Free();
+			ret = ERR_MEM_BUDGET;
+		}
+	}
+	if(ret != ERR_OK)
+	{
+		if(ret != ERR_MEM_BUDGET)
+		{
+			lastError = p->LastError();
+		}
+		*nRet = ret;
+		delete p;
+	}
+	else
+	{
+		addItem(p, *size, tag);
+		return p->address;
+	}
+	return NULL;
+}
+void *MemoryManager::ReadFileIntoMemoryItem(wchar_t *filepath, size_t *size, int *nRet, int tag)
+{
+	return mapFileIntoMemory(filepath, size, nRet, false, tag);
+}
+void *MemoryManager::CreateFileIntoMemoryItem(wchar_t *filepath, size_t size, int *nRet, int tag)
+{
+	return mapFileIntoMemory(filepath, &size, nRet, true, tag);
+}
+LPVOID MemoryManager::Allocate(size_t size, int tag)
 {
 	int ret = ERR_OK;
 	int i;
 	int si;
-	bool full = true;
 	MemoryItem *p = NULL;
 	TCHAR  buffer[FILENAME_MAX];
+	if(!withinLimit(size, tag))
+	{
+		return NULL;
+	}
+	if(ramBudget > 0 && size > 0)
+	{
+		//scratch memory within the RAM budget does not need a file
+		p = allocateFromPool(size, tag);
+		if(p != NULL)
+		{
+			addItem(p, size, tag);
+			return p->address;
+		}
+	}
 	//find an unused file name
 	i = 0;
 	while(true)
 	{
+#ifdef _WIN32
 		si = swprintf_s(buffer, FILENAME_MAX, L"%s\\mp%d.dat",fileDir, i);
+#else
+		si = swprintf(buffer, FILENAME_MAX, L"%ls/mp%d.dat",fileDir, i);
+#endif
 		if(si < 0)
 		{
 			lastError = ERR_MEM_EINVAL;
@@ -921,37 +1991,16 @@ LPVOID MemoryManager::Allocate(size_t size)
 	if(ret == ERR_OK)
 	{
 		p = new MemoryItem(buffer);
+		p->SetOptions(mapOptions[MEM_PURPOSE_SCRATCH]);
 		ret = p->AllocateMemoryItem(size);
 		if(ret != ERR_OK)
 		{
 			lastError = p->LastError();
+			delete p;
 		}
 		else
 		{
-			for(i=0;i<count;i++)
-			{
-				if(items[i] == NULL)
-				{
-					items[i] = p;
-					full = false;
-					break;
-				}
-			}
-			if(full)
-			{
-				MemoryItem **pp = (MemoryItem **) malloc((count+1)*sizeof(MemoryItem *));
-				for(i=0;i<count;i++)
-				{
-					pp[i] = items[i];
-				}
-				pp[count] = p;
-				if(items != NULL)
-				{
-					free(items);
-				}
-				items = pp;
-				count ++;
-			}
+			addItem(p, size, tag);
 			return p->address;
 		}
 	}
@@ -959,20 +2008,47 @@ LPVOID MemoryManager::Allocate(size_t size)
 }
 int MemoryManager::Free(LPVOID address)
 {
-	int i;
-	for(i=0;i<count;i++)
+	MemoryItem *p = removeItem(address);
+	if(p == NULL)
 	{
-		if(items[i] != NULL)
+		return ERR_MEM_ADDR_NOT_FOUND;
+	}
+	if(p->IsAnonymous())
+	{
+		//keep the block for reuse
+		int k;
+		bool full = true;
+		for(k=0;k<poolCount;k++)
 		{
-			if(items[i]->address == address)
+			if(pool[k] == NULL)
 			{
-				items[i]->Free();
-				items[i] = NULL;
-				return ERR_OK;
+				pool[k] = p;
+				full = false;
+				break;
 			}
 		}
+		if(full)
+		{
+			MemoryItem **pp = (MemoryItem **) malloc((poolCount+1)*sizeof(MemoryItem *));
+			for(k=0;k<poolCount;k++)
+			{
+				pp[k] = pool[k];
+			}
+			pp[poolCount] = p;
+			if(pool != NULL)
+			{
+				free(pool);
+			}
+			pool = pp;
+			poolCount ++;
+		}
+	}
+	else
+	{
+		p->Free();
+		delete p;
 	}
-	return ERR_MEM_ADDR_NOT_FOUND;
+	return ERR_OK;
 }
 int MemoryManager::GetTemporaryFolder(char *folder, int size)
 {
@@ -6,8 +6,19 @@
 
 ********************************************************************/
 
+#ifdef _WIN32
 #include <Windows.h>
 #include <FileAPI.h>
+#else
+#include <wchar.h>
+//the Windows types used by the interface; the POSIX backend maps files with mmap
+typedef void *LPVOID;
+typedef const wchar_t *LPCWSTR;
+typedef const char *LPCSTR;
+typedef wchar_t TCHAR;
+typedef unsigned long DWORD;
+typedef void *HINSTANCE;
+#endif
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -15,6 +26,54 @@
 
 #define NAMESIZE 100
 
+/*
+	purposes of memory mappings. each purpose has its own mapping options, see MemoryManager::SetMappingOptions
+	MEM_PURPOSE_SCRATCH  - memory from Allocate; the temporary file is deleted when the memory is freed
+	MEM_PURPOSE_SNAPSHOT - memory from CreateFileIntoMemoryItem; a data file written once, mostly in sequence
+	MEM_PURPOSE_INPUT    - memory from ReadFileIntoMemoryItem; a read-only data file, usually read in sequence
+*/
+#define MEM_PURPOSE_SCRATCH  0
+#define MEM_PURPOSE_SNAPSHOT 1
+#define MEM_PURPOSE_INPUT    2
+#define MEM_PURPOSE_COUNT    3
+
+/*
+	mapping options. they are hints to the POSIX backend and are not used on Windows
+	MEM_MAP_POPULATE   - fault in all the pages when mapping (MAP_POPULATE)
+	MEM_MAP_SEQUENTIAL - the memory is swept in sequence; read ahead aggressively and drop pages behind (MADV_SEQUENTIAL)
+	MEM_MAP_WILLNEED   - start reading the file in the background (MADV_WILLNEED)
+	MEM_MAP_HUGEPAGE   - ask for transparent huge pages where the file system supports them (MADV_HUGEPAGE)
+	MEM_MAP_FALLOCATE  - reserve the disk blocks of a new file so that a full disk fails the allocation instead of a later write
+*/
+#define MEM_MAP_POPULATE   0x01
+#define MEM_MAP_SEQUENTIAL 0x02
+#define MEM_MAP_WILLNEED   0x04
+#define MEM_MAP_HUGEPAGE   0x08
+#define MEM_MAP_FALLOCATE  0x10
+
+/*
+	parse mapping options from names separated by ',' or ';', for example "SEQUENTIAL;WILLNEED".
+	names: NONE, POPULATE, SEQUENTIAL, WILLNEED, HUGEPAGE, FALLOCATE. returns ERR_MEM_MAP_OPTION on an unknown name
+*/
+int ParseMappingOptions(const char *names, unsigned *options);
+
+//smallest block of the scratch memory pool; blocks are in 4 size classes per power of 2 above it
+#define MEM_POOL_MIN_BLOCK 65536
+
+/*
+	categories of memory usage. MemoryManager keeps the bytes in use and the peak bytes of each category
+*/
+#define MEM_TAG_FIELDS     0 //field arrays and field data files
+#define MEM_TAG_CURLS      1 //curls, derivatives and other per-point work arrays of a time step
+#define MEM_TAG_MATERIALS  2 //material coefficients, material indexes and masks
+#define MEM_TAG_STATISTICS 3 //arrays of data analysis tasks
+#define MEM_TAG_IO         4 //data files read or written by tasks
+#define MEM_TAG_OTHER      5
+#define MEM_TAG_COUNT      6
+
+//name of a MEM_TAG_*
+const char *MemoryTagName(int tag);
+
 typedef void* (*fnCreatePluginInstance)(char *name, double *params);
 typedef void (*fnRemovePluginInstances)();
 
@@ -22,14 +81,28 @@ class MemoryItem
 {
 private:
 	TCHAR filename[FILENAME_MAX];
+#ifdef _WIN32
 	HANDLE filehandle;
 	HANDLE maphandle;
+#else
+	int filehandle;    //file descriptor, -1 if not open
+	size_t mappedSize; //size given to mmap, used by munmap
+	void adviseMemory();
+#endif
+	unsigned options;  //MEM_MAP_* flags
 	//
 	bool readOnly;
 	bool keepFileOnFree;
+	bool anonymous;    //memory not backed by a file, see AllocateAnonymousItem
+	size_t blockSize;  //size of an anonymous block
+	size_t hugePages;  //huge pages backing an anonymous block, 0 if it has small pages
 	//
 	DWORD lastError;
 public:
+	MemoryItem *next;  //next item in the same bucket of the handle table of MemoryManager
+	int tag;           //MEM_TAG_*
+	size_t usedSize;   //bytes counted for tag
+	//
 	MemoryItem(LPCWSTR diskfile);
 	virtual ~MemoryItem(void);
 	void Free();
@@ -38,33 +111,107 @@ public:
 	LPVOID address;
 	//
 	void KeepFile();
+	void SetOptions(unsigned mapOptions){options = mapOptions;}
 	virtual int AllocateMemoryItem(size_t size);
 	int ReadFileIntoMemoryItem(size_t *size);
+	/*
+		allocate RAM not backed by a file. it is used by the scratch memory pool of MemoryManager.
+		hugePageSize > 0 asks for huge pages of that size, for a size which is a multiple of it; when the system
+		does not give them the block gets small pages, and on Linux is advised for transparent huge pages
+	*/
+	int AllocateAnonymousItem(size_t size, size_t hugePageSize);
 	bool IsReadOnly();
+	bool IsAnonymous(){return anonymous;}
+	size_t BlockSize(){return blockSize;}
+	size_t HugePages(){return hugePages;}
 };
 
 class MemoryManager
 {
 private:
-	MemoryItem **items;
-	int count;
+	//handle table: items hashed by address, chained by MemoryItem::next. bucketCount is a power of 2
+	MemoryItem **buckets;
+	size_t bucketCount;
+	size_t itemCount;
 	TCHAR fileDir[FILENAME_MAX];
+	unsigned mapOptions[MEM_PURPOSE_COUNT]; //MEM_MAP_* flags of each MEM_PURPOSE_*
+	//
+	//scratch memory pool. Allocate takes anonymous blocks while they fit in ramBudget, and spills to
+	//temporary files after that. a freed block is kept in pool for reuse by an allocation of the same size class
+	MemoryItem **pool;
+	int poolCount;
+	size_t ramBudget; //bytes of anonymous blocks allowed, in use and kept in pool; 0 to use files only
+	size_t ramUsed;   //bytes of anonymous blocks, in use and kept in pool
+	//
+	//huge pages for the blocks of field and curl arrays
+	size_t hugePageSize;      //0 for small pages only
+	size_t hugePagesObtained; //huge pages of the blocks taken so far
+	size_t hugePageFallbacks; //blocks which asked for huge pages and got small pages
+	//
+	//accounting
+	size_t tagUsed[MEM_TAG_COUNT];
+	size_t tagPeak[MEM_TAG_COUNT];
+	size_t totalUsed;
+	size_t totalPeak;
+	size_t hardLimit;      //bytes; an allocation making totalUsed larger fails with ERR_MEM_BUDGET. 0 for no limit
+	size_t deniedSize;     //size of the allocation denied by hardLimit, 0 if none is denied
+	int deniedTag;
+	size_t deniedUsed;     //bytes in use when the allocation is denied
 	//
 	DWORD lastError;
 	//
-	void *mapFileIntoMemory(wchar_t *filepath, size_t *size, int *nRet, bool createFile);
+	void *mapFileIntoMemory(wchar_t *filepath, size_t *size, int *nRet, bool createFile, int tag);
+	bool withinLimit(size_t size, int tag);
+	void addItem(MemoryItem *p, size_t size, int tag);
+	MemoryItem *removeItem(LPVOID address);
+	MemoryItem *allocateFromPool(size_t size, int tag);
+	void trimPool(size_t bytes);
 public:
 	MemoryManager(LPCWSTR folder);
 	~MemoryManager();
 	void SetFolder(LPCWSTR folder);
+	/*
+		set MEM_MAP_* options for the mappings made for a MEM_PURPOSE_*.
+		defaults: scratch - FALLOCATE; snapshot - FALLOCATE | SEQUENTIAL; input - SEQUENTIAL | WILLNEED
+	*/
+	int SetMappingOptions(int purpose, unsigned options);
+	unsigned GetMappingOptions(int purpose);
+	/*
+		set the RAM budget in bytes of the scratch memory pool; 0 makes Allocate use temporary files only.
+		the default is half of the physical memory
+	*/
+	void SetRamBudget(size_t bytes);
+	size_t GetRamBudget(){return ramBudget;}
+	/*
+		back the pool blocks of MEM_TAG_FIELDS and MEM_TAG_CURLS allocations of at least one huge page with huge pages,
+		bytes: 2MB or 1GB, 0 for small pages only. on Windows the process needs the "Lock pages in memory" right,
+		and the large page size of the processor is used. a block the system cannot give huge pages to gets small pages
+	*/
+	int SetHugePageSize(size_t bytes);
+	size_t GetHugePageSize(){return hugePageSize;}
+	//huge pages obtained so far and the number of blocks which got small pages instead
+	void GetHugePageReport(size_t *obtained, size_t *fallbacks);
+	//release the blocks kept in the pool
+	void ReleasePool();
 	int GetTemporaryFolder(char *folder, int size);
 	void Clear();
 	DWORD LastError();
 	//
-	void *ReadFileIntoMemoryItem(wchar_t *filepath, size_t *size, int *nRet);
-	void *CreateFileIntoMemoryItem(wchar_t *filepath, size_t size, int *nRet);
-	LPVOID Allocate(size_t size);
+	void *ReadFileIntoMemoryItem(wchar_t *filepath, size_t *size, int *nRet, int tag = MEM_TAG_IO);
+	void *CreateFileIntoMemoryItem(wchar_t *filepath, size_t size, int *nRet, int tag = MEM_TAG_IO);
+	LPVOID Allocate(size_t size, int tag = MEM_TAG_OTHER);
 	int Free(LPVOID address);
+	//
+	/*
+		hard limit in bytes of all the memory given by the memory manager, in use at the same time; 0 for no limit.
+		an allocation going over the limit fails at once; GetDeniedAllocation tells which one
+	*/
+	void SetHardLimit(size_t bytes){hardLimit = bytes;}
+	size_t GetHardLimit(){return hardLimit;}
+	//false if no allocation is denied by the hard limit
+	bool GetDeniedAllocation(size_t *size, int *tag, size_t *used);
+	//bytes in use and peak bytes of a MEM_TAG_*, or of all the tags if tag is MEM_TAG_COUNT
+	void GetUsage(int tag, size_t *used, size_t *peak);
 };
 
 /*
@@ -86,6 +233,9 @@ public:
 //allocate memory using a temporary file for mapping. the file will be deleted on freeing the memory
 #define AllocateMemory(size) _mem->Allocate(size)
 
+//AllocateMemory counted for a category of memory usage, tag: MEM_TAG_*
+#define AllocateTaggedMemory(size, tag) _mem->Allocate((size), (tag))
+
 //free memory. close the memory mapping file. delete the file if it is a tempory file. 
 #define FreeMemory(e) _mem->Free((e))
 
@@ -93,4 +243,8 @@ public:
 #define ReadFileIntoMemory(fname, sizeRet, errRet) _mem->ReadFileIntoMemoryItem((fname), (sizeRet), (errRet))
 
 //create a new file and map it to a writable memory, fname: wchar_t*, sizeRet: size_t, errRet: int*
-#define CreateFileIntoMemory(fname, size, errRet) _mem->CreateFileIntoMemoryItem((fname), (size), (errRet))
\ No newline at end of file
+#define CreateFileIntoMemory(fname, size, errRet) _mem->CreateFileIntoMemoryItem((fname), (size), (errRet))
+
+//ReadFileIntoMemory and CreateFileIntoMemory counted for a category of memory usage other than MEM_TAG_IO, tag: MEM_TAG_*
+#define ReadFileIntoTaggedMemory(fname, sizeRet, errRet, tag) _mem->ReadFileIntoMemoryItem((fname), (sizeRet), (errRet), (tag))
+#define CreateFileIntoTaggedMemory(fname, size, errRet, tag) _mem->CreateFileIntoMemoryItem((fname), (size), (errRet), (tag))
\ No newline at end of file
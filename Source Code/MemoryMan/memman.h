@@ -6,7 +6,7 @@
 	Allrights reserved by Bob Limnor
 
 ********************************************************************/
-#include "..\ProcessMonitor\workProcess.h"
+#include "../ProcessMonitor/workProcess.h"
 
 #define ERR_OK                 0
 #define ERR_MEM_CREATE_FILE    6001
@@ -28,9 +28,17 @@
 #define ERR_MEM_MAN_APP_PATH   6017
 #define ERR_MEM_OUTOFMEMORY    6018
 #define ERR_MEM_DIR_NOTEXIST   6019
+#define ERR_MEM_MAP_OPTION     6020
+#define ERR_MEM_BUDGET         6021
+#define ERR_MEM_PIN_THREAD     6022
+#define ERR_MEM_HUGE_PAGE_SIZE 6023
 #define ERR_MEM_UNKNOWN        6030
 
 
+#ifndef _WIN32
+typedef long long __int64;
+#endif
+
 #define LODWORD(l)           ((DWORD)(((size_t)(l)) & 0xffffffff))
 #define HIDWORD(l)           ((DWORD)((((size_t)(l)) >> 32) & 0xffffffff))
 
@@ -79,6 +87,15 @@ int formDataFileName(char *filename, size_t size, const char *basename, size_t t
 int formDataFileNameW(wchar_t *filename, size_t size, const wchar_t *basename, size_t timeIndex);
 int formFieldFileNameW(wchar_t *filename, size_t size, const wchar_t *basename, size_t timeIndex);
 
+//number of NUMA nodes of the computer; 1 if it is not a NUMA computer
+int NumaNodeCount();
+/*
+	pin the calling thread to one processor as thread i of threadCount threads working on contiguous blocks in order.
+	the threads are spread evenly over the NUMA nodes, thread 0 on node 0, so that the blocks of the threads of one node
+	are next to each other. memory first touched by a pinned thread stays on its node
+*/
+int PinThreadToNode(int i, int threadCount);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
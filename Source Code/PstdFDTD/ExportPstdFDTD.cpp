@@ -0,0 +1,49 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+/*
+	Each subclass of FDTD should be a class in a DLL like this one.
+	A DLL may contain several classes. each class should provide a parameterless constructor. 
+	To use a class, a program specifies DLL file path and a class name.
+*/
+#include "PstdFDTD.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+	__declspec (dllexport) void* CreatePluginInstance(char *name, double *params);
+	__declspec (dllexport) void RemovePluginInstances();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+PstdFDTD **pstdList = NULL;
+unsigned int pstdCount = 0;
+
+__declspec (dllexport) void RemovePluginInstances()
+{
+	REMOVEALLPLUGINS(PstdFDTD, pstdCount, pstdList);
+}
+__declspec (dllexport) void* CreatePluginInstance(char *name, double *params)
+{
+	FDTD *p = NULL;
+	if(strcmp(name,"PstdFDTD") == 0)
+	{
+		CREATEPLUGININSTANCE(PstdFDTD, pstdCount, pstdList);
+	}
+	if(p != NULL)
+	{
+		//class name will be used in forming data file names
+		p->setClassName(name);
+	}
+	return p;
+}
@@ -0,0 +1,333 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+
+#include <Windows.h>
+#include "PstdFDTD.h"
+#include <malloc.h>
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+
+#include "..\MemoryMan\memman.h"
+
+/*
+	thread function for the pencils of one thread
+*/
+static DWORD WINAPI pencilThread(LPVOID param)
+{
+	PstdPencilWork *w = (PstdPencilWork *)param;
+	w->owner->processPencils(w);
+	return 0;
+}
+
+PstdFDTD::PstdFDTD(void)
+{
+	mu0 = 4.0 * M_PI * 1.0e-7;
+	eps0 = 1.0 /(mu0 * c0 * c0);
+	substeps = 1;
+	threadCount = 1;
+	for(int c=0;c<3;c++)
+	{
+		length[c] = 0;
+		radius[c] = 0;
+		waveNumbers[c] = NULL;
+	}
+	for(int i=0;i<MAX_PSTD_THREADS;i++)
+	{
+		works[i].owner = this;
+		works[i].line = NULL;
+		works[i].work = NULL;
+		works[i].indexes = NULL;
+	}
+	_axis = 0;
+	_fromE = true;
+	_coef = 0.0;
+}
+PstdFDTD::~PstdFDTD(void)
+{
+	cleanup();
+}
+
+void PstdFDTD::cleanup()
+{
+	for(int c=0;c<3;c++)
+	{
+		plans[c].cleanup();
+		if(waveNumbers[c] != NULL)
+		{
+			free(waveNumbers[c]);
+			waveNumbers[c] = NULL;
+		}
+	}
+	for(int i=0;i<MAX_PSTD_THREADS;i++)
+	{
+		if(works[i].line != NULL)
+		{
+			free(works[i].line);
+			works[i].line = NULL;
+		}
+		if(works[i].work != NULL)
+		{
+			free(works[i].work);
+			works[i].work = NULL;
+		}
+		if(works[i].indexes != NULL)
+		{
+			free(works[i].indexes);
+			works[i].indexes = NULL;
+		}
+	}
+}
+
+void PstdFDTD::OnFinishSimulation()
+{
+	cleanup();
+}
+
+int PstdFDTD::onInitialized(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	int longest = 0, workSize = 0;
+	double k2 = 0.0;
+	cleanup();
+	if(_tfsf != NULL)
+	{
+		ret = ERR_PSTD_TFSF;
+	}
+	else
+	{
+		substeps = (int)taskParameters->getUInt(TP_PSTD_SUBSTEPS, true);
+		threadCount = (int)taskParameters->getUInt(TP_FDTD_THREADS, true);
+		ret = taskParameters->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		radius[0] = maxRadiusX;
+		radius[1] = maxRadiusY;
+		radius[2] = maxRadiusZ;
+		for(int c=0;c<3 && ret == ERR_OK;c++)
+		{
+			length[c] = 2 * radius[c] + 1;
+			ret = plans[c].initialize(length[c]);
+			if(ret == ERR_OK)
+			{
+				waveNumbers[c] = (double *)malloc(length[c] * sizeof(double));
+				if(waveNumbers[c] == NULL)
+				{
+					ret = ERR_OUTOFMEMORY;
+				}
+			}
+			if(ret == ERR_OK)
+			{
+				//item j of the transform is for the wave number 2*pi*j/(L*ds), j = -(L-1)/2,...,(L-1)/2;
+				//the division by L is for the inverse transform
+				double L = (double)length[c];
+				for(int j=0;j<length[c];j++)
+				{
+					int jw = (2 * j <= length[c])? j : j - length[c];
+					if(2 * j == length[c])
+					{
+						//the Nyquist item of an even length has no derivative
+						jw = 0;
+					}
+					waveNumbers[c][j] = (2.0 * M_PI * (double)jw / (L * ds)) / L;
+				}
+				k2 += pow(2.0 * M_PI * (double)((length[c] - 1) / 2) / (L * ds), 2);
+				if(length[c] > longest) longest = length[c];
+				if(plans[c].getWorkSize() > workSize) workSize = plans[c].getWorkSize();
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//the largest angular frequency of the grid decides the number of sub-steps
+		int stableSteps = (int)ceil(c0 * sqrt(k2) * dt / PSTD_STABILITY);
+		if(stableSteps < 1) stableSteps = 1;
+		if(substeps == 0)
+		{
+			substeps = stableSteps;
+		}
+		else if(substeps < stableSteps)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			taskParameters->setNameOfInvalidValue(TP_PSTD_SUBSTEPS);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		if(threadCount == 0)
+		{
+			SYSTEM_INFO si;
+			GetSystemInfo(&si);
+			threadCount = (int)si.dwNumberOfProcessors;
+		}
+		if(threadCount > MAX_PSTD_THREADS) threadCount = MAX_PSTD_THREADS;
+		for(int i=0;i<threadCount;i++)
+		{
+			works[i].first = i;
+			works[i].step = threadCount;
+			works[i].line = (FftComplex *)malloc(longest * sizeof(FftComplex));
+			works[i].work = (FftComplex *)malloc((workSize > 0 ? workSize : 1) * sizeof(FftComplex));
+			works[i].indexes = (size_t *)malloc(longest * sizeof(size_t));
+			if(works[i].line == NULL || works[i].work == NULL || works[i].indexes == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+	for each pencil along _axis, c1 and c2 are the other 2 components in cyclic order.
+	dF[c1]/d[_axis] goes to component c2 of the curl and -dF[c2]/d[_axis] goes to component c1 of the curl
+*/
+void PstdFDTD::processPencils(PstdPencilWork *w)
+{
+	int c = _axis;
+	int a = (c + 1) % 3;
+	int b = (c + 2) % 3;
+	int src = _fromE ? 0 : 3;
+	int dest = _fromE ? 3 : 0;
+	int L = length[c];
+	int pencils = length[a] * length[b];
+	double *k = waveNumbers[c];
+	FftPlan *plan = &(plans[c]);
+	FftComplex *line = w->line;
+	size_t *idx = w->indexes;
+	int q[3];
+	double re, im;
+	w->ret = ERR_OK;
+	for(int pc=w->first;pc<pencils;pc+=w->step)
+	{
+		q[a] = pc / length[b] - radius[a];
+		q[b] = pc % length[b] - radius[b];
+		//two real components in one complex pencil
+		for(int j=0;j<L;j++)
+		{
+			double *f;
+			q[c] = j - radius[c];
+			idx[j] = seriesIndex->Index(q[0], q[1], q[2]);
+			f = (double *)&(HE[idx[j]]);
+			line[j].re = f[src + a];
+			line[j].im = f[src + b];
+		}
+		plan->transform(line, w->work);
+		//multiply by i*k and take the inverse transform by conj(forward(conj(.)))
+		for(int j=0;j<L;j++)
+		{
+			re = line[j].re;
+			im = line[j].im;
+			line[j].re = -k[j] * im;
+			line[j].im = -k[j] * re;
+		}
+		plan->transform(line, w->work);
+		for(int j=0;j<L;j++)
+		{
+			double *f = (double *)&(HE[idx[j]]);
+			f[dest + b] += _coef * line[j].re;
+			f[dest + a] += _coef * line[j].im;
+		}
+	}
+}
+
+/*
+	add _coef times the derivatives along an axis to the curl of E (into H) or the curl of H (into E)
+*/
+int PstdFDTD::derivativePass(int axis, bool fromE, double coef)
+{
+	int ret = ERR_OK;
+	_axis = axis;
+	_fromE = fromE;
+	_coef = coef;
+	if(threadCount == 1)
+	{
+		processPencils(&(works[0]));
+		ret = works[0].ret;
+	}
+	else
+	{
+		HANDLE threads[MAX_PSTD_THREADS];
+		DWORD count = 0;
+		for(int i=0;i<threadCount;i++)
+		{
+			threads[count] = CreateThread(NULL, 0, pencilThread, &(works[i]), 0, NULL);
+			if(threads[count] == NULL)
+			{
+				RememberOSerror();
+				ret = ERR_PSTD_THREAD;
+				break;
+			}
+			count++;
+		}
+		if(count > 0)
+		{
+			WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+			for(DWORD i=0;i<count;i++)
+			{
+				CloseHandle(threads[i]);
+			}
+		}
+		for(DWORD i=0;i<count && ret == ERR_OK;i++)
+		{
+			ret = works[i].ret;
+		}
+	}
+	return ret;
+}
+
+/*
+	H += coef * curl E if fromE is true; E += coef * curl H if fromE is false
+*/
+int PstdFDTD::curlPass(bool fromE, double coef)
+{
+	int ret = ERR_OK;
+	for(int c=0;c<3 && ret == ERR_OK;c++)
+	{
+		ret = derivativePass(c, fromE, coef);
+	}
+	return ret;
+}
+
+int PstdFDTD::updateFieldsToMoveForward()
+{
+	int ret = ERR_OK;
+	double h = dt / (double)substeps;
+	//advance time indicators
+	_timeIndex++;
+	_time += dt;
+	//save existing fields to a file and allocating new memory.
+	//it will copy the existing fields to new memory.
+	//fields are still at a time of _time-dt.
+	ret = allocateFieldMemory();
+	if(ret == ERR_OK)
+	{
+		if(_recordFDTDStepTimes)
+		{
+			startTime = getTimeCount();
+		}
+		//H to the middle of the first sub-step
+		ret = curlPass(true, -0.5 * h / mu0);
+		for(int s=0;s<substeps && ret == ERR_OK;s++)
+		{
+			ret = curlPass(false, h / eps0);
+			if(ret == ERR_OK)
+			{
+				//the half steps of H between 2 sub-steps are merged into one step
+				ret = curlPass(true, ((s == substeps - 1)? -0.5 : -1.0) * h / mu0);
+			}
+		}
+		if(_recordFDTDStepTimes)
+		{
+			endTime = getTimeCount(); timeUsed = endTime - startTime;
+			_sumtimeused += timeUsed;
+			_timesteps++;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,102 @@
+#ifndef __PSTDFDTD_H__
+#define __PSTDFDTD_H__
+
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+
+#include "..\EMField\EMField.h"
+#include "..\EMField\FdtdMemory.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "..\MathTools\Fft.h"
+
+#define ERR_PSTD_TFSF   2101
+#define ERR_PSTD_THREAD 2102
+
+//largest number of threads for the pencil passes; it is the limit of WaitForMultipleObjects
+#define MAX_PSTD_THREADS 64
+
+//the time stepping is stable if the largest angular frequency of the grid times the sub-step is less than 2; keep a margin
+#define PSTD_STABILITY 1.9
+
+class PstdFDTD;
+
+/*
+	work of one thread: pencils first, first+step, first+2*step, ... of a pass
+*/
+typedef struct PstdPencilWork
+{
+	PstdFDTD *owner;
+	int first;
+	int step;
+	FftComplex *line;  //[longest axis], one pencil
+	FftComplex *work;  //work buffer of the FFT plans
+	size_t *indexes;   //[longest axis], memory indexes of the pencil
+	int ret;
+}PstdPencilWork;
+
+/*
+	pseudo-spectral time domain (PSTD) algorithm.
+
+	all field components are at the grid points and at the same time, as for TSS. a space derivative along an axis
+	is taken for a whole line of grid points (a pencil) by an FFT: multiply the transform by i*k and transform back.
+	two real components are packed into one complex pencil, so each FFT gives the derivatives of 2 components.
+	a curl is 3 passes, one for each axis; the pencils of a pass are shared by FDTD.THREADS threads.
+
+	time stepping is second order (velocity Verlet):
+		H += -(h/2)/mu0 curl E, E += h/eps0 curl H, H += -(h/2)/mu0 curl E
+	with h = dt/S. the spectral derivatives make the largest frequency of the grid higher than Yee's, so dt is
+	divided into S sub-steps to be stable; the middle half steps of H are merged, giving 2S+1 curls for each dt.
+	task parameter FDTD.PSTD_SUBSTEPS may give a larger S for a smaller time error.
+
+	the FFT treats the domain as periodic; it suits periodic problems and fields which are negligible near the domain faces.
+	a boundary condition still works on the grid points at the faces. a TF/SF boundary is not supported.
+	FDTD.HALF_ORDER_SPACE and FDTD.HALF_ORDER_TIME are not used.
+*/
+class PstdFDTD: public virtual FDTD
+{
+private:
+	double mu0;  //Permeability
+	double eps0; //Permittivity
+	//
+	int substeps;                      //S
+	int threadCount;                   //FDTD.THREADS
+	int length[3];                     //grid points along each axis
+	int radius[3];                     //maxRadiusX, maxRadiusY, maxRadiusZ
+	FftPlan plans[3];                  //FFT of each axis
+	double *waveNumbers[3];            //[length[c]], k/length[c] for each transform item of axis c
+	PstdPencilWork works[MAX_PSTD_THREADS];
+	//
+	//current pass
+	int _axis;                         //derivatives along this axis
+	bool _fromE;                       //true: curl E is added to H; false: curl H is added to E
+	double _coef;                      //multiply the curl by it
+	//
+	int derivativePass(int axis, bool fromE, double coef);
+	int curlPass(bool fromE, double coef);
+protected:
+	virtual void cleanup();
+	virtual int onInitialized(TaskFile *taskParameters); //called after initialize(...) returns ERR_OK
+
+public:
+	PstdFDTD(void);
+	~PstdFDTD(void);
+	//
+	//pencils are indexed by (m,n,p); they work on a row-major box
+	virtual bool SupportBoxDomain(){return true;}
+	virtual bool IsStaggered(){return false;}
+
+	virtual int updateFieldsToMoveForward();
+	virtual void OnFinishSimulation();
+	//
+	/*
+		do the pencils of w for the current pass. it is called by a thread of a pass
+	*/
+	void processPencils(PstdPencilWork *w);
+};
+
+#endif
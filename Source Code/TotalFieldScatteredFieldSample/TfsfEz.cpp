@@ -11,10 +11,17 @@
 #include "..\EMField\RadiusIndex.h"
 
 #include <malloc.h>
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++  
+#include <cmath>
+
+//impedance of vacuum, sqrt(mu0/eps0)
+#define IMP0 376.730313461
 
 TfsfEz::TfsfEz(void)
 {
 	g1 = NULL;
+	ppw = 15.0;
 }
 
 /*
@@ -33,6 +40,20 @@ int TfsfEz::initialize(double Courant, int maximumRadius, TaskFile *taskParamete
 		}
 		else
 		{
+			ppw = taskParameters->getDouble(TP_TFSF_PPW, true);
+			ret = taskParameters->getErrorCode();
+			if(ret == ERR_OK)
+			{
+				if(ppw == 0.0)
+				{
+					ppw = 15.0;
+				}
+				else if(ppw < 0.0)
+				{
+					ret = ERR_TASK_INVALID_VALUE;
+					taskParameters->setNameOfInvalidValue(TP_TFSF_PPW);
+				}
+			}
 		}
 	}
 	return ret;
@@ -56,3 +77,47 @@ void TfsfEz::applyOnPlaneZ0(int i, int j)
 void TfsfEz::applyOnPlaneZ1(int i, int j)
 {
 }
+
+/*
+	a Ricker plane wave of Ez travelling along +x, entering the total field region at plane x0.
+	it uses the same Ricker function as ricker.c of the book "understanding FDTD method":
+		arg = M_PI * ((cdtds * time - location) / ppw - 1.0);
+		ezInc = (1.0 - 2.0 * arg * arg) * exp(-arg * arg);
+	Hy = -Ez / IMP0 so that E x H points to +x
+*/
+int TfsfEz::getIncidentField(int m, int n, int p, double t, FieldPoint3D *f)
+{
+	return getIncidentFieldAt((double)m, (double)n, (double)p, t, f);
+}
+int TfsfEz::getIncidentFieldAt(double x, double y, double z, double t, FieldPoint3D *f)
+{
+	double location = x + (double)(maxRadiusX - firstX + 1);
+	double arg = M_PI * ((Cdtds * t - location) / ppw - 1.0);
+	arg = arg * arg;
+	f->E.x = f->E.y = 0.0;
+	f->E.z = (1.0 - 2.0 * arg) * exp(-arg);
+	f->H.x = f->H.z = 0.0;
+	f->H.y = -f->E.z / IMP0;
+	return ERR_OK;
+}
+
+/*
+	the incident wave only changes along x, so a line along y or z is one value
+*/
+int TfsfEz::getIncidentLine(double x, double y, double z, int axis, int count, double t, FieldPoint3D *f)
+{
+	int ret;
+	if(axis == 0)
+	{
+		ret = TotalFieldScatteredFieldBoundary::getIncidentLine(x, y, z, axis, count, t, f);
+	}
+	else
+	{
+		ret = getIncidentFieldAt(x, y, z, t, f);
+		for(int s=1;s<count;s++)
+		{
+			f[s] = f[0];
+		}
+	}
+	return ret;
+}
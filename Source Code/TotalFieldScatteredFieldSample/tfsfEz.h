@@ -11,6 +11,9 @@
 #include "..\EMField\EMField.h"
 #include "..\EMField\TotalFieldScatteredFieldBoundary.h"
 
+//points per wavelength of the incident Ricker wave, optional, default to 15
+#define TP_TFSF_PPW "TFSF.PPW"
+
 /*
 	implement TFSF boundary
 	the code/algorithm is taken from from book "understanding FDTD method" by John B. Schneider
@@ -45,6 +48,7 @@ class TfsfEz:public TotalFieldScatteredFieldBoundary
 {
 protected:
 	Grid *g1; // 1D auxilliary grid
+	double ppw; //points per wavelength of the incident wave
 public:
 	TfsfEz(void);
 
@@ -55,6 +59,9 @@ public:
 	virtual void applyOnPlaneY1(int i, int k);
 	virtual void applyOnPlaneZ0(int i, int j);
 	virtual void applyOnPlaneZ1(int i, int j);
+	virtual int getIncidentField(int m, int n, int p, double t, FieldPoint3D *f);
+	virtual int getIncidentFieldAt(double x, double y, double z, double t, FieldPoint3D *f);
+	virtual int getIncidentLine(double x, double y, double z, int axis, int count, double t, FieldPoint3D *f);
 
 };
 
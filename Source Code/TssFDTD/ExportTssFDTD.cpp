@@ -31,11 +31,17 @@ TssFDTD **tssList = NULL;
 unsigned int tssCount = 0;
 TssFDTDinhomo **tssinhomoList = NULL;
 unsigned int tssInhomoCOunt = 0;
+TssFDTDhybrid **tssHybridList = NULL;
+unsigned int tssHybridCount = 0;
+TssFDTDwave **tssWaveList = NULL;
+unsigned int tssWaveCount = 0;
 
 __declspec (dllexport) void RemovePluginInstances()
 {
 	REMOVEALLPLUGINS(TssFDTD, tssCount, tssList);
 	REMOVEALLPLUGINS(TssFDTDinhomo, tssInhomoCOunt, tssinhomoList);
+	REMOVEALLPLUGINS(TssFDTDhybrid, tssHybridCount, tssHybridList);
+	REMOVEALLPLUGINS(TssFDTDwave, tssWaveCount, tssWaveList);
 }
 __declspec (dllexport) void* CreatePluginInstance(char *name, double *params)
 {
@@ -48,6 +54,14 @@ __declspec (dllexport) void* CreatePluginInstance(char *name, double *params)
 	{
 		CREATEPLUGININSTANCE(TssFDTDinhomo, tssInhomoCOunt, tssinhomoList);
 	}
+	else if(strcmp(name, "TssFDTDhybrid") == 0)
+	{
+		CREATEPLUGININSTANCE(TssFDTDhybrid, tssHybridCount, tssHybridList);
+	}
+	else if(strcmp(name, "TssFDTDwave") == 0)
+	{
+		CREATEPLUGININSTANCE(TssFDTDwave, tssWaveCount, tssWaveList);
+	}
 	if(p != NULL)
 	{
 		//class name will be used in forming data file names
@@ -15,6 +15,22 @@ TssFDTD::~TssFDTD(void)
 {
 }
 ///////////////////////////////////////////////////////
+TssFDTDhybrid::TssFDTDhybrid(void)
+{
+}
+
+TssFDTDhybrid::~TssFDTDhybrid(void)
+{
+}
+///////////////////////////////////////////////////////
+TssFDTDwave::TssFDTDwave(void)
+{
+}
+
+TssFDTDwave::~TssFDTDwave(void)
+{
+}
+///////////////////////////////////////////////////////
 TssFDTDinhomo::TssFDTDinhomo(void)
 {
 }
@@ -11,6 +11,8 @@
 #include "..\EMField\EMField.h"
 #include "..\TssInSphere\TssInSphere.h"
 #include "..\TssInSphere\TssInhomogeneous.h"
+#include "..\TssInSphere\TssYeeHybrid.h"
+#include "..\TssInSphere\TssWaveEquation.h"
 
 class TssFDTD:public TssInSphere
 {
@@ -19,6 +21,26 @@ public:
 	~TssFDTD(void);
 };
 ///////////////////////////////////////////////////////////////
+/*
+	TSS within task parameter FDTD.TSS_RADIUS and Yee's algorithm outside it
+*/
+class TssFDTDhybrid:public TssYeeHybrid
+{
+public:
+	TssFDTDhybrid(void);
+	~TssFDTDhybrid(void);
+};
+///////////////////////////////////////////////////////////////
+/*
+	E-only wave equation form of TSS, for source-free homogeneous spaces
+*/
+class TssFDTDwave:public TssWaveEquation
+{
+public:
+	TssFDTDwave(void);
+	~TssFDTDwave(void);
+};
+///////////////////////////////////////////////////////////////
 /*
 	a sample implementation of applying TSS algorithm to inhomogeneous environments
 */
@@ -9,6 +9,10 @@
 
 ApplyCurls::ApplyCurls()
 {
+	_rates = NULL;
+	_step = 0;
+	_materials8 = NULL;
+	_materials16 = NULL;
 }
 void ApplyCurls::SetFields(FieldPoint3D *fields, FieldPoint3D *curls, double *factorE, double *factorH)
 {
@@ -18,6 +22,26 @@ void ApplyCurls::SetFields(FieldPoint3D *fields, FieldPoint3D *curls, double *fa
 	_factorH = factorH;
 	index = 0;
 }
+int ApplyCurls::gothroughRuns(const MaskRun *runs, size_t count, size_t endIndex)
+{
+	size_t end;
+	ret = ERR_OK;
+	for(size_t i=0;i<count;i++)
+	{
+		if(runs[i].start >= endIndex)
+		{
+			break;
+		}
+		end = runs[i].end < endIndex ? runs[i].end : endIndex;
+		//a handler only uses index, and moves it to the next point
+		index = runs[i].start;
+		while(index < end)
+		{
+			handleData(0, 0, 0);
+		}
+	}
+	return ret;
+}
 void ApplyCurlsEven::handleData(int m, int n, int p)
 {
 	_fields[index].E.x += *_factorE * _curls[index].E.x;
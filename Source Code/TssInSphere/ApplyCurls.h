@@ -7,6 +7,7 @@
 ********************************************************************/
 #include "..\EMField\RadiusIndex.h"
 #include "..\EMField\EMField.h"
+#include "..\EMField\MaterialMask.h"
 /*
 	apply curls for advancing fields in time
 */
@@ -16,9 +17,23 @@ protected:
 	FieldPoint3D *_fields; //fields for applying curls to it
 	FieldPoint3D *_curls;  //curls to apply to _fields
 	double *_factorE, *_factorH;
+	unsigned char *_rates; //rate of each point for multi-rate time stepping, NULL if all points are advanced in every time step
+	size_t _step;          //time step index for multi-rate time stepping; a point is advanced if _step is a multiple of its rate
+	//material index of each point for factors given by materials, see TssInhomogeneous; both are NULL if factors are not by materials
+	const unsigned char *_materials8;
+	const unsigned short *_materials16;
+	size_t materialAt(size_t i){return _materials8 != NULL ? (size_t)_materials8[i] : (size_t)_materials16[i];}
 public:
 	ApplyCurls();
 	virtual void SetFields(FieldPoint3D *fields, FieldPoint3D *curls, double *factorE, double *factorH);
+	void SetRates(unsigned char *rates, size_t step){_rates = rates; _step = step;}
+	//one of them is not NULL; the factors given to SetFields are indexed by materials
+	void SetMaterials(const unsigned char *materials8, const unsigned short *materials16){_materials8 = materials8; _materials16 = materials16;}
+	/*
+		apply curls only at the points of runs, instead of going through a sphere.
+		runs are in memory order; points at and after endIndex are not visited
+	*/
+	int gothroughRuns(const MaskRun *runs, size_t count, size_t endIndex);
 	virtual void handleData(int m, int n, int p)=0;
 };
 /*
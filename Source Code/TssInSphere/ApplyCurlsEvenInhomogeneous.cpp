@@ -9,23 +9,45 @@
 
 void ApplyCurlsEvenInhomogeneous::handleData(int m, int n, int p)
 {
-	_fields[index].E.x += _factorE[index] * _curls[index].E.x;
-	_fields[index].E.y += _factorE[index] * _curls[index].E.y;
-	_fields[index].E.z += _factorE[index] * _curls[index].E.z;
-	_fields[index].H.x += _factorH[index] * _curls[index].H.x;
-	_fields[index].H.y += _factorH[index] * _curls[index].H.y;
-	_fields[index].H.z += _factorH[index] * _curls[index].H.z;
+	size_t k;
+	if(_rates != NULL)
+	{
+		if(_step % _rates[index] != 0)
+		{
+			//the point is not advanced in this time step
+			index++;
+			return;
+		}
+	}
+	k = materialAt(index);
+	_fields[index].E.x += _factorE[k] * _curls[index].E.x;
+	_fields[index].E.y += _factorE[k] * _curls[index].E.y;
+	_fields[index].E.z += _factorE[k] * _curls[index].E.z;
+	_fields[index].H.x += _factorH[k] * _curls[index].H.x;
+	_fields[index].H.y += _factorH[k] * _curls[index].H.y;
+	_fields[index].H.z += _factorH[k] * _curls[index].H.z;
 	//
 	index++;
 }
 void ApplyCurlsOddInhomogeneous::handleData(int m, int n, int p)
 {
-	_fields[index].E.x += _factorH[index] * _curls[index].H.x;
-	_fields[index].E.y += _factorH[index] * _curls[index].H.y;
-	_fields[index].E.z += _factorH[index] * _curls[index].H.z;
-	_fields[index].H.x += _factorE[index] * _curls[index].E.x;
-	_fields[index].H.y += _factorE[index] * _curls[index].E.y;
-	_fields[index].H.z += _factorE[index] * _curls[index].E.z;
+	size_t k;
+	if(_rates != NULL)
+	{
+		if(_step % _rates[index] != 0)
+		{
+			//the point is not advanced in this time step
+			index++;
+			return;
+		}
+	}
+	k = materialAt(index);
+	_fields[index].E.x += _factorH[k] * _curls[index].H.x;
+	_fields[index].E.y += _factorH[k] * _curls[index].H.y;
+	_fields[index].E.z += _factorH[k] * _curls[index].H.z;
+	_fields[index].H.x += _factorE[k] * _curls[index].E.x;
+	_fields[index].H.y += _factorE[k] * _curls[index].E.y;
+	_fields[index].H.z += _factorE[k] * _curls[index].E.z;
 	//
 	index++;
 }
@@ -9,7 +9,8 @@
 #include "ApplyCurls.h"
 
 /*
-	apply curls for advancing fields in time at order 2k
+	apply curls for advancing fields in time at order 2k.
+	factors are given for each material; SetMaterials must be called
 */
 class ApplyCurlsEvenInhomogeneous:public ApplyCurlsEven
 {
@@ -18,7 +19,8 @@ public:
 };
 
 /*
-	apply curls for advancing fields in time at order 2k+1
+	apply curls for advancing fields in time at order 2k+1.
+	factors are given for each material; SetMaterials must be called
 */
 class ApplyCurlsOddInhomogeneous:public ApplyCurlsOdd
 {
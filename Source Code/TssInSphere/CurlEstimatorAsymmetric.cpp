@@ -11,6 +11,11 @@
 CurlEstimatorAsymmetric::CurlEstimatorAsymmetric(DerivativeEstimatorAsymmetric *derivative)
 {
 	_derivative = derivative;
+	_derivativeMax = derivative;
+	_orderMap = NULL;
+	_levels = NULL;
+	_level = 0;
+	_mask = NULL;
 	_fields = NULL;
 	_curls = NULL;
 	if(_derivative != NULL)
@@ -29,28 +34,57 @@ void CurlEstimatorAsymmetric::SetFields(FieldPoint3D *fields, FieldPoint3D *curl
 	_curls = curls;
 	index = 0;
 }
+void CurlEstimatorAsymmetric::SetOrderMap(EstimationOrderMap *orderMap)
+{
+	_orderMap = orderMap;
+	_derivative = _derivativeMax;
+}
+RadiusHandleType CurlEstimatorAsymmetric::setRadius(int radius)
+{
+	if(_orderMap != NULL)
+	{
+		_derivative = _orderMap->EstimatorAt(radius);
+	}
+	return NeedProcess;
+}
 void CurlEstimatorAsymmetric::handleData(int m, int n, int p)
 {
 	int h;
 	int k,i;
+	const DerivativeStencil *stencil;
+	if(_mask != NULL && (_mask[index] & MASK_INACTIVE))
+	{
+		index++;
+		return;
+	}
+	if(_levels != NULL)
+	{
+		if(_levels[index] < _level)
+		{
+			//not needed by the points advanced in this time step
+			index++;
+			return;
+		}
+	}
 	_curls[index].E.x = _curls[index].H.x = _curls[index].E.y = _curls[index].H.y = _curls[index].E.z = _curls[index].H.z = 0.0;
 	//
 	//get dy
-	h = _derivative->checkBoundary(n);
+	stencil = _derivative->GetStencil(n);
+	h = stencil->h;
 	if(h == 0)
 	{
 		//_positiveEnd = M, _negativeEnd=-M
-		//_derivative->coefficients[i] = - _derivative->coefficients[i+M], i=0,1,2,...,M-1
+		//stencil->coefficients[i] = - stencil->coefficients[i+M], i=0,1,2,...,M-1
 		i=0; //i=0,1,2,...,_positiveEnd-1
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m,n+k,p);
 			idx2 = seriesIndex->Index(m,n-k,p);
-			_curls[index].E.x += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
-			_curls[index].H.x += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
-			_curls[index].E.z -= _derivative->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
-			_curls[index].H.z -= _derivative->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
+			_curls[index].E.x += stencil->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
+			_curls[index].H.x += stencil->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
+			_curls[index].E.z -= stencil->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
+			_curls[index].H.z -= stencil->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
 			k++;
 			i++;
 		}
@@ -59,43 +93,44 @@ void CurlEstimatorAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0; //i=0,1,2,...,_positiveEnd-1
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m,n+k,p);
-			_curls[index].E.x += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_curls[index].H.x += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
-			_curls[index].E.z -= _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_curls[index].H.z -= _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_curls[index].E.x += stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_curls[index].H.x += stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_curls[index].E.z -= stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_curls[index].H.z -= stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k++;
 			i++;
 		}
 		//i=_positiveEnd, _positiveEnd+1, _positiveEnd+2,...,_positiveEnd+(-_negativeEnd-1)=2M-1
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m,n+k,p);
-			_curls[index].E.x += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_curls[index].H.x += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
-			_curls[index].E.z -= _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_curls[index].H.z -= _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_curls[index].E.x += stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_curls[index].H.x += stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_curls[index].E.z -= stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_curls[index].H.z -= stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k--;
 			i++;
 		}
 	}
 	//get dz
-	h = _derivative->checkBoundary(p);
+	stencil = _derivative->GetStencil(p);
+	h = stencil->h;
 	if(h == 0)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m,n,p+k);
 			idx2 = seriesIndex->Index(m,n,p-k);
-			_curls[index].E.x -= _derivative->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
-			_curls[index].H.x -= _derivative->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
-			_curls[index].E.y += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
-			_curls[index].H.y += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
+			_curls[index].E.x -= stencil->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
+			_curls[index].H.x -= stencil->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
+			_curls[index].E.y += stencil->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
+			_curls[index].H.y += stencil->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
 			k++;
 			i++;
 		}
@@ -104,42 +139,43 @@ void CurlEstimatorAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m,n,p+k);
-			_curls[index].E.x -= _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_curls[index].H.x -= _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
-			_curls[index].E.y += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_curls[index].H.y += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_curls[index].E.x -= stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_curls[index].H.x -= stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_curls[index].E.y += stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_curls[index].H.y += stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k++;
 			i++;
 		}
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m,n,p+k);
-			_curls[index].E.x -= _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_curls[index].H.x -= _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
-			_curls[index].E.y += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_curls[index].H.y += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_curls[index].E.x -= stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_curls[index].H.x -= stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_curls[index].E.y += stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_curls[index].H.y += stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k--;
 			i++;
 		}
 	}
 	//get dx
-	h = _derivative->checkBoundary(m);
+	stencil = _derivative->GetStencil(m);
+	h = stencil->h;
 	if(h == 0)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m+k,n,p);
 			idx2 = seriesIndex->Index(m-k,n,p);
-			_curls[index].E.y -= _derivative->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
-			_curls[index].H.y -= _derivative->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
-			_curls[index].E.z += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
-			_curls[index].H.z += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
+			_curls[index].E.y -= stencil->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
+			_curls[index].H.y -= stencil->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
+			_curls[index].E.z += stencil->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
+			_curls[index].H.z += stencil->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
 			k++;
 			i++;
 		}
@@ -148,24 +184,24 @@ void CurlEstimatorAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m+k,n,p);
-			_curls[index].E.y -= _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_curls[index].H.y -= _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
-			_curls[index].E.z += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_curls[index].H.z += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_curls[index].E.y -= stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_curls[index].H.y -= stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_curls[index].E.z += stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_curls[index].H.z += stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
 			k++;
 			i++;
 		}
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m+k,n,p);
-			_curls[index].E.y -= _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_curls[index].H.y -= _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
-			_curls[index].E.z += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_curls[index].H.z += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_curls[index].E.y -= stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_curls[index].H.y -= stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_curls[index].E.z += stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_curls[index].H.z += stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
 			k--;
 			i++;
 		}
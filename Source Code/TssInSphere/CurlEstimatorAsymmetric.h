@@ -8,8 +8,12 @@
 #include "..\EMField\EMField.h"
 #include "..\EMField\RadiusIndex.h"
 #include "DerivativeEstimator.h"
+#include "EstimationOrderMap.h"
+#include "..\EMField\MaterialMask.h"
 /*
-	estimate curls using asymmetric derivative estimation
+	estimate curls using asymmetric derivative estimation.
+	if an order map is set then the derivative estimator is switched at the start of each radius.
+	with a material mask, curls are not estimated at inactive points; they must be cleared once by MaterialMask::ClearInactive
 */
 class CurlEstimatorAsymmetric:public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
 {
@@ -17,14 +21,26 @@ private:
 	FieldPoint3D *_fields; //fields for calculating curls of it
 	FieldPoint3D *_curls;  //curls of _fields
 	DerivativeEstimatorAsymmetric *_derivative;
+	DerivativeEstimatorAsymmetric *_derivativeMax; //estimator of the maximum order, used when there is not an order map
+	EstimationOrderMap *_orderMap;                 //estimation order at each radius
+	unsigned char *_levels;                        //curls are only estimated where _levels[index] >= _level; NULL for all points
+	unsigned char _level;
+	const unsigned char *_mask;                    //kinds of points of a MaterialMask; NULL if not used
 	size_t index;
 	int r;
 protected:
 	int ret;
 	size_t idx, idx2;
+	virtual RadiusHandleType setRadius(int radius);
 public:
 	CurlEstimatorAsymmetric(DerivativeEstimatorAsymmetric *derivative);
 	void SetFields(FieldPoint3D *fields, FieldPoint3D *curls);
+	//use different estimation orders at different radiuses; NULL for using the maximum order everywhere
+	void SetOrderMap(EstimationOrderMap *orderMap);
+	//estimate curls only at points where levels[i] >= level; levels is NULL for all points
+	void SetLevels(unsigned char *levels, unsigned char level){_levels = levels; _level = level;}
+	//skip inactive points of a material mask; NULL for all points
+	void SetMask(const unsigned char *mask){_mask = mask;}
 	virtual void handleData(int m, int n, int p);
 };
 
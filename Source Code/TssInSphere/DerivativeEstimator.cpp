@@ -38,6 +38,9 @@ DerivativeEstimatorAsymmetric::DerivativeEstimatorAsymmetric(int maxEstimationOr
 	ret = ERR_OK;
 	coefficientByEdge = NULL;
 	coefficients = NULL;
+	coefficient2ByEdge = NULL;
+	coefficients2 = NULL;
+	_stencils = NULL;
 	_numEstimatins = 2 * maxEstimationOrder + 1;
 }
 DerivativeEstimatorAsymmetric::~DerivativeEstimatorAsymmetric()
@@ -57,6 +60,25 @@ void DerivativeEstimatorAsymmetric::cleanup()
 			}
 		}
 		delete[] coefficientByEdge;
+		coefficientByEdge = NULL;
+	}
+	if(coefficient2ByEdge != NULL)
+	{
+		for(int i=0;i<_numEstimatins;i++)
+		{
+			if(coefficient2ByEdge[i] != NULL)
+			{
+				delete coefficient2ByEdge[i];
+				coefficient2ByEdge[i] = NULL;
+			}
+		}
+		delete[] coefficient2ByEdge;
+		coefficient2ByEdge = NULL;
+	}
+	if(_stencils != NULL)
+	{
+		free(_stencils);
+		_stencils = NULL;
 	}
 }
 /*
@@ -120,42 +142,20 @@ void DerivativeEstimatorAsymmetric::fillTaylorMatrixAsymmetric(double *a, int po
 */
 int DerivativeEstimatorAsymmetric::checkBoundary(int idx)
 {
-	int h;
-	if(idx >= 0)
-	{
-		if(idx <= _radiusOfInterior)
-		{
-			h = 0;
-			coefficients = coefficientByEdge[0];
-			_positiveEnd =  _maxOrder;
-			_negativeEnd = -_maxOrder;
-		}
-		else
-		{
-			h = maxRadius - idx + 1;                 //1(idx=maxRadius:maximum index), 2(maxRadius-1), 3, ..., _maxOrder(idx=maxRadius-_maxOrder+1:minimum boundary index)
-			coefficients = coefficientByEdge[h];
-			_positiveEnd =  h - 1;                   //0              (idx at edge), 1,              2,            ..., _maxOrder-1 (idx just enters boundary)
-			_negativeEnd = -(2 * _maxOrder - h + 1); //-2 * _maxOrder (idx at edge), -2*_maxOrder-1, -2*_maxOrder-2, ..., -_maxOrder-1 
-		}
-	}
-	else
-	{
-		if(idx >= -_radiusOfInterior)
-		{
-			h = 0;
-			coefficients = coefficientByEdge[0];
-			_positiveEnd =  _maxOrder;
-			_negativeEnd = -_maxOrder;
-		}
-		else
-		{
-			h = maxRadius + idx + 1;                         //1(idx=-maxRadius),          2(-maxRadius+1),3(-maxRadius+2),...,_maxOrder(-maxRadius+_maxOrder-1)
-			coefficients = coefficientByEdge[_maxOrder + h];
-			_positiveEnd =  2 * _maxOrder - h + 1;           //2 * _maxOrder (idx at edge), 2*_maxOrder-1, 2*_maxOrder-2, ..., _maxOrder+1
-			_negativeEnd = -h + 1;                           //0             (idx at edge), -1,            -2,            ..., -_maxOrder+1
-		}
-	}
-	return h;
+	return checkBoundary(idx, maxRadius);
+}
+/*
+	the same as checkBoundary(idx) but the boundary is at axisRadius instead of maxRadius.
+	the coefficients do not depend on maxRadius, so, one estimator serves all 3 axes of a rectangular box
+*/
+int DerivativeEstimatorAsymmetric::checkBoundary(int idx, int axisRadius)
+{
+	const DerivativeStencil *stencil = GetStencil(idx, axisRadius);
+	coefficients = stencil->coefficients;
+	coefficients2 = stencil->coefficients2;
+	_positiveEnd = stencil->positiveEnd;
+	_negativeEnd = stencil->negativeEnd;
+	return stencil->h;
 }
 void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 {
@@ -163,18 +163,21 @@ void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 	int M22 = M2 * M2;
 	cleanup();
 	coefficientByEdge = new double*[_numEstimatins];
-	if(coefficientByEdge == NULL)
+	coefficient2ByEdge = new double*[_numEstimatins];
+	if(coefficientByEdge == NULL || coefficient2ByEdge == NULL)
 		ret = ERR_OUTOFMEMORY;
 	else
 	{
 		for(i=0;i<_numEstimatins;i++)
 		{
 			coefficientByEdge[i] = NULL;
+			coefficient2ByEdge[i] = NULL;
 		}
 		for(i=0;i<_numEstimatins;i++)
 		{
 			coefficientByEdge[i] = new double[M2];
-			if(coefficientByEdge[i] == NULL)
+			coefficient2ByEdge[i] = new double[M2];
+			if(coefficientByEdge[i] == NULL || coefficient2ByEdge[i] == NULL)
 			{
 				ret = ERR_OUTOFMEMORY;
 				break;
@@ -202,9 +205,11 @@ void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 			if(inverse(A, Q, M2))
 			{
 				coefficients = coefficientByEdge[0];
+				coefficients2 = coefficient2ByEdge[0];
 				for(i=0;i<M2;i++)
 				{
 					coefficients[i] = Q[i];
+					coefficients2[i] = Q[M2 + i];
 				}
 			}
 			else
@@ -220,9 +225,11 @@ void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 					if(inverse(A, Q, M2))
 					{
 						coefficients = coefficientByEdge[h];
+						coefficients2 = coefficient2ByEdge[h];
 						for(i=0;i<M2;i++)
 						{
 							coefficients[i] = Q[i];
+							coefficients2[i] = Q[M2 + i];
 						}
 					}
 					else
@@ -241,9 +248,11 @@ void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 					if(inverse(A, Q, M2))
 					{
 						coefficients = coefficientByEdge[_maxOrder + h];
+						coefficients2 = coefficient2ByEdge[_maxOrder + h];
 						for(i=0;i<M2;i++)
 						{
 							coefficients[i] = Q[i];
+							coefficients2[i] = Q[M2 + i];
 						}
 					}
 					else
@@ -254,6 +263,37 @@ void DerivativeEstimatorAsymmetric::prepareCoefficeints()
 				}
 			}
 		}
+		if(ret == ERR_OK)
+		{
+			//stencils by edge, see checkBoundary
+			_stencils = (DerivativeStencil *)malloc(_numEstimatins * sizeof(DerivativeStencil));
+			if(_stencils == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+			else
+			{
+				_stencils[0].h = 0;
+				_stencils[0].positiveEnd =  _maxOrder;
+				_stencils[0].negativeEnd = -_maxOrder;
+				for(int h=1;h<=_maxOrder;h++)
+				{
+					//near or at the positive edge
+					_stencils[h].h = h;
+					_stencils[h].positiveEnd =  h - 1;
+					_stencils[h].negativeEnd = -(2 * _maxOrder - h + 1);
+					//near or at the negative edge
+					_stencils[_maxOrder + h].h = h;
+					_stencils[_maxOrder + h].positiveEnd =  2 * _maxOrder - h + 1;
+					_stencils[_maxOrder + h].negativeEnd = -h + 1;
+				}
+				for(i=0;i<_numEstimatins;i++)
+				{
+					_stencils[i].coefficients = coefficientByEdge[i];
+					_stencils[i].coefficients2 = coefficient2ByEdge[i];
+				}
+			}
+		}
 		if(A != NULL)
 		{
 			free(A);
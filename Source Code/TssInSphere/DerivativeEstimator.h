@@ -33,6 +33,21 @@ public:
 	inline void SetIndex(int m, int n, int p, size_t index);
 };
 /////////////////////////////////////////////////////////////////////////
+/*
+	samplings and coefficients of the derivative estimations at a location of an axis.
+	samplings are at k = 1,...,positiveEnd then k = -1,...,negativeEnd; coefficients[i] is for the i-th sampling.
+	h is what checkBoundary returns: 0 for the central estimation, in which coefficients of -k are the negatives
+	of the coefficients of k and only k = 1,...,positiveEnd are used
+*/
+typedef struct DerivativeStencil
+{
+	double *coefficients;  //first derivative
+	double *coefficients2; //second derivative
+	int positiveEnd;
+	int negativeEnd;
+	int h;
+}DerivativeStencil;
+/////////////////////////////////////////////////////////////////////////
 /*
 	estimate derivatives. use asymmetric estimations near and at the boundary
 */
@@ -40,6 +55,7 @@ class DerivativeEstimatorAsymmetric: public DerivativeEstimator
 {
 private:
 	int _numEstimatins; //1+2*_maxOrder
+	DerivativeStencil *_stencils; //[_numEstimatins], the same order as coefficientByEdge
 	void fillTaylorMatrixAsymmetric(double *a, int positiveEnd, int negativeEnd);
 protected:
 	virtual void cleanup();
@@ -48,10 +64,34 @@ public:
 	~DerivativeEstimatorAsymmetric();
 	//
 	virtual void prepareCoefficeints();
+	/*
+		checkBoundary sets coefficients, coefficients2, _positiveEnd and _negativeEnd of this object for idx.
+		GetStencil gives the same values without changing this object, so, one estimator can be shared by
+		curl estimators, analysors and threads working at the same time
+	*/
 	virtual int checkBoundary(int idx);
+	//check boundary on an axis of a rectangular box; axisRadius is the maximum radius of the axis
+	int checkBoundary(int idx, int axisRadius);
+	const DerivativeStencil *GetStencil(int idx) const {return GetStencil(idx, maxRadius);}
+	const DerivativeStencil *GetStencil(int idx, int axisRadius) const
+	{
+		int radiusOfInterior = axisRadius - _maxOrder;
+		if(idx >= 0)
+		{
+			if(idx <= radiusOfInterior)
+				return &(_stencils[0]);
+			return &(_stencils[axisRadius - idx + 1]);
+		}
+		if(idx >= -radiusOfInterior)
+			return &(_stencils[0]);
+		return &(_stencils[_maxOrder + axisRadius + idx + 1]);
+	}
 	//array used by "asymmetric estimation" approach 
 	double **coefficientByEdge; //[2M+1] pointer of 2M doubles
 	double *coefficients; //findCoeeficients sets coefficients to one of pointers in coefficientByEdge
+	//second derivatives from the same samplings, used the same way as coefficientByEdge and coefficients
+	double **coefficient2ByEdge; //[2M+1] pointer of 2M doubles
+	double *coefficients2; //checkBoundary sets coefficients2 to one of pointers in coefficient2ByEdge
 	int _positiveEnd, _negativeEnd; //indexes for getting samplings, set by findCoeeficients
 
 };
@@ -0,0 +1,396 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include <malloc.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EstimationOrderMap.h"
+
+/*
+	largest absolute value of the 6 field components
+*/
+static double largestComponent(FieldPoint3D *f)
+{
+	double v = fabs(f->E.x);
+	if(fabs(f->E.y) > v) v = fabs(f->E.y);
+	if(fabs(f->E.z) > v) v = fabs(f->E.z);
+	if(fabs(f->H.x) > v) v = fabs(f->H.x);
+	if(fabs(f->H.y) > v) v = fabs(f->H.y);
+	if(fabs(f->H.z) > v) v = fabs(f->H.z);
+	return v;
+}
+/*
+	largest absolute value of the second differences of the 6 field components, f1 - 2*f0 + f2
+*/
+static double secondDifference(FieldPoint3D *f1, FieldPoint3D *f0, FieldPoint3D *f2)
+{
+	double v = fabs(f1->E.x - 2.0 * f0->E.x + f2->E.x);
+	double d;
+	d = fabs(f1->E.y - 2.0 * f0->E.y + f2->E.y); if(d > v) v = d;
+	d = fabs(f1->E.z - 2.0 * f0->E.z + f2->E.z); if(d > v) v = d;
+	d = fabs(f1->H.x - 2.0 * f0->H.x + f2->H.x); if(d > v) v = d;
+	d = fabs(f1->H.y - 2.0 * f0->H.y + f2->H.y); if(d > v) v = d;
+	d = fabs(f1->H.z - 2.0 * f0->H.z + f2->H.z); if(d > v) v = d;
+	return v;
+}
+
+SmoothnessByRadius::SmoothnessByRadius(void)
+{
+	_fields = NULL;
+	_maxField = NULL;
+	_maxDifference = NULL;
+}
+SmoothnessByRadius::~SmoothnessByRadius(void)
+{
+	cleanup();
+}
+void SmoothnessByRadius::cleanup()
+{
+	if(_maxField != NULL)
+	{
+		free(_maxField);
+		_maxField = NULL;
+	}
+	if(_maxDifference != NULL)
+	{
+		free(_maxDifference);
+		_maxDifference = NULL;
+	}
+}
+int SmoothnessByRadius::AllocateList(int maxR)
+{
+	cleanup();
+	maxRadius = maxR;
+	_maxField = (double *)malloc((maxR + 1) * sizeof(double));
+	_maxDifference = (double *)malloc((maxR + 1) * sizeof(double));
+	if(_maxField == NULL || _maxDifference == NULL)
+	{
+		return ERR_OUTOFMEMORY;
+	}
+	for(int i=0;i<=maxR;i++)
+	{
+		_maxField[i] = _maxDifference[i] = 0.0;
+	}
+	return ERR_OK;
+}
+void SmoothnessByRadius::SetFields(FieldPoint3D *fields)
+{
+	_fields = fields;
+}
+double SmoothnessByRadius::Ratio(int radius)
+{
+	if(_maxField[radius] <= 0.0)
+	{
+		return 0.0;
+	}
+	return _maxDifference[radius] / _maxField[radius];
+}
+RadiusHandleType SmoothnessByRadius::setRadius(int radius)
+{
+	r = radius;
+	_maxField[r] = _maxDifference[r] = 0.0;
+	return NeedProcess;
+}
+/*
+	second differences are taken along an axis only where both neighbours exist
+*/
+void SmoothnessByRadius::handleData(int m, int n, int p)
+{
+	double v;
+	FieldPoint3D *f = &(_fields[index]);
+	v = largestComponent(f);
+	if(v > _maxField[r]) _maxField[r] = v;
+	if(m > -maxRadius && m < maxRadius)
+	{
+		v = secondDifference(&(_fields[SINDEX(m+1,n,p)]), f, &(_fields[SINDEX(m-1,n,p)]));
+		if(v > _maxDifference[r]) _maxDifference[r] = v;
+	}
+	if(n > -maxRadius && n < maxRadius)
+	{
+		v = secondDifference(&(_fields[SINDEX(m,n+1,p)]), f, &(_fields[SINDEX(m,n-1,p)]));
+		if(v > _maxDifference[r]) _maxDifference[r] = v;
+	}
+	if(p > -maxRadius && p < maxRadius)
+	{
+		v = secondDifference(&(_fields[SINDEX(m,n,p+1)]), f, &(_fields[SINDEX(m,n,p-1)]));
+		if(v > _maxDifference[r]) _maxDifference[r] = v;
+	}
+	index++;
+}
+
+////////////////////////////////////////////////////////////////
+
+EstimationOrderMap::EstimationOrderMap(void)
+{
+	ret = ERR_OK;
+	_maxHalfOrder = 0;
+	_maxR = 0;
+	_derivativeByOrder = NULL;
+	_capByRadius = NULL;
+	_selectedByRadius = NULL;
+	_halfOrderByRadius = NULL;
+	_useMap = false;
+	_tolerance = 0.0;
+	_interval = DEF_ORDER_SELECT_INTERVAL;
+	_stepsToSelect = 0;
+	_smoothness = NULL;
+}
+EstimationOrderMap::~EstimationOrderMap(void)
+{
+	cleanup();
+}
+void EstimationOrderMap::cleanup()
+{
+	if(_derivativeByOrder != NULL)
+	{
+		//the estimator of the maximum order belongs to the caller
+		for(int h=1;h<_maxHalfOrder;h++)
+		{
+			if(_derivativeByOrder[h] != NULL)
+			{
+				delete _derivativeByOrder[h];
+				_derivativeByOrder[h] = NULL;
+			}
+		}
+		delete[] _derivativeByOrder;
+		_derivativeByOrder = NULL;
+	}
+	if(_capByRadius != NULL)
+	{
+		free(_capByRadius);
+		_capByRadius = NULL;
+	}
+	if(_selectedByRadius != NULL)
+	{
+		free(_selectedByRadius);
+		_selectedByRadius = NULL;
+	}
+	if(_halfOrderByRadius != NULL)
+	{
+		free(_halfOrderByRadius);
+		_halfOrderByRadius = NULL;
+	}
+	if(_smoothness != NULL)
+	{
+		delete _smoothness;
+		_smoothness = NULL;
+	}
+	_useMap = false;
+	_tolerance = 0.0;
+}
+/*
+	map - "radius:halfOrder,radius:halfOrder,...", radius in ascending order.
+	each half order is applied from its radius to _maxR; a later item overrides the radiuses from its own radius
+*/
+int EstimationOrderMap::parseMap(const char *map)
+{
+	const char *s = map;
+	char *e;
+	long radius, h;
+	long lastRadius = -1;
+	ret = ERR_OK;
+	while(*s != 0)
+	{
+		radius = strtol(s, &e, 10);
+		if(e == s)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s = e;
+		while(*s == ' ') s++;
+		if(*s != ':')
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s++;
+		h = strtol(s, &e, 10);
+		if(e == s)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s = e;
+		while(*s == ' ') s++;
+		if(radius <= lastRadius || h < 1 || h > _maxHalfOrder)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		for(long i=radius;i<=_maxR;i++)
+		{
+			_capByRadius[i] = (int)h;
+		}
+		lastRadius = radius;
+		if(*s == ',')
+		{
+			s++;
+		}
+		else if(*s != 0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+	}
+	return ret;
+}
+/*
+	the lowest half order M for which share*q^M, the estimated error of half order M, is below the tolerance.
+	q - (second difference)/(field) at a radius
+	share - (field at the radius)/(largest field)
+*/
+int EstimationOrderMap::orderByRatio(double q, double share)
+{
+	int h;
+	if(q <= 0.0 || share <= _tolerance)
+	{
+		return 1;
+	}
+	if(q >= 1.0)
+	{
+		return _maxHalfOrder;
+	}
+	h = (int)ceil(log(_tolerance / share) / log(q));
+	if(h < 1) h = 1;
+	if(h > _maxHalfOrder) h = _maxHalfOrder;
+	return h;
+}
+int EstimationOrderMap::initialize(DerivativeEstimatorAsymmetric *maxOrderEstimator, int maxHalfOrder, int maxR, RadiusIndexToSeriesIndex *indexCache, TaskFile *taskParameters)
+{
+	char *map;
+	int h;
+	cleanup();
+	_maxHalfOrder = maxHalfOrder;
+	_maxR = maxR;
+	map = taskParameters->getString(TP_HALF_ORDER_SPACE_MAP, true);
+	_tolerance = taskParameters->getDouble(TP_HALF_ORDER_SPACE_TOL, true);
+	_interval = taskParameters->getUInt(TP_HALF_ORDER_SPACE_INTERVAL, true);
+	ret = taskParameters->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		if(_interval == 0)
+		{
+			_interval = DEF_ORDER_SELECT_INTERVAL;
+		}
+		if(_tolerance < 0.0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			taskParameters->setNameOfInvalidValue(TP_HALF_ORDER_SPACE_TOL);
+		}
+		else if(map != NULL && strlen(map) > 0)
+		{
+			_useMap = true;
+		}
+	}
+	if(ret == ERR_OK && IsUsed())
+	{
+		_capByRadius = (int *)malloc((_maxR + 1) * sizeof(int));
+		_selectedByRadius = (int *)malloc((_maxR + 1) * sizeof(int));
+		_halfOrderByRadius = (int *)malloc((_maxR + 1) * sizeof(int));
+		_derivativeByOrder = new DerivativeEstimatorAsymmetric*[_maxHalfOrder + 1];
+		if(_capByRadius == NULL || _selectedByRadius == NULL || _halfOrderByRadius == NULL || _derivativeByOrder == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			for(int i=0;i<=_maxR;i++)
+			{
+				_capByRadius[i] = _maxHalfOrder;
+			}
+			for(h=0;h<=_maxHalfOrder;h++)
+			{
+				_derivativeByOrder[h] = NULL;
+			}
+			if(_useMap)
+			{
+				ret = parseMap(map);
+				if(ret != ERR_OK)
+				{
+					taskParameters->setNameOfInvalidValue(TP_HALF_ORDER_SPACE_MAP);
+				}
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			for(int i=0;i<=_maxR;i++)
+			{
+				_halfOrderByRadius[i] = _capByRadius[i];
+			}
+			_derivativeByOrder[_maxHalfOrder] = maxOrderEstimator;
+			for(h=1;h<_maxHalfOrder;h++)
+			{
+				_derivativeByOrder[h] = new DerivativeEstimatorAsymmetric(h, maxR, indexCache);
+				_derivativeByOrder[h]->prepareCoefficeints();
+				ret = _derivativeByOrder[h]->GetLastHandlerError();
+				if(ret != ERR_OK)
+				{
+					break;
+				}
+			}
+		}
+		if(ret == ERR_OK && _tolerance > 0.0)
+		{
+			_smoothness = new SmoothnessByRadius();
+			_smoothness->setIndexCache(indexCache);
+			ret = _smoothness->AllocateList(_maxR);
+			_stepsToSelect = 0;
+		}
+	}
+	return ret;
+}
+/*
+	select orders by smoothness once every _interval time steps
+*/
+int EstimationOrderMap::update(FieldPoint3D *fields)
+{
+	int r, i, h, r0, r1;
+	double largest;
+	ret = ERR_OK;
+	if(_smoothness != NULL)
+	{
+		if(_stepsToSelect == 0)
+		{
+			_stepsToSelect = _interval;
+			_smoothness->SetFields(fields);
+			ret = _smoothness->gothroughSphere(_maxR);
+			if(ret == ERR_OK)
+			{
+				largest = 0.0;
+				for(r=0;r<=_maxR;r++)
+				{
+					if(_smoothness->FieldAt(r) > largest) largest = _smoothness->FieldAt(r);
+				}
+				for(r=0;r<=_maxR;r++)
+				{
+					if(largest > 0.0)
+						_selectedByRadius[r] = orderByRatio(_smoothness->Ratio(r), _smoothness->FieldAt(r) / largest);
+					else
+						_selectedByRadius[r] = 1;
+				}
+				//fields may reach radiuses within _interval before next selection
+				for(r=0;r<=_maxR;r++)
+				{
+					r0 = r - (int)_interval;
+					r1 = r + (int)_interval;
+					if(r0 < 0) r0 = 0;
+					if(r1 > _maxR) r1 = _maxR;
+					h = 1;
+					for(i=r0;i<=r1;i++)
+					{
+						if(_selectedByRadius[i] > h) h = _selectedByRadius[i];
+					}
+					if(h > _capByRadius[r]) h = _capByRadius[r];
+					_halfOrderByRadius[r] = h;
+				}
+			}
+		}
+		_stepsToSelect--;
+	}
+	return ret;
+}
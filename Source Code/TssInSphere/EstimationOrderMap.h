@@ -0,0 +1,91 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\FileUtil\taskFile.h"
+#include "DerivativeEstimator.h"
+
+//default time steps between two automatic selections of estimation orders
+#define DEF_ORDER_SELECT_INTERVAL 10
+
+/*
+	measure smoothness of fields at each radius.
+	for each radius it records the largest field component and the largest second difference along the 3 axes.
+	for a wave of wave number k, (second difference)/(field) is about (k*ds)^2, and an estimation of half order M
+	has an error about (field)*(k*ds)^(2M), so the ratio and the field tell how many estimation orders are needed at the radius
+*/
+class SmoothnessByRadius: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	FieldPoint3D *_fields;
+	double *_maxField;      //[maxRadius+1], largest field component at each radius
+	double *_maxDifference; //[maxRadius+1], largest second difference at each radius
+protected:
+	virtual RadiusHandleType setRadius(int radius);
+	virtual void handleData(int m, int n, int p);
+public:
+	SmoothnessByRadius(void);
+	~SmoothnessByRadius(void);
+	int AllocateList(int maxR);
+	void SetFields(FieldPoint3D *fields);
+	//(second difference)/(field) at a radius; 0 if the fields are 0 at the radius
+	double Ratio(int radius);
+	//largest field component at a radius
+	double FieldAt(int radius){return _maxField[radius];}
+	void cleanup();
+};
+
+/*
+	estimation order of space derivatives at each radius.
+	a high order is needed where fields change fast; far from sources the fields are smooth and
+	a low order is as accurate. one derivative estimator is prepared for each half order 1, 2, ..., maxHalfOrder,
+	and a curl estimator picks the estimator of a radius when it starts the radius.
+
+	task parameters:
+	FDTD.HALF_ORDER_SPACE_MAP - optional, "radius:halfOrder,radius:halfOrder,...", radius in ascending order;
+		a half order is used from its radius up to the next radius in the map; below the first radius FDTD.HALF_ORDER_SPACE is used.
+		when automatic selection is also used, the map gives the highest half order allowed at each radius
+	FDTD.HALF_ORDER_SPACE_TOL - optional, a positive value enables automatic selection by field smoothness;
+		at each radius the lowest half order with an estimated error, relative to the largest field, below the tolerance is used
+	FDTD.HALF_ORDER_SPACE_INTERVAL - optional, time steps between two automatic selections, default to DEF_ORDER_SELECT_INTERVAL.
+		fields move less than one space step in a time step, so a selected order is extended to radiuses within the interval
+*/
+class EstimationOrderMap
+{
+private:
+	int ret;
+	int _maxHalfOrder;
+	int _maxR;
+	DerivativeEstimatorAsymmetric **_derivativeByOrder; //[_maxHalfOrder+1], item 0 is not used; item _maxHalfOrder is not owned by this object
+	int *_capByRadius;       //[_maxR+1], highest half order allowed at each radius
+	int *_selectedByRadius;  //[_maxR+1], work array for automatic selection
+	int *_halfOrderByRadius; //[_maxR+1], half order in use at each radius
+	bool _useMap;            //task parameter map is given
+	double _tolerance;       //>0: select orders automatically
+	unsigned _interval;      //time steps between two automatic selections
+	unsigned _stepsToSelect; //time steps left before next automatic selection
+	SmoothnessByRadius *_smoothness;
+	//
+	int parseMap(const char *map);
+	int orderByRatio(double q, double share);
+public:
+	EstimationOrderMap(void);
+	~EstimationOrderMap(void);
+	void cleanup();
+	/*
+		maxOrderEstimator - an estimator of maxHalfOrder already prepared by the caller, it is used but not deleted by this object
+		return ERR_TASK_INVALID_VALUE if the map in the task file is not valid
+	*/
+	int initialize(DerivativeEstimatorAsymmetric *maxOrderEstimator, int maxHalfOrder, int maxR, RadiusIndexToSeriesIndex *indexCache, TaskFile *taskParameters);
+	//false if neither a map nor automatic selection is specified; then the maximum order is used everywhere
+	bool IsUsed(){return _useMap || _tolerance > 0.0;}
+	//select orders by smoothness of the fields when it is time to do it; call it once in each time step
+	int update(FieldPoint3D *fields);
+	int HalfOrderAt(int radius){return _halfOrderByRadius[radius];}
+	DerivativeEstimatorAsymmetric *EstimatorAt(int radius){return _derivativeByOrder[_halfOrderByRadius[radius]];}
+};
@@ -24,7 +24,11 @@ FieldAnalysor::FieldAnalysor(RadiusIndexToSeriesIndex* indexCache)
 	_fields = NULL;
 	_divergenceEstimator = NULL;
 	_derivativeAsymmetric = NULL;
+	ds = 0.0;
+	_halfOrder = 0;
 	index = 0;
+	_isBox = false;
+	maxRadiusX = maxRadiusY = maxRadiusZ = 0;
 }
 FieldAnalysor::~FieldAnalysor(void)
 {
@@ -44,37 +48,74 @@ void FieldAnalysor::cleanup()
 	}
 	_fields = NULL;
 }
+/*
+	the estimators are kept for following calls using the same estimation order and space step.
+	stencils are taken by the radius of each call, so the estimators do not depend on maxR
+*/
 int FieldAnalysor::setFields(FieldPoint3D *fields, int maxR, double spaceStep, int halfOrder)
 {
-	cleanup();
+	ret = ERR_OK;
+	if(_derivativeAsymmetric == NULL || _divergenceEstimator == NULL || halfOrder != _halfOrder || spaceStep != ds)
+	{
+		cleanup();
+		_halfOrder = halfOrder;
+		ds = spaceStep;
+		_derivativeAsymmetric = new DerivativeEstimatorAsymmetric(_halfOrder, maxR, seriesIndex);
+		_divergenceEstimator = new FieldStatisticsByDivergenceAsymmetric(_derivativeAsymmetric, fields, ds);
+		_derivativeAsymmetric->prepareCoefficeints();
+		ret = _derivativeAsymmetric->GetLastHandlerError();
+	}
 	_fields = fields;
 	maxRadius = maxR;
-	ds = spaceStep;
-	_halfOrder = halfOrder;
-	_derivativeAsymmetric = new DerivativeEstimatorAsymmetric(_halfOrder, maxRadius, seriesIndex);
-	_divergenceEstimator = new FieldStatisticsByDivergenceAsymmetric(_derivativeAsymmetric, _fields, ds);
-	_derivativeAsymmetric->prepareCoefficeints();
-	ret = _derivativeAsymmetric->GetLastHandlerError();
+	maxRadiusX = maxRadiusY = maxRadiusZ = maxR;
+	_isBox = false;
 	if(ret == ERR_OK)
 	{
 		ret = _divergenceEstimator->AllocateList(maxRadius);
 	}
 	return ret;
 }
+int FieldAnalysor::setFields(FieldPoint3D *fields, int maxRx, int maxRy, int maxRz, double spaceStep, int halfOrder)
+{
+	int maxR = maxRx;
+	if(maxRy > maxR) maxR = maxRy;
+	if(maxRz > maxR) maxR = maxRz;
+	//statistics by radius is allocated for the largest axis
+	ret = setFields(fields, maxR, spaceStep, halfOrder);
+	maxRadiusX = maxRx;
+	maxRadiusY = maxRy;
+	maxRadiusZ = maxRz;
+	_isBox = true;
+	return ret;
+}
 int FieldAnalysor::execute()
 {
 	ret = RADIUSINDEXMAPEXIST;
 	if(ret == ERR_OK)
 	{
 		_divergenceEstimator->SetField(_fields);
-		ret =_divergenceEstimator->gothroughSphere(maxRadius);
+		if(_isBox)
+		{
+			ret =_divergenceEstimator->gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+		}
+		else
+		{
+			ret =_divergenceEstimator->gothroughSphere(maxRadius);
+		}
 		if(ret == ERR_OK)
 		{
 			dataByRadius = _divergenceEstimator->GetList();
 			if(dataByRadius != NULL)
 			{
 				index = 0;
-				ret = this->gothroughSphere(maxRadius, ds);
+				if(_isBox)
+				{
+					ret = this->gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ, ds);
+				}
+				else
+				{
+					ret = this->gothroughSphere(maxRadius, ds);
+				}
 			}
 		}
 	}
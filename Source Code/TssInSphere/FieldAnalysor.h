@@ -19,6 +19,8 @@ class FieldAnalysor:public virtual GoThroughSphereBySpaces, public virtual Radiu
 private:
 	FieldPoint3D *_fields;
 	int maxRadius;
+	int maxRadiusX, maxRadiusY, maxRadiusZ; //for a rectangular box
+	bool _isBox;
 	double ds;
 	int _halfOrder;
 	//
@@ -37,6 +39,10 @@ public:
 	~FieldAnalysor(void);
 	void cleanup();
 	int setFields(FieldPoint3D *fields, int maxR, double spaceStep, int halfOrder);
+	/*
+		do statistics on the whole rectangular box. fields are in row-major order
+	*/
+	int setFields(FieldPoint3D *fields, int maxRx, int maxRy, int maxRz, double spaceStep, int halfOrder);
 	int execute();
 	int WriteDivegenceToFile(int filehandle);
 	void ShowDetails(fnProgressReport reporter);
@@ -37,6 +37,38 @@ void FieldStatistics::Reset()
 	_divergE = _divergH = _divergE = _divergH = 0.0;
 	_rMaxDivE = _rMaxDivH = _rMaxE = _rMaxH = -1;
 	_sumDivgE = _sumDivgH = 0.0;
+	_pointCount = 0;
+}
+/*
+	count a point used in the statistics.
+	a sphere has pointsAt(r) points at radius r; a rectangular box may have less
+*/
+void FieldStatistics::CountPoint(int r)
+{
+	_pointCount++;
+	if(_dvgByRadius != NULL)
+	{
+		_dvgByRadius[r].pointCount++;
+	}
+}
+size_t FieldStatistics::PointsAtRadius(int r)
+{
+	if(_dvgByRadius != NULL)
+	{
+		if(_dvgByRadius[r].pointCount > 0)
+		{
+			return _dvgByRadius[r].pointCount;
+		}
+	}
+	return pointsAt(r);
+}
+size_t FieldStatistics::TotalPoints()
+{
+	if(_pointCount > 0)
+	{
+		return _pointCount;
+	}
+	return totalPointsInSphere(maxRadius);
 }
 int FieldStatistics::AllocateList(int maxR)
 {
@@ -49,12 +81,7 @@ int FieldStatistics::AllocateList(int maxR)
 	_dvgByRadius = (DivergenceByRadius *)malloc((maxR+1) * sizeof(DivergenceByRadius));
 	if(_dvgByRadius != NULL)
 	{
-		for(int i=0;i<=maxR;i++)
-		{
-			_dvgByRadius[i].r = i;
-			_dvgByRadius[i].sumFieldStrengthE = _dvgByRadius[i].sumFieldStrengthH = _dvgByRadius[i].maxDivergenceE = _dvgByRadius[i].maxDivergenceH = _dvgByRadius[i].sumDivergenceE = _dvgByRadius[i].sumDivergenceH = 0;
-			_dvgByRadius[i].sumEnergyCircular = _dvgByRadius[i].sumEnergyInwards = _dvgByRadius[i].sumEnergyOutwards = _dvgByRadius[i].sumEnergy = 0.0;
-		}
+		ResetList();
 		return ERR_OK;
 	}
 	else
@@ -62,6 +89,19 @@ int FieldStatistics::AllocateList(int maxR)
 		return ERR_OUTOFMEMORY;
 	}
 }
+void FieldStatistics::ResetList()
+{
+	if(_dvgByRadius != NULL)
+	{
+		for(int i=0;i<=maxRadius;i++)
+		{
+			_dvgByRadius[i].r = i;
+			_dvgByRadius[i].sumFieldStrengthE = _dvgByRadius[i].sumFieldStrengthH = _dvgByRadius[i].maxDivergenceE = _dvgByRadius[i].maxDivergenceH = _dvgByRadius[i].sumDivergenceE = _dvgByRadius[i].sumDivergenceH = 0;
+			_dvgByRadius[i].sumEnergyCircular = _dvgByRadius[i].sumEnergyInwards = _dvgByRadius[i].sumEnergyOutwards = _dvgByRadius[i].sumEnergy = 0.0;
+			_dvgByRadius[i].pointCount = 0;
+		}
+	}
+}
 DivergenceByRadius *FieldStatistics::GetList()
 {
 	return _dvgByRadius;
@@ -73,7 +113,7 @@ int FieldStatistics::WriteDivegenceToFile(int filehandle)
 	double se, sh, s;
 	for(int i=0;i<=maxRadius;i++)
 	{
-		num = pointsAt(i);
+		num = PointsAtRadius(i);
 		se = _dvgByRadius[i].sumDivergenceE/(double)num;
 		sh = _dvgByRadius[i].sumDivergenceH/(double)num;
 		s = sqrt(se * se + sh*sh);
@@ -87,7 +127,7 @@ int FieldStatistics::WriteDivegenceToFile(int filehandle)
 }
 void FieldStatistics::ShowReport(fnProgressReport reporter)
 {
-	size_t num = totalPointsInSphere(maxRadius);
+	size_t num = TotalPoints();
 	reportProcess(reporter, false, "Average divergence (E, H): %g, %g", _sumDivgE / (double)num, _sumDivgH / (double)num);
 	reportProcess(reporter, false, " Field(Max,r): E(%g,%d)  H(%g,%d) Dvg(Max,r): E(%g,%d)  H(%g,%d)",
 		_maxFieldE, _rMaxE, 
@@ -101,7 +141,7 @@ void FieldStatistics::ShowReport(fnProgressReport reporter)
 		reportProcess(reporter,false,"r\tEnergy\tRate\tIn\tOut\tCircle\tDiv. E\tDiv. H");
 		for(int i=0;i<=maxRadius;i++)
 		{
-			num = pointsAt(i);
+			num = PointsAtRadius(i);
 			sumRate = _dvgByRadius[i].sumEnergyCircular + _dvgByRadius[i].sumEnergyInwards + _dvgByRadius[i].sumEnergyOutwards;
 			if(sumRate > 0.0)
 			{
@@ -136,7 +176,7 @@ void FieldStatistics::ShowDetails(fnProgressReport reporter)
 		puts("\r\nr  E(sum field, max divg, sum divg, average divg) H(sum field, max divg, sum divg, average divg)\r\n  Outwards,  inwards,  circular\r\n");
 		for(int i=0;i<=maxRadius;i++)
 		{
-			num = pointsAt(i);
+			num = PointsAtRadius(i);
 			reportProcess(reporter, false, " r=%d  E(%g, %g, %g, %g) H(%g, %g, %g, %g)", i, 
 				_dvgByRadius[i].sumFieldStrengthE,_dvgByRadius[i].maxDivergenceE,_dvgByRadius[i].sumDivergenceE, _dvgByRadius[i].sumDivergenceE/(double)num,
 				_dvgByRadius[i].sumFieldStrengthH, _dvgByRadius[i].maxDivergenceH, _dvgByRadius[i].sumDivergenceH, _dvgByRadius[i].sumDivergenceH/(double)num
@@ -152,7 +192,7 @@ void FieldStatistics::ShowSummary(fnProgressReport reporter)
 	if(_dvgByRadius != NULL)
 	{
 		double sumE,sumH,sumDivE,sumDivH;
-		size_t num = totalPointsInSphere(maxRadius);
+		size_t num = TotalPoints();
 		//puts("\r\nr  E(sum field, max divg, sum divg, average divg) H(sum field, max divg, sum divg, average divg)\r\n");
 		sumE = sumH = sumDivE = sumDivH = 0.0;
 		for(int i=0;i<=maxRadius;i++)
@@ -226,12 +266,12 @@ void FieldStatistics::MakeStatistics(FieldPoint3D *_fields, size_t index, int r)
 }
 double FieldStatistics::GetAverageDivergenceE()
 {
-	size_t num = totalPointsInSphere(maxRadius);
+	size_t num = TotalPoints();
 	return _sumDivgE / (double)num;
 }
 double FieldStatistics::GetAverageDivergenceH()
 {
-	size_t num = totalPointsInSphere(maxRadius);
+	size_t num = TotalPoints();
 	return _sumDivgH / (double)num;
 }
 
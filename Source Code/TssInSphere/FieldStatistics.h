@@ -25,6 +25,7 @@ typedef struct DivergenceByRadius
 	double sumEnergyOutwards;
 	double sumEnergyCircular;
 	double sumEnergy;
+	size_t pointCount; //number of points counted at the radius; for a rectangular box a radius is clipped by the box
 }DivergenceByRadius;
 ///////////////////////////////////////////
 /*
@@ -40,9 +41,14 @@ protected:
 	int _rMaxE, _rMaxH;
 	int _rMaxDivE, _rMaxDivH;
 	double _sumDivgE, _sumDivgH;
+	size_t _pointCount;
 	DivergenceByRadius *_dvgByRadius;
 	//
 	void Reset();
+	void CountPoint(int r);
+	size_t PointsAtRadius(int r);
+	size_t TotalPoints();
+	void ResetList(); //zero the values by radius
 public:
 	FieldStatistics(void);
 	~FieldStatistics();
@@ -16,6 +16,7 @@ FieldStatisticsByDivergence::FieldStatisticsByDivergence(FieldPoint3D *fields, d
 	ret = ERR_OK;
 	_fields = fields;
 	ds2 = halfSpaceStep;
+	_mask = NULL;
 	index = 0;
 }
 FieldStatisticsByDivergence::~FieldStatisticsByDivergence()
@@ -49,19 +50,27 @@ void FieldStatisticsByDivergenceAsymmetric::handleData(int m, int n, int p)
 {
 	int h;
 	int k,i;
+	const DerivativeStencil *stencil;
+	if(_mask != NULL && _mask[index] != MASK_ACTIVE)
+	{
+		//fields are held or not advanced at the point
+		index++;
+		return;
+	}
 	_divergE = _divergH = 0.0;
 	//dFx/dx
-	h = _derivative->checkBoundary(m);
+	stencil = _derivative->GetStencil(m, maxRadiusX);
+	h = stencil->h;
 	if(h == 0)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m+k,n,p);
 			idx2 = seriesIndex->Index(m-k,n,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.x - _fields[idx2].E.x);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.x - _fields[idx2].H.x);
 			k++;
 			i++;
 		}
@@ -70,36 +79,37 @@ void FieldStatisticsByDivergenceAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m+k,n,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k++;
 			i++;
 		}
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m+k,n,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.x - _fields[index].E.x);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.x - _fields[index].H.x);
 			k--;
 			i++;
 		}
 	}
 	//dFy/dy
-	h = _derivative->checkBoundary(n);
+	stencil = _derivative->GetStencil(n, maxRadiusY);
+	h = stencil->h;
 	if(h == 0)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m,n+k,p);
 			idx2 = seriesIndex->Index(m,n-k,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.y - _fields[idx2].E.y);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.y - _fields[idx2].H.y);
 			k++;
 			i++;
 		}
@@ -108,36 +118,37 @@ void FieldStatisticsByDivergenceAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m,n+k,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
 			k++;
 			i++;
 		}
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m,n+k,p);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.y - _fields[index].E.y);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.y - _fields[index].H.y);
 			k--;
 			i++;
 		}
 	}
 	//dFz/dz
-	h = _derivative->checkBoundary(p);
+	stencil = _derivative->GetStencil(p, maxRadiusZ);
+	h = stencil->h;
 	if(h == 0)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx  = seriesIndex->Index(m,n,p+k);
 			idx2 = seriesIndex->Index(m,n,p-k);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.z - _fields[idx2].E.z);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.z - _fields[idx2].H.z);
 			k++;
 			i++;
 		}
@@ -146,20 +157,20 @@ void FieldStatisticsByDivergenceAsymmetric::handleData(int m, int n, int p)
 	{
 		i=0;
 		k=1;
-		while(k <= _derivative->_positiveEnd)
+		while(k <= stencil->positiveEnd)
 		{
 			idx = seriesIndex->Index(m,n,p+k);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
 			k++;
 			i++;
 		}
 		k=-1;
-		while(k >= _derivative->_negativeEnd)
+		while(k >= stencil->negativeEnd)
 		{
 			idx = seriesIndex->Index(m,n,p+k);
-			_divergE += _derivative->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
-			_divergH += _derivative->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
+			_divergE += stencil->coefficients[i] * (_fields[idx].E.z - _fields[index].E.z);
+			_divergH += stencil->coefficients[i] * (_fields[idx].H.z - _fields[index].H.z);
 			k--;
 			i++;
 		}
@@ -171,6 +182,7 @@ void FieldStatisticsByDivergenceAsymmetric::handleData(int m, int n, int p)
 	_sumDivgE += abs(_divergE);
 	_sumDivgH += abs(_divergH);
 	//
+	CountPoint(r);
 	MakeStatistics(_fields, index, r);
 	//
 	index++;
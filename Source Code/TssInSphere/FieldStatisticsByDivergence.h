@@ -8,6 +8,7 @@
 #include "FieldStatistics.h"
 #include "..\EMField\RadiusIndex.h"
 #include "DerivativeEstimator.h"
+#include "..\EMField\MaterialMask.h"
 /*
 	check field validity by divergence=0
 */
@@ -16,10 +17,13 @@ class FieldStatisticsByDivergence: public virtual FieldStatistics, public virtua
 protected:
 	FieldPoint3D *_fields;
 	double ds2;
+	const unsigned char *_mask; //kinds of points of a MaterialMask; NULL if not used
 public:
 	FieldStatisticsByDivergence(FieldPoint3D *fields, double halfSpaceStep);
 	~FieldStatisticsByDivergence();
 	void SetField(FieldPoint3D *fields);
+	//make statistics only at active points of a material mask; NULL for all points
+	void SetMask(const unsigned char *mask){_mask = mask;}
 	
 	virtual void handleData(int m, int n, int p)=0;
 };
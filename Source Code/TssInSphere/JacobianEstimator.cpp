@@ -0,0 +1,151 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "JacobianEstimator.h"
+#include "TssInSphere.h"
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++  
+#include <cmath>  
+
+JacobianEstimatorAsymmetric::JacobianEstimatorAsymmetric(DerivativeEstimatorAsymmetric *derivative, double spaceStep):FieldStatisticsByDivergence(NULL, spaceStep)
+{
+	_derivative = derivative;
+	_derivativeMax = derivative;
+	_orderMap = NULL;
+	_curls = NULL;
+	_jacobians = NULL;
+	_statistics = false;
+	if(_derivative == NULL)
+	{
+		ret = ERR_TSS_DERIVATIVE;
+	}
+	else
+	{
+		_derivative->shareIndexCacheTo(this);
+		ret = ERR_OK;
+	}
+}
+JacobianEstimatorAsymmetric::~JacobianEstimatorAsymmetric()
+{
+}
+void JacobianEstimatorAsymmetric::SetFields(FieldPoint3D *fields, FieldPoint3D *curls, FieldJacobian *jacobians, bool statistics)
+{
+	_fields = fields;
+	_curls = curls;
+	_jacobians = jacobians;
+	_statistics = statistics;
+	index = 0;
+	if(_statistics)
+	{
+		Reset();
+		ResetList();
+	}
+}
+void JacobianEstimatorAsymmetric::SetOrderMap(EstimationOrderMap *orderMap)
+{
+	_orderMap = orderMap;
+	_derivative = _derivativeMax;
+}
+RadiusHandleType JacobianEstimatorAsymmetric::setRadius(int radius)
+{
+	r = radius;
+	if(_orderMap != NULL)
+	{
+		_derivative = _orderMap->EstimatorAt(radius);
+	}
+	return NeedProcess;
+}
+/*
+	one gather of the neighbours along an axis serves all 6 components
+*/
+void JacobianEstimatorAsymmetric::derivative(int m, int n, int p, int dm, int dn, int dp, int j)
+{
+	int k, i;
+	double a;
+	FieldPoint3D *f2;
+	const DerivativeStencil *stencil = _derivative->GetStencil(dm != 0?m:(dn != 0?n:p));
+	i=0;
+	k=1;
+	while(k <= stencil->positiveEnd)
+	{
+		idx = seriesIndex->Index(m+k*dm,n+k*dn,p+k*dp);
+		//central estimation: coefficients of -k are the negatives of the coefficients of k
+		idx2 = (stencil->h == 0)?seriesIndex->Index(m-k*dm,n-k*dn,p-k*dp):index;
+		a = stencil->coefficients[i];
+		f2 = &(_fields[idx2]);
+		_j.E[0][j] += a * (_fields[idx].E.x - f2->E.x);
+		_j.E[1][j] += a * (_fields[idx].E.y - f2->E.y);
+		_j.E[2][j] += a * (_fields[idx].E.z - f2->E.z);
+		_j.H[0][j] += a * (_fields[idx].H.x - f2->H.x);
+		_j.H[1][j] += a * (_fields[idx].H.y - f2->H.y);
+		_j.H[2][j] += a * (_fields[idx].H.z - f2->H.z);
+		k++;
+		i++;
+	}
+	if(stencil->h != 0)
+	{
+		f2 = &(_fields[index]);
+		k=-1;
+		while(k >= stencil->negativeEnd)
+		{
+			idx = seriesIndex->Index(m+k*dm,n+k*dn,p+k*dp);
+			a = stencil->coefficients[i];
+			_j.E[0][j] += a * (_fields[idx].E.x - f2->E.x);
+			_j.E[1][j] += a * (_fields[idx].E.y - f2->E.y);
+			_j.E[2][j] += a * (_fields[idx].E.z - f2->E.z);
+			_j.H[0][j] += a * (_fields[idx].H.x - f2->H.x);
+			_j.H[1][j] += a * (_fields[idx].H.y - f2->H.y);
+			_j.H[2][j] += a * (_fields[idx].H.z - f2->H.z);
+			k--;
+			i++;
+		}
+	}
+}
+void JacobianEstimatorAsymmetric::handleData(int m, int n, int p)
+{
+	if(_mask != NULL && (_mask[index] & MASK_INACTIVE))
+	{
+		index++;
+		return;
+	}
+	for(int i=0;i<3;i++)
+	{
+		for(int j=0;j<3;j++)
+		{
+			_j.E[i][j] = _j.H[i][j] = 0.0;
+		}
+	}
+	//d/dx, d/dy, d/dz
+	derivative(m, n, p, 1, 0, 0, 0);
+	derivative(m, n, p, 0, 1, 0, 1);
+	derivative(m, n, p, 0, 0, 1, 2);
+	if(_curls != NULL)
+	{
+		_curls[index].E.x = _j.E[2][1] - _j.E[1][2];
+		_curls[index].E.y = _j.E[0][2] - _j.E[2][0];
+		_curls[index].E.z = _j.E[1][0] - _j.E[0][1];
+		_curls[index].H.x = _j.H[2][1] - _j.H[1][2];
+		_curls[index].H.y = _j.H[0][2] - _j.H[2][0];
+		_curls[index].H.z = _j.H[1][0] - _j.H[0][1];
+	}
+	if(_jacobians != NULL)
+	{
+		_jacobians[index] = _j;
+	}
+	if(_statistics && (_mask == NULL || _mask[index] == MASK_ACTIVE))
+	{
+		_divergE = (_j.E[0][0] + _j.E[1][1] + _j.E[2][2]) / ds2;
+		_divergH = (_j.H[0][0] + _j.H[1][1] + _j.H[2][2]) / ds2;
+		//
+		_sumDivgE += abs(_divergE);
+		_sumDivgH += abs(_divergH);
+		//
+		CountPoint(r);
+		MakeStatistics(_fields, index, r);
+	}
+	//
+	index++;
+}
@@ -0,0 +1,64 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "DerivativeEstimator.h"
+#include "EstimationOrderMap.h"
+#include "FieldStatisticsByDivergence.h"
+
+/*
+	first partial derivatives of the fields at a space point.
+	E[i][j] is dEi/dxj and H[i][j] is dHi/dxj, i,j = 0,1,2 for x,y,z.
+	like curls, they are not divided by the space step
+*/
+typedef struct FieldJacobian
+{
+	double E[3][3];
+	double H[3][3];
+}FieldJacobian;
+
+/*
+	estimate all 18 first partial derivatives of the fields at each point by one stencil gather per axis,
+	using asymmetric derivative estimations near and at the boundary.
+	curls and divergences are assembled from the derivatives, so one pass gives what CurlEstimatorAsymmetric and
+	FieldStatisticsByDivergenceAsymmetric get by two passes:
+		curls - optional, the same values as CurlEstimatorAsymmetric except for rounding
+		divergence statistics - optional, the same statistics as FieldStatisticsByDivergenceAsymmetric
+		derivatives - optional, for an analysis needing more than curls and divergences
+	if an order map is set then the derivative estimator is switched at the start of each radius.
+	with a material mask, inactive points are skipped and statistics are only made at active points
+*/
+class JacobianEstimatorAsymmetric: public virtual FieldStatisticsByDivergence
+{
+private:
+	DerivativeEstimatorAsymmetric *_derivative;
+	DerivativeEstimatorAsymmetric *_derivativeMax; //estimator of the maximum order, used when there is not an order map
+	EstimationOrderMap *_orderMap;                 //estimation order at each radius
+	FieldPoint3D *_curls;          //curls of _fields; NULL if curls are not needed
+	FieldJacobian *_jacobians;     //derivatives of _fields; NULL if they are not kept
+	bool _statistics;              //do divergence statistics
+	FieldJacobian _j;              //derivatives at the current point
+	size_t idx,idx2;
+	//add the derivatives of all components along axis j, (dm,dn,dp) is the unit step of the axis
+	void derivative(int m, int n, int p, int dm, int dn, int dp, int j);
+protected:
+	virtual RadiusHandleType setRadius(int radius);
+public:
+	JacobianEstimatorAsymmetric(DerivativeEstimatorAsymmetric *derivative, double spaceStep);
+	~JacobianEstimatorAsymmetric();
+	/*
+		fields - fields to be estimated
+		curls - receives curls of fields; NULL if not needed
+		jacobians - receives derivatives of fields; NULL if not needed
+		statistics - true: do divergence statistics; the list by radius must be allocated by AllocateList
+	*/
+	void SetFields(FieldPoint3D *fields, FieldPoint3D *curls, FieldJacobian *jacobians, bool statistics);
+	//use different estimation orders at different radiuses; NULL for using the maximum order everywhere
+	void SetOrderMap(EstimationOrderMap *orderMap);
+	virtual void handleData(int m, int n, int p);
+};
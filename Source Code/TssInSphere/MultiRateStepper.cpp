@@ -0,0 +1,276 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include <math.h>
+#include "MultiRateStepper.h"
+
+//handleData passes
+#define PASS_LIMIT_RATE 0 //limit the rate of a point by the rates of its neighbours
+#define PASS_MARK_LEVEL 1 //mark the curl order needed by neighbours
+
+/*
+	f = a + w * (b - a)
+*/
+static void interpolate(FieldPoint3D *f, FieldPoint3D *a, FieldPoint3D *b, double w)
+{
+	f->E.x = a->E.x + w * (b->E.x - a->E.x);
+	f->E.y = a->E.y + w * (b->E.y - a->E.y);
+	f->E.z = a->E.z + w * (b->E.z - a->E.z);
+	f->H.x = a->H.x + w * (b->H.x - a->H.x);
+	f->H.y = a->H.y + w * (b->H.y - a->H.y);
+	f->H.z = a->H.z + w * (b->H.z - a->H.z);
+}
+
+MultiRateStepper::MultiRateStepper(void)
+{
+	_pass = PASS_LIMIT_RATE;
+	_maxRate = 1;
+	_width = 0;
+	_curlCount = 0;
+	_items = 0;
+	_step = 0;
+	_rate = NULL;
+	_work = NULL;
+	for(int i=0;i<MAX_TIME_RATE;i++)
+	{
+		_levels[i] = NULL;
+	}
+	_marking = NULL;
+	_level = 0;
+	_fieldsFrom = NULL;
+	_fieldsTo = NULL;
+}
+MultiRateStepper::~MultiRateStepper(void)
+{
+	cleanup();
+}
+void MultiRateStepper::cleanup()
+{
+	if(_rate != NULL)
+	{
+		FreeMemory(_rate);
+		_rate = NULL;
+	}
+	if(_work != NULL)
+	{
+		FreeMemory(_work);
+		_work = NULL;
+	}
+	for(int i=0;i<MAX_TIME_RATE;i++)
+	{
+		if(_levels[i] != NULL)
+		{
+			FreeMemory(_levels[i]);
+			_levels[i] = NULL;
+		}
+	}
+	if(_fieldsFrom != NULL)
+	{
+		FreeMemory(_fieldsFrom);
+		_fieldsFrom = NULL;
+	}
+	if(_fieldsTo != NULL)
+	{
+		FreeMemory(_fieldsTo);
+		_fieldsTo = NULL;
+	}
+	_maxRate = 1;
+}
+/*
+	smallest rate of the points used by the curl estimation at (m,n,p)
+*/
+unsigned char MultiRateStepper::neighbourRate(int m, int n, int p)
+{
+	unsigned char rate = _work[index];
+	unsigned char v;
+	for(int k=1;k<=_width;k++)
+	{
+		if(m + k <= maxRadius) { v = _work[SINDEX(m+k,n,p)]; if(v < rate) rate = v; }
+		if(m - k >= -maxRadius){ v = _work[SINDEX(m-k,n,p)]; if(v < rate) rate = v; }
+		if(n + k <= maxRadius) { v = _work[SINDEX(m,n+k,p)]; if(v < rate) rate = v; }
+		if(n - k >= -maxRadius){ v = _work[SINDEX(m,n-k,p)]; if(v < rate) rate = v; }
+		if(p + k <= maxRadius) { v = _work[SINDEX(m,n,p+k)]; if(v < rate) rate = v; }
+		if(p - k >= -maxRadius){ v = _work[SINDEX(m,n,p-k)]; if(v < rate) rate = v; }
+	}
+	return rate;
+}
+/*
+	curl order _level at (m,n,p) uses curl order _level-1 of the points within _width along the 3 axes
+*/
+void MultiRateStepper::markNeighbours(int m, int n, int p)
+{
+	unsigned char lv = _level - 1;
+	size_t i;
+	for(int k=1;k<=_width;k++)
+	{
+		if(m + k <= maxRadius) { i = SINDEX(m+k,n,p); if(_marking[i] < lv) _marking[i] = lv; }
+		if(m - k >= -maxRadius){ i = SINDEX(m-k,n,p); if(_marking[i] < lv) _marking[i] = lv; }
+		if(n + k <= maxRadius) { i = SINDEX(m,n+k,p); if(_marking[i] < lv) _marking[i] = lv; }
+		if(n - k >= -maxRadius){ i = SINDEX(m,n-k,p); if(_marking[i] < lv) _marking[i] = lv; }
+		if(p + k <= maxRadius) { i = SINDEX(m,n,p+k); if(_marking[i] < lv) _marking[i] = lv; }
+		if(p - k >= -maxRadius){ i = SINDEX(m,n,p-k); if(_marking[i] < lv) _marking[i] = lv; }
+	}
+}
+void MultiRateStepper::handleData(int m, int n, int p)
+{
+	if(_pass == PASS_LIMIT_RATE)
+	{
+		_rate[index] = neighbourRate(m, n, p);
+	}
+	else
+	{
+		//a point marked in this pass gets _level-1, so it is not marking others in this pass
+		if(_marking[index] == _level)
+		{
+			markNeighbours(m, n, p);
+		}
+	}
+	index++;
+}
+int MultiRateStepper::initialize(unsigned maxRate, int maxR, double *mu, double *eps, double mu0, double eps0, int halfOrderSpace, int halfOrderTime)
+{
+	int ret = ERR_OK;
+	size_t i;
+	unsigned j, rate;
+	double ratio;
+	cleanup();
+	_items = totalPointsInSphere(maxR);
+	_width = 2 * halfOrderSpace; //asymmetric estimations near the boundary reach 2M points at one side
+	_curlCount = 2 * halfOrderTime - 1;
+	_step = 0;
+	if(maxRate > MAX_TIME_RATE)
+	{
+		maxRate = MAX_TIME_RATE;
+	}
+	_rate = (unsigned char *)AllocateTaggedMemory(_items, MEM_TAG_CURLS);
+	_work = (unsigned char *)AllocateTaggedMemory(_items, MEM_TAG_CURLS);
+	if(_rate == NULL || _work == NULL)
+	{
+		ret = ERR_OUTOFMEMORY;
+	}
+	if(ret == ERR_OK)
+	{
+		//rate allowed by the local wave speed
+		for(i=0;i<_items;i++)
+		{
+			ratio = sqrt((mu[i] * eps[i]) / (mu0 * eps0)); //vacuum light speed / local wave speed
+			rate = 1;
+			while(2 * rate <= maxRate && (double)(2 * rate) <= ratio)
+			{
+				rate *= 2;
+			}
+			_work[i] = (unsigned char)rate;
+		}
+		//rate allowed by the neighbours
+		_pass = PASS_LIMIT_RATE;
+		ret = gothroughSphere(maxR);
+	}
+	if(ret == ERR_OK)
+	{
+		FreeMemory(_work);
+		_work = NULL;
+		_maxRate = 1;
+		for(i=0;i<_items;i++)
+		{
+			if(_rate[i] > _maxRate) _maxRate = _rate[i];
+		}
+		if(_maxRate > 1)
+		{
+			_fieldsFrom = (FieldPoint3D *)AllocateTaggedMemory(_items * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+			_fieldsTo = (FieldPoint3D *)AllocateTaggedMemory(_items * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+			if(_fieldsFrom == NULL || _fieldsTo == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+			//curl orders needed for each time step of a cycle
+			for(j=0;j<_maxRate && ret == ERR_OK;j++)
+			{
+				_levels[j] = (unsigned char *)AllocateTaggedMemory(_items, MEM_TAG_CURLS);
+				if(_levels[j] == NULL)
+				{
+					ret = ERR_OUTOFMEMORY;
+					break;
+				}
+				for(i=0;i<_items;i++)
+				{
+					_levels[j][i] = (j % _rate[i] == 0)?(unsigned char)_curlCount:0;
+				}
+				_marking = _levels[j];
+				_pass = PASS_MARK_LEVEL;
+				for(_level=(unsigned char)_curlCount;_level>1;_level--)
+				{
+					ret = gothroughSphere(maxR);
+					if(ret != ERR_OK)
+					{
+						break;
+					}
+				}
+			}
+		}
+	}
+	return ret;
+}
+void MultiRateStepper::beforeAdvance(FieldPoint3D *fields)
+{
+	size_t i;
+	unsigned s;
+	double w;
+	FieldPoint3D f;
+	for(i=0;i<_items;i++)
+	{
+		if(_rate[i] > 1)
+		{
+			s = (unsigned)(_step % _rate[i]);
+			if(s == 0)
+			{
+				//the point is advanced in this time step, from its fields at the end of the previous time step
+				_fieldsFrom[i] = fields[i];
+				_fieldsTo[i] = fields[i];
+			}
+			else
+			{
+				//afterAdvance gave the point the fields at w; the difference is made by a field source,
+				//a boundary condition or a TF/SF boundary, and is moved to both ends of the interpolation
+				w = (double)s / (double)_rate[i];
+				interpolate(&f, &(_fieldsFrom[i]), &(_fieldsTo[i]), w);
+				f.E.x = fields[i].E.x - f.E.x;
+				f.E.y = fields[i].E.y - f.E.y;
+				f.E.z = fields[i].E.z - f.E.z;
+				f.H.x = fields[i].H.x - f.H.x;
+				f.H.y = fields[i].H.y - f.H.y;
+				f.H.z = fields[i].H.z - f.H.z;
+				_fieldsFrom[i].E.x += f.E.x; _fieldsTo[i].E.x += f.E.x;
+				_fieldsFrom[i].E.y += f.E.y; _fieldsTo[i].E.y += f.E.y;
+				_fieldsFrom[i].E.z += f.E.z; _fieldsTo[i].E.z += f.E.z;
+				_fieldsFrom[i].H.x += f.H.x; _fieldsTo[i].H.x += f.H.x;
+				_fieldsFrom[i].H.y += f.H.y; _fieldsTo[i].H.y += f.H.y;
+				_fieldsFrom[i].H.z += f.H.z; _fieldsTo[i].H.z += f.H.z;
+			}
+		}
+	}
+}
+void MultiRateStepper::afterAdvance(FieldPoint3D *fields)
+{
+	size_t i;
+	unsigned s;
+	double w;
+	for(i=0;i<_items;i++)
+	{
+		if(_rate[i] > 1)
+		{
+			s = (unsigned)(_step % _rate[i]);
+			if(s == 0)
+			{
+				//fields at the end of the rate*dt step
+				_fieldsTo[i] = fields[i];
+			}
+			//fields at the end of this time step
+			w = (double)(s + 1) / (double)_rate[i];
+			interpolate(&(fields[i]), &(_fieldsFrom[i]), &(_fieldsTo[i]), w);
+		}
+	}
+	_step++;
+}
@@ -0,0 +1,88 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\MemoryManager.h"
+
+//largest rate allowed; a rate is a power of 2
+#define MAX_TIME_RATE 8
+
+/*
+	multi-rate time stepping for inhomogeneous environments.
+
+	time step dt is decided by the light speed in vacuum. where the wave speed is lower a larger time step
+	is stable. each space point is given a rate, 1, 2, 4, ..., not more than the ratio of the vacuum light speed
+	to the local wave speed and not more than the task parameter FDTD.MAX_RATE. the rate of a point is also limited
+	by the rates of all points its curl estimation uses, so that a slow point next to a fast region moves at the fast rate.
+
+	a point of rate r is advanced once every r time steps, by a time step of r*dt. between two advancements
+	its fields are linearly interpolated from the fields before and after the advancement; that is how
+	the fields of slow points are given to fast points at an interface. fast points are advanced at every
+	time step, so a slow point at an interface uses the fields of fast points at the same time.
+	after every time step a slow point holds its fields interpolated to the end of the step, so data files,
+	field sources, boundary conditions and TF/SF boundaries see all the points at the same time. a change they
+	make to a slow point is added to the fields before and after its advancement, so it is kept.
+
+	in each time step, curls are only estimated at the points advanced and at the points their curl estimations depend on.
+*/
+class MultiRateStepper: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser, public virtual MemoryManUser
+{
+private:
+	int _pass;                 //what handleData does, see MultiRateStepper.cpp
+	unsigned _maxRate;         //largest rate in use
+	int _width;                //space points used by a curl estimation at each side of a point along an axis
+	int _curlCount;            //number of curl estimations in a time step, 2 * FDTD.HALF_ORDER_TIME - 1
+	size_t _items;             //number of space points
+	size_t _step;              //time steps made
+	unsigned char *_rate;      //[_items], rate of each point
+	unsigned char *_work;      //[_items], rate of each point before it is limited by its neighbours
+	unsigned char *_levels[MAX_TIME_RATE]; //[_maxRate][_items], for each time step in a cycle of _maxRate steps, the highest curl order needed at each point
+	unsigned char *_marking;   //one of _levels being marked
+	unsigned char _level;      //curl order being marked
+	FieldPoint3D *_fieldsFrom; //[_items], fields of a slow point before its last advancement
+	FieldPoint3D *_fieldsTo;   //[_items], fields of a slow point after its last advancement
+	//
+	unsigned char neighbourRate(int m, int n, int p);
+	void markNeighbours(int m, int n, int p);
+protected:
+	virtual void handleData(int m, int n, int p);
+public:
+	MultiRateStepper(void);
+	~MultiRateStepper(void);
+	void cleanup();
+	/*
+		maxRate - FDTD.MAX_RATE
+		maxR - radius of the sphere
+		mu, eps - Permeability and Permittivity at each space point
+		mu0, eps0 - Permeability and Permittivity of vacuum
+		halfOrderSpace - half order of space derivative estimation
+		halfOrderTime - half order of time advancement
+	*/
+	int initialize(unsigned maxRate, int maxR, double *mu, double *eps, double mu0, double eps0, int halfOrderSpace, int halfOrderTime);
+	//false if every point has rate 1
+	bool IsUsed(){return _maxRate > 1;}
+	unsigned RateAt(size_t i){return _rate[i];}
+	unsigned char *Rates(){return _rate;}
+	size_t Step(){return _step;}
+	//curl orders needed at each point in the current time step; curl order k is estimated where the value >= k
+	unsigned char *CurlLevels(){return _levels[_step % _maxRate];}
+	/*
+		call it before advancing fields: a slow point advanced in this time step starts from its current fields.
+		for other slow points, changes made to the fields since afterAdvance are added to the interpolation ends
+	*/
+	void beforeAdvance(FieldPoint3D *fields);
+	/*
+		call it after advancing fields: the fields of a slow point advanced in this time step are saved,
+		and every slow point gets the fields interpolated to the end of this time step
+	*/
+	void afterAdvance(FieldPoint3D *fields);
+	/*
+		start a new cycle at the next time step, for example after the fields are replaced
+	*/
+	void restart(){_step = 0;}
+};
@@ -0,0 +1,417 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "TfsfCurlCorrection.h"
+#include "TssInSphere.h"
+
+//handleData passes
+#define PASS_BOUNDARY 0 //find out points whose curl estimation crosses the TF/SF boundary
+#define PASS_REACH    1 //mark points the incident curls are needed
+#define PASS_BAND     2 //list the marked points
+
+//side for sampling, besides 0 (SF) and 1 (TF)
+#define BOTH_SIDES 2
+
+TfsfCurlCorrection::TfsfCurlCorrection(void)
+{
+	_tfsf = NULL;
+	_derivative = NULL;
+	_orderMap = NULL;
+	_pass = PASS_BOUNDARY;
+	_width = 0;
+	_curlCount = 0;
+	_items = 0;
+	_prepared = false;
+	_reach = NULL;
+	_level = 0;
+	_bandCount = 0;
+	_band = NULL;
+	_samples = NULL;
+	_incident = NULL;
+	_work = NULL;
+	_zero.E.x = _zero.E.y = _zero.E.z = 0.0;
+	_zero.H.x = _zero.H.y = _zero.H.z = 0.0;
+}
+TfsfCurlCorrection::~TfsfCurlCorrection(void)
+{
+	cleanup();
+}
+void TfsfCurlCorrection::cleanup()
+{
+	if(_reach != NULL)
+	{
+		FreeMemory(_reach);
+		_reach = NULL;
+	}
+	if(_band != NULL)
+	{
+		FreeMemory(_band);
+		_band = NULL;
+	}
+	if(_samples != NULL)
+	{
+		FreeMemory(_samples);
+		_samples = NULL;
+	}
+	if(_incident != NULL)
+	{
+		FreeMemory(_incident);
+		_incident = NULL;
+	}
+	if(_work != NULL)
+	{
+		FreeMemory(_work);
+		_work = NULL;
+	}
+	_bandCount = 0;
+	_prepared = false;
+}
+int TfsfCurlCorrection::initialize(TotalFieldScatteredFieldBoundary *tfsf, DerivativeEstimatorAsymmetric *derivative, EstimationOrderMap *orderMap, int maxR, int halfOrderSpace, int halfOrderTime)
+{
+	int ret = ERR_OK;
+	cleanup();
+	_tfsf = tfsf;
+	_derivative = derivative;
+	_orderMap = orderMap;
+	maxRadius = maxR;
+	_items = totalPointsInSphere(maxR);
+	_width = 2 * halfOrderSpace; //asymmetric estimations near the boundary reach 2M points at one side
+	_curlCount = 2 * halfOrderTime - 1;
+	if(_derivative == NULL)
+	{
+		ret = ERR_TSS_DERIVATIVE;
+	}
+	return ret;
+}
+/*
+	whether a point of the other side is within _width along an axis
+*/
+bool TfsfCurlCorrection::crossBoundary(int m, int n, int p)
+{
+	bool s = _tfsf->IsTotalField(m, n, p);
+	for(int k=1;k<=_width;k++)
+	{
+		if(m + k <= maxRadius  && _tfsf->IsTotalField(m+k,n,p) != s) return true;
+		if(m - k >= -maxRadius && _tfsf->IsTotalField(m-k,n,p) != s) return true;
+		if(n + k <= maxRadius  && _tfsf->IsTotalField(m,n+k,p) != s) return true;
+		if(n - k >= -maxRadius && _tfsf->IsTotalField(m,n-k,p) != s) return true;
+		if(p + k <= maxRadius  && _tfsf->IsTotalField(m,n,p+k) != s) return true;
+		if(p - k >= -maxRadius && _tfsf->IsTotalField(m,n,p-k) != s) return true;
+	}
+	return false;
+}
+/*
+	a curl of order _level at (m,n,p) uses curls of order _level-1 of the points within _width along the 3 axes
+*/
+void TfsfCurlCorrection::markNeighbours(int m, int n, int p)
+{
+	unsigned char lv = _level - 1;
+	size_t i;
+	for(int k=1;k<=_width;k++)
+	{
+		if(m + k <= maxRadius) { i = SINDEX(m+k,n,p); if(_reach[i] < lv) _reach[i] = lv; }
+		if(m - k >= -maxRadius){ i = SINDEX(m-k,n,p); if(_reach[i] < lv) _reach[i] = lv; }
+		if(n + k <= maxRadius) { i = SINDEX(m,n+k,p); if(_reach[i] < lv) _reach[i] = lv; }
+		if(n - k >= -maxRadius){ i = SINDEX(m,n-k,p); if(_reach[i] < lv) _reach[i] = lv; }
+		if(p + k <= maxRadius) { i = SINDEX(m,n,p+k); if(_reach[i] < lv) _reach[i] = lv; }
+		if(p - k >= -maxRadius){ i = SINDEX(m,n,p-k); if(_reach[i] < lv) _reach[i] = lv; }
+	}
+}
+void TfsfCurlCorrection::handleData(int m, int n, int p)
+{
+	TfsfBandPoint *b;
+	switch(_pass)
+	{
+	case PASS_BOUNDARY:
+		_reach[index] = crossBoundary(m, n, p)?(unsigned char)(_curlCount + 1):0;
+		break;
+	case PASS_REACH:
+		//a point marked in this pass gets _level-1, so it is not marking others in this pass
+		if(_reach[index] == _level)
+		{
+			markNeighbours(m, n, p);
+		}
+		break;
+	case PASS_BAND:
+		if(_reach[index] > 0)
+		{
+			b = &(_band[_bandCount]);
+			b->index = index;
+			b->m = m; b->n = n; b->p = p;
+			b->radius = r;
+			b->side = _tfsf->IsTotalField(m, n, p)?1:0;
+			b->reach = _reach[index];
+			_bandCount++;
+		}
+		break;
+	}
+	index++;
+}
+/*
+	list the points with _reach > 0 and the band slots of the points within _width of them along the 3 axes.
+	the estimation order of a radius may change between time steps, so the slots do not depend on a stencil.
+	a slot map of all points is only used here
+*/
+int TfsfCurlCorrection::formBand()
+{
+	int ret = ERR_OK;
+	size_t i;
+	int axis, k, s, m, n, p;
+	int *samples;
+	int *slots; //[_items], band slot of every point, -1 for a point not in the band
+	_bandCount = 0;
+	slots = (int *)AllocateTaggedMemory(_items * sizeof(int), MEM_TAG_CURLS);
+	if(slots == NULL)
+	{
+		ret = ERR_OUTOFMEMORY;
+	}
+	if(ret == ERR_OK)
+	{
+		//slots are in the order gothroughSphere visits the points
+		for(i=0;i<_items;i++)
+		{
+			if(_reach[i] > 0)
+			{
+				slots[i] = (int)_bandCount;
+				_bandCount++;
+			}
+			else
+			{
+				slots[i] = -1;
+			}
+		}
+		_band = (TfsfBandPoint *)AllocateTaggedMemory((_bandCount + 1) * sizeof(TfsfBandPoint), MEM_TAG_CURLS);
+		_samples = (int *)AllocateTaggedMemory((_bandCount * 6 * _width + 1) * sizeof(int), MEM_TAG_CURLS);
+		_incident = (FieldPoint3D *)AllocateTaggedMemory((_bandCount + 1) * sizeof(FieldPoint3D), MEM_TAG_CURLS);
+		_work = (FieldPoint3D *)AllocateTaggedMemory((_bandCount + 1) * sizeof(FieldPoint3D), MEM_TAG_CURLS);
+		if(_band == NULL || _samples == NULL || _incident == NULL || _work == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		_bandCount = 0;
+		_pass = PASS_BAND;
+		ret = gothroughSphere(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		for(i=0;i<_bandCount;i++)
+		{
+			for(axis=0;axis<3;axis++)
+			{
+				samples = &(_samples[(i * 3 + axis) * 2 * _width]);
+				for(s=0;s<2*_width;s++)
+				{
+					k = (s < _width)?(s + 1):(_width - s - 1);
+					m = _band[i].m; n = _band[i].n; p = _band[i].p;
+					if(axis == 0) m += k;
+					else if(axis == 1) n += k;
+					else p += k;
+					if(m < -maxRadius || m > maxRadius || n < -maxRadius || n > maxRadius || p < -maxRadius || p > maxRadius)
+						samples[s] = -1;
+					else
+						samples[s] = slots[SINDEX(m, n, p)];
+				}
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		for(i=0;i<_bandCount;i++)
+		{
+			_incident[i] = _zero;
+		}
+	}
+	if(slots != NULL)
+	{
+		FreeMemory(slots);
+	}
+	return ret;
+}
+/*
+	form the band. it is done at the first time step because the TF/SF boundary object is initialized after the FDTD object.
+	incident curl of order k (k=0,1,...,_curlCount-1) is needed at points with _reach > k.
+	_reach is only used here, it is freed when the band is formed
+*/
+int TfsfCurlCorrection::prepare()
+{
+	int ret = ERR_OK;
+	_reach = (unsigned char *)AllocateTaggedMemory(_items, MEM_TAG_CURLS);
+	if(_reach == NULL)
+	{
+		ret = ERR_OUTOFMEMORY;
+	}
+	if(ret == ERR_OK)
+	{
+		_pass = PASS_BOUNDARY;
+		ret = gothroughSphere(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		_pass = PASS_REACH;
+		for(_level=(unsigned char)(_curlCount + 1);_level>1;_level--)
+		{
+			ret = gothroughSphere(maxRadius);
+			if(ret != ERR_OK)
+			{
+				break;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		ret = formBand();
+	}
+	if(_reach != NULL)
+	{
+		FreeMemory(_reach);
+		_reach = NULL;
+	}
+	if(ret == ERR_OK)
+	{
+		_prepared = true;
+	}
+	return ret;
+}
+int TfsfCurlCorrection::begin(double t)
+{
+	int ret = ERR_OK;
+	size_t i;
+	if(!_prepared)
+	{
+		ret = prepare();
+	}
+	for(i=0;i<_bandCount && ret == ERR_OK;i++)
+	{
+		ret = _tfsf->getIncidentField(_band[i].m, _band[i].n, _band[i].p, t, &(_incident[i]));
+	}
+	return ret;
+}
+/*
+	fields of a band slot for a sampling; 0 for a point not in the band or not at the given side
+*/
+const FieldPoint3D *TfsfCurlCorrection::sampling(int slot, const FieldPoint3D *fields, unsigned char side)
+{
+	if(slot < 0)
+		return &_zero;
+	if(side != BOTH_SIDES && _band[slot].side != side)
+		return &_zero;
+	return &(fields[slot]);
+}
+/*
+	add the terms of the derivatives along an axis to a curl, the same way CurlEstimatorAsymmetric does:
+		y: curl.x += d(f.z), curl.z -= d(f.x)
+		z: curl.x -= d(f.y), curl.y += d(f.x)
+		x: curl.y -= d(f.z), curl.z += d(f.y)
+	samplings are at k = 1,...,positiveEnd then k = -1,...,negativeEnd
+*/
+void TfsfCurlCorrection::estimateAxis(size_t slot, int axis, const DerivativeStencil *stencil, const FieldPoint3D *fields, unsigned char side, FieldPoint3D *curl)
+{
+	static double Point3Dstruct::* const components[3] = {&Point3Dstruct::x, &Point3Dstruct::y, &Point3Dstruct::z};
+	static const int terms[3][3] = {{1,2,-1},{0,2,1},{0,1,-1}}; //u, v and sign of each axis
+	double Point3Dstruct::* u = components[terms[axis][0]];
+	double Point3Dstruct::* v = components[terms[axis][1]];
+	double sign = (double)terms[axis][2];
+	const int *samples = &(_samples[(slot * 3 + axis) * 2 * _width]);
+	const FieldPoint3D *f, *f2;
+	double c;
+	int i, k;
+	if(stencil->h == 0)
+	{
+		for(k=1;k<=stencil->positiveEnd;k++)
+		{
+			f  = sampling(samples[k - 1], fields, side);
+			f2 = sampling(samples[_width + k - 1], fields, side);
+			c = sign * stencil->coefficients[k - 1];
+			curl->E.*u += c * (f->E.*v - f2->E.*v);
+			curl->H.*u += c * (f->H.*v - f2->H.*v);
+			curl->E.*v -= c * (f->E.*u - f2->E.*u);
+			curl->H.*v -= c * (f->H.*u - f2->H.*u);
+		}
+	}
+	else
+	{
+		f2 = sampling((int)slot, fields, side);
+		i = 0;
+		for(k=1;k<=stencil->positiveEnd;k++)
+		{
+			f = sampling(samples[k - 1], fields, side);
+			c = sign * stencil->coefficients[i++];
+			curl->E.*u += c * (f->E.*v - f2->E.*v);
+			curl->H.*u += c * (f->H.*v - f2->H.*v);
+			curl->E.*v -= c * (f->E.*u - f2->E.*u);
+			curl->H.*v -= c * (f->H.*u - f2->H.*u);
+		}
+		for(k=-1;k>=stencil->negativeEnd;k--)
+		{
+			f = sampling(samples[_width - k - 1], fields, side);
+			c = sign * stencil->coefficients[i++];
+			curl->E.*u += c * (f->E.*v - f2->E.*v);
+			curl->H.*u += c * (f->H.*v - f2->H.*v);
+			curl->E.*v -= c * (f->E.*u - f2->E.*u);
+			curl->H.*v -= c * (f->H.*u - f2->H.*u);
+		}
+	}
+}
+/*
+	curl estimation at a band slot using fields of the band at one side, or both sides
+*/
+void TfsfCurlCorrection::estimateCurl(size_t slot, const FieldPoint3D *fields, unsigned char side, FieldPoint3D *curl)
+{
+	TfsfBandPoint *b = &(_band[slot]);
+	DerivativeEstimatorAsymmetric *d = (_orderMap != NULL)?_orderMap->EstimatorAt(b->radius):_derivative;
+	*curl = _zero;
+	estimateAxis(slot, 1, d->GetStencil(b->n), fields, side, curl);
+	estimateAxis(slot, 2, d->GetStencil(b->p), fields, side, curl);
+	estimateAxis(slot, 0, d->GetStencil(b->m), fields, side, curl);
+}
+/*
+	_incident holds incident curls of order-1.
+	points in the TF region add curls of incident fields at SF points;
+	points in the SF region subtract curls of incident fields at TF points
+*/
+int TfsfCurlCorrection::correct(int order, FieldPoint3D *curls)
+{
+	size_t i, j;
+	unsigned char boundary = (unsigned char)(_curlCount + 1);
+	FieldPoint3D c;
+	FieldPoint3D *f;
+	for(i=0;i<_bandCount;i++)
+	{
+		if(_band[i].reach == boundary)
+		{
+			estimateCurl(i, _incident, (unsigned char)(1 - _band[i].side), &c);
+			j = _band[i].index;
+			if(_band[i].side == 1)
+			{
+				curls[j].E.x += c.E.x; curls[j].E.y += c.E.y; curls[j].E.z += c.E.z;
+				curls[j].H.x += c.H.x; curls[j].H.y += c.H.y; curls[j].H.z += c.H.z;
+			}
+			else
+			{
+				curls[j].E.x -= c.E.x; curls[j].E.y -= c.E.y; curls[j].E.z -= c.E.z;
+				curls[j].H.x -= c.H.x; curls[j].H.y -= c.H.y; curls[j].H.z -= c.H.z;
+			}
+		}
+	}
+	//incident curls of this order, for correcting curls of next order
+	if(order < _curlCount)
+	{
+		for(i=0;i<_bandCount;i++)
+		{
+			if(_band[i].reach >= order + 1)
+			{
+				estimateCurl(i, _incident, BOTH_SIDES, &(_work[i]));
+			}
+		}
+		f = _incident;
+		_incident = _work;
+		_work = f;
+	}
+	return ERR_OK;
+}
@@ -0,0 +1,88 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\TotalFieldScatteredFieldBoundary.h"
+#include "..\MemoryMan\MemoryManager.h"
+#include "DerivativeEstimator.h"
+#include "EstimationOrderMap.h"
+
+/*
+	total field/scattered field boundary for TSS.
+
+	fields are total fields inside the TF region and scattered fields outside it. a curl estimation at a point
+	uses points within the stencil width along the 3 axes; when some of them are at the other side of the TF/SF boundary
+	the curl is estimated on mixed fields. because curl estimations are linear, the curl is corrected by the curl
+	estimation of the incident fields at the points at the other side:
+		a point in the TF region adds C(incident curl of previous order, at SF points)
+		a point in the SF region subtracts C(incident curl of previous order, at TF points)
+	where C is the same curl estimator used by TSS. TSS applies C repeatedly, so the incident curl of each order
+	is also estimated by C, only at those points within reach of the TF/SF boundary.
+
+	all of it is done on a band of points around the TF/SF boundary, the points within reach of it. the band is
+	listed once, together with the band slots of the points within _width of each band point along the 3 axes;
+	incident fields and curls are only kept for the band, and a sampling outside the band is taken as 0.
+*/
+//a point of the band
+typedef struct TfsfBandPoint
+{
+	size_t index;                        //memory index of the point
+	int m, n, p;
+	int radius;                          //for the estimation order of the point
+	unsigned char side;                  //1: in the TF region; 0: in the SF region
+	unsigned char reach;                 //_curlCount+1 at points next to the boundary, decreasing by 1 every _width points away from the boundary
+}TfsfBandPoint;
+
+class TfsfCurlCorrection: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser, public virtual MemoryManUser
+{
+private:
+	TotalFieldScatteredFieldBoundary *_tfsf;
+	DerivativeEstimatorAsymmetric *_derivative; //the estimator of the maximum order
+	EstimationOrderMap *_orderMap;              //estimation order at each radius, NULL for the maximum order everywhere
+	int _pass;                      //what handleData does, see TfsfCurlCorrection.cpp
+	int _width;                     //space points used by a curl estimation at each side of a point along an axis
+	int _curlCount;                 //number of curl estimations in a time step
+	size_t _items;
+	bool _prepared;                 //the band is formed
+	unsigned char *_reach;          //[_items], reach of every point, only used while forming the band
+	unsigned char _level;           //the value of _reach being marked
+	size_t _bandCount;              //number of points in the band
+	TfsfBandPoint *_band;           //[_bandCount], in the order of memory indexes
+	int *_samples;                  //[_bandCount*3*2*_width], band slots of the points at k=1,...,_width then k=-1,...,-_width along each axis, -1 for a point not in the band
+	FieldPoint3D *_incident;        //[_bandCount], incident curl of the order to be used for correction
+	FieldPoint3D *_work;            //[_bandCount], incident curl of next order
+	FieldPoint3D _zero;
+	//
+	int prepare();
+	int formBand();
+	bool crossBoundary(int m, int n, int p);
+	void markNeighbours(int m, int n, int p);
+	const FieldPoint3D *sampling(int slot, const FieldPoint3D *fields, unsigned char side);
+	void estimateAxis(size_t slot, int axis, const DerivativeStencil *stencil, const FieldPoint3D *fields, unsigned char side, FieldPoint3D *curl);
+	void estimateCurl(size_t slot, const FieldPoint3D *fields, unsigned char side, FieldPoint3D *curl);
+protected:
+	virtual void handleData(int m, int n, int p);
+public:
+	TfsfCurlCorrection(void);
+	~TfsfCurlCorrection(void);
+	void cleanup();
+	/*
+		derivative and orderMap are the ones used by the TSS curl estimator; orderMap can be NULL.
+		tfsf does not need to be initialized yet; the band is formed at the first call of begin
+	*/
+	int initialize(TotalFieldScatteredFieldBoundary *tfsf, DerivativeEstimatorAsymmetric *derivative, EstimationOrderMap *orderMap, int maxR, int halfOrderSpace, int halfOrderTime);
+	/*
+		get incident fields at the start of a time step; t is in time steps
+	*/
+	int begin(double t);
+	/*
+		correct curls of order "order" (1,2,...) just estimated by TSS.
+		call it after each curl estimation, in order, after calling begin
+	*/
+	int correct(int order, FieldPoint3D *curls);
+};
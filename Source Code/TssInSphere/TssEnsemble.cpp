@@ -0,0 +1,328 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "TssEnsemble.h"
+#include <malloc.h>
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+#include "..\MemoryMan\memman.h"
+
+//component offsets in a lane item
+#define LANE_EX 0
+#define LANE_EY 1
+#define LANE_EZ 2
+#define LANE_H  3
+
+/*
+	dest[b] += a * (f1[b] - f2[b]) for all lanes; it is the loop a compiler vectorizes
+*/
+static inline void addDifference(double *dest, const double *f1, const double *f2, double a, unsigned lanes)
+{
+	for(unsigned b=0;b<lanes;b++)
+	{
+		dest[b] += a * (f1[b] - f2[b]);
+	}
+}
+
+CurlEstimatorEnsemble::CurlEstimatorEnsemble(DerivativeEstimatorAsymmetric *derivative)
+{
+	_derivative = derivative;
+	_fields = NULL;
+	_curls = NULL;
+	_lanes = 0;
+	_itemSize = 0;
+	if(_derivative != NULL)
+	{
+		_derivative->shareIndexCacheTo(this);
+		ret = ERR_OK;
+	}
+	else
+	{
+		ret = ERR_TSS_DERIVATIVE;
+	}
+}
+void CurlEstimatorEnsemble::SetFields(double *fields, double *curls, unsigned lanes)
+{
+	_fields = fields;
+	_curls = curls;
+	_lanes = lanes;
+	_itemSize = 6 * (size_t)lanes;
+	index = 0;
+}
+void CurlEstimatorEnsemble::derivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, int plus, int plusSrc, int minus, int minusSrc)
+{
+	double *c = _curls + _itemSize * index;
+	double *f0 = _fields + _itemSize * index;
+	double *f1, *f2;
+	double a;
+	int i = 0, k, eh;
+	if(stencil->h == 0)
+	{
+		//central estimation: coefficients of -k are the negatives of the coefficients of k
+		for(k=1;k<=stencil->positiveEnd;k++,i++)
+		{
+			f1 = _fields + _itemSize * seriesIndex->Index(m+k*dm, n+k*dn, p+k*dp);
+			f2 = _fields + _itemSize * seriesIndex->Index(m-k*dm, n-k*dn, p-k*dp);
+			a = stencil->coefficients[i];
+			for(eh=0;eh<=LANE_H;eh+=LANE_H)
+			{
+				addDifference(c + (plus + eh) * _lanes, f1 + (plusSrc + eh) * _lanes, f2 + (plusSrc + eh) * _lanes, a, _lanes);
+				addDifference(c + (minus + eh) * _lanes, f1 + (minusSrc + eh) * _lanes, f2 + (minusSrc + eh) * _lanes, -a, _lanes);
+			}
+		}
+	}
+	else
+	{
+		for(k=1;k<=stencil->positiveEnd;k++,i++)
+		{
+			f1 = _fields + _itemSize * seriesIndex->Index(m+k*dm, n+k*dn, p+k*dp);
+			a = stencil->coefficients[i];
+			for(eh=0;eh<=LANE_H;eh+=LANE_H)
+			{
+				addDifference(c + (plus + eh) * _lanes, f1 + (plusSrc + eh) * _lanes, f0 + (plusSrc + eh) * _lanes, a, _lanes);
+				addDifference(c + (minus + eh) * _lanes, f1 + (minusSrc + eh) * _lanes, f0 + (minusSrc + eh) * _lanes, -a, _lanes);
+			}
+		}
+		for(k=-1;k>=stencil->negativeEnd;k--,i++)
+		{
+			f1 = _fields + _itemSize * seriesIndex->Index(m+k*dm, n+k*dn, p+k*dp);
+			a = stencil->coefficients[i];
+			for(eh=0;eh<=LANE_H;eh+=LANE_H)
+			{
+				addDifference(c + (plus + eh) * _lanes, f1 + (plusSrc + eh) * _lanes, f0 + (plusSrc + eh) * _lanes, a, _lanes);
+				addDifference(c + (minus + eh) * _lanes, f1 + (minusSrc + eh) * _lanes, f0 + (minusSrc + eh) * _lanes, -a, _lanes);
+			}
+		}
+	}
+}
+void CurlEstimatorEnsemble::handleData(int m, int n, int p)
+{
+	double *c = _curls + _itemSize * index;
+	for(size_t j=0;j<_itemSize;j++)
+	{
+		c[j] = 0.0;
+	}
+	//the same order as CurlEstimatorAsymmetric: dy, dz, dx
+	//curl.x += dz/dy, curl.z -= dx/dy
+	derivative(m, n, p, 0, 1, 0, _derivative->GetStencil(n), LANE_EX, LANE_EZ, LANE_EZ, LANE_EX);
+	//curl.y += dx/dz, curl.x -= dy/dz
+	derivative(m, n, p, 0, 0, 1, _derivative->GetStencil(p), LANE_EY, LANE_EX, LANE_EX, LANE_EY);
+	//curl.z += dy/dx, curl.y -= dz/dx
+	derivative(m, n, p, 1, 0, 0, _derivative->GetStencil(m), LANE_EZ, LANE_EY, LANE_EY, LANE_EZ);
+	index++;
+}
+////////////////////////////////////////////////////////////////////
+TssEnsemble::TssEnsemble(void)
+{
+	mu0 = 4.0 * M_PI * 1.0e-7;
+	eps0 = 1.0 /(mu0 * c0 * c0);
+	_lanes = 1;
+	_laneMemorySize = 0;
+	_laneFields = NULL;
+	_laneCurls[0] = _laneCurls[1] = NULL;
+	_derivative = NULL;
+	_curlEstimate = NULL;
+}
+TssEnsemble::~TssEnsemble(void)
+{
+	cleanup();
+}
+void TssEnsemble::cleanup()
+{
+	if(_curlEstimate != NULL)
+	{
+		delete _curlEstimate;
+		_curlEstimate = NULL;
+	}
+	if(_derivative != NULL)
+	{
+		delete _derivative;
+		_derivative = NULL;
+	}
+	if(_laneFields != NULL)
+	{
+		FreeMemory(_laneFields);
+		_laneFields = NULL;
+	}
+	for(int i=0;i<2;i++)
+	{
+		if(_laneCurls[i] != NULL)
+		{
+			FreeMemory(_laneCurls[i]);
+			_laneCurls[i] = NULL;
+		}
+	}
+}
+void TssEnsemble::OnFinishSimulation()
+{
+	cleanup();
+}
+int TssEnsemble::SetLaneCount(unsigned lanes)
+{
+	if(lanes == 0 || lanes > MAX_ENSEMBLE_LANES)
+	{
+		return ERR_TSS_ENSEMBLE;
+	}
+	_lanes = lanes;
+	return ERR_OK;
+}
+
+int TssEnsemble::onInitialized(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	cleanup();
+	if(_tfsf != NULL)
+	{
+		ret = ERR_TSS_ENSEMBLE;
+	}
+	if(ret == ERR_OK)
+	{
+		_laneMemorySize = fieldItems * 6 * _lanes * sizeof(double);
+		_laneFields = (double *)AllocateTaggedMemory(_laneMemorySize, MEM_TAG_FIELDS);
+		_laneCurls[0] = (double *)AllocateTaggedMemory(_laneMemorySize, MEM_TAG_CURLS);
+		_laneCurls[1] = (double *)AllocateTaggedMemory(_laneMemorySize, MEM_TAG_CURLS);
+		if(_laneFields == NULL || _laneCurls[0] == NULL || _laneCurls[1] == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		_derivative = new DerivativeEstimatorAsymmetric(_maxOrderSpaceDerivative, maxRadius, seriesIndex);
+		ret = _derivative->GetLastHandlerError();
+		if(ret == ERR_OK)
+		{
+			_derivative->prepareCoefficeints();
+			ret = _derivative->GetLastHandlerError();
+		}
+		if(ret == ERR_OK)
+		{
+			_curlEstimate = new CurlEstimatorEnsemble(_derivative);
+			ret = _curlEstimate->GetLastHandlerError();
+		}
+	}
+	return ret;
+}
+
+void TssEnsemble::SetMemberFields(unsigned lane, FieldPoint3D *fields)
+{
+	double *f = _laneFields + lane;
+	for(size_t i=0;i<fieldItems;i++)
+	{
+		f[0]          = fields[i].E.x;
+		f[_lanes]     = fields[i].E.y;
+		f[2 * _lanes] = fields[i].E.z;
+		f[3 * _lanes] = fields[i].H.x;
+		f[4 * _lanes] = fields[i].H.y;
+		f[5 * _lanes] = fields[i].H.z;
+		f += 6 * _lanes;
+	}
+}
+void TssEnsemble::GetMemberFields(unsigned lane, FieldPoint3D *fields)
+{
+	double *f = _laneFields + lane;
+	for(size_t i=0;i<fieldItems;i++)
+	{
+		fields[i].E.x = f[0];
+		fields[i].E.y = f[_lanes];
+		fields[i].E.z = f[2 * _lanes];
+		fields[i].H.x = f[3 * _lanes];
+		fields[i].H.y = f[4 * _lanes];
+		fields[i].H.z = f[5 * _lanes];
+		f += 6 * _lanes;
+	}
+}
+
+void TssEnsemble::applyCurls(double *curls, double factorE, double factorH, bool even)
+{
+	size_t half = 3 * (size_t)_lanes;
+	double *f = _laneFields;
+	double *c = curls;
+	for(size_t i=0;i<fieldItems;i++)
+	{
+		if(even)
+		{
+			for(size_t j=0;j<half;j++)
+			{
+				f[j] += factorE * c[j];
+				f[half + j] += factorH * c[half + j];
+			}
+		}
+		else
+		{
+			for(size_t j=0;j<half;j++)
+			{
+				f[j] += factorH * c[half + j];
+				f[half + j] += factorE * c[j];
+			}
+		}
+		f += 2 * half;
+		c += 2 * half;
+	}
+}
+
+/*
+	advance all the members by one step of dt, the same way TssInSphere does
+*/
+int TssEnsemble::updateFieldsToMoveForward()
+{
+	int ret = ERR_OK;
+	double dtmu  = -(dt/mu0) / ds;
+	double dteps =  (dt/eps0) / ds;
+	double ae = 1.0, ah = 1.0, ae0, ah0, kd;
+	double *curl0 = _laneCurls[0];
+	double *curl1 = _laneFields; //order 0 curl estimation is the field itself
+	//advance time indicators
+	_timeIndex++;
+	_time += dt;
+	if(_recordFDTDStepTimes)
+	{
+		startTime = getTimeCount();
+	}
+	for(int k = 0; k < _maxOrderTimeAdvance && ret == ERR_OK; k++)
+	{
+		kd = 2.0 * (double)k;
+		if(k > 0)
+		{
+			//curl estimation of order 2k
+			ae0 = dtmu * ah / kd;
+			ah0 = dteps * ae / kd;
+			ae = ae0;
+			ah = ah0;
+			curl1 = _laneCurls[1];
+			_curlEstimate->SetFields(curl0, curl1, _lanes);
+			ret = _curlEstimate->gothroughSphere(maxRadius);
+			if(ret == ERR_OK)
+			{
+				applyCurls(curl1, ae, ah, true);
+			}
+		}
+		if(ret == ERR_OK)
+		{
+			//curl estimation of order 2k+1
+			kd += 1.0;
+			ae0 = dtmu * ah / kd;
+			ah0 = dteps * ae / kd;
+			ae = ae0;
+			ah = ah0;
+			curl0 = _laneCurls[0];
+			_curlEstimate->SetFields(curl1, curl0, _lanes);
+			ret = _curlEstimate->gothroughSphere(maxRadius);
+			if(ret == ERR_OK)
+			{
+				applyCurls(curl0, ae, ah, false);
+			}
+		}
+	}
+	if(_recordFDTDStepTimes)
+	{
+		endTime = getTimeCount(); timeUsed = endTime - startTime;
+		_sumtimeused += timeUsed;
+		_timesteps++;
+	}
+	return ret;
+}
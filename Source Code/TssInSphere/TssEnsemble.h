@@ -0,0 +1,90 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\FdtdMemory.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "DerivativeEstimator.h"
+#include "TssInSphere.h"
+
+//maximum number of ensemble members advanced together
+#define MAX_ENSEMBLE_LANES 64
+
+/*
+	fields of an ensemble stored by lanes: each field component of a space point is followed by the same component
+	of the other members. with L lanes, component c (0-5 for Ex,Ey,Ez,Hx,Hy,Hz) of member b at memory index i is
+		f[(6*i + c)*L + b]
+*/
+#define LANEITEM(f, i, c, lanes) ((f) + (6 * (i) + (c)) * (lanes))
+
+/*
+	estimate curls of all the lanes of an ensemble using asymmetric derivative estimations.
+	it does the same calculations as CurlEstimatorAsymmetric in the same order, but each memory index and
+	coefficient it looks up is used for all the lanes by a loop over contiguous memory
+*/
+class CurlEstimatorEnsemble:public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	double *_fields; //lanes for calculating curls of it
+	double *_curls;  //curls of _fields
+	unsigned _lanes;
+	size_t _itemSize; //6*_lanes
+	DerivativeEstimatorAsymmetric *_derivative;
+	/*
+		derivative along (dm,dn,dp):
+		curl[plus] += d(src[plusSrc]), curl[minus] -= d(src[minusSrc]), for E and for H
+	*/
+	void derivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, int plus, int plusSrc, int minus, int minusSrc);
+public:
+	CurlEstimatorEnsemble(DerivativeEstimatorAsymmetric *derivative);
+	void SetFields(double *fields, double *curls, unsigned lanes);
+	virtual void handleData(int m, int n, int p);
+};
+
+/*
+	TSS for an ensemble of simulations differing only in their initial fields, field sources and boundary conditions.
+	all members use the grid, estimation orders and time step of this object.
+
+	the fields of all members are stored by lanes (see LANEITEM) and advanced together; a time step estimates the same
+	curls as TssInSphere, but the index and coefficient lookups of a space point serve all the members. HE holds the
+	fields of one member at a time: PopulateFields(...) fills it, and SetMemberFields/GetMemberFields copy it to and
+	from a lane, so field sources, boundary conditions and data files work on the members one by one.
+	the maximum space estimation order is used everywhere; TF/SF boundaries and rectangular domains are not supported.
+*/
+class TssEnsemble: public virtual FDTD
+{
+private:
+	double mu0;  //Permeability
+	double eps0; //Permittivity
+	//
+	unsigned _lanes;           //number of members
+	size_t _laneMemorySize;    //bytes of all the lanes
+	double *_laneFields;       //fields of all the members
+	double *_laneCurls[2];     //curls of odd and even orders of all the members
+	DerivativeEstimatorAsymmetric *_derivative;
+	CurlEstimatorEnsemble *_curlEstimate;
+	//
+	//fields += factor * curls; even orders apply curls of E to E and curls of H to H, odd orders apply them crosswise
+	void applyCurls(double *curls, double factorE, double factorH, bool even);
+protected:
+	virtual void cleanup();
+	virtual int onInitialized(TaskFile *taskParameters); //called after initialize(...) returns ERR_OK
+public:
+	TssEnsemble(void);
+	virtual ~TssEnsemble(void);
+	//
+	//call it before initialize(...); 1 to MAX_ENSEMBLE_LANES
+	int SetLaneCount(unsigned lanes);
+	unsigned GetLaneCount(){return _lanes;}
+	//copy fields of GetMemoryItemCount() items to and from the lane of a member
+	void SetMemberFields(unsigned lane, FieldPoint3D *fields);
+	void GetMemberFields(unsigned lane, FieldPoint3D *fields);
+	//
+	virtual int updateFieldsToMoveForward();
+	virtual void OnFinishSimulation();
+};
@@ -39,7 +39,11 @@ TssInSphere::TssInSphere(void)
 	//
 	_derivative = NULL;
 	_curlEstimate = NULL;
+	_orderMap = NULL;
+	_tfsfCorrection = NULL;
 	_fieldStatistics = NULL;
+	_jacobian = NULL;
+	_stepStatisticsRadius = -1;
 	//
 }
 
@@ -59,11 +63,26 @@ void TssInSphere::cleanup()
 		delete _curlEstimate;
 		_curlEstimate = NULL;
 	}
+	if(_orderMap != NULL)
+	{
+		delete _orderMap;
+		_orderMap = NULL;
+	}
+	if(_tfsfCorrection != NULL)
+	{
+		delete _tfsfCorrection;
+		_tfsfCorrection = NULL;
+	}
 	if(_fieldStatistics != NULL)
 	{
 		delete _fieldStatistics;
 		_fieldStatistics = NULL;
 	}
+	if(_jacobian != NULL)
+	{
+		delete _jacobian;
+		_jacobian = NULL;
+	}
 	if(HE != NULL)
 	{
 		FreeMemory(HE);
@@ -113,7 +132,7 @@ int TssInSphere::onInitialized(TaskFile *taskParameters)
 		}
 		for(int i=0;i<curlCount;i++)
 		{
-			Curls[i] = (FieldPoint3D *)AllocateMemory(fieldMemorySize);
+			Curls[i] = (FieldPoint3D *)AllocateTaggedMemory(fieldMemorySize, MEM_TAG_CURLS);
 			if(Curls[i] == NULL)
 			{
 				ret = ERR_OUTOFMEMORY;
@@ -123,6 +142,16 @@ int TssInSphere::onInitialized(TaskFile *taskParameters)
 	}
 	if(ret == ERR_OK)
 	{
+		if(_orderMap != NULL)
+		{
+			delete _orderMap;
+			_orderMap = NULL;
+		}
+		if(_tfsfCorrection != NULL)
+		{
+			delete _tfsfCorrection;
+			_tfsfCorrection = NULL;
+		}
 		if(_derivative != NULL)
 		{
 			delete _derivative;
@@ -138,6 +167,12 @@ int TssInSphere::onInitialized(TaskFile *taskParameters)
 			delete _fieldStatistics;
 			_fieldStatistics = NULL;
 		}
+		if(_jacobian != NULL)
+		{
+			delete _jacobian;
+			_jacobian = NULL;
+		}
+		_stepStatisticsRadius = -1;
 		//
 		_derivative = new DerivativeEstimatorAsymmetric(_maxOrderSpaceDerivative, maxRadius, seriesIndex);
 		_fieldStatistics = new FieldStatisticsByDivergenceAsymmetric(_derivative, HE, ds);
@@ -149,6 +184,65 @@ int TssInSphere::onInitialized(TaskFile *taskParameters)
 			{
 				ret = _fieldStatistics->AllocateList(maxRadius);
 				if(ret == ERR_OK)
+				{
+					//optional space estimation orders by radius
+					_orderMap = new EstimationOrderMap();
+					ret = _orderMap->initialize(_derivative, _maxOrderSpaceDerivative, maxRadius, seriesIndex, taskParameters);
+					if(ret == ERR_OK)
+					{
+						if(_orderMap->IsUsed())
+						{
+							_curlEstimate->SetOrderMap(_orderMap);
+						}
+						else
+						{
+							delete _orderMap;
+							_orderMap = NULL;
+						}
+					}
+				}
+				if(ret == ERR_OK)
+				{
+					//optional divergence statistics by the first curl estimation of each time step
+					bool stepStatistics = taskParameters->getBoolean(TP_STEP_STATISTICS, true);
+					ret = taskParameters->getErrorCode();
+					if(ret == ERR_OK && stepStatistics)
+					{
+						_jacobian = new JacobianEstimatorAsymmetric(_derivative, ds);
+						ret = _jacobian->GetLastHandlerError();
+						if(ret == ERR_OK)
+						{
+							ret = _jacobian->AllocateList(maxRadius);
+						}
+						if(ret == ERR_OK && _orderMap != NULL)
+						{
+							_jacobian->SetOrderMap(_orderMap);
+						}
+					}
+				}
+				if(ret == ERR_OK && _mask != NULL)
+				{
+					//curls are not estimated at inactive points, so they stay 0 there
+					for(int i=0;i<curlCount;i++)
+					{
+						_mask->ClearInactive(Curls[i]);
+					}
+					_curlEstimate->SetMask(_mask->Kinds());
+					_fieldStatistics->SetMask(_mask->Kinds());
+					if(_jacobian != NULL)
+					{
+						_jacobian->SetMask(_mask->Kinds());
+					}
+				}
+				if(ret == ERR_OK && _tfsf != NULL)
+				{
+					//TSS does not use applyTFSF; curls estimated across the TF/SF boundary are corrected by incident fields
+					_tfsfCorrection = new TfsfCurlCorrection();
+					_tfsfCorrection->SetMemoryManager(_mem);
+					shareIndexCacheTo(_tfsfCorrection);
+					ret = _tfsfCorrection->initialize(_tfsf, _derivative, _orderMap, maxRadius, _maxOrderSpaceDerivative, _maxOrderTimeAdvance);
+				}
+				if(ret == ERR_OK)
 				{
 					createCurlGenerators();
 				}
@@ -217,6 +311,15 @@ int TssInSphere::verifyCurls()
 	return ret;
 }
 
+int TssInSphere::applyCurlsWithin(ApplyCurls *apply)
+{
+	if(_mask != NULL)
+	{
+		return apply->gothroughRuns(_mask->Runs(), _mask->RunCount(), totalPointsInSphere(advanceRadius()));
+	}
+	return apply->gothroughSphere(advanceRadius());
+}
+
 /*
 	apply curls of orders 2k and 2k+1
 	to time advancement
@@ -242,12 +345,20 @@ int TssInSphere::applyCurls(int k)
 		curl1 = Curls[1]; //Curls[1] holds curls from an even estimation order
 		//from curl0 to get curl1, it is in Curl[1]
 		_curlEstimate->SetFields(curl0, curl1);
-		ret = _curlEstimate->gothroughSphere(maxRadius);
+		ret = _curlEstimate->gothroughSphere(curlRadius(2 * k));
+		if(ret == ERR_OK && _tfsfCorrection != NULL)
+		{
+			ret = _tfsfCorrection->correct(2 * k, curl1);
+		}
+		if(ret == ERR_OK && _mask != NULL)
+		{
+			_mask->ConstrainCurls(curl1, 2 * k);
+		}
 		if(ret == ERR_OK)
 		{
 			//use curl1 to get a time advance estimation
 			_applyCurlsEven->SetFields(HE, curl1, &ae, &ah);
-			ret = _applyCurlsEven->gothroughSphere(maxRadius);
+			ret = applyCurlsWithin(_applyCurlsEven);
 		}
 	}
 	if(ret == ERR_OK)
@@ -259,15 +370,36 @@ int TssInSphere::applyCurls(int k)
 		ae = ae0;
 		ah = ah0;
 		curl0 = Curls[0]; //Curls[0] holds curls from an odd estimation order
-		//from curl1 to get curl0
-		_curlEstimate->SetFields(curl1, curl0);
-		//estimating curl0, it is in Curls[0]
-		ret = _curlEstimate->gothroughSphere(maxRadius);
+		if(k == 0 && _jacobian != NULL)
+		{
+			//curl1 is HE; estimating curl0 and the divergence statistics of HE by one pass
+			_jacobian->SetFields(curl1, curl0, NULL, true);
+			ret = _jacobian->gothroughSphere(curlRadius(1));
+			if(ret == ERR_OK)
+			{
+				_stepStatisticsRadius = curlRadius(1);
+			}
+		}
+		else
+		{
+			//from curl1 to get curl0
+			_curlEstimate->SetFields(curl1, curl0);
+			//estimating curl0, it is in Curls[0]
+			ret = _curlEstimate->gothroughSphere(curlRadius(2 * k + 1));
+		}
+		if(ret == ERR_OK && _tfsfCorrection != NULL)
+		{
+			ret = _tfsfCorrection->correct(2 * k + 1, curl0);
+		}
+		if(ret == ERR_OK && _mask != NULL)
+		{
+			_mask->ConstrainCurls(curl0, 2 * k + 1);
+		}
 		if(ret == ERR_OK)
 		{
 			//use curl0 to make time advance estimation
 			_applyCurlsOdd->SetFields(HE, curl0, &ae, &ah);
-			ret = _applyCurlsOdd->gothroughSphere(maxRadius);
+			ret = applyCurlsWithin(_applyCurlsOdd);
 		}
 	}
 	return ret;
@@ -291,9 +423,25 @@ int TssInSphere::updateFieldsToMoveForward()
 		{
 			startTime = getTimeCount();
 		}
+		//set by applyCurls(0); a derived class estimating curls in its own way does not make statistics
+		_stepStatisticsRadius = -1;
+		//choose space estimation orders for this time step
+		if(_orderMap != NULL)
+		{
+			ret = _orderMap->update(HE);
+		}
+		//incident fields at the start of this time step
+		if(ret == ERR_OK && _tfsfCorrection != NULL)
+		{
+			ret = _tfsfCorrection->begin((double)(_timeIndex - 1));
+		}
+		if(ret == ERR_OK)
+		{
+			ret = onBeforeTimeAdvance();
+		}
 		//bring fields to _time
 		//use each order of space curls to get each order of temporal derivative for advancing fields in time
-		for(int k = 0; k < _maxOrderTimeAdvance; k++)
+		for(int k = 0; k < _maxOrderTimeAdvance && ret == ERR_OK; k++)
 		{
 			//for k=0, one first-order curl estimation is applied, resulting in a second-order time advance estimation
 			//for k>0, one even order curl estimation is applied then one odd order curl estimation is applied, 
@@ -304,6 +452,10 @@ int TssInSphere::updateFieldsToMoveForward()
 				break;
 			}
 		}
+		if(ret == ERR_OK)
+		{
+			ret = onAfterTimeAdvance();
+		}
 		if(_recordFDTDStepTimes)
 		{
 			endTime = getTimeCount(); timeUsed = endTime - startTime;
@@ -313,5 +465,39 @@ int TssInSphere::updateFieldsToMoveForward()
 	}
 	return ret;
 }
-
+/*
+	average absolute divergences made by the latest time step, of the fields at the start of the time step,
+	over the points within radius
+*/
+bool TssInSphere::GetStepDivergence(int radius, double *averageE, double *averageH)
+{
+	double sumE = 0.0, sumH = 0.0;
+	size_t count = 0;
+	DivergenceByRadius *list;
+	if(_jacobian == NULL || _stepStatisticsRadius < 0)
+	{
+		return false;
+	}
+	list = _jacobian->GetList();
+	if(radius > _stepStatisticsRadius)
+	{
+		radius = _stepStatisticsRadius;
+	}
+	for(int i=0;i<=radius;i++)
+	{
+		sumE += list[i].sumDivergenceE;
+		sumH += list[i].sumDivergenceH;
+		count += list[i].pointCount;
+	}
+	if(count > 0)
+	{
+		*averageE = sumE / (double)count;
+		*averageH = sumH / (double)count;
+	}
+	else
+	{
+		*averageE = *averageH = 0.0;
+	}
+	return true;
+}
 
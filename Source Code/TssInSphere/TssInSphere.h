@@ -11,13 +11,29 @@
 #include "DerivativeEstimator.h"
 #include "CurlEstimatorAsymmetric.h"
 #include "FieldStatisticsByDivergence.h"
+#include "JacobianEstimator.h"
 #include "ApplyCurls.h"
+#include "TfsfCurlCorrection.h"
 #include "..\EMField\FDTD.h"
 
 //reporter not set
 #define ERR_TSS_REPORTER   201
 //missing space derivative estimator
 #define ERR_TSS_DERIVATIVE 202
+//a TF/SF boundary is not supported by the hybrid TSS/Yee engine
+#define ERR_TSS_HYBRID_TFSF 203
+//a TF/SF boundary is not supported by the wave equation engine
+#define ERR_TSS_WAVE_TFSF   204
+//the time advance order of the wave equation engine is too low for the space estimation order
+#define ERR_TSS_WAVE_UNSTABLE 205
+//invalid number of ensemble members, or a TF/SF boundary used with the ensemble engine
+#define ERR_TSS_ENSEMBLE      206
+//more than MAX_MATERIALS materials in an inhomogeneous environment
+#define ERR_TSS_MATERIALS     207
+//a voxel model file does not match its header, or VOXEL.DIMS and VOXEL.BYTES
+#define ERR_TSS_VOXEL         208
+//error creating a thread
+#define ERR_TSS_THREAD        209
 
 //initialize maxRadius, maxN and ds
 #define INITGEOMETRY(i_N, i_range) \
@@ -53,14 +69,30 @@ protected:
 	//space derivative/curl estimations
 	DerivativeEstimatorAsymmetric *_derivative;
 	CurlEstimatorAsymmetric *_curlEstimate;
+	EstimationOrderMap *_orderMap; //space estimation order at each radius, NULL if the maximum order is used everywhere
+	TfsfCurlCorrection *_tfsfCorrection; //correcting curls across the TF/SF boundary, NULL if there is not a TF/SF boundary
 	//time advancement estimation
 	ApplyCurlsEven *_applyCurlsEven;
 	ApplyCurlsOdd *_applyCurlsOdd;
 	//field statistics
 	FieldStatisticsByDivergenceAsymmetric *_fieldStatistics;
+	/*
+		used when FDTD.STEP_STATISTICS is true. the first curl estimation of a time step is done by it,
+		which also makes divergence statistics of the fields at the start of the time step
+	*/
+	JacobianEstimatorAsymmetric *_jacobian;
+	int _stepStatisticsRadius; //radius covered by the statistics of the current time step; -1 if there are not statistics
 	//work variables
 	FieldPoint3D *curl0, *curl1;
 	virtual int applyCurls(int k);
+	//apply curls within advanceRadius(); with a material mask only the runs of points to be advanced are visited
+	int applyCurlsWithin(ApplyCurls *apply);
+	//called before and after fields are advanced by one time step; default is doing nothing
+	virtual int onBeforeTimeAdvance(){return ERR_OK;}
+	virtual int onAfterTimeAdvance(){return ERR_OK;}
+	//largest radius where curls of an order (1,2,...) are estimated, and where fields are advanced; default is the whole sphere
+	virtual int curlRadius(int order){return maxRadius;}
+	virtual int advanceRadius(){return maxRadius;}
 	//
 	//simulation data
 	FieldPoint3D **Curls;   //curls; Curls[0] is the curls; Curls[1] is the curls of curls; Curls[0] is the 3rd order curls; Curls[1] is the fourth order curls; and so on
@@ -79,6 +111,9 @@ public:
 	//
 	virtual int updateFieldsToMoveForward();
 	virtual void OnFinishSimulation();
+	virtual bool GetStepDivergence(int radius, double *averageE, double *averageH);
+	//inactive points are skipped by curl, apply and statistics sweeps; held components of curls are set to 0 at PEC/PMC points
+	virtual bool SupportMaterialMask(){return true;}
 
 };
 
@@ -7,9 +7,19 @@
 
 #include "TssInhomogeneous.h"
 #include "ApplyCurlsInhomogeneous.h"
+#include "VoxelMaterials.h"
+#include <malloc.h>
+#include <string.h>
 
 TssInhomogeneous::TssInhomogeneous(void)
 {
+	mu = eps = dtmu = dteps = NULL;
+	ae_a = ah_a = ae0_a = ah0_a = NULL;
+	_materialCount = 0;
+	_materials8 = NULL;
+	_materials16 = NULL;
+	_maxRate = 1;
+	_multiRate = NULL;
 }
 
 TssInhomogeneous::~TssInhomogeneous(void)
@@ -29,51 +39,223 @@ void TssInhomogeneous::cleanup()
 		FreeMemory(eps);
 		eps = NULL;
 	}
+	if(_materials8 != NULL)
+	{
+		FreeMemory(_materials8);
+		_materials8 = NULL;
+	}
+	if(_materials16 != NULL)
+	{
+		FreeMemory(_materials16);
+		_materials16 = NULL;
+	}
+	//coefficients of materials are small arrays
+	if(dtmu != NULL)
+	{
+		free(dtmu);
+		dtmu = NULL;
+	}
+	if(dteps != NULL)
+	{
+		free(dteps);
+		dteps = NULL;
+	}
 	if(ae0_a != NULL)
 	{
-		FreeMemory(ae0_a);
+		free(ae0_a);
+		ae0_a = NULL;
 	}
 	if(ae_a != NULL)
 	{
-		FreeMemory(ae_a);
+		free(ae_a);
+		ae_a = NULL;
 	}
 	if(ah0_a != NULL)
 	{
-		FreeMemory(ah0_a);
+		free(ah0_a);
+		ah0_a = NULL;
 	}
 	if(ah_a != NULL)
 	{
-		FreeMemory(ah_a);
+		free(ah_a);
+		ah_a = NULL;
+	}
+	_materialCount = 0;
+	if(_multiRate != NULL)
+	{
+		delete _multiRate;
+		_multiRate = NULL;
+	}
+}
+
+/*
+	hash of a material for finding it in the hash table
+*/
+static size_t materialHash(double a, double b)
+{
+	unsigned long long x, y;
+	memcpy(&x, &a, sizeof(x));
+	memcpy(&y, &b, sizeof(y));
+	x ^= y * 0x9E3779B97F4A7C15ULL;
+	x ^= x >> 29;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	return (size_t)(x >> 32);
+}
+
+/*
+	a material is a distinct pair of dtmu and dteps; the rate of multi-rate time stepping is included in them.
+	the coefficients are calculated for each point the same way as they were calculated before materials were used,
+	so the results do not change
+*/
+int TssInhomogeneous::formMaterials()
+{
+	int ret = ERR_OK;
+	size_t i, h;
+	double dm, de;
+	int *slots = (int *)malloc(MATERIAL_HASH_SIZE * sizeof(int)); //material index, -1 for an empty slot
+	unsigned short *ids = (unsigned short *)AllocateTaggedMemory(fieldItems * sizeof(unsigned short), MEM_TAG_MATERIALS);
+	dtmu = (double *)malloc(MAX_MATERIALS * sizeof(double));
+	dteps = (double *)malloc(MAX_MATERIALS * sizeof(double));
+	if(slots == NULL || ids == NULL || dtmu == NULL || dteps == NULL)
+	{
+		ret = ERR_OUTOFMEMORY;
+	}
+	else
+	{
+		for(h=0;h<MATERIAL_HASH_SIZE;h++)
+		{
+			slots[h] = -1;
+		}
+		_materialCount = 0;
+		for(i=0;i<fieldItems;i++)
+		{
+			dm = -(dt/mu[i]) / ds;
+			de = (dt/eps[i]) / ds;
+			if(_multiRate != NULL)
+			{
+				//a point of rate r is advanced by r*dt
+				dm *= (double)_multiRate->RateAt(i);
+				de *= (double)_multiRate->RateAt(i);
+			}
+			h = materialHash(dm, de) & (MATERIAL_HASH_SIZE - 1);
+			while(slots[h] >= 0 && !(dtmu[slots[h]] == dm && dteps[slots[h]] == de))
+			{
+				h = (h + 1) & (MATERIAL_HASH_SIZE - 1);
+			}
+			if(slots[h] < 0)
+			{
+				if(_materialCount == MAX_MATERIALS)
+				{
+					ret = ERR_TSS_MATERIALS;
+					break;
+				}
+				slots[h] = (int)_materialCount;
+				dtmu[_materialCount] = dm;
+				dteps[_materialCount] = de;
+				_materialCount++;
+			}
+			ids[i] = (unsigned short)slots[h];
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		if(_materialCount <= 256)
+		{
+			_materials8 = (unsigned char *)AllocateTaggedMemory(fieldItems, MEM_TAG_MATERIALS);
+			if(_materials8 == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+			else
+			{
+				for(i=0;i<fieldItems;i++)
+				{
+					_materials8[i] = (unsigned char)ids[i];
+				}
+			}
+		}
+		else
+		{
+			_materials16 = ids;
+			ids = NULL;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		size_t sz = _materialCount * sizeof(double);
+		ae0_a = (double *)malloc(sz);
+		ae_a = (double *)malloc(sz);
+		ah0_a = (double *)malloc(sz);
+		ah_a = (double *)malloc(sz);
+		if(ae0_a == NULL || ae_a == NULL || ah0_a == NULL || ah_a == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ids != NULL)
+	{
+		FreeMemory(ids);
+	}
+	if(slots != NULL)
+	{
+		free(slots);
 	}
+	return ret;
 }
 
 int TssInhomogeneous::onInitInhomogeneous()
 {
 	int ret = ERR_OK;
-	//non-inhomogeneous:
-	//dtmu  = -(dt/mu0) / ds;
-	//dteps =  (dt/eps0) / ds;
-	//inhomogeneous:
-	for(size_t i = 0;i<fieldItems;i++)
+	//multi-rate: a point of rate r is advanced by r*dt
+	if(_maxRate > 1)
+	{
+		_multiRate = new MultiRateStepper();
+		_multiRate->SetMemoryManager(_mem);
+		shareIndexCacheTo(_multiRate);
+		ret = _multiRate->initialize(_maxRate, maxRadius, mu, eps, mu0, eps0, _maxOrderSpaceDerivative, _maxOrderTimeAdvance);
+		if(ret == ERR_OK)
+		{
+			if(!_multiRate->IsUsed())
+			{
+				delete _multiRate;
+				_multiRate = NULL;
+			}
+		}
+	}
+	if(ret == ERR_OK)
 	{
-		dtmu[i] = -(dt/mu[i]) / ds;
-		dteps[i] = (dt/eps[i]) / ds;
+		//non-inhomogeneous:
+		//dtmu  = -(dt/mu0) / ds;
+		//dteps =  (dt/eps0) / ds;
+		//inhomogeneous: dtmu and dteps of each material
+		ret = formMaterials();
+	}
+	if(ret == ERR_OK)
+	{
+		_applyCurlsEven->SetMaterials(_materials8, _materials16);
+		_applyCurlsOdd->SetMaterials(_materials8, _materials16);
+		ret = onPreparedInhomogeneous();
 	}
-	ret = onPreparedInhomogeneous();
 	return ret;
 }
 
 /*
-	initialize memories for space-location-dependent Permeability, Permittivity, and coefficients
+	initialize memories for space-location-dependent Permeability and Permittivity; coefficients are formed by materials
 */
 int TssInhomogeneous::onInitialized(TaskFile *taskParameters)
 {
 	int ret = TssInSphere::onInitialized(taskParameters);
 	if(ret == ERR_OK)
+	{
+		_maxRate = taskParameters->getUInt(TP_MAX_RATE, true);
+		ret = taskParameters->getErrorCode();
+		if(_maxRate == 0) _maxRate = 1;
+	}
+	if(ret == ERR_OK)
 	{
 		size_t sz = fieldItems * sizeof(double); //memory size for space-location-dependent doubles
 		//space-location-dependent Permeability
-		mu = (double *)AllocateMemory(sz);
+		mu = (double *)AllocateTaggedMemory(sz, MEM_TAG_MATERIALS);
 		if(mu == NULL)
 		{
 			ret = ERR_OUTOFMEMORY;
@@ -81,64 +263,29 @@ int TssInhomogeneous::onInitialized(TaskFile *taskParameters)
 		else
 		{
 			//space-location-dependent Permittivity
-			eps = (double *)AllocateMemory(sz);
+			eps = (double *)AllocateTaggedMemory(sz, MEM_TAG_MATERIALS);
 			if(eps == NULL)
 			{
 				ret = ERR_OUTOFMEMORY;
 			}
-			else
-			{
-				//coefficients computed from Permeability, Permittivity and Courant number
-				dtmu = (double *)AllocateMemory(sz);
-				if(dtmu == NULL)
-				{
-					ret = ERR_OUTOFMEMORY;
-				}
-				else
-				{
-					dteps = (double *)AllocateMemory(sz);
-					if(dteps == NULL)
-					{
-						ret = ERR_OUTOFMEMORY;
-					}
-				}
-			}
 			if(ret == ERR_OK)
 			{
-				//TSS algorithm factors to update fields
-				ae0_a = (double *)AllocateMemory(sz);
-				if(ae0_a == NULL)
-				{
-					ret = ERR_OUTOFMEMORY;
-				}
-				else
+				char *voxelFile = taskParameters->getString(TP_VOXEL_FILE, true);
+				ret = taskParameters->getErrorCode();
+				if(ret == ERR_OK)
 				{
-					ae_a = (double *)AllocateMemory(sz);
-					if(ae_a == NULL)
+					if(voxelFile != NULL && strlen(voxelFile) > 0)
 					{
-						ret = ERR_OUTOFMEMORY;
+						VoxelMaterialImport voxels(maxRadius, maxRadius, maxRadius, ds);
+						voxels.SetMemoryManager(_mem);
+						shareIndexCacheTo(&voxels);
+						ret = voxels.import(taskParameters, mu, eps, mu0, eps0);
 					}
 					else
 					{
-						ah_a = (double *)AllocateMemory(sz);
-						if(ah_a == NULL)
-						{
-							ret = ERR_OUTOFMEMORY;
-						}
-						else
-						{
-							ah0_a = (double *)AllocateMemory(sz);
-							if(ah0_a == NULL)
-							{
-								ret = ERR_OUTOFMEMORY;
-							}
-						}
+						ret = initializeInhomogeneous();
 					}
 				}
-			}
-			if(ret == ERR_OK)
-			{
-				ret = initializeInhomogeneous();
 				if(ret == ERR_OK)
 				{
 					ret = onInitInhomogeneous();
@@ -167,7 +314,7 @@ int TssInhomogeneous::applyCurls(int k)
 	//curl estimation of order 2k, it is even order
 	if(k == 0) //order 0
 	{
-		for(i=0;i<fieldItems;i++)
+		for(i=0;i<_materialCount;i++)
 		{
 			ae_a[i] = ah_a[i] = 1.0;
 		}
@@ -176,12 +323,12 @@ int TssInhomogeneous::applyCurls(int k)
 	else
 	{
 		//kd is the estimation order, it can be 2, 4, 6, ...
-		for(i=0;i<fieldItems;i++)
+		for(i=0;i<_materialCount;i++)
 		{
 			ae0_a[i] = dtmu[i] * ah_a[i] / kd;
 			ah0_a[i] = dteps[i] * ae_a[i] / kd;
 		}
-		for(i=0;i<fieldItems;i++)
+		for(i=0;i<_materialCount;i++)
 		{
 			ae_a[i] = ae0_a[i];
 			ah_a[i] = ah0_a[i];
@@ -189,24 +336,36 @@ int TssInhomogeneous::applyCurls(int k)
 		curl1 = Curls[1]; //Curls[1] holds curls from an even estimation order
 		//from curl0 to get curl1, it is in Curl[1]
 		_curlEstimate->SetFields(curl0, curl1);
+		if(_multiRate != NULL)
+		{
+			_curlEstimate->SetLevels(_multiRate->CurlLevels(), (unsigned char)(2 * k));
+		}
 		ret = _curlEstimate->gothroughSphere(maxRadius);
+		if(ret == ERR_OK && _tfsfCorrection != NULL)
+		{
+			ret = _tfsfCorrection->correct(2 * k, curl1);
+		}
+		if(ret == ERR_OK && _mask != NULL)
+		{
+			_mask->ConstrainCurls(curl1, 2 * k);
+		}
 		if(ret == ERR_OK)
 		{
 			//use curl1 to get a time advance estimation
 			_applyCurlsEven->SetFields(HE, curl1, ae_a, ah_a);
-			ret = _applyCurlsEven->gothroughSphere(maxRadius);
+			ret = applyCurlsWithin(_applyCurlsEven);
 		}
 	}
 	if(ret == ERR_OK)
 	{
 		//curl estimation of order 2k+1, it is odd order
 		kd += 1.0;
-		for(i=0;i<fieldItems;i++)
+		for(i=0;i<_materialCount;i++)
 		{
 			ae0_a[i] = dtmu[i] * ah_a[i] / kd;
 			ah0_a[i] = dteps[i] * ae_a[i] / kd;
 		}
-		for(i=0;i<fieldItems;i++)
+		for(i=0;i<_materialCount;i++)
 		{
 			ae_a[i] = ae0_a[i];
 			ah_a[i] = ah0_a[i];
@@ -215,16 +374,54 @@ int TssInhomogeneous::applyCurls(int k)
 		curl0 = Curls[0]; //Curls[0] holds curls from an odd estimation order
 		//from curl1 to get curl0
 		_curlEstimate->SetFields(curl1, curl0);
+		if(_multiRate != NULL)
+		{
+			_curlEstimate->SetLevels(_multiRate->CurlLevels(), (unsigned char)(2 * k + 1));
+		}
 		//estimating curl0, it is in Curls[0]
 		ret = _curlEstimate->gothroughSphere(maxRadius);
+		if(ret == ERR_OK && _tfsfCorrection != NULL)
+		{
+			ret = _tfsfCorrection->correct(2 * k + 1, curl0);
+		}
+		if(ret == ERR_OK && _mask != NULL)
+		{
+			_mask->ConstrainCurls(curl0, 2 * k + 1);
+		}
 		if(ret == ERR_OK)
 		{
 			//use curl0 to make time advance estimation
 			_applyCurlsOdd->SetFields(HE, curl0, ae_a, ah_a);
-			ret = _applyCurlsOdd->gothroughSphere(maxRadius);
+			ret = applyCurlsWithin(_applyCurlsOdd);
 		}
 	}
 	return ret;
 }
+int TssInhomogeneous::onBeforeTimeAdvance()
+{
+	if(_multiRate != NULL)
+	{
+		_multiRate->beforeAdvance(HE);
+		_applyCurlsEven->SetRates(_multiRate->Rates(), _multiRate->Step());
+		_applyCurlsOdd->SetRates(_multiRate->Rates(), _multiRate->Step());
+	}
+	return ERR_OK;
+}
+int TssInhomogeneous::onAfterTimeAdvance()
+{
+	if(_multiRate != NULL)
+	{
+		_multiRate->afterAdvance(HE);
+	}
+	return ERR_OK;
+}
+int TssInhomogeneous::onFieldsReplaced()
+{
+	if(_multiRate != NULL)
+	{
+		_multiRate->restart();
+	}
+	return ERR_OK;
+}
 
 ////////////////////
\ No newline at end of file
@@ -7,10 +7,22 @@
 ********************************************************************/
 
 #include "TssInSphere.h"
+#include "MultiRateStepper.h"
 
+//largest number of materials; a point holds a 2-byte material index
+#define MAX_MATERIALS 65536
+//size of the hash table for finding materials, a power of 2 larger than MAX_MATERIALS
+#define MATERIAL_HASH_SIZE 131072
 
 /*
-	an abstract class to apply TSS algorithm in inhomogeneous environments
+	an abstract class to apply TSS algorithm in inhomogeneous environments.
+
+	points having the same coefficients form a material: the same Permeability and Permittivity, and the same
+	rate for multi-rate time stepping. each point holds the index of its material, 1 byte if there are not more
+	than 256 materials and 2 bytes otherwise; coefficients are kept for each material, not for each point.
+
+	if task parameter VOXEL.FILE is given then Permeability and Permittivity are imported from a voxel model
+	by VoxelMaterialImport, and initializeInhomogeneous is not called
 */
 class TssInhomogeneous: public TssInSphere
 {
@@ -18,24 +30,37 @@ protected:
 	//initialization should allocate memory and initialize space-related values of these two arrays
 	double *mu;  //Permeability at each space point, in radius indexing
 	double *eps; //Permittivity at each space point, in radius indexing
-	double *dtmu;  //-dt/(ds*mu0) = - 1 / (c0 * sqrt(3) * mu0)
-	double *dteps; // dt/(ds*eps0) = 1 / (c0 * sqrt(3) * eps0)
 	//
-	//factors to update fields, they are space-location dependent
+	size_t _materialCount;
+	unsigned char *_materials8;   //material index of each space point; NULL if 2-byte indexes are used
+	unsigned short *_materials16; //material index of each space point; NULL if 1-byte indexes are used
+	//
+	double *dtmu;  //of each material, -dt/(ds*mu), multiplied by the rate of multi-rate time stepping
+	double *dteps; //of each material,  dt/(ds*eps), multiplied by the rate of multi-rate time stepping
+	//
+	//factors to update fields, of each material
 	double *ae_a;
 	double *ah_a;
 	double *ae0_a;
 	double *ah0_a; 
 	//
+	//multi-rate time stepping, NULL if all points use dt
+	unsigned _maxRate; //FDTD.MAX_RATE
+	MultiRateStepper *_multiRate;
+	//
 	/*
 		a subclass override this function to assign values to space-location-dependent Permeability and Permittivity,
 		that is, set values for mu[i] and eps[i]
 	*/
 	virtual int initializeInhomogeneous()=0;
 	/*
-		prepare dtmu and dteps
+		prepare multi-rate time stepping, material indexes and dtmu and dteps
 	*/
 	virtual int onInitInhomogeneous();
+	/*
+		form materials from mu, eps and the rates, and give each point the index of its material
+	*/
+	int formMaterials();
 	/*
 		create curl-estimators of desired classes
 	*/
@@ -51,7 +76,7 @@ protected:
 	virtual void cleanup();
 	/*
 		1. initialize memories for space-location-dependent Permeability, Permittivity, and coefficients
-		2. call initializeInhomogeneous to assigned values to space-location-dependent Permeability and Permittivity 
+		2. import a voxel model, or call initializeInhomogeneous to assigned values to space-location-dependent Permeability and Permittivity 
 		3. call onInitInhomogeneous
 	*/
 	virtual int onInitialized(TaskFile *taskParameters);
@@ -59,6 +84,18 @@ protected:
 		use curls to estimate time-advancement in a space-location-dependent manner
 	*/
 	virtual int applyCurls(int k);
+	/*
+		multi-rate time stepping: give interpolated fields to slow points not advanced in this time step
+	*/
+	virtual int onBeforeTimeAdvance();
+	/*
+		multi-rate time stepping: save fields of slow points advanced in this time step
+	*/
+	virtual int onAfterTimeAdvance();
+	/*
+		multi-rate time stepping: start a new cycle from the replaced fields
+	*/
+	virtual int onFieldsReplaced();
 	//
 public:
 	TssInhomogeneous(void);
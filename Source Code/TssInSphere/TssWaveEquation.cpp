@@ -0,0 +1,566 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "TssWaveEquation.h"
+#include <malloc.h>
+#include <math.h>
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+#include "..\MemoryMan\memman.h"
+
+//points for finding the highest frequency of the interior estimation
+#define WAVE_STABILITY_SAMPLES 1000
+
+VectorOperatorAsymmetric::VectorOperatorAsymmetric(DerivativeEstimatorAsymmetric *derivative)
+{
+	_derivative = derivative;
+	_curl = false;
+	_addToDest = false;
+	_src = NULL;
+	_srcStep = 1;
+	_dest = NULL;
+	_factor = 1.0;
+	_acc1 = _acc2 = NULL;
+	_a1 = _a2 = 0.0;
+	if(_derivative != NULL)
+	{
+		_derivative->shareIndexCacheTo(this);
+		ret = ERR_OK;
+	}
+	else
+	{
+		ret = ERR_TSS_DERIVATIVE;
+	}
+}
+void VectorOperatorAsymmetric::SetLaplacian(Point3Dstruct *src, int srcStep, Point3Dstruct *dest, double factor)
+{
+	_curl = false;
+	_src = src;
+	_srcStep = srcStep;
+	_dest = dest;
+	_factor = factor;
+	_acc1 = _acc2 = NULL;
+}
+void VectorOperatorAsymmetric::SetAccumulators(Point3Dstruct *acc1, double a1, Point3Dstruct *acc2, double a2)
+{
+	_acc1 = acc1;
+	_a1 = a1;
+	_acc2 = acc2;
+	_a2 = a2;
+}
+void VectorOperatorAsymmetric::SetCurl(Point3Dstruct *src, int srcStep, Point3Dstruct *dest, double factor, bool addToDest)
+{
+	_curl = true;
+	_addToDest = addToDest;
+	_src = src;
+	_srcStep = srcStep;
+	_dest = dest;
+	_factor = factor;
+	_acc1 = _acc2 = NULL;
+}
+/*
+	stencil is from GetStencil of the axis.
+	h == 0: the samplings are symmetric and so are the coefficients; f'' = sum of c[i] * (f(k) + f(-k) - 2f(0))
+	h > 0: f'' = sum of c[i] * (f(k) - f(0)), k = 1,...,positiveEnd then k = -1,...,negativeEnd
+*/
+void VectorOperatorAsymmetric::secondDerivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, Point3Dstruct *f0, Point3Dstruct *sum)
+{
+	Point3Dstruct *f, *f2;
+	double c;
+	int i = 0;
+	int k = 1;
+	if(stencil->h == 0)
+	{
+		while(k <= stencil->positiveEnd)
+		{
+			c = stencil->coefficients2[i];
+			f  = at(m + k * dm, n + k * dn, p + k * dp);
+			f2 = at(m - k * dm, n - k * dn, p - k * dp);
+			sum->x += c * (f->x + f2->x - 2.0 * f0->x);
+			sum->y += c * (f->y + f2->y - 2.0 * f0->y);
+			sum->z += c * (f->z + f2->z - 2.0 * f0->z);
+			k++;
+			i++;
+		}
+	}
+	else
+	{
+		while(k <= stencil->positiveEnd)
+		{
+			c = stencil->coefficients2[i];
+			f = at(m + k * dm, n + k * dn, p + k * dp);
+			sum->x += c * (f->x - f0->x);
+			sum->y += c * (f->y - f0->y);
+			sum->z += c * (f->z - f0->z);
+			k++;
+			i++;
+		}
+		k = -1;
+		while(k >= stencil->negativeEnd)
+		{
+			c = stencil->coefficients2[i];
+			f = at(m + k * dm, n + k * dn, p + k * dp);
+			sum->x += c * (f->x - f0->x);
+			sum->y += c * (f->y - f0->y);
+			sum->z += c * (f->z - f0->z);
+			k--;
+			i++;
+		}
+	}
+}
+/*
+	the same samplings as secondDerivative, using the first derivative coefficients.
+	for h == 0, f' = sum of c[i] * (f(k) - f(-k))
+*/
+void VectorOperatorAsymmetric::firstDerivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, Point3Dstruct *f0, Point3Dstruct *d)
+{
+	Point3Dstruct *f, *f2;
+	double c;
+	int i = 0;
+	int k = 1;
+	d->x = d->y = d->z = 0.0;
+	if(stencil->h == 0)
+	{
+		while(k <= stencil->positiveEnd)
+		{
+			c = stencil->coefficients[i];
+			f  = at(m + k * dm, n + k * dn, p + k * dp);
+			f2 = at(m - k * dm, n - k * dn, p - k * dp);
+			d->x += c * (f->x - f2->x);
+			d->y += c * (f->y - f2->y);
+			d->z += c * (f->z - f2->z);
+			k++;
+			i++;
+		}
+	}
+	else
+	{
+		while(k <= stencil->positiveEnd)
+		{
+			c = stencil->coefficients[i];
+			f = at(m + k * dm, n + k * dn, p + k * dp);
+			d->x += c * (f->x - f0->x);
+			d->y += c * (f->y - f0->y);
+			d->z += c * (f->z - f0->z);
+			k++;
+			i++;
+		}
+		k = -1;
+		while(k >= stencil->negativeEnd)
+		{
+			c = stencil->coefficients[i];
+			f = at(m + k * dm, n + k * dn, p + k * dp);
+			d->x += c * (f->x - f0->x);
+			d->y += c * (f->y - f0->y);
+			d->z += c * (f->z - f0->z);
+			k--;
+			i++;
+		}
+	}
+}
+void VectorOperatorAsymmetric::handleData(int m, int n, int p)
+{
+	Point3Dstruct *f0 = &(_src[index * _srcStep]);
+	Point3Dstruct *v = &(_dest[index]);
+	if(_curl)
+	{
+		Point3Dstruct dx, dy, dz;
+		firstDerivative(m, n, p, 1, 0, 0, _derivative->GetStencil(m, maxRadiusX), f0, &dx);
+		firstDerivative(m, n, p, 0, 1, 0, _derivative->GetStencil(n, maxRadiusY), f0, &dy);
+		firstDerivative(m, n, p, 0, 0, 1, _derivative->GetStencil(p, maxRadiusZ), f0, &dz);
+		if(!_addToDest)
+		{
+			v->x = v->y = v->z = 0.0;
+		}
+		v->x += _factor * (dy.z - dz.y);
+		v->y += _factor * (dz.x - dx.z);
+		v->z += _factor * (dx.y - dy.x);
+	}
+	else
+	{
+		Point3Dstruct sum;
+		sum.x = sum.y = sum.z = 0.0;
+		secondDerivative(m, n, p, 1, 0, 0, _derivative->GetStencil(m, maxRadiusX), f0, &sum);
+		secondDerivative(m, n, p, 0, 1, 0, _derivative->GetStencil(n, maxRadiusY), f0, &sum);
+		secondDerivative(m, n, p, 0, 0, 1, _derivative->GetStencil(p, maxRadiusZ), f0, &sum);
+		v->x = _factor * sum.x;
+		v->y = _factor * sum.y;
+		v->z = _factor * sum.z;
+		if(_acc1 != NULL)
+		{
+			_acc1[index].x += _a1 * v->x;
+			_acc1[index].y += _a1 * v->y;
+			_acc1[index].z += _a1 * v->z;
+		}
+		if(_acc2 != NULL)
+		{
+			_acc2[index].x += _a2 * v->x;
+			_acc2[index].y += _a2 * v->y;
+			_acc2[index].z += _a2 * v->z;
+		}
+	}
+	index++;
+}
+////////////////////////////////////////////////////////////////////
+TssWaveEquation::TssWaveEquation(void)
+{
+	mu0 = 4.0 * M_PI * 1.0e-7;
+	eps0 = 1.0 /(mu0 * c0 * c0);
+	_withH = false;
+	_evenCoef = NULL;
+	_oddCoef = NULL;
+	_prevE = NULL;
+	_prevH = NULL;
+	_sumH = NULL;
+	_lap[0] = _lap[1] = NULL;
+	_derivative = NULL;
+	_operator = NULL;
+}
+TssWaveEquation::~TssWaveEquation(void)
+{
+	cleanup();
+}
+void TssWaveEquation::cleanup()
+{
+	if(_operator != NULL)
+	{
+		delete _operator;
+		_operator = NULL;
+	}
+	if(_derivative != NULL)
+	{
+		delete _derivative;
+		_derivative = NULL;
+	}
+	if(_evenCoef != NULL)
+	{
+		free(_evenCoef);
+		_evenCoef = NULL;
+	}
+	if(_oddCoef != NULL)
+	{
+		free(_oddCoef);
+		_oddCoef = NULL;
+	}
+	if(_prevE != NULL)
+	{
+		FreeMemory(_prevE);
+		_prevE = NULL;
+	}
+	if(_prevH != NULL)
+	{
+		FreeMemory(_prevH);
+		_prevH = NULL;
+	}
+	if(_sumH != NULL)
+	{
+		FreeMemory(_sumH);
+		_sumH = NULL;
+	}
+	for(int i=0;i<2;i++)
+	{
+		if(_lap[i] != NULL)
+		{
+			FreeMemory(_lap[i]);
+			_lap[i] = NULL;
+		}
+	}
+}
+void TssWaveEquation::OnFinishSimulation()
+{
+	cleanup();
+}
+
+int TssWaveEquation::onInitialized(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	size_t size = fieldItems * sizeof(Point3Dstruct);
+	cleanup();
+	if(_tfsf != NULL)
+	{
+		ret = ERR_TSS_WAVE_TFSF;
+	}
+	else
+	{
+		_withH = taskParameters->getBoolean(TP_WAVE_H, true);
+		ret = taskParameters->getErrorCode();
+	}
+	if(ret == ERR_OK)
+	{
+		_evenCoef = (double *)malloc((_maxOrderTimeAdvance + 1) * sizeof(double));
+		_oddCoef = (double *)malloc((_maxOrderTimeAdvance + 1) * sizeof(double));
+		_prevE = (Point3Dstruct *)AllocateTaggedMemory(size, MEM_TAG_FIELDS);
+		_lap[0] = (Point3Dstruct *)AllocateTaggedMemory(size, MEM_TAG_CURLS);
+		_lap[1] = (Point3Dstruct *)AllocateTaggedMemory(size, MEM_TAG_CURLS);
+		if(_evenCoef == NULL || _oddCoef == NULL || _prevE == NULL || _lap[0] == NULL || _lap[1] == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else if(_withH)
+		{
+			_prevH = (Point3Dstruct *)AllocateTaggedMemory(size, MEM_TAG_FIELDS);
+			_sumH = (Point3Dstruct *)AllocateTaggedMemory(size, MEM_TAG_FIELDS);
+			if(_prevH == NULL || _sumH == NULL)
+			{
+				ret = ERR_OUTOFMEMORY;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//_evenCoef[k] = 2*dt^(2k)/(2k)!, _oddCoef[k] = 2*dt^(2k+1)/(2k+1)!
+		double a = 2.0;
+		for(int k=0;k<=_maxOrderTimeAdvance;k++)
+		{
+			if(k > 0)
+			{
+				a *= dt / (double)(2 * k);
+			}
+			_evenCoef[k] = a;
+			a *= dt / (double)(2 * k + 1);
+			_oddCoef[k] = a;
+		}
+		_derivative = new DerivativeEstimatorAsymmetric(_maxOrderSpaceDerivative, maxRadius, seriesIndex);
+		_operator = new VectorOperatorAsymmetric(_derivative);
+		ret = _derivative->GetLastHandlerError();
+		if(ret == ERR_OK)
+		{
+			_derivative->prepareCoefficeints();
+			ret = _derivative->GetLastHandlerError();
+		}
+		if(ret == ERR_OK)
+		{
+			ret = _operator->GetLastHandlerError();
+		}
+		if(ret == ERR_OK)
+		{
+			ret = checkStability();
+		}
+	}
+	return ret;
+}
+/*
+	for a plane wave exp(i*(w*t - k.r)), L gives -w*w with w*w = c0*c0*(s(kx)+s(ky)+s(kz))/(ds*ds),
+	s(a) = -sum of c[i] * (2cos(k*a) - 2) for the interior coefficients c of the second derivative.
+	a time step multiplies the wave by a root of g*g - 2*C*g + 1 = 0, C = sum of (-w*w*dt*dt)^k/(2k)!, k = 0,...,K;
+	|g| = 1 for |C| <= 1
+*/
+int TssWaveEquation::checkStability()
+{
+	int ret = ERR_OK;
+	double smax = 0.0;
+	double *c = _derivative->coefficient2ByEdge[0];
+	double r = c0 * dt / ds;
+	double x2max;
+	for(int j=0;j<=WAVE_STABILITY_SAMPLES;j++)
+	{
+		double a = M_PI * (double)j / (double)WAVE_STABILITY_SAMPLES;
+		double s = 0.0;
+		for(int i=0;i<_maxOrderSpaceDerivative;i++)
+		{
+			s -= c[i] * (2.0 * cos((double)(i + 1) * a) - 2.0);
+		}
+		if(s > smax) smax = s;
+	}
+	x2max = 3.0 * smax * r * r;
+	for(int j=0;j<=WAVE_STABILITY_SAMPLES;j++)
+	{
+		double x2 = x2max * (double)j / (double)WAVE_STABILITY_SAMPLES;
+		double C = 0.0;
+		double t = 1.0;
+		for(int k=0;k<=_maxOrderTimeAdvance;k++)
+		{
+			if(k > 0)
+			{
+				t *= -x2 / (double)((2 * k - 1) * 2 * k);
+			}
+			C += t;
+		}
+		if(fabs(C) > 1.0 + 1.0e-9)
+		{
+			ret = ERR_TSS_WAVE_UNSTABLE;
+			break;
+		}
+	}
+	return ret;
+}
+int TssWaveEquation::goThrough()
+{
+	if(_boxDomain)
+	{
+		return _operator->gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+	}
+	return _operator->gothroughSphere(maxRadius);
+}
+int TssWaveEquation::series(Point3Dstruct *src, int srcStep, Point3Dstruct *acc, double *coef, double s, Point3Dstruct *acc2, double *coef2, double s2)
+{
+	int ret = ERR_OK;
+	Point3Dstruct *f = src;
+	int step = srcStep;
+	double lapFactor = (c0 * c0) / (ds * ds);
+	//k = 0
+	for(size_t i=0;i<fieldItems;i++)
+	{
+		Point3Dstruct *v = &(src[i * srcStep]);
+		acc[i].x += s * coef[0] * v->x;
+		acc[i].y += s * coef[0] * v->y;
+		acc[i].z += s * coef[0] * v->z;
+		if(acc2 != NULL)
+		{
+			acc2[i].x += s2 * coef2[0] * v->x;
+			acc2[i].y += s2 * coef2[0] * v->y;
+			acc2[i].z += s2 * coef2[0] * v->z;
+		}
+	}
+	for(int k=1;k<=_maxOrderTimeAdvance && ret == ERR_OK;k++)
+	{
+		//L^k src from L^(k-1) src
+		_operator->SetLaplacian(f, step, _lap[k % 2], lapFactor);
+		_operator->SetAccumulators(acc, s * coef[k], acc2, (acc2 == NULL)?0.0:s2 * coef2[k]);
+		ret = goThrough();
+		f = _lap[k % 2];
+		step = 1;
+	}
+	return ret;
+}
+/*
+	E(-dt) = sum of dt^(2k)/(2k)! L^k E - sum of dt^(2k+1)/(2k+1)! L^k dE/dt, dE/dt = curl H/eps0
+	H(-dt) = sum of dt^(2k)/(2k)! L^k H - sum of dt^(2k+1)/(2k+1)! L^k dH/dt, dH/dt = -curl E/mu0
+*/
+int TssWaveEquation::startTimeStepping()
+{
+	int ret = ERR_OK;
+	Point3Dstruct *deriv = _sumH;
+	if(deriv == NULL)
+	{
+		deriv = (Point3Dstruct *)AllocateTaggedMemory(fieldItems * sizeof(Point3Dstruct), MEM_TAG_CURLS);
+		if(deriv == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		for(size_t i=0;i<fieldItems;i++)
+		{
+			_prevE[i].x = _prevE[i].y = _prevE[i].z = 0.0;
+		}
+		ret = series(&(HE[0].E), 2, _prevE, _evenCoef, 0.5, NULL, NULL, 0.0);
+	}
+	if(ret == ERR_OK)
+	{
+		_operator->SetCurl(&(HE[0].H), 2, deriv, 1.0 / (eps0 * ds), false);
+		ret = goThrough();
+		if(ret == ERR_OK)
+		{
+			ret = series(deriv, 1, _prevE, _oddCoef, -0.5, NULL, NULL, 0.0);
+		}
+	}
+	if(ret == ERR_OK && _withH)
+	{
+		for(size_t i=0;i<fieldItems;i++)
+		{
+			_prevH[i].x = _prevH[i].y = _prevH[i].z = 0.0;
+		}
+		ret = series(&(HE[0].H), 2, _prevH, _evenCoef, 0.5, NULL, NULL, 0.0);
+		if(ret == ERR_OK)
+		{
+			_operator->SetCurl(&(HE[0].E), 2, deriv, -1.0 / (mu0 * ds), false);
+			ret = goThrough();
+		}
+		if(ret == ERR_OK)
+		{
+			ret = series(deriv, 1, _prevH, _oddCoef, -0.5, NULL, NULL, 0.0);
+		}
+	}
+	if(deriv != NULL && deriv != _sumH)
+	{
+		FreeMemory(deriv);
+	}
+	return ret;
+}
+int TssWaveEquation::PopulateFields(FieldsInitializer *fieldValues)
+{
+	int ret = FDTD::PopulateFields(fieldValues);
+	if(ret == ERR_OK)
+	{
+		ret = startTimeStepping();
+	}
+	return ret;
+}
+/*
+	advance time forward by one step of dt
+*/
+int TssWaveEquation::updateFieldsToMoveForward()
+{
+	int ret = ERR_OK;
+	//advance time indicators
+	_timeIndex++;
+	_time += dt;
+	//save existing fields to a file and allocating new memory
+	//it will copy the existing fields to new memory
+	//fields are still at a time of _time-dt
+	ret = allocateFieldMemory();
+	if(ret == ERR_OK)
+	{
+		if(_recordFDTDStepTimes)
+		{
+			startTime = getTimeCount();
+		}
+		//E(t+dt) = -E(t-dt) + 2E(t) + ...; S = 0 + 2*dt*E(t) + ...
+		for(size_t i=0;i<fieldItems;i++)
+		{
+			_prevE[i].x = -_prevE[i].x;
+			_prevE[i].y = -_prevE[i].y;
+			_prevE[i].z = -_prevE[i].z;
+		}
+		if(_withH)
+		{
+			for(size_t i=0;i<fieldItems;i++)
+			{
+				_sumH[i].x = _sumH[i].y = _sumH[i].z = 0.0;
+			}
+		}
+		ret = series(&(HE[0].E), 2, _prevE, _evenCoef, 1.0, _sumH, _oddCoef, 1.0);
+		if(ret == ERR_OK && _withH)
+		{
+			//H(t+dt) = H(t-dt) - (1/mu0) curl S
+			_operator->SetCurl(_sumH, 1, _prevH, -1.0 / (mu0 * ds), true);
+			ret = goThrough();
+		}
+		if(ret == ERR_OK)
+		{
+			//the fields at t+dt go to HE, and the fields at t are kept for the next time step
+			Point3Dstruct v;
+			for(size_t i=0;i<fieldItems;i++)
+			{
+				v = HE[i].E; HE[i].E = _prevE[i]; _prevE[i] = v;
+			}
+			if(_withH)
+			{
+				for(size_t i=0;i<fieldItems;i++)
+				{
+					v = HE[i].H; HE[i].H = _prevH[i]; _prevH[i] = v;
+				}
+			}
+			else
+			{
+				//H is not estimated; it is written as 0 rather than as the fields at time 0
+				for(size_t i=0;i<fieldItems;i++)
+				{
+					HE[i].H.x = HE[i].H.y = HE[i].H.z = 0.0;
+				}
+			}
+		}
+		if(_recordFDTDStepTimes)
+		{
+			endTime = getTimeCount(); timeUsed = endTime - startTime;
+			_sumtimeused += timeUsed;
+			_timesteps++;
+		}
+	}
+	return ret;
+}
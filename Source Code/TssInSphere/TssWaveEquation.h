@@ -0,0 +1,111 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\FdtdMemory.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+#include "DerivativeEstimator.h"
+#include "TssInSphere.h"
+
+/*
+	Laplacian or curl of a vector field by the asymmetric derivative estimations.
+	src items are srcStep Point3Dstruct apart, so E or H of FieldPoint3D can be used directly with srcStep 2.
+
+	Laplacian: dest = factor * Laplacian of src, by coefficients2 of DerivativeEstimatorAsymmetric.
+	while dest is estimated up to 2 accumulators are updated: acc[i] += a * dest[i].
+	curl: dest = factor * curl of src, or dest += factor * curl of src, by coefficients of DerivativeEstimatorAsymmetric.
+*/
+class VectorOperatorAsymmetric: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	DerivativeEstimatorAsymmetric *_derivative;
+	bool _curl;            //true: curl; false: Laplacian
+	bool _addToDest;       //true: the curl is added to dest
+	Point3Dstruct *_src;
+	int _srcStep;
+	Point3Dstruct *_dest;
+	double _factor;
+	Point3Dstruct *_acc1, *_acc2; //accumulators of a Laplacian, NULL if not used
+	double _a1, _a2;
+	//
+	inline Point3Dstruct *at(int m, int n, int p){return &(_src[seriesIndex->Index(m,n,p) * _srcStep]);}
+	//add the second derivatives (Laplacian) or get the first derivatives (curl) along (dm,dn,dp)
+	void secondDerivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, Point3Dstruct *f0, Point3Dstruct *sum);
+	void firstDerivative(int m, int n, int p, int dm, int dn, int dp, const DerivativeStencil *stencil, Point3Dstruct *f0, Point3Dstruct *d);
+protected:
+	virtual void handleData(int m, int n, int p);
+public:
+	VectorOperatorAsymmetric(DerivativeEstimatorAsymmetric *derivative);
+	void SetLaplacian(Point3Dstruct *src, int srcStep, Point3Dstruct *dest, double factor);
+	void SetAccumulators(Point3Dstruct *acc1, double a1, Point3Dstruct *acc2, double a2);
+	void SetCurl(Point3Dstruct *src, int srcStep, Point3Dstruct *dest, double factor, bool addToDest);
+};
+
+/*
+	E-only (wave equation) form of TSS for a source-free homogeneous space.
+
+	in such a space div E = 0 and E follows d2E/dt2 = L E, L = c0*c0*Laplacian; the initial fields must be divergence free.
+	adding the time Taylor series of E at t+dt and t-dt leaves only the even orders:
+		E(t+dt) = 2E(t) - E(t-dt) + sum of 2*dt^(2k)/(2k)! L^k E(t), k = 1,2,...,K
+	K = FDTD.HALF_ORDER_TIME gives a time estimation order of 2K, as for TSS. L is estimated by the second derivatives
+	of DerivativeEstimatorAsymmetric with FDTD.HALF_ORDER_SPACE. a time step estimates K Laplacians of E instead of the
+	2K-1 curls of E and H of TSS, and keeps E at 2 times and 2 Laplacian buffers instead of E, H and 2 curl buffers.
+
+	H is only needed for output, i.e. data files and Poynting analysis. it is estimated at the same time as E
+	when task parameter FDTD.WAVE_H is true:
+		H(t+dt) = H(t-dt) - (1/mu0) curl S, S = sum of 2*dt^(2k+1)/(2k+1)! L^k E(t), k = 0,1,...,K
+	S is accumulated while the Laplacians are estimated, so H costs one curl and 2 more buffers; otherwise H is 0
+	after time 0, also in data files.
+
+	E(-dt) and H(-dt) are formed from the fields at time 0 by Taylor series with dE/dt = curl H/eps0 and dH/dt = -curl E/mu0.
+	a boundary condition may change E between time steps; a change of H is not used by the time stepping.
+
+	the even series is stable if |sum of (-w*w*dt*dt)^k/(2k)!| <= 1 for the highest frequency w of the interior
+	estimation; it is checked at initialization, a higher space order may need a higher time order.
+	a TF/SF boundary is not supported.
+*/
+class TssWaveEquation: public virtual FDTD
+{
+private:
+	double mu0;  //Permeability
+	double eps0; //Permittivity
+	//
+	bool _withH;               //H is estimated
+	double *_evenCoef;         //[K+1], 2*dt^(2k)/(2k)!
+	double *_oddCoef;          //[K+1], 2*dt^(2k+1)/(2k+1)!
+	Point3Dstruct *_prevE;     //E(t-dt); it becomes E(t+dt) during a time step
+	Point3Dstruct *_prevH;     //H(t-dt); it becomes H(t+dt) during a time step; NULL if H is not estimated
+	Point3Dstruct *_sumH;      //S; NULL if H is not estimated
+	Point3Dstruct *_lap[2];    //L^k E for odd and even k
+	DerivativeEstimatorAsymmetric *_derivative;
+	VectorOperatorAsymmetric *_operator;
+	//
+	int goThrough();
+	int checkStability();
+	/*
+		acc += s * sum of coef[k] L^k src, k = 0,1,...,K; and the same for acc2 if it is not NULL
+	*/
+	int series(Point3Dstruct *src, int srcStep, Point3Dstruct *acc, double *coef, double s, Point3Dstruct *acc2, double *coef2, double s2);
+	//form E(-dt) and H(-dt) from the fields at the current time
+	int startTimeStepping();
+protected:
+	virtual void cleanup();
+	virtual int onInitialized(TaskFile *taskParameters); //called after initialize(...) returns ERR_OK
+	virtual int onFieldsReplaced(){return startTimeStepping();}
+public:
+	TssWaveEquation(void);
+	virtual ~TssWaveEquation(void);
+	//
+	//derivative estimations use (m,n,p) and the axis radius, so they work on a row-major box
+	virtual bool SupportBoxDomain(){return true;}
+	virtual bool IsStaggered(){return false;}
+	//
+	virtual int PopulateFields(FieldsInitializer *fieldValues);
+	virtual int updateFieldsToMoveForward();
+	virtual void OnFinishSimulation();
+};
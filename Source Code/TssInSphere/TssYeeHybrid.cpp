@@ -0,0 +1,341 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "TssYeeHybrid.h"
+#include "..\MemoryMan\memman.h"
+
+//handleData passes
+#define PASS_E_TO_YEE 0 //Yee E from TSS E
+#define PASS_H_TO_YEE 1 //Yee H from TSS H
+#define PASS_TO_TSS   2 //TSS E and H from Yee E and H
+
+TssYeeCoupling::TssYeeCoupling(void)
+{
+	_pass = PASS_E_TO_YEE;
+	_domainRadius = 0;
+	_innerRadius = 0;
+	_tss = NULL;
+	_yee = NULL;
+	_tssPrev = NULL;
+	_yeePrev = NULL;
+}
+void TssYeeCoupling::initialize(RadiusIndexToSeriesIndex *cache, int maxR, int innerR, FieldPoint3D *yee, FieldPoint3D *tssPrev, FieldPoint3D *yeePrev)
+{
+	seriesIndex = cache;
+	_domainRadius = maxR;
+	_innerRadius = innerR;
+	_yee = yee;
+	_tssPrev = tssPrev;
+	_yeePrev = yeePrev;
+}
+/*
+	Yee components at (m,n,p) from TSS components; (m,n,p) is at least one space step inside the TSS region.
+	Ex is at (m+1/2,n,p), Ey at (m,n+1/2,p), Ez at (m,n,p+1/2);
+	Hx is at (m,n+1/2,p+1/2), Hy at (m+1/2,n,p+1/2), Hz at (m+1/2,n+1/2,p)
+*/
+void TssYeeCoupling::yeeComponents(int m, int n, int p, FieldPoint3D *f, bool getE, bool getH)
+{
+	size_t i0 = index;
+	size_t im = SINDEX(m+1,n,p);
+	size_t in = SINDEX(m,n+1,p);
+	size_t ip = SINDEX(m,n,p+1);
+	if(getE)
+	{
+		f->E.x = 0.5 * (_tss[i0].E.x + _tss[im].E.x);
+		f->E.y = 0.5 * (_tss[i0].E.y + _tss[in].E.y);
+		f->E.z = 0.5 * (_tss[i0].E.z + _tss[ip].E.z);
+	}
+	if(getH)
+	{
+		size_t inp = SINDEX(m,n+1,p+1);
+		size_t imp = SINDEX(m+1,n,p+1);
+		size_t imn = SINDEX(m+1,n+1,p);
+		//average of 4 points and 2 times
+		f->H.x = 0.125 * (_tss[i0].H.x + _tss[in].H.x + _tss[ip].H.x + _tss[inp].H.x
+			+ _tssPrev[i0].H.x + _tssPrev[in].H.x + _tssPrev[ip].H.x + _tssPrev[inp].H.x);
+		f->H.y = 0.125 * (_tss[i0].H.y + _tss[im].H.y + _tss[ip].H.y + _tss[imp].H.y
+			+ _tssPrev[i0].H.y + _tssPrev[im].H.y + _tssPrev[ip].H.y + _tssPrev[imp].H.y);
+		f->H.z = 0.125 * (_tss[i0].H.z + _tss[im].H.z + _tss[in].H.z + _tss[imn].H.z
+			+ _tssPrev[i0].H.z + _tssPrev[im].H.z + _tssPrev[in].H.z + _tssPrev[imn].H.z);
+	}
+}
+/*
+	TSS components at (m,n,p) from the Yee components around it.
+	a Yee component beyond the negative edge is taken as 0, as Yee's algorithm does
+*/
+void TssYeeCoupling::tssComponents(int m, int n, int p, FieldPoint3D *f, bool getE, bool getH)
+{
+	size_t i;
+	double hx, hy, hz;
+	size_t i0 = index;
+	bool hasM = (m - 1 >= -_domainRadius);
+	bool hasN = (n - 1 >= -_domainRadius);
+	bool hasP = (p - 1 >= -_domainRadius);
+	if(getE)
+	{
+		f->E.x = _yee[i0].E.x;
+		f->E.y = _yee[i0].E.y;
+		f->E.z = _yee[i0].E.z;
+		if(hasM) f->E.x += _yee[SINDEX(m-1,n,p)].E.x;
+		if(hasN) f->E.y += _yee[SINDEX(m,n-1,p)].E.y;
+		if(hasP) f->E.z += _yee[SINDEX(m,n,p-1)].E.z;
+		f->E.x *= 0.5;
+		f->E.y *= 0.5;
+		f->E.z *= 0.5;
+	}
+	if(getH)
+	{
+		//Yee H is at half time steps; the time average gives H at the start of the time step
+		hx = _yee[i0].H.x + _yeePrev[i0].H.x;
+		hy = _yee[i0].H.y + _yeePrev[i0].H.y;
+		hz = _yee[i0].H.z + _yeePrev[i0].H.z;
+		if(hasM)
+		{
+			i = SINDEX(m-1,n,p);
+			hy += _yee[i].H.y + _yeePrev[i].H.y;
+			hz += _yee[i].H.z + _yeePrev[i].H.z;
+		}
+		if(hasN)
+		{
+			i = SINDEX(m,n-1,p);
+			hx += _yee[i].H.x + _yeePrev[i].H.x;
+			hz += _yee[i].H.z + _yeePrev[i].H.z;
+		}
+		if(hasP)
+		{
+			i = SINDEX(m,n,p-1);
+			hx += _yee[i].H.x + _yeePrev[i].H.x;
+			hy += _yee[i].H.y + _yeePrev[i].H.y;
+		}
+		if(hasN && hasP)
+		{
+			i = SINDEX(m,n-1,p-1);
+			hx += _yee[i].H.x + _yeePrev[i].H.x;
+		}
+		if(hasM && hasP)
+		{
+			i = SINDEX(m-1,n,p-1);
+			hy += _yee[i].H.y + _yeePrev[i].H.y;
+		}
+		if(hasM && hasN)
+		{
+			i = SINDEX(m-1,n-1,p);
+			hz += _yee[i].H.z + _yeePrev[i].H.z;
+		}
+		f->H.x = 0.125 * hx;
+		f->H.y = 0.125 * hy;
+		f->H.z = 0.125 * hz;
+	}
+}
+void TssYeeCoupling::handleData(int m, int n, int p)
+{
+	switch(_pass)
+	{
+	case PASS_E_TO_YEE:
+		yeeComponents(m, n, p, &(_yee[index]), true, false);
+		break;
+	case PASS_H_TO_YEE:
+		yeeComponents(m, n, p, &(_yee[index]), false, true);
+		break;
+	case PASS_TO_TSS:
+		if(r > _innerRadius)
+		{
+			tssComponents(m, n, p, &(_tss[index]), true, true);
+		}
+		break;
+	}
+	index++;
+}
+int TssYeeCoupling::eToYee(int r)
+{
+	_pass = PASS_E_TO_YEE;
+	return gothroughSphere(r);
+}
+int TssYeeCoupling::hToYee(int r)
+{
+	_pass = PASS_H_TO_YEE;
+	return gothroughSphere(r);
+}
+int TssYeeCoupling::toTss(int r)
+{
+	_pass = PASS_TO_TSS;
+	return gothroughSphere(r);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+TssYeeHybrid::TssYeeHybrid(void)
+{
+	ch = ce = 0.0;
+	_innerRadius = 0;
+	_bandRadius = 0;
+	_curlWidth = 0;
+	_curlCount = 0;
+	_innerItems = 0;
+	_bandItems = 0;
+	_yee = NULL;
+	_tssPrev = NULL;
+	_yeePrev = NULL;
+}
+TssYeeHybrid::~TssYeeHybrid(void)
+{
+	cleanup();
+}
+void TssYeeHybrid::cleanup()
+{
+	TssInSphere::cleanup();
+	if(_yee != NULL)
+	{
+		FreeMemory(_yee);
+		_yee = NULL;
+	}
+	if(_tssPrev != NULL)
+	{
+		FreeMemory(_tssPrev);
+		_tssPrev = NULL;
+	}
+	if(_yeePrev != NULL)
+	{
+		FreeMemory(_yeePrev);
+		_yeePrev = NULL;
+	}
+}
+void TssYeeHybrid::copyFields(FieldPoint3D *dest, FieldPoint3D *src, size_t start, size_t end)
+{
+	for(size_t i=start;i<end;i++)
+	{
+		dest[i] = src[i];
+	}
+}
+int TssYeeHybrid::onInitialized(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	if(_tfsf != NULL)
+	{
+		ret = ERR_TSS_HYBRID_TFSF;
+	}
+	else
+	{
+		ret = TssInSphere::onInitialized(taskParameters);
+	}
+	if(ret == ERR_OK)
+	{
+		_innerRadius = (int)taskParameters->getUInt(TP_TSS_RADIUS, false);
+		ret = taskParameters->getErrorCode();
+		if(ret == ERR_OK)
+		{
+			//TSS needs at least one space step inside it for giving the Yee fields
+			if(_innerRadius < 1 || _innerRadius >= (int)maxRadius)
+			{
+				ret = ERR_TASK_INVALID_VALUE;
+				taskParameters->setNameOfInvalidValue(TP_TSS_RADIUS);
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		int bandItemsRadius;
+		_curlWidth = _maxOrderSpaceDerivative;
+		_curlCount = 2 * _maxOrderTimeAdvance - 1;
+		_bandRadius = _innerRadius + _curlCount * _curlWidth;
+		if(_bandRadius > (int)maxRadius) _bandRadius = maxRadius;
+		//interpolating TSS fields at the band uses Yee fields one space step further
+		bandItemsRadius = _bandRadius + 1;
+		if(bandItemsRadius > (int)maxRadius) bandItemsRadius = maxRadius;
+		_innerItems = totalPointsInSphere(_innerRadius);
+		_bandItems = totalPointsInSphere(bandItemsRadius);
+		_yee = (FieldPoint3D *)AllocateTaggedMemory(fieldMemorySize, MEM_TAG_FIELDS);
+		_tssPrev = (FieldPoint3D *)AllocateTaggedMemory(_innerItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+		_yeePrev = (FieldPoint3D *)AllocateTaggedMemory(_bandItems * sizeof(FieldPoint3D), MEM_TAG_FIELDS);
+		if(_yee == NULL || _tssPrev == NULL || _yeePrev == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			ch = (dt/ds)/mu0;
+			ce = (dt/ds)/eps0;
+			updateH.setMaxRadius(seriesIndex, maxRadius, ch, ce);
+			updateE.setMaxRadius(seriesIndex, maxRadius, ch, ce);
+			coupling.initialize(seriesIndex, maxRadius, _innerRadius, _yee, _tssPrev, _yeePrev);
+		}
+	}
+	return ret;
+}
+/*
+	curls of order k are needed within Rin + (K-k)*M
+*/
+int TssYeeHybrid::curlRadius(int order)
+{
+	int r = _innerRadius + (_curlCount - order) * _curlWidth;
+	if(r > (int)maxRadius) r = maxRadius;
+	return r;
+}
+int TssYeeHybrid::PopulateFields(FieldsInitializer *fieldValues)
+{
+	int ret = FDTD::PopulateFields(fieldValues);
+	if(ret == ERR_OK)
+	{
+		PopulateYeeFieldsTime0 p(fieldValues, _yee, ds);
+		ret = p.gothroughSphere(maxRadius, ds);
+		if(ret == ERR_OK)
+		{
+			copyFields(HE, _yee, _innerItems, fieldItems);
+		}
+	}
+	return ret;
+}
+/*
+	fields are at the start of the time step.
+	advance the Yee fields by one time step, and fill the coupling band of the TSS fields
+*/
+int TssYeeHybrid::onBeforeTimeAdvance()
+{
+	int ret;
+	coupling.setTssFields(HE);
+	//outside Rin the fields are the Yee fields, possibly modified by a boundary condition or a field source
+	copyFields(_yee, HE, _innerItems, fieldItems);
+	//inside Rin Yee E comes from TSS
+	ret = coupling.eToYee(_innerRadius - 1);
+	if(ret == ERR_OK)
+	{
+		copyFields(_tssPrev, HE, 0, _innerItems);
+		copyFields(_yeePrev, _yee, 0, _bandItems);
+		updateH.reset(_yee);
+		ret = updateH.gothroughSphere(maxRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = coupling.toTss(_bandRadius);
+	}
+	if(ret == ERR_OK)
+	{
+		updateE.reset(_yee);
+		ret = updateE.gothroughSphere(maxRadius);
+	}
+	return ret;
+}
+/*
+	TSS fields within Rin are advanced.
+	inside Rin Yee H comes from TSS for the next time step; outside Rin the fields are the Yee fields
+*/
+int TssYeeHybrid::onAfterTimeAdvance()
+{
+	int ret = coupling.hToYee(_innerRadius - 1);
+	if(ret == ERR_OK)
+	{
+		copyFields(HE, _yee, _innerItems, fieldItems);
+	}
+	return ret;
+}
+int TssYeeHybrid::onFieldsReplaced()
+{
+	int ret;
+	coupling.setTssFields(HE);
+	copyFields(_tssPrev, HE, 0, _innerItems);
+	ret = coupling.hToYee(_innerRadius - 1);
+	return ret;
+}
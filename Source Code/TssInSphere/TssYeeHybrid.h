@@ -0,0 +1,100 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\YeeFDTD\FieldUpdator.h"
+#include "..\YeeFDTD\PopulateFields.h"
+#include "TssInSphere.h"
+
+/*
+	moves fields between the TSS fields and the Yee fields of TssYeeHybrid.
+	TSS fields are at the grid points; a Yee field component is half a space step away from its grid point,
+	see PopulateYeeFieldsTime0. a Yee component is the average of the 2 (E) or 4 (H) TSS components around it,
+	and a TSS component is the average of the 2 or 4 Yee components around it.
+*/
+class TssYeeCoupling: public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	int _pass;              //what handleData does, see TssYeeHybrid.cpp
+	int _domainRadius;      //radius of the sphere
+	int _innerRadius;       //a point within it is not processed by the pass to TSS
+	FieldPoint3D *_tss;     //TSS fields
+	FieldPoint3D *_yee;     //Yee fields
+	FieldPoint3D *_tssPrev; //TSS fields at the start of the time step, for points within the TSS region
+	FieldPoint3D *_yeePrev; //Yee fields before the H update of the time step, for points within the coupling band
+	//
+	void yeeComponents(int m, int n, int p, FieldPoint3D *f, bool getE, bool getH);
+	void tssComponents(int m, int n, int p, FieldPoint3D *f, bool getE, bool getH);
+protected:
+	virtual void handleData(int m, int n, int p);
+public:
+	TssYeeCoupling(void);
+	void initialize(RadiusIndexToSeriesIndex *cache, int maxR, int innerR, FieldPoint3D *yee, FieldPoint3D *tssPrev, FieldPoint3D *yeePrev);
+	//the TSS field memory changes at every time step
+	void setTssFields(FieldPoint3D *tss){_tss = tss;}
+	//Yee E within radius r from TSS E
+	int eToYee(int r);
+	//Yee H within radius r from the time average of TSS H in _tssPrev and TSS H
+	int hToYee(int r);
+	//TSS E and H between _innerRadius and radius r from Yee E, and from the time average of Yee H in _yeePrev and Yee H
+	int toTss(int r);
+};
+
+/*
+	hybrid of TSS and Yee's algorithm.
+
+	TSS is used within the radius given by task parameter FDTD.TSS_RADIUS (Rin), i.e. around field sources;
+	Yee's algorithm is used everywhere else. the Yee fields of the whole sphere are kept in a separate memory;
+	within Rin they are taken from the TSS fields at every time step, so that Yee's algorithm is only
+	making its own estimations outside Rin.
+
+	TSS needs the fields at the start of a time step within a coupling band Rin < r <= Rin + K*M,
+	K = 2*FDTD.HALF_ORDER_TIME-1 is the number of curl estimations in a time step and M = FDTD.HALF_ORDER_SPACE.
+	the band is interpolated from the Yee fields: E directly, H by the average of the Yee H before and after the H update.
+	curls of order k are estimated within Rin + (K-k)*M, so each curl estimation only uses valid points;
+	fields are advanced by TSS only within Rin.
+
+	the fields are TSS fields within Rin and Yee fields (half space step shifted) outside Rin; a boundary condition
+	works on the Yee fields as it does for YeeFDTD. the accuracy at the interface is limited by the second order interpolations;
+	a wider Rin, relative to the wave length, keeps the high order region away from the interface.
+	a TF/SF boundary is not supported.
+*/
+class TssYeeHybrid: public TssInSphere
+{
+private:
+	double ch, ce;         //ch = (dt/ds)/mu0, ce = (dt/ds)/eps0
+	int _innerRadius;      //Rin
+	int _bandRadius;       //Rin + K*M, not more than maxRadius
+	int _curlWidth;        //M
+	int _curlCount;        //K
+	size_t _innerItems;    //points within Rin
+	size_t _bandItems;     //points within _bandRadius+1
+	FieldPoint3D *_yee;    //[fieldItems], Yee fields
+	FieldPoint3D *_tssPrev;//[_innerItems]
+	FieldPoint3D *_yeePrev;//[_bandItems]
+	UpdateHField updateH;
+	UpdateEField updateE;
+	TssYeeCoupling coupling;
+	//
+	void copyFields(FieldPoint3D *dest, FieldPoint3D *src, size_t start, size_t end);
+protected:
+	virtual void cleanup();
+	virtual int onInitialized(TaskFile *taskParameters);
+	virtual int onBeforeTimeAdvance();
+	virtual int onAfterTimeAdvance();
+	virtual int onFieldsReplaced();
+	virtual int curlRadius(int order);
+	virtual int advanceRadius(){return _innerRadius;}
+public:
+	TssYeeHybrid(void);
+	virtual ~TssYeeHybrid(void);
+	//TSS fields within Rin and Yee fields outside Rin
+	virtual int PopulateFields(FieldsInitializer *fieldValues);
+	//the Yee region does not use a material mask
+	virtual bool SupportMaterialMask(){return false;}
+};
@@ -0,0 +1,421 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include <Windows.h>
+#include "VoxelMaterials.h"
+#include "TssInSphere.h"
+#include "..\MemoryMan\memman.h"
+#include <malloc.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	thread function for the planes of one thread
+*/
+static DWORD WINAPI voxelThread(LPVOID param)
+{
+	VoxelWork *w = (VoxelWork *)param;
+	w->owner->scatterPlanes(w);
+	return 0;
+}
+
+/*
+	read a number at *s and skip the spaces after it; false if there is not a number
+*/
+static bool readNumber(const char **s, double *v)
+{
+	char *e;
+	*v = strtod(*s, &e);
+	if(e == *s)
+	{
+		return false;
+	}
+	while(*e == ' ') e++;
+	*s = e;
+	return true;
+}
+
+VoxelMaterialImport::VoxelMaterialImport(int maxRx, int maxRy, int maxRz, double ds)
+{
+	_rx = maxRx;
+	_ry = maxRy;
+	_rz = maxRz;
+	_ds = ds;
+	_file = NULL;
+	_voxels = NULL;
+	_nx = _ny = _nz = 0;
+	_bytes = 1;
+	_background = 0;
+	_tableMu = NULL;
+	_tableEps = NULL;
+	_defined = NULL;
+	for(int i=0;i<3;i++)
+	{
+		_map[i] = NULL;
+	}
+	_mu = NULL;
+	_eps = NULL;
+	_threadCount = 1;
+}
+
+VoxelMaterialImport::~VoxelMaterialImport()
+{
+	cleanup();
+}
+
+void VoxelMaterialImport::cleanup()
+{
+	if(_file != NULL)
+	{
+		FreeMemory(_file);
+		_file = NULL;
+	}
+	_voxels = NULL;
+	if(_tableMu != NULL)
+	{
+		free(_tableMu);
+		_tableMu = NULL;
+	}
+	if(_tableEps != NULL)
+	{
+		free(_tableEps);
+		_tableEps = NULL;
+	}
+	if(_defined != NULL)
+	{
+		free(_defined);
+		_defined = NULL;
+	}
+	for(int i=0;i<3;i++)
+	{
+		if(_map[i] != NULL)
+		{
+			free(_map[i]);
+			_map[i] = NULL;
+		}
+	}
+}
+
+/*
+	map the voxel file into memory and get the dimensions from its header or from VOXEL.DIMS and VOXEL.BYTES
+*/
+int VoxelMaterialImport::mapFile(TaskFile *taskParameters, const char *file)
+{
+	int ret = ERR_OK;
+	wchar_t fileW[FILENAME_MAX];
+	size_t size = 0;
+	size_t header = 0;
+	ret = copyC2W(fileW, FILENAME_MAX, file);
+	if(ret == ERR_OK)
+	{
+		_file = ReadFileIntoTaggedMemory(fileW, &size, &ret, MEM_TAG_MATERIALS);
+		if(ret == ERR_OK && _file == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		const unsigned char *b = (const unsigned char *)_file;
+		if(size >= VOXEL_HEADER_SIZE && memcmp(b, VOXEL_MAGIC, 8) == 0)
+		{
+			unsigned v[4];
+			//little-endian 32-bit integers after the magic
+			for(int i=0;i<4;i++)
+			{
+				const unsigned char *q = b + 8 + 4 * i;
+				v[i] = (unsigned)q[0] | ((unsigned)q[1] << 8) | ((unsigned)q[2] << 16) | ((unsigned)q[3] << 24);
+			}
+			_nx = v[0];
+			_ny = v[1];
+			_nz = v[2];
+			_bytes = v[3];
+			header = VOXEL_HEADER_SIZE;
+		}
+		else
+		{
+			//a raw file
+			char *dims = taskParameters->getString(TP_VOXEL_DIMS, false);
+			_bytes = taskParameters->getUInt(TP_VOXEL_BYTES, true);
+			ret = taskParameters->getErrorCode();
+			if(ret == ERR_OK)
+			{
+				const char *s = dims;
+				double d[3];
+				if(_bytes == 0) _bytes = 1;
+				for(int i=0;i<3 && ret == ERR_OK;i++)
+				{
+					while(*s == ' ') s++;
+					if(!readNumber(&s, &(d[i])) || d[i] < 1.0 || (i < 2 && *(s++) != ','))
+					{
+						ret = ERR_TASK_INVALID_VALUE;
+					}
+				}
+				if(ret == ERR_OK)
+				{
+					_nx = (unsigned)d[0];
+					_ny = (unsigned)d[1];
+					_nz = (unsigned)d[2];
+				}
+				else
+				{
+					taskParameters->setNameOfInvalidValue(TP_VOXEL_DIMS);
+				}
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		if((_bytes != 1 && _bytes != 2) || _nx == 0 || _ny == 0 || _nz == 0)
+		{
+			ret = ERR_TSS_VOXEL;
+		}
+		else if(size != header + (size_t)_nx * (size_t)_ny * (size_t)_nz * (size_t)_bytes)
+		{
+			ret = ERR_TSS_VOXEL;
+		}
+		else
+		{
+			_voxels = (const unsigned char *)_file + header;
+		}
+	}
+	return ret;
+}
+
+/*
+	table - "id:eps_r,mu_r;...", mu_r is optional
+*/
+int VoxelMaterialImport::readTable(TaskFile *taskParameters, const char *table, double mu0, double eps0)
+{
+	int ret = ERR_OK;
+	const char *s = table;
+	double id, er, mr;
+	_tableMu = (double *)malloc(MAX_VOXEL_IDS * sizeof(double));
+	_tableEps = (double *)malloc(MAX_VOXEL_IDS * sizeof(double));
+	_defined = (unsigned char *)malloc(MAX_VOXEL_IDS);
+	if(_tableMu == NULL || _tableEps == NULL || _defined == NULL)
+	{
+		return ERR_OUTOFMEMORY;
+	}
+	memset(_defined, 0, MAX_VOXEL_IDS);
+	while(*s != 0 && ret == ERR_OK)
+	{
+		while(*s == ' ') s++;
+		if(!readNumber(&s, &id) || id < 0.0 || id >= (double)MAX_VOXEL_IDS || *s != ':')
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		s++;
+		while(*s == ' ') s++;
+		if(!readNumber(&s, &er) || er <= 0.0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		mr = 1.0;
+		if(*s == ',')
+		{
+			s++;
+			while(*s == ' ') s++;
+			if(!readNumber(&s, &mr) || mr <= 0.0)
+			{
+				ret = ERR_TASK_INVALID_VALUE;
+				break;
+			}
+		}
+		if(*s == ';')
+		{
+			s++;
+		}
+		else if(*s != 0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			break;
+		}
+		_tableMu[(unsigned)id] = mr * mu0;
+		_tableEps[(unsigned)id] = er * eps0;
+		_defined[(unsigned)id] = 1;
+	}
+	if(ret != ERR_OK)
+	{
+		taskParameters->setNameOfInvalidValue(TP_VOXEL_MATERIALS);
+	}
+	return ret;
+}
+
+/*
+	voxel i of an axis of n voxels covers [(i - n/2) * size, (i + 1 - n/2) * size); a grid point takes the voxel it falls in
+*/
+int VoxelMaterialImport::formMap(int axis, int radius, unsigned voxels, double size)
+{
+	int count = 2 * radius + 1;
+	double v;
+	_map[axis] = (int *)malloc(count * sizeof(int));
+	if(_map[axis] == NULL)
+	{
+		return ERR_OUTOFMEMORY;
+	}
+	for(int m=-radius;m<=radius;m++)
+	{
+		v = floor((double)m * _ds / size + 0.5 * (double)voxels);
+		_map[axis][m + radius] = (v >= 0.0 && v < (double)voxels) ? (int)v : -1;
+	}
+	return ERR_OK;
+}
+
+void VoxelMaterialImport::scatterPlanes(VoxelWork *w)
+{
+	int i, j, k;
+	unsigned id;
+	size_t idx, row;
+	const unsigned char *v;
+	w->ret = ERR_OK;
+	for(int p=-_rz+w->first;p<=_rz;p+=w->step)
+	{
+		k = _map[2][p + _rz];
+		for(int n=-_ry;n<=_ry;n++)
+		{
+			j = _map[1][n + _ry];
+			row = ((size_t)k * (size_t)_ny + (size_t)j) * (size_t)_nx;
+			for(int m=-_rx;m<=_rx;m++)
+			{
+				i = _map[0][m + _rx];
+				if(i < 0 || j < 0 || k < 0)
+				{
+					id = _background;
+				}
+				else
+				{
+					v = _voxels + (row + (size_t)i) * _bytes;
+					id = (_bytes == 1) ? (unsigned)v[0] : ((unsigned)v[0] | ((unsigned)v[1] << 8));
+				}
+				if(!_defined[id])
+				{
+					w->ret = ERR_TASK_INVALID_VALUE;
+					return;
+				}
+				idx = SINDEX(m, n, p);
+				_mu[idx] = _tableMu[id];
+				_eps[idx] = _tableEps[id];
+			}
+		}
+	}
+}
+
+int VoxelMaterialImport::import(TaskFile *taskParameters, double *mu, double *eps, double mu0, double eps0)
+{
+	int ret = ERR_OK;
+	char *file = taskParameters->getString(TP_VOXEL_FILE, false);
+	char *table = taskParameters->getString(TP_VOXEL_MATERIALS, false);
+	double size = taskParameters->getDouble(TP_VOXEL_SIZE, false);
+	_background = taskParameters->getUInt(TP_VOXEL_BACKGROUND, true);
+	_threadCount = (int)taskParameters->getUInt(TP_FDTD_THREADS, true);
+	ret = taskParameters->getErrorCode();
+	cleanup();
+	_mu = mu;
+	_eps = eps;
+	if(ret == ERR_OK)
+	{
+		ret = MEMMANEXIST;
+	}
+	if(ret == ERR_OK)
+	{
+		ret = RADIUSINDEXMAPEXIST;
+	}
+	if(ret == ERR_OK)
+	{
+		if(size <= 0.0)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			taskParameters->setNameOfInvalidValue(TP_VOXEL_SIZE);
+		}
+		else if(_background >= MAX_VOXEL_IDS)
+		{
+			ret = ERR_TASK_INVALID_VALUE;
+			taskParameters->setNameOfInvalidValue(TP_VOXEL_BACKGROUND);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		ret = readTable(taskParameters, table, mu0, eps0);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = mapFile(taskParameters, file);
+	}
+	if(ret == ERR_OK)
+	{
+		ret = formMap(0, _rx, _nx, size);
+		if(ret == ERR_OK)
+		{
+			ret = formMap(1, _ry, _ny, size);
+		}
+		if(ret == ERR_OK)
+		{
+			ret = formMap(2, _rz, _nz, size);
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		if(_threadCount == 0)
+		{
+			SYSTEM_INFO si;
+			GetSystemInfo(&si);
+			_threadCount = (int)si.dwNumberOfProcessors;
+		}
+		if(_threadCount > MAX_VOXEL_THREADS) _threadCount = MAX_VOXEL_THREADS;
+		if(_threadCount > 2 * _rz + 1) _threadCount = 2 * _rz + 1;
+		for(int i=0;i<_threadCount;i++)
+		{
+			works[i].owner = this;
+			works[i].first = i;
+			works[i].step = _threadCount;
+			works[i].ret = ERR_OK;
+		}
+		if(_threadCount == 1)
+		{
+			scatterPlanes(&(works[0]));
+			ret = works[0].ret;
+		}
+		else
+		{
+			HANDLE threads[MAX_VOXEL_THREADS];
+			DWORD count = 0;
+			for(int i=0;i<_threadCount;i++)
+			{
+				threads[count] = CreateThread(NULL, 0, voxelThread, &(works[i]), 0, NULL);
+				if(threads[count] == NULL)
+				{
+					RememberOSerror();
+					ret = ERR_TSS_THREAD;
+					break;
+				}
+				count++;
+			}
+			if(count > 0)
+			{
+				WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+				for(DWORD i=0;i<count;i++)
+				{
+					CloseHandle(threads[i]);
+				}
+			}
+			for(DWORD i=0;i<count && ret == ERR_OK;i++)
+			{
+				ret = works[i].ret;
+			}
+		}
+		if(ret == ERR_TASK_INVALID_VALUE)
+		{
+			//a voxel id is not in the table
+			taskParameters->setNameOfInvalidValue(TP_VOXEL_MATERIALS);
+		}
+	}
+	cleanup();
+	return ret;
+}
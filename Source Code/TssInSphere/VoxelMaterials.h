@@ -0,0 +1,87 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+#include "..\EMField\EMField.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\MemoryMan\MemoryManager.h"
+#include "..\FileUtil\taskFile.h"
+
+//a voxel file starting with these 8 bytes has a header: 4 unsigned 32-bit integers nx, ny, nz and bytes per voxel
+#define VOXEL_MAGIC       "TSSVOXEL"
+#define VOXEL_HEADER_SIZE 24
+
+//largest voxel id; a voxel is 1 or 2 bytes
+#define MAX_VOXEL_IDS 65536
+
+//largest number of threads for scattering voxels; it is the limit of WaitForMultipleObjects
+#define MAX_VOXEL_THREADS 64
+
+class VoxelMaterialImport;
+
+/*
+	work of one thread: z-planes first, first+step, first+2*step, ... of the grid
+*/
+typedef struct VoxelWork
+{
+	VoxelMaterialImport *owner;
+	int first;
+	int step;
+	int ret;
+}VoxelWork;
+
+/*
+	import Permeability and Permittivity of an inhomogeneous environment from a voxel model.
+
+	a voxel file holds one material id per voxel, 1 or 2 bytes (little-endian), x changing fastest, then y, then z.
+	it either starts with a header (see VOXEL_MAGIC) or is raw; the dimensions of a raw file are given by
+	VOXEL.DIMS "nx,ny,nz" and VOXEL.BYTES (1 or 2). VOXEL.SIZE is the voxel edge length, in meters;
+	the model is centered at the origin.
+	VOXEL.MATERIALS is the material table, "id:eps_r,mu_r;id:eps_r,mu_r;...", relative to vacuum; mu_r can be omitted for 1.
+	grid points outside of the model get material VOXEL.BACKGROUND, 0 by default.
+
+	the file is mapped into memory, not read; a grid point takes the voxel it falls in, so only the voxels
+	at grid points are touched. the z-planes of the grid are shared by FDTD.THREADS threads, each thread
+	scattering the materials of its planes into the radius-indexed memory order
+*/
+class VoxelMaterialImport: public virtual RadiusIndexCacheUser, public virtual MemoryManUser
+{
+private:
+	int _rx, _ry, _rz;                 //radius of each axis of the grid
+	double _ds;                        //space step
+	void *_file;                       //the mapped voxel file
+	const unsigned char *_voxels;      //voxels in _file
+	unsigned _nx, _ny, _nz;            //voxel dimensions
+	unsigned _bytes;                   //1 or 2 bytes per voxel
+	unsigned _background;              //material id outside of the model
+	double *_tableMu;                  //[MAX_VOXEL_IDS], Permeability of each material id
+	double *_tableEps;                 //[MAX_VOXEL_IDS], Permittivity of each material id
+	unsigned char *_defined;           //[MAX_VOXEL_IDS], 1 if the material id is in the table
+	int *_map[3];                      //for each axis, the voxel index at each grid index; -1 outside of the model
+	double *_mu;                       //Permeability to be set at each space point
+	double *_eps;                      //Permittivity to be set at each space point
+	int _threadCount;                  //FDTD.THREADS
+	VoxelWork works[MAX_VOXEL_THREADS];
+	//
+	int mapFile(TaskFile *taskParameters, const char *file);
+	int readTable(TaskFile *taskParameters, const char *table, double mu0, double eps0);
+	int formMap(int axis, int radius, unsigned voxels, double size);
+	void cleanup();
+public:
+	/*
+		maxRx, maxRy, maxRz - radius of each axis of the grid; ds - space step
+	*/
+	VoxelMaterialImport(int maxRx, int maxRy, int maxRz, double ds);
+	~VoxelMaterialImport();
+	/*
+		set mu[i] and eps[i] of every space point from the voxel model given by the task file
+	*/
+	int import(TaskFile *taskParameters, double *mu, double *eps, double mu0, double eps0);
+	/*
+		scatter the planes of w. it is called by a thread
+	*/
+	void scatterPlanes(VoxelWork *w);
+};
@@ -10,6 +10,7 @@
 
 #include "YeeFDTD.h"
 #include "YeeFDTDSpaceSynched.h"
+#include "YeeFDTDRowMajor.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -30,11 +31,14 @@ YeeFDTD **yeeList = NULL;
 unsigned int yeeCount = 0;
 YeeFDTDSpaceSynched **yeesynchList = NULL;
 unsigned int yeesynchCount = 0;
+YeeFDTDRowMajor **yeeRowList = NULL;
+unsigned int yeeRowCount = 0;
 
 __declspec (dllexport) void RemovePluginInstances()
 {
 	REMOVEALLPLUGINS(YeeFDTD, yeeCount, yeeList);
 	REMOVEALLPLUGINS(YeeFDTDSpaceSynched, yeesynchCount, yeesynchList);
+	REMOVEALLPLUGINS(YeeFDTDRowMajor, yeeRowCount, yeeRowList);
 }
 
 __declspec (dllexport) void* CreatePluginInstance(char *name, double *params)
@@ -48,6 +52,10 @@ __declspec (dllexport) void* CreatePluginInstance(char *name, double *params)
 	{
 		CREATEPLUGININSTANCE(YeeFDTDSpaceSynched, yeesynchCount, yeesynchList);
 	}
+	else if(strcmp(name, "YeeFDTDRowMajor") == 0)
+	{
+		CREATEPLUGININSTANCE(YeeFDTDRowMajor, yeeRowCount, yeeRowList);
+	}
 	if(p != NULL)
 	{
 		//class name will be used in forming data file names
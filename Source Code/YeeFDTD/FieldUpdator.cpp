@@ -10,6 +10,7 @@
 UpdateField::UpdateField()
 {
 	_field = NULL;
+	_mask = NULL;
 	ret = ERR_OK;
 	index = 0;
 }
@@ -17,7 +18,6 @@ void UpdateField::setMaxRadius(RadiusIndexToSeriesIndex *cache, int maxR, double
 {
 	seriesIndex = cache;
 	maxRadius = maxR; 
-	maxRadiusNeg = -maxR; 
 	ch = ch_i;
 	ce = ce_i;
 }
@@ -30,6 +30,12 @@ void UpdateHField::handleData(int m, int n, int p)
 {
 	size_t i;
 	double hx,hy,hz;
+	if(_mask != NULL && (_mask[index] & (MASK_PMC | MASK_INACTIVE)))
+	{
+		//H is held
+		index++;
+		return;
+	}
 	//H = H - (dt/mu) Curl(E)
 	//    Curl(E)x = dEz/dy - dEy/dz
 	//    Curl(E)y = dEx/dz - dEz/dx
@@ -45,7 +51,7 @@ void UpdateHField::handleData(int m, int n, int p)
 	hy = -_field[index].E.z + _field[index].E.x;
 	hz = -_field[index].E.x + _field[index].E.y;
 	// handle p+1
-	if(p == maxRadius)
+	if(p == maxRadiusZ)
 	{
 		//at positive edge, p+1 not available, assume 0
 	}
@@ -56,7 +62,7 @@ void UpdateHField::handleData(int m, int n, int p)
 		hy -= _field[i].E.x;
 	}
 	//handle n+1
-	if(n == maxRadius)
+	if(n == maxRadiusY)
 	{
 		//at positive edge, n+1 not available, assume 0
 	}
@@ -67,7 +73,7 @@ void UpdateHField::handleData(int m, int n, int p)
 		hz += _field[i].E.x;
 	}
 	//handle m+1
-	if(m == maxRadius)
+	if(m == maxRadiusX)
 	{
 		//at positive edge, m+1 not available, assume 0
 	}
@@ -88,6 +94,12 @@ void UpdateEField::handleData(int m, int n, int p)
 {
 	size_t i;
 	double ex,ey,ez;
+	if(_mask != NULL && (_mask[index] & (MASK_PEC | MASK_INACTIVE)))
+	{
+		//E is held
+		index++;
+		return;
+	}
 	//E = E + (dt/eps) Curl(H)
 	//    Curl(H)x = dHz/dy - dHy/dz
 	//    Curl(H)y = dHx/dz - dHz/dx
@@ -102,7 +114,7 @@ void UpdateEField::handleData(int m, int n, int p)
 	ey = _field[index].H.x - _field[index].H.z;
 	ez = _field[index].H.y - _field[index].H.x;
 	//handle n-1
-	if(n == maxRadiusNeg)
+	if(n == -maxRadiusY)
 	{
 		//at negative edge, n-1 not available, assume 0
 	}
@@ -113,7 +125,7 @@ void UpdateEField::handleData(int m, int n, int p)
 		ex -= _field[i].H.z;
 	}
 	//handle p-1
-	if(p == maxRadiusNeg)
+	if(p == -maxRadiusZ)
 	{
 		//at negative edge, p-1 not available, assume 0
 	}
@@ -124,7 +136,7 @@ void UpdateEField::handleData(int m, int n, int p)
 		ey -= _field[i].H.x;
 	}
 	//handle m-1
-	if(m == maxRadiusNeg)
+	if(m == -maxRadiusX)
 	{
 		//at negative edge, m-1 not available, assume 0
 	}
@@ -8,21 +8,26 @@
 
 #include "..\EMField\EMField.h"
 #include "..\EMField\RadiusIndex.h"
+#include "..\EMField\MaterialMask.h"
 
 ///////////////////////////////////////////////////////////////////
 /*
-	advance field in time
+	advance field in time.
+	it works on a sphere via gothroughSphere or on a row-major box via gothroughBox;
+	edges are checked by maxRadiusX, maxRadiusY and maxRadiusZ set by the going-through function.
+	with a material mask, H is not updated at PMC and inactive points and E is not updated at PEC and inactive points
 */
 class UpdateField:public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
 {
 protected:
 	double ch, ce; //ch = (dt/ds)/mu0, ce = (dt/ds)/eps0
 	FieldPoint3D *_field;
-	int maxRadius, maxRadiusNeg;
+	const unsigned char *_mask; //kinds of points of a MaterialMask; NULL if not used
 public:
 	UpdateField();
 	void setMaxRadius(RadiusIndexToSeriesIndex *cache, int maxR, double ch_i, double ce_i);
 	void reset(FieldPoint3D *field);
+	void SetMask(const unsigned char *mask){_mask = mask;}
 	//
 	virtual void handleData(int m, int n, int p)=0;
 };
@@ -40,7 +40,18 @@ int YeeFDTD::PopulateFields(FieldsInitializer *fieldValues)
 {
 	int ret = ERR_OK;
 	PopulateYeeFieldsTime0 p(fieldValues, HE, ds);
-	ret = p.gothroughSphere(maxRadius, ds);
+	if(_boxDomain)
+	{
+		ret = p.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ, ds);
+	}
+	else
+	{
+		ret = p.gothroughSphere(maxRadius, ds);
+	}
+	if(ret == ERR_OK)
+	{
+		applyMaskToFields();
+	}
 	return ret;
 
 }
@@ -50,7 +61,18 @@ int YeeFDTD::setFieldValues(FieldsInitializer *fieldValues, double shiftX, doubl
 	int ret = ERR_OK;
 	PopulateYeeFieldsTime0 p(fieldValues, HE, ds);
 	p.setShifted(shiftX, shiftY, shiftZ);
-	ret = p.gothroughSphere(maxRadius, ds);
+	if(_boxDomain)
+	{
+		ret = p.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ, ds);
+	}
+	else
+	{
+		ret = p.gothroughSphere(maxRadius, ds);
+	}
+	if(ret == ERR_OK)
+	{
+		applyMaskToFields();
+	}
 	return ret;
 }
 
@@ -62,6 +84,8 @@ int YeeFDTD::onInitialized(TaskFile *taskParameters)
 	//
 	updateE.setMaxRadius(seriesIndex, maxRadius, ch, ce);
 	updateH.setMaxRadius(seriesIndex, maxRadius, ch, ce);
+	updateE.SetMask(_mask != NULL ? _mask->Kinds() : NULL);
+	updateH.SetMask(_mask != NULL ? _mask->Kinds() : NULL);
 	//
 	return ret;
 }
@@ -69,6 +93,7 @@ int YeeFDTD::onInitialized(TaskFile *taskParameters)
 int YeeFDTD::updateFieldsToMoveForward()
 {
 	int ret = ERR_OK;
+	bool faceFields = false;
 	//advance time indicators
 	_timeIndex++;
 	_time += dt;
@@ -84,7 +109,14 @@ int YeeFDTD::updateFieldsToMoveForward()
 			startTime = getTimeCount();
 		}
 		updateH.reset(HE);
-		ret = updateH.gothroughSphere(maxRadius);
+		if(_boxDomain)
+		{
+			ret = updateH.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+		}
+		else
+		{
+			ret = updateH.gothroughSphere(maxRadius);
+		}
 		if(_recordFDTDStepTimes)
 		{
 			endTime = getTimeCount(); timeUsed = endTime - startTime;
@@ -94,7 +126,18 @@ int YeeFDTD::updateFieldsToMoveForward()
 		{
 			if(_tfsf != NULL)
 			{
-				ret = _tfsf->applyTFSF(HE);
+				//E read by the H update is at the previous time index, H read by the E update is half a step later
+				ret = _tfsf->formFaceFields((double)_timeIndex - 1.0, (double)_timeIndex - 0.5);
+				if(ret == ERR_OK)
+				{
+					faceFields = true;
+					_tfsf->applyFaceFieldsH(HE, ch);
+				}
+				else if(ret == ERR_TFSF_INCIDENT)
+				{
+					//the TF/SF boundary does not give incident fields
+					ret = _tfsf->applyTFSF(HE);
+				}
 			}
 		}
 		//advance E next
@@ -105,7 +148,18 @@ int YeeFDTD::updateFieldsToMoveForward()
 				startTime = getTimeCount();
 			}
 			updateE.reset(HE);
-			ret = updateE.gothroughSphere(maxRadius);
+			if(_boxDomain)
+			{
+				ret = updateE.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+			}
+			else
+			{
+				ret = updateE.gothroughSphere(maxRadius);
+			}
+			if(ret == ERR_OK && faceFields)
+			{
+				_tfsf->applyFaceFieldsE(HE, ce);
+			}
 			if(_recordFDTDStepTimes)
 			{
 				endTime = getTimeCount(); 
@@ -36,7 +36,7 @@ public:
 	~YeeFDTD(void);
 	/*
 		it populates the fields with space poisition shifts.
-		it is used by YeeFDTDSpaceSynched to generate 6 YeeFDTD instances to get space-synchronized Yee estimations
+		with half space step shifts it gives a YeeFDTD instance whose components of one kind are at the grid points
 	*/
 	int setFieldValues(FieldsInitializer *fieldValues, double shiftX, double shiftY, double shiftZ);
 
@@ -46,6 +46,11 @@ public:
 		if special initialization is needed then override this function
 	*/
 	virtual int PopulateFields(FieldsInitializer *fieldValues);
+	//
+	//Yee's updates only use neighbours along axes; they work on a row-major box
+	virtual bool SupportBoxDomain(){return true;}
+	virtual bool IsStaggered(){return true;}
+	virtual bool SupportMaterialMask(){return true;}
 
 	virtual int updateFieldsToMoveForward();
 	virtual void OnFinishSimulation();
@@ -0,0 +1,755 @@
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+
+#include <Windows.h>
+#include "YeeFDTDRowMajor.h"
+#include <malloc.h>
+#include <math.h>
+#include <string.h>
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+
+#include "PopulateFields.h"
+#include "..\MemoryMan\memman.h"
+
+/*
+	thread function for the planes of one thread
+*/
+static DWORD WINAPI planeThread(LPVOID param)
+{
+	YeeRowWork *w = (YeeRowWork *)param;
+	w->owner->processPlanes(w);
+	return 0;
+}
+
+YeeFDTDRowMajor::YeeFDTDRowMajor(void)
+{
+	mu0 = 4.0 * M_PI * 1.0e-7;
+	eps0 = 1.0 /(mu0 * c0 * c0);
+	ch = ce = 0;
+	nx = ny = nz = 0;
+	sx = sy = 0;
+	_grid = NULL;
+	for(int c=0;c<6;c++)
+	{
+		_c[c] = NULL;
+	}
+	_series = NULL;
+	threadCount = 1;
+	_pinThreads = false;
+	for(int i=0;i<MAX_YEE_THREADS;i++)
+	{
+		works[i].owner = this;
+		works[i].index = i;
+		works[i].first = works[i].last = 0;
+		works[i].ret = ERR_OK;
+	}
+	_pass = YEE_PASS_GATHER;
+	_passE = _passH = true;
+	_faceFields = false;
+	_fieldsAt = YEE_FIELDS_IN_HE;
+	_timeBlock = 1;
+	abccoef = 0;
+	_abc = NULL;
+	eyx0 = ezx0 = eyx1 = ezx1 = exy0 = ezy0 = exy1 = ezy1 = exz0 = eyz0 = exz1 = eyz1 = NULL;
+}
+YeeFDTDRowMajor::~YeeFDTDRowMajor(void)
+{
+	cleanup();
+}
+
+void YeeFDTDRowMajor::cleanup()
+{
+	if(_grid != NULL)
+	{
+		FreeMemory(_grid);
+		_grid = NULL;
+	}
+	for(int c=0;c<6;c++)
+	{
+		_c[c] = NULL;
+	}
+	if(_series != NULL)
+	{
+		FreeMemory(_series);
+		_series = NULL;
+	}
+	if(_abc != NULL)
+	{
+		FreeMemory(_abc);
+		_abc = NULL;
+	}
+	eyx0 = ezx0 = eyx1 = ezx1 = exy0 = ezy0 = exy1 = ezy1 = exz0 = eyz0 = exz1 = eyz1 = NULL;
+}
+
+void YeeFDTDRowMajor::OnFinishSimulation()
+{
+	//the fields at the maximum time index stay in HE
+	scatterFields();
+	cleanup();
+}
+
+/*
+	copy the grid to HE if the grid is newer
+*/
+void YeeFDTDRowMajor::scatterFields()
+{
+	if(_fieldsAt == YEE_FIELDS_IN_GRID && _grid != NULL)
+	{
+		if(runPass(YEE_PASS_SCATTER, true, true) != ERR_OK)
+		{
+			//threads cannot be created; copy on this thread
+			for(int i=0;i<nx;i++)
+			{
+				copyPlane(i, false);
+			}
+		}
+		_fieldsAt = YEE_FIELDS_SAME;
+	}
+}
+
+FieldPoint3D *YeeFDTDRowMajor::GetFieldMemory()
+{
+	scatterFields();
+	if(_grid != NULL)
+	{
+		_fieldsAt = YEE_FIELDS_IN_HE;
+	}
+	return HE;
+}
+
+int YeeFDTDRowMajor::PopulateFields(FieldsInitializer *fieldValues)
+{
+	int ret = ERR_OK;
+	PopulateYeeFieldsTime0 p(fieldValues, HE, ds);
+	if(_boxDomain)
+	{
+		ret = p.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ, ds);
+	}
+	else
+	{
+		ret = p.gothroughSphere(maxRadius, ds);
+	}
+	_fieldsAt = YEE_FIELDS_IN_HE;
+	return ret;
+}
+
+int YeeFDTDRowMajor::onInitialized(TaskFile *taskParameters)
+{
+	int ret = ERR_OK;
+	cleanup();
+	ch = (dt/ds)/mu0;
+	ce = (dt/ds)/eps0;
+	_fieldsAt = YEE_FIELDS_IN_HE;
+	threadCount = (int)taskParameters->getUInt(TP_FDTD_THREADS, true);
+	_timeBlock = taskParameters->getUInt(TP_FDTD_TIME_BLOCK, true);
+	_pinThreads = taskParameters->getBoolean(TP_FDTD_PIN_THREADS, true);
+	ret = taskParameters->getErrorCode();
+	if(ret == ERR_OK)
+	{
+		if(_timeBlock == 0)
+		{
+			_timeBlock = 1;
+		}
+		else if(_timeBlock > 1 && _tfsf != NULL)
+		{
+			//H must be given to the TF/SF boundary between the steps
+			ret = ERR_EMF_TIME_BLOCK;
+		}
+		else if(_timeBlock > 1 && !_boxDomain)
+		{
+			//on a cubic domain AbcFirstOrder visits the faces by radius, in an order the sweep cannot follow
+			ret = ERR_EMF_TIME_BLOCK;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		size_t items;
+		nx = 2 * maxRadiusX + 1;
+		ny = 2 * maxRadiusY + 1;
+		nz = 2 * maxRadiusZ + 1;
+		sy = (size_t)(nz + 2);
+		sx = (size_t)(ny + 2) * sy;
+		items = (size_t)(nx + 2) * sx;
+		_grid = (double *)AllocateTaggedMemory(6 * items * sizeof(double), MEM_TAG_FIELDS);
+		if(_grid == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			//the grid is zeroed by YEE_PASS_TOUCH; the face layers stay 0
+			for(int c=0;c<6;c++)
+			{
+				_c[c] = _grid + c * items;
+			}
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		//memory indexes of HE in the row-major order of the grid, formed by YEE_PASS_TOUCH
+		_series = (size_t *)AllocateTaggedMemory((size_t)nx * (size_t)ny * (size_t)nz * sizeof(size_t), MEM_TAG_CURLS);
+		if(_series == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+	}
+	if(ret == ERR_OK)
+	{
+		if(threadCount == 0)
+		{
+			SYSTEM_INFO si;
+			GetSystemInfo(&si);
+			threadCount = (int)si.dwNumberOfProcessors;
+		}
+		if(threadCount > MAX_YEE_THREADS) threadCount = MAX_YEE_THREADS;
+		if(threadCount > nx) threadCount = nx;
+		for(int i=0;i<threadCount;i++)
+		{
+			//contiguous blocks of planes
+			works[i].first = (int)(((size_t)nx * i) / threadCount);
+			works[i].last = (int)(((size_t)nx * (i + 1)) / threadCount);
+		}
+		ret = runPass(YEE_PASS_TOUCH, true, true);
+	}
+	if(ret == ERR_OK && _timeBlock > 1)
+	{
+		//boundary planes of the first order ABC, starting at 0 as AbcFirstOrder does
+		size_t sizeX = (size_t)ny * (size_t)nz;
+		size_t sizeY = (size_t)nx * (size_t)nz;
+		size_t sizeZ = (size_t)nx * (size_t)ny;
+		size_t size = 4 * (sizeX + sizeY + sizeZ);
+		abccoef = (courant - 1.0) / (courant + 1.0);
+		_abc = (double *)AllocateTaggedMemory(size * sizeof(double), MEM_TAG_FIELDS);
+		if(_abc == NULL)
+		{
+			ret = ERR_OUTOFMEMORY;
+		}
+		else
+		{
+			memset(_abc, 0, size * sizeof(double));
+			eyx0 = _abc; ezx0 = eyx0 + sizeX; eyx1 = ezx0 + sizeX; ezx1 = eyx1 + sizeX;
+			exy0 = ezx1 + sizeX; ezy0 = exy0 + sizeY; exy1 = ezy0 + sizeY; ezy1 = exy1 + sizeY;
+			exz0 = ezy1 + sizeY; eyz0 = exz0 + sizeZ; exz1 = eyz0 + sizeZ; eyz1 = exz1 + sizeZ;
+		}
+	}
+	return ret;
+}
+
+/*
+	zero x-plane i of the grid and form the memory indexes of the plane; a box domain gives 0, 1, 2, ...
+	the thread of plane 0 also zeroes the face layer before it, and the thread of plane nx-1 the face layer after it
+*/
+void YeeFDTDRowMajor::touchPlane(int i)
+{
+	size_t k = (size_t)i * (size_t)ny * (size_t)nz;
+	int m = i - (int)maxRadiusX;
+	for(int c=0;c<6;c++)
+	{
+		memset(_c[c] + (size_t)(i + 1) * sx, 0, sx * sizeof(double));
+		if(i == 0)
+		{
+			memset(_c[c], 0, sx * sizeof(double));
+		}
+		if(i == nx - 1)
+		{
+			memset(_c[c] + (size_t)(nx + 1) * sx, 0, sx * sizeof(double));
+		}
+	}
+	for(int n=-(int)maxRadiusY;n<=(int)maxRadiusY;n++)
+	{
+		for(int p=-(int)maxRadiusZ;p<=(int)maxRadiusZ;p++)
+		{
+			_series[k++] = SINDEX(m, n, p);
+		}
+	}
+}
+
+/*
+	copy x-plane i between HE and the grid
+*/
+void YeeFDTDRowMajor::copyPlane(int i, bool toGrid)
+{
+	size_t g, s = (size_t)i * (size_t)ny * (size_t)nz;
+	const size_t *a;
+	for(int j=0;j<ny;j++,s+=nz)
+	{
+		g = (size_t)(i + 1) * sx + (size_t)(j + 1) * sy + 1;
+		a = _series + s;
+		//E and H are separate loops so that each loop has 3 streams of the grid
+		for(int c=0;c<6;c+=3)
+		{
+			if((c == 0 && !_passE) || (c == 3 && !_passH))
+			{
+				continue;
+			}
+			double * __restrict fx = _c[c] + g;
+			double * __restrict fy = _c[c+1] + g;
+			double * __restrict fz = _c[c+2] + g;
+			double *f;
+			if(toGrid)
+			{
+				for(int k=0;k<nz;k++)
+				{
+					f = (double *)&(HE[a[k]]) + c;
+					fx[k] = f[0];
+					fy[k] = f[1];
+					fz[k] = f[2];
+				}
+			}
+			else
+			{
+				for(int k=0;k<nz;k++)
+				{
+					f = (double *)&(HE[a[k]]) + c;
+					f[0] = fx[k];
+					f[1] = fy[k];
+					f[2] = fz[k];
+				}
+			}
+		}
+	}
+}
+
+/*
+	the same as UpdateHField::handleData; a neighbour beyond the positive faces is 0
+*/
+void YeeFDTDRowMajor::updateHPlane(int i)
+{
+	const size_t by = sy, bx = sx;
+	const double h = ch;
+	for(int j=0;j<ny;j++)
+	{
+		size_t g = (size_t)(i + 1) * sx + (size_t)(j + 1) * sy + 1;
+		const double * __restrict ex = _c[0] + g;
+		const double * __restrict ey = _c[1] + g;
+		const double * __restrict ez = _c[2] + g;
+		double * __restrict hx = _c[3] + g;
+		double * __restrict hy = _c[4] + g;
+		double * __restrict hz = _c[5] + g;
+		for(int k=0;k<nz;k++)
+		{
+			hx[k] += (((-ey[k] + ez[k]) + ey[k+1]) - ez[k+by]) * h;
+			hy[k] += (((-ez[k] + ex[k]) - ex[k+1]) + ez[k+bx]) * h;
+			hz[k] += (((-ex[k] + ey[k]) + ex[k+by]) - ey[k+bx]) * h;
+		}
+		if(_faceFields)
+		{
+			correctRow(i, j, g, true);
+		}
+	}
+}
+
+/*
+	the same as UpdateEField::handleData; a neighbour beyond the negative faces is 0
+*/
+void YeeFDTDRowMajor::updateEPlane(int i)
+{
+	const size_t by = sy, bx = sx;
+	const double e = ce;
+	for(int j=0;j<ny;j++)
+	{
+		size_t g = (size_t)(i + 1) * sx + (size_t)(j + 1) * sy + 1;
+		double * __restrict ex = _c[0] + g;
+		double * __restrict ey = _c[1] + g;
+		double * __restrict ez = _c[2] + g;
+		const double * __restrict hx = _c[3] + g;
+		const double * __restrict hy = _c[4] + g;
+		const double * __restrict hz = _c[5] + g;
+		for(int k=0;k<nz;k++)
+		{
+			ex[k] += (((hz[k] - hy[k]) - hz[k-by]) + hy[k-1]) * e;
+			ey[k] += (((hx[k] - hz[k]) - hx[k-1]) + hz[k-bx]) * e;
+			ez[k] += (((hy[k] - hx[k]) + hx[k-by]) - hy[k-bx]) * e;
+		}
+		if(_faceFields)
+		{
+			correctRow(i, j, g, false);
+		}
+	}
+}
+
+/*
+	correct H, or E, of row (i,j) at the TF/SF faces; g is the grid index of point (i,j,0).
+	it makes the same corrections as TotalFieldScatteredFieldBoundary::applyFaceFieldsH/applyFaceFieldsE,
+	with the faces in the same order, so the results are the same as those of YeeFDTD
+*/
+void YeeFDTDRowMajor::correctRow(int i, int j, size_t g, bool forH)
+{
+	int h, e, at;
+	size_t offset;
+	double sign, s;
+	int fi0 = _tfsf->getFaceFirst(0), fi1 = _tfsf->getFaceLast(0);
+	int fj0 = _tfsf->getFaceFirst(1), fj1 = _tfsf->getFaceLast(1);
+	int fk0 = _tfsf->getFaceFirst(2), fk1 = _tfsf->getFaceLast(2);
+	const double coef = forH?ch:ce;
+	const double *line;
+	double *t;
+	for(int f=0;f<6;f++)
+	{
+		if(!_tfsf->FaceExists(f))
+		{
+			continue;
+		}
+		int a = f / 2;
+		//H is corrected at the point of a pair with the smaller index, E at the other
+		at = _tfsf->GetFaceLow(f) + (forH?0:1);
+		if(a == 0)
+		{
+			if(i != at || j < fj0 || j > fj1)
+			{
+				continue;
+			}
+			offset = (size_t)(j - fj0) * (size_t)(fk1 - fk0 + 1);
+		}
+		else if(a == 1)
+		{
+			if(j != at || i < fi0 || i > fi1)
+			{
+				continue;
+			}
+			offset = (size_t)(i - fi0) * (size_t)(fk1 - fk0 + 1);
+		}
+		else
+		{
+			if(i < fi0 || i > fi1 || j < fj0 || j > fj1)
+			{
+				continue;
+			}
+			offset = (size_t)(i - fi0) * (size_t)(fj1 - fj0 + 1) + (size_t)(j - fj0);
+		}
+		for(int term=0;term<2;term++)
+		{
+			TotalFieldScatteredFieldBoundary::FaceTerm(a, term, &h, &e, &sign);
+			s = (f % 2 == 0)?sign * coef:-sign * coef;
+			t = forH?(_c[3 + h] + g):(_c[e] + g);
+			line = _tfsf->GetFaceLine(f, forH, term) + offset;
+			if(a == 2)
+			{
+				//one point of the row
+				t[at] += s * line[0];
+			}
+			else
+			{
+				for(int k=fk0;k<=fk1;k++)
+				{
+					t[k] += s * line[k - fk0];
+				}
+			}
+		}
+	}
+}
+
+/*
+	the same as AbcFirstOrder::handleData at grid point (i,j,k), which is at a face
+*/
+void YeeFDTDRowMajor::abcPoint(int i, int j, int k)
+{
+	double * __restrict ex = _c[0];
+	double * __restrict ey = _c[1];
+	double * __restrict ez = _c[2];
+	size_t g = (size_t)(i + 1) * sx + (size_t)(j + 1) * sy + (size_t)(k + 1);
+	size_t g2, a;
+	if(i == 0)
+	{
+		a = (size_t)k + (size_t)nz * (size_t)j;
+		g2 = g + sx;
+		ey[g] = eyx0[a] + abccoef * (ey[g2] - ey[g]);
+		eyx0[a] = ey[g2];
+		ez[g] = ezx0[a] + abccoef * (ez[g2] - ez[g]);
+		ezx0[a] = ez[g2];
+	}
+	else if(i == nx - 1)
+	{
+		a = (size_t)k + (size_t)nz * (size_t)j;
+		g2 = g - sx;
+		ey[g] = eyx1[a] + abccoef * (ey[g2] - ey[g]);
+		eyx1[a] = ey[g2];
+		ez[g] = ezx1[a] + abccoef * (ez[g2] - ez[g]);
+		ezx1[a] = ez[g2];
+	}
+	if(j == 0)
+	{
+		a = (size_t)k + (size_t)nz * (size_t)i;
+		g2 = g + sy;
+		ex[g] = exy0[a] + abccoef * (ex[g2] - ex[g]);
+		exy0[a] = ex[g2];
+		ez[g] = ezy0[a] + abccoef * (ez[g2] - ez[g]);
+		ezy0[a] = ez[g2];
+	}
+	else if(j == ny - 1)
+	{
+		a = (size_t)k + (size_t)nz * (size_t)i;
+		g2 = g - sy;
+		ex[g] = exy1[a] + abccoef * (ex[g2] - ex[g]);
+		exy1[a] = ex[g2];
+		ez[g] = ezy1[a] + abccoef * (ez[g2] - ez[g]);
+		ezy1[a] = ez[g2];
+	}
+	if(k == 0)
+	{
+		a = (size_t)j + (size_t)ny * (size_t)i;
+		g2 = g + 1;
+		ex[g] = exz0[a] + abccoef * (ex[g2] - ex[g]);
+		exz0[a] = ex[g2];
+		ey[g] = eyz0[a] + abccoef * (ey[g2] - ey[g]);
+		eyz0[a] = ey[g2];
+	}
+	else if(k == nz - 1)
+	{
+		a = (size_t)j + (size_t)ny * (size_t)i;
+		g2 = g - 1;
+		ex[g] = exz1[a] + abccoef * (ex[g2] - ex[g]);
+		exz1[a] = ex[g2];
+		ey[g] = eyz1[a] + abccoef * (ey[g2] - ey[g]);
+		eyz1[a] = ey[g2];
+	}
+}
+
+/*
+	first order ABC at the face points of x-plane i, in the row-major order of gothroughBoxFaces
+*/
+void YeeFDTDRowMajor::abcPlane(int i)
+{
+	bool onX = (i == 0 || i == nx - 1);
+	for(int j=0;j<ny;j++)
+	{
+		if(onX || j == 0 || j == ny - 1)
+		{
+			for(int k=0;k<nz;k++)
+			{
+				abcPoint(i, j, k);
+			}
+		}
+		else
+		{
+			abcPoint(i, j, 0);
+			if(nz > 1)
+			{
+				abcPoint(i, j, nz - 1);
+			}
+		}
+	}
+}
+
+/*
+	advance the grid by steps time steps in one sweep over the x-planes.
+	at sweep position f, step s (0-based) works on plane a = f - 3s: H of plane a, E of plane a-1 and the ABC of
+	plane a-2. H of plane a reads E of planes a and a+1 after the ABC of step s-1, which is done at the same position
+	just before; E of plane a-1 reads H of planes a-1 and a-2; the ABC of plane a-2 reads E of planes a-3, a-2 and a-1.
+	a plane is overwritten only after all of its readers of the previous step are done
+*/
+void YeeFDTDRowMajor::sweepBlock(unsigned steps)
+{
+	int a;
+	int last = nx + 2 + 3 * ((int)steps - 1);
+	for(int f=0;f<last;f++)
+	{
+		for(int s=0;s<(int)steps;s++)
+		{
+			a = f - 3 * s;
+			if(a < 0)
+			{
+				//later steps have not started
+				break;
+			}
+			if(a < nx)
+			{
+				updateHPlane(a);
+			}
+			if(a - 1 >= 0 && a - 1 < nx)
+			{
+				updateEPlane(a - 1);
+			}
+			if(a - 2 >= 0 && a - 2 < nx)
+			{
+				abcPlane(a - 2);
+			}
+		}
+	}
+}
+
+void YeeFDTDRowMajor::processPlanes(YeeRowWork *w)
+{
+	w->ret = ERR_OK;
+	if(_pinThreads && threadCount > 1)
+	{
+		//a thread of every pass works on the same planes on the same processor
+		w->ret = PinThreadToNode(w->index, threadCount);
+		if(w->ret != ERR_OK)
+		{
+			return;
+		}
+	}
+	for(int i=w->first;i<w->last;i++)
+	{
+		switch(_pass)
+		{
+		case YEE_PASS_GATHER:
+			copyPlane(i, true);
+			break;
+		case YEE_PASS_H:
+			updateHPlane(i);
+			break;
+		case YEE_PASS_E:
+			updateEPlane(i);
+			break;
+		case YEE_PASS_SCATTER:
+			copyPlane(i, false);
+			break;
+		case YEE_PASS_TOUCH:
+			touchPlane(i);
+			break;
+		}
+	}
+}
+
+/*
+	a pass over all the planes. planes are independent in every pass:
+	an H pass only changes H and reads E, an E pass only changes E and reads H
+*/
+int YeeFDTDRowMajor::runPass(int pass, bool withE, bool withH)
+{
+	int ret = ERR_OK;
+	_pass = pass;
+	_passE = withE;
+	_passH = withH;
+	if(threadCount == 1)
+	{
+		processPlanes(&(works[0]));
+		ret = works[0].ret;
+	}
+	else
+	{
+		HANDLE threads[MAX_YEE_THREADS];
+		DWORD count = 0;
+		for(int i=0;i<threadCount;i++)
+		{
+			threads[count] = CreateThread(NULL, 0, planeThread, &(works[i]), 0, NULL);
+			if(threads[count] == NULL)
+			{
+				RememberOSerror();
+				ret = ERR_YEE_THREAD;
+				break;
+			}
+			count++;
+		}
+		if(count > 0)
+		{
+			WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+			for(DWORD i=0;i<count;i++)
+			{
+				CloseHandle(threads[i]);
+			}
+		}
+		for(DWORD i=0;i<count && ret == ERR_OK;i++)
+		{
+			ret = works[i].ret;
+		}
+	}
+	return ret;
+}
+
+int YeeFDTDRowMajor::updateFieldsToMoveForward()
+{
+	int ret = ERR_OK;
+	unsigned steps = 1;
+	if(_timeBlock > 1)
+	{
+		//the last sweep stops at the maximum time index
+		steps = _timeBlock;
+		if(_maximumTimeIndex > _timeIndex && _timeIndex + steps > _maximumTimeIndex)
+		{
+			steps = (unsigned)(_maximumTimeIndex - _timeIndex);
+		}
+	}
+	//advance time indicators
+	for(unsigned s=0;s<steps;s++)
+	{
+		_timeIndex++;
+		_time += dt;
+	}
+	//save existing fields to a file and allocating new memory.
+	//it will copy the existing fields to new memory.
+	//fields are still at a time of _time-dt2.
+	ret = allocateFieldMemory();
+	if(ret == ERR_OK)
+	{
+		if(_recordFDTDStepTimes)
+		{
+			startTime = getTimeCount();
+		}
+		if(_fieldsAt == YEE_FIELDS_IN_HE)
+		{
+			//HE may have been changed by field sources and boundary conditions
+			ret = runPass(YEE_PASS_GATHER, true, true);
+		}
+		_fieldsAt = YEE_FIELDS_IN_GRID;
+		_faceFields = false;
+		if(ret == ERR_OK && _tfsf != NULL)
+		{
+			//E read by the H update is at the previous time index, H read by the E update is half a step later
+			ret = _tfsf->formFaceFields((double)_timeIndex - 1.0, (double)_timeIndex - 0.5);
+			if(ret == ERR_OK)
+			{
+				_faceFields = true;
+			}
+			else if(ret == ERR_TFSF_INCIDENT)
+			{
+				//the TF/SF boundary does not give incident fields; it is applied by applyTFSF
+				ret = ERR_OK;
+			}
+		}
+		if(ret == ERR_OK && _timeBlock > 1)
+		{
+			//H, E and the ABC of all the steps
+			sweepBlock(steps);
+		}
+		else
+		{
+			//advance H first
+			if(ret == ERR_OK)
+			{
+				ret = runPass(YEE_PASS_H, false, false);
+			}
+			if(ret == ERR_OK && _tfsf != NULL && !_faceFields)
+			{
+				//HE is given to applyTFSF as YeeFDTD gives it: H advanced, E not yet
+				ret = runPass(YEE_PASS_SCATTER, true, true);
+				if(ret == ERR_OK)
+				{
+					ret = _tfsf->applyTFSF(HE);
+				}
+				if(ret == ERR_OK)
+				{
+					ret = runPass(YEE_PASS_GATHER, false, true);
+				}
+			}
+			//advance E next
+			if(ret == ERR_OK)
+			{
+				ret = runPass(YEE_PASS_E, false, false);
+			}
+		}
+		if(ret == ERR_OK && _basefilename != NULL)
+		{
+			//the data file of the next step is made from HE
+			ret = runPass(YEE_PASS_SCATTER, true, true);
+			if(ret == ERR_OK)
+			{
+				_fieldsAt = YEE_FIELDS_SAME;
+			}
+		}
+		if(_recordFDTDStepTimes)
+		{
+			endTime = getTimeCount(); timeUsed = endTime - startTime;
+			_sumtimeused += timeUsed;
+			_timesteps += steps;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,148 @@
+#pragma once
+/*******************************************************************
+	Author: Bob Limnor (bob@limnor.com, aka Wei Ge)
+	Last modified: 03/31/2018
+	Allrights reserved by Bob Limnor
+
+********************************************************************/
+
+#include "..\EMField\EMField.h"
+#include "..\EMField\FdtdMemory.h"
+#include "..\EMField\RadiusIndex.h"
+#include "..\EMField\FDTD.h"
+
+#define ERR_YEE_THREAD 2201
+
+//largest number of threads; it is the limit of WaitForMultipleObjects
+#define MAX_YEE_THREADS 64
+
+//what YeeFDTDRowMajor::processPlanes does
+#define YEE_PASS_GATHER  0 //copy HE into the row-major grid
+#define YEE_PASS_H       1 //advance H
+#define YEE_PASS_E       2 //advance E
+#define YEE_PASS_SCATTER 3 //copy the row-major grid into HE
+#define YEE_PASS_TOUCH   4 //zero the grid and form the memory indexes, so that each thread first touches its own planes
+
+//where the current fields are
+#define YEE_FIELDS_SAME    0 //HE and the grid hold the same fields
+#define YEE_FIELDS_IN_HE   1 //HE is newer: it has been populated, replaced or given out by GetFieldMemory
+#define YEE_FIELDS_IN_GRID 2 //the grid is newer: HE is copied out only when it is asked for
+
+class YeeFDTDRowMajor;
+
+/*
+	work of one thread: x-planes first to last-1 of a pass
+*/
+typedef struct YeeRowWork
+{
+	YeeFDTDRowMajor *owner;
+	int index;
+	int first;
+	int last;
+	int ret;
+}YeeRowWork;
+
+/*
+	Yee's FDTD algorithm on contiguous row-major arrays.
+
+	it does the same calculations as YeeFDTD, in the same order for each component, so the results are the same.
+	each field component is kept in its own array of (nx+2)*(ny+2)*(nz+2) doubles, z changing fastest; the extra layer
+	at each face is 0 so that a point at a face uses the same code as the other points, and the inner loop along z
+	is a unit-stride loop without branches which a compiler vectorizes. the x-planes are shared by FDTD.THREADS threads.
+	the grid and the memory indexes are zeroed and formed by the same threads, over the same planes, as the passes
+	that sweep them, so on a NUMA computer the pages of a block of planes are placed on the node of the thread working
+	on it. FDTD.PIN_THREADS=true pins the threads to processors spread over the nodes so that they stay there.
+
+	the arrays are the fields between time steps; HE is still the fields seen by data files, field sources, boundary
+	conditions, TF/SF boundaries and simulators. HE is only copied out of the arrays when it is needed: at every step when
+	data files are written, and when GetFieldMemory is called, which a simulator does after a step when it applies a field
+	source or a boundary condition or reads the fields. HE given out may be changed, so the next step copies it back into
+	the arrays first. a simulation without data files, field sources and boundary conditions on HE, such as one using
+	FDTD.TIME_BLOCK, copies HE in once at the start and out once at the end. the copies are streaming loops over memory.
+	a TF/SF boundary giving incident fields is applied within the passes: after a row of H or E is updated, the points
+	of the row at the faces of the TF region are corrected by the incident fields of TotalFieldScatteredFieldBoundary::formFaceFields,
+	the same as applyFaceFieldsH and applyFaceFieldsE do for YeeFDTD. for other TF/SF boundaries H is copied out and in
+	around applyTFSF.
+	a material mask is not supported.
+
+	FDTD.TIME_BLOCK = K > 1 makes one moveForward advance K time steps in one sweep over the x-planes, so the grid
+	is read from and written to memory once for K steps instead of K times. step s works 3 planes behind step s-1:
+	at each position of the sweep, step s advances H of plane a, E of plane a-1 and applies a first order ABC to
+	plane a-2, which only needs planes step s-1 has finished. the ABC is done by this class, with the formulas and
+	the point order of AbcFirstOrder on a box domain, so the fields are the same as those of K single steps each
+	followed by AbcFirstOrder. it is only supported on a box domain: on a cubic domain AbcFirstOrder visits the faces
+	by radius and reads some edge neighbours after they are updated instead of before, which the sweep cannot follow.
+	field sources and TF/SF boundaries are not supported. the sweep is done by one thread whatever FDTD.THREADS is,
+	and a block of planes is only kept in cache when 3K planes fit in it
+*/
+class YeeFDTDRowMajor: public virtual FDTD
+{
+private:
+	double mu0;  //Permeability
+	double eps0; //Permittivity
+	//
+	double ch, ce; //ch = (dt/ds)/mu0, ce = (dt/ds)/eps0
+	//
+	int nx, ny, nz;      //grid points along each axis
+	size_t sx, sy;       //strides of x and y in a component array; the stride of z is 1
+	double *_grid;       //6 component arrays
+	double *_c[6];       //Ex, Ey, Ez, Hx, Hy, Hz in _grid
+	size_t *_series;     //[nx*ny*nz], memory index in HE of each grid point
+	//
+	int threadCount;     //FDTD.THREADS
+	bool _pinThreads;    //FDTD.PIN_THREADS
+	YeeRowWork works[MAX_YEE_THREADS];
+	//
+	//time blocking
+	unsigned _timeBlock; //FDTD.TIME_BLOCK, time steps of one sweep
+	double abccoef;      //(courant-1)/(courant+1), the same as AbcFirstOrder
+	double *_abc;        //memory of the 12 boundary planes below
+	double *eyx0, *ezx0, *eyx1, *ezx1; //planes perpendicular to x, (j,k) at k+nz*j
+	double *exy0, *ezy0, *exy1, *ezy1; //planes perpendicular to y, (i,k) at k+nz*i
+	double *exz0, *eyz0, *exz1, *eyz1; //planes perpendicular to z, (i,j) at j+ny*i
+	//
+	//current pass
+	int _pass;
+	bool _passE;         //gather and scatter E
+	bool _passH;         //gather and scatter H
+	bool _faceFields;    //the H and E passes apply the incident fields at the TF/SF faces
+	//
+	int _fieldsAt;       //YEE_FIELDS_SAME, YEE_FIELDS_IN_HE or YEE_FIELDS_IN_GRID
+	void scatterFields();
+	//
+	int runPass(int pass, bool withE, bool withH);
+	void copyPlane(int i, bool toGrid);
+	void touchPlane(int i);
+	void updateHPlane(int i);
+	void updateEPlane(int i);
+	void correctRow(int i, int j, size_t g, bool forH);
+	void abcPoint(int i, int j, int k);
+	void abcPlane(int i);
+	void sweepBlock(unsigned steps);
+protected:
+	virtual void cleanup();
+	virtual int onInitialized(TaskFile *taskParameters); //called after initialize(...) returns ERR_OK
+	virtual int onFieldsReplaced(){_fieldsAt = YEE_FIELDS_IN_HE; return ERR_OK;}
+
+public:
+	YeeFDTDRowMajor(void);
+	~YeeFDTDRowMajor(void);
+	//
+	virtual int PopulateFields(FieldsInitializer *fieldValues);
+	/*
+		copy the grid out to HE if the grid is newer. the caller may change HE, so the next step copies it back first
+	*/
+	virtual FieldPoint3D *GetFieldMemory();
+	//
+	virtual bool SupportBoxDomain(){return true;}
+	virtual bool IsStaggered(){return true;}
+	virtual unsigned GetStepsPerMove(){return _timeBlock;}
+
+	virtual int updateFieldsToMoveForward();
+	virtual void OnFinishSimulation();
+	//
+	/*
+		do the planes of w for the current pass. it is called by a thread of a pass
+	*/
+	void processPlanes(YeeRowWork *w);
+};
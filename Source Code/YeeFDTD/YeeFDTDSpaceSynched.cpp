@@ -9,129 +9,91 @@
 #include "YeeFDTDSpaceSynched.h"
 #include "..\MemoryMan\memman.h"
 
+SynchronizeYeeFields::SynchronizeYeeFields(void)
+{
+	_yee = NULL;
+	_synched = NULL;
+}
+void SynchronizeYeeFields::reset(FieldPoint3D *yee, FieldPoint3D *synched)
+{
+	_yee = yee;
+	_synched = synched;
+	index = 0;
+}
+void SynchronizeYeeFields::handleData(int m, int n, int p)
+{
+	//Ex is at (m+1/2,n,p), Ey at (m,n+1/2,p), Ez at (m,n,p+1/2)
+	//Hx is at (m,n+1/2,p+1/2), Hy at (m+1/2,n,p+1/2), Hz at (m+1/2,n+1/2,p)
+	//the value at (m,n,p) is the average of the values around it
+	int m1 = (m == -maxRadiusX)? m : m - 1;
+	int n1 = (n == -maxRadiusY)? n : n - 1;
+	int p1 = (p == -maxRadiusZ)? p : p - 1;
+	FieldPoint3D *f = &(_yee[index]);
+	FieldPoint3D *fm = &(_yee[seriesIndex->Index(m1,n,p)]);
+	FieldPoint3D *fn = &(_yee[seriesIndex->Index(m,n1,p)]);
+	FieldPoint3D *fp = &(_yee[seriesIndex->Index(m,n,p1)]);
+	//
+	_synched[index].E.x = 0.5 * (f->E.x + fm->E.x);
+	_synched[index].E.y = 0.5 * (f->E.y + fn->E.y);
+	_synched[index].E.z = 0.5 * (f->E.z + fp->E.z);
+	_synched[index].H.x = 0.25 * (f->H.x + fn->H.x + fp->H.x + _yee[seriesIndex->Index(m,n1,p1)].H.x);
+	_synched[index].H.y = 0.25 * (f->H.y + fm->H.y + fp->H.y + _yee[seriesIndex->Index(m1,n,p1)].H.y);
+	_synched[index].H.z = 0.25 * (f->H.z + fm->H.z + fn->H.z + _yee[seriesIndex->Index(m1,n1,p)].H.z);
+	//
+	index++;
+}
+
 YeeFDTDSpaceSynched::YeeFDTDSpaceSynched(void)
 {
-	yeeEx = NULL;
-	yeeEy = NULL;
-	yeeEz = NULL;
-	yeeHx = NULL;
-	yeeHy = NULL;
-	yeeHz = NULL;
+	yee = NULL;
 	ret = ERR_OK;
 }
 YeeFDTDSpaceSynched::~YeeFDTDSpaceSynched()
 {
-	delete yeeEx;
-	delete yeeEy;
-	delete yeeEz;
-	delete yeeHx;
-	delete yeeHy;
-	delete yeeHz;
+	delete yee;
 }
 void YeeFDTDSpaceSynched::cleanup(void)
 {
 }
 int YeeFDTDSpaceSynched::onInitialized(TaskFile *taskParameters)
 {
-	freeFieldMemory(); //initialize(...) allocated memory, we do not need it here
-	yeeEx = new YeeFDTD();
-	yeeEy = new YeeFDTD();
-	yeeEz = new YeeFDTD();
-	yeeHx = new YeeFDTD();
-	yeeHy = new YeeFDTD();
-	yeeHz = new YeeFDTD();
-	//
-	shareIndexCacheTo(yeeEx);
-	shareIndexCacheTo(yeeEy);
-	shareIndexCacheTo(yeeEz);
-	shareIndexCacheTo(yeeHx);
-	shareIndexCacheTo(yeeHy);
-	shareIndexCacheTo(yeeHz);
-	//
-	yeeEx->SetMemoryManager(_mem);
-	yeeEy->SetMemoryManager(_mem);
-	yeeEz->SetMemoryManager(_mem);
-	yeeHx->SetMemoryManager(_mem);
-	yeeHy->SetMemoryManager(_mem);
-	yeeHz->SetMemoryManager(_mem);
-	//
-	ds2 = ds / 2.0; //for making shift
-	ret = yeeEx->initialize(NULL, _tfsf, taskParameters);
-	if(ret == ERR_OK)
-	{
-		ret = yeeEy->initialize(NULL, _tfsf, taskParameters);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeEz->initialize(NULL, _tfsf, taskParameters);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHx->initialize(NULL, _tfsf, taskParameters);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHy->initialize(NULL, _tfsf, taskParameters);
-	}
+	//HE allocated by initialize(...) holds the space-synchronized fields
+	yee = new YeeFDTD();
+	shareIndexCacheTo(yee);
+	yee->SetMemoryManager(_mem);
+	//the staggered fields are not recorded
+	ret = yee->initialize(NULL, _tfsf, taskParameters);
 	if(ret == ERR_OK)
 	{
-		ret = yeeHz->initialize(NULL, _tfsf, taskParameters);
+		synch.setMaxRadius(seriesIndex, maxRadius);
 	}
 	return ret;
 }
+/*
+	interpolate the fields of the YeeFDTD instance into HE
+*/
 int YeeFDTDSpaceSynched::formSpaceSynchedFields()
 {
-	ret = allocateFieldMemory(); //create a memory mapped file, memory point is HE
-	if(ret == ERR_OK)
+	synch.reset(yee->GetFieldMemory(), HE);
+	if(_boxDomain)
 	{
-		fEx = yeeEx->GetFieldMemory();
-		fEy = yeeEy->GetFieldMemory();
-		fEz = yeeEz->GetFieldMemory();
-		fHx = yeeHx->GetFieldMemory();
-		fHy = yeeHy->GetFieldMemory();
-		fHz = yeeHz->GetFieldMemory();
-		for(size_t index=0;index<fieldItems;index++)
-		{
-			HE[index].E.x = fEx[index].E.x;
-			HE[index].E.y = fEy[index].E.y;
-			HE[index].E.z = fEz[index].E.z;
-			HE[index].H.x = fHx[index].H.x;
-			HE[index].H.y = fHy[index].H.y;
-			HE[index].H.z = fHz[index].H.z;
-		}
-		freeFieldMemory(); //close the memory mapped file
+		ret = synch.gothroughBox(maxRadiusX, maxRadiusY, maxRadiusZ);
+	}
+	else
+	{
+		ret = synch.gothroughSphere(maxRadius);
 	}
 	return ret;
 }
 
 /*
-	populate all 6 YeeFDTD instances, make space shifts to create a space synchronized EM field
+	populate the YeeFDTD instance at Yee's positions and interpolate the fields to the grid points
 */
 int YeeFDTDSpaceSynched::PopulateFields(FieldsInitializer *fieldValues)
 {
 	if(ret == ERR_OK)
 	{
-		ret = yeeEx->setFieldValues(fieldValues, -ds2, 0.0, 0.0);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeEy->setFieldValues(fieldValues, 0.0, -ds2, 0.0);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeEz->setFieldValues(fieldValues, 0.0, 0.0, -ds2);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHx->setFieldValues(fieldValues, 0.0, -ds2, -ds2);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHy->setFieldValues(fieldValues, -ds2, 0.0, -ds2);
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHz->setFieldValues(fieldValues, -ds2, -ds2, 0.0);
+		ret = yee->PopulateFields(fieldValues);
 	}
 	if(ret == ERR_OK)
 	{
@@ -142,49 +104,29 @@ int YeeFDTDSpaceSynched::PopulateFields(FieldsInitializer *fieldValues)
 
 void YeeFDTDSpaceSynched::OnFinishSimulation()
 {
-	
+	if(yee != NULL)
+	{
+		yee->FinishSimulation();
+	}
 }
 
 int YeeFDTDSpaceSynched::updateFieldsToMoveForward()
 {
 	ret = ERR_OK;
-	//advance time step index
+	//advance time indicators
 	_timeIndex++;
+	_time += dt;
 	//
-	ret = yeeEx->moveForward();
-	if(ret == ERR_OK)
-	{
-		ret = yeeEy->moveForward();
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeEz->moveForward();
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHx->moveForward();
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHy->moveForward();
-	}
-	if(ret == ERR_OK)
-	{
-		ret = yeeHz->moveForward();
-	}
+	ret = yee->moveForward();
 	if(ret == ERR_OK)
 	{
 		if(_recordFDTDStepTimes)
 		{
-			_sumtimeused += (
-				 yeeEx->GetCurrentFDTDStepTime()
-				+yeeEy->GetCurrentFDTDStepTime()
-				+yeeEz->GetCurrentFDTDStepTime()
-				+yeeHx->GetCurrentFDTDStepTime()
-				+yeeHy->GetCurrentFDTDStepTime()
-				+yeeHz->GetCurrentFDTDStepTime())/6.0;
+			_sumtimeused += yee->GetCurrentFDTDStepTime();
 			_timesteps++;
 		}
+		//save existing fields to a file and allocating new memory for the current time index
+		ret = allocateFieldMemory();
 	}
 	if(ret == ERR_OK)
 	{
@@ -192,4 +134,3 @@ int YeeFDTDSpaceSynched::updateFieldsToMoveForward()
 	}
 	return ret;
 }
-
@@ -8,29 +8,35 @@
 
 #include "YeeFDTD.h"
 
+/*
+	interpolate the fields of a Yee grid to the grid points.
+	Ex, Ey and Ez are averaged over the 2 neighbours along their own axes;
+	Hx, Hy and Hz are averaged over the 4 neighbours in the planes normal to their own axes.
+	at a negative edge a missing neighbour is replaced by the point itself
+*/
+class SynchronizeYeeFields:public virtual GoThroughSphereByIndexes, public virtual RadiusIndexCacheUser
+{
+private:
+	FieldPoint3D *_yee;     //fields at Yee's positions
+	FieldPoint3D *_synched; //fields at the grid points
+public:
+	SynchronizeYeeFields(void);
+	void setMaxRadius(RadiusIndexToSeriesIndex *cache, int maxR){seriesIndex = cache; maxRadius = maxR;}
+	void reset(FieldPoint3D *yee, FieldPoint3D *synched);
+	virtual void handleData(int m, int n, int p);
+};
+
 /*
 	this class is for doing space-synchronized Yee simulation.
-	it uses 6 YeeFDTD instances, each with certain space shifts.
-	each YeeFDTD provides one field component which is at a sychronized location.
-	together they provide all 6 field components at the synchronized location.
+	it advances one YeeFDTD instance and interpolates its staggered components to the grid points
+	each time it moves forward. the interpolated fields are in HE and recorded in the data files;
+	the staggered fields are kept by the YeeFDTD instance and only used for time advancement.
 */
 class YeeFDTDSpaceSynched: public virtual FDTD
 {
 private:
-	YeeFDTD *yeeEx; //shift Ex to (x,y,z)
-	YeeFDTD *yeeEy; //shift Ey to (x,y,z)
-	YeeFDTD *yeeEz; //shift Ez to (x,y,z)
-	YeeFDTD *yeeHx; //shift Hx to (x,y,z)
-	YeeFDTD *yeeHy; //shift Hy to (x,y,z)
-	YeeFDTD *yeeHz; //shift Hz to (x,y,z)
-	FieldPoint3D *fEx; //fields for yeeEx
-	FieldPoint3D *fEy; //fields for yeeEy
-	FieldPoint3D *fEz; //fields for yeeEz
-	FieldPoint3D *fHx; //fields for yeeHx
-	FieldPoint3D *fHy; //fields for yeeHy
-	FieldPoint3D *fHz; //fields for yeeHz
-	//
-	double ds2; //space shift distance
+	YeeFDTD *yee; //the staggered grid
+	SynchronizeYeeFields synch;
 	int ret;
 protected:
 	virtual void cleanup(void);
@@ -44,6 +50,7 @@ public:
 	virtual int updateFieldsToMoveForward();
 	virtual void OnFinishSimulation();
 	//
+	//the YeeFDTD instance works on a row-major box; fields are interpolated point by point
+	virtual bool SupportBoxDomain(){return true;}
+	//
 };
-
-